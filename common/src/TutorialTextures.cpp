@@ -20,6 +20,7 @@
 #include "TutoWindowManager.hpp"
 #include "TutorialUtils.hpp"
 
+#include <cstring>
 #include <stdexcept>
 
 extern VkDevice tutorialDevice;
@@ -28,10 +29,34 @@ extern VkPhysicalDeviceMemoryProperties tutorialMemoryProperties;
 extern VkCommandPool cmdPool;
 extern VkPhysicalDevice tutorialGpu;
 
+static void setTextureLayout(VkCommandBuffer cmd, VkImage image,
+                             VkImageLayout oldLayout, VkImageLayout newLayout,
+                             VkAccessFlags srcAccess, VkAccessFlags dstAccess,
+                             VkPipelineStageFlags srcStages,
+                             VkPipelineStageFlags dstStages) {
+  VkImageMemoryBarrier barrier = {
+      .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+      .pNext = nullptr,
+      .srcAccessMask = srcAccess,
+      .dstAccessMask = dstAccess,
+      .oldLayout = oldLayout,
+      .newLayout = newLayout,
+      .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+      .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+      .image = image,
+      .subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1},
+  };
+  vkCmdPipelineBarrier(cmd, srcStages, dstStages, 0, 0, nullptr, 0, nullptr, 1,
+                       &barrier);
+}
+
 // Open texture file from asset, load it into the created texture
 // The supported texture format is in kTexFmt
-//     Skipping memory barriers the next draw command is far out
-//     by then, the blit will way complete ahead
+//     Linear images are sampled directly when the format allows it,
+//     otherwise the pixels go through a staging buffer into an optimal image
+//     usage is added to the image's usage, required_props to the properties
+//     its memory must have. Either way the image ends up in
+//     VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL.
 VkResult tutorialLoadTextureFromFile(const char* filePath,
                                      struct texture_object* tex_obj,
                                      VkImageUsageFlags usage,
@@ -60,16 +85,19 @@ VkResult tutorialLoadTextureFromFile(const char* filePath,
   size_t fileLength = AAsset_getLength(file);
   stbi_uc* fileContent = new unsigned char[fileLength];
   AAsset_read(file, fileContent, fileLength);
+  AAsset_close(file);
 
   uint32_t imgWidth, imgHeight, n;
   unsigned char* imageData = stbi_load_from_memory(
           fileContent, fileLength, reinterpret_cast<int*>(&imgWidth),
-          reinterpret_cast<int*>(&imgHeight), reinterpret_cast<int*>(&n), 0);
+          reinterpret_cast<int*>(&imgHeight), reinterpret_cast<int*>(&n), 4);
+  delete[] fileContent;
 
   tex_obj->tex_width = imgWidth;
   tex_obj->tex_height = imgHeight;
 
-  // Allocate the linear texture so texture could be copied over
+  tex_obj->imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+
   VkImageCreateInfo image_create_info = {
           .sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
           .pNext = nullptr,
@@ -80,11 +108,14 @@ VkResult tutorialLoadTextureFromFile(const char* filePath,
           .mipLevels = 1,
           .arrayLayers = 1,
           .samples = VK_SAMPLE_COUNT_1_BIT,
-          .tiling = VK_IMAGE_TILING_LINEAR,
-          .usage = (needBlit ? VK_IMAGE_USAGE_TRANSFER_SRC_BIT :
-                               VK_IMAGE_USAGE_SAMPLED_BIT),
+          .tiling = (needBlit ? VK_IMAGE_TILING_OPTIMAL : VK_IMAGE_TILING_LINEAR),
+          .usage = usage | (needBlit ? VK_IMAGE_USAGE_TRANSFER_DST_BIT |
+                                       VK_IMAGE_USAGE_SAMPLED_BIT :
+                                       VK_IMAGE_USAGE_SAMPLED_BIT),
           .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
           .queueFamilyIndexCount = 0,
+          .initialLayout = (needBlit ? VK_IMAGE_LAYOUT_UNDEFINED :
+                                       VK_IMAGE_LAYOUT_PREINITIALIZED),
           .flags = 0,
   };
   VkMemoryAllocateInfo mem_alloc = {
@@ -99,13 +130,44 @@ VkResult tutorialLoadTextureFromFile(const char* filePath,
                       nullptr, &tex_obj->image));
   vkGetImageMemoryRequirements(tutorialDevice, tex_obj->image, &mem_reqs);
   mem_alloc.allocationSize = mem_reqs.size;
-  VK_CHECK(memory_type_from_properties(mem_reqs.memoryTypeBits,
-                              VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT,
-                              &mem_alloc.memoryTypeIndex));
+  if (needBlit) {
+    VK_CHECK(memory_type_from_properties(mem_reqs.memoryTypeBits,
+                                VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT | required_props,
+                                &mem_alloc.memoryTypeIndex));
+  } else if (memory_type_from_properties(mem_reqs.memoryTypeBits,
+                                VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+                                VK_MEMORY_PROPERTY_HOST_COHERENT_BIT | required_props,
+                                &mem_alloc.memoryTypeIndex) != VK_SUCCESS) {
+    // no coherent type for the image, the writes are flushed below
+    VK_CHECK(memory_type_from_properties(mem_reqs.memoryTypeBits,
+                                VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | required_props,
+                                &mem_alloc.memoryTypeIndex));
+  }
   CALL_VK(vkAllocateMemory(tutorialDevice, &mem_alloc, nullptr, &tex_obj->mem));
   CALL_VK(vkBindImageMemory(tutorialDevice, tex_obj->image, tex_obj->mem, 0));
 
-  if (required_props & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) {
+  VkCommandBuffer gfxCmd;
+  const VkCommandBufferAllocateInfo cmd = {
+          .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+          .pNext = nullptr,
+          .commandPool = cmdPool,
+          .level = VK_COMMAND_BUFFER_LEVEL_PRIMARY,
+          .commandBufferCount = 1,
+  };
+  CALL_VK(vkAllocateCommandBuffers(tutorialDevice, &cmd, &gfxCmd));
+
+  VkCommandBufferBeginInfo cmd_buf_info = {
+          .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+          .pNext = nullptr,
+          .flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT,
+          .pInheritanceInfo = nullptr};
+  CALL_VK(vkBeginCommandBuffer(gfxCmd, &cmd_buf_info));
+
+  VkBuffer stageBuf = VK_NULL_HANDLE;
+  VkDeviceMemory stageMem = VK_NULL_HANDLE;
+
+  // Linear texture: write the rows straight into the image
+  if (!needBlit) {
     const VkImageSubresource subres = {
             .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
             .mipLevel = 0,
@@ -119,89 +181,88 @@ VkResult tutorialLoadTextureFromFile(const char* filePath,
     CALL_VK(vkMapMemory(tutorialDevice, tex_obj->mem, 0, mem_alloc.allocationSize,
                       0, &data));
 
-    for (int32_t y = 0; y < imgHeight; y++) {
-      unsigned char* row = (unsigned char*)((char*)data + layout.rowPitch * y);
-      for (int32_t x = 0; x < imgWidth; x++) {
-        row[x * 4] = imageData[(x + y * imgWidth) * 4];
-        row[x * 4 + 1] = imageData[(x + y * imgWidth) * 4 + 1];
-        row[x * 4 + 2] = imageData[(x + y * imgWidth) * 4 + 2];
-        row[x * 4 + 3] = imageData[(x + y * imgWidth) * 4 + 3];
-      }
+    for (uint32_t y = 0; y < imgHeight; y++) {
+      memcpy((char*)data + layout.offset + layout.rowPitch * y,
+             imageData + y * imgWidth * 4, imgWidth * 4);
     }
 
+    // a no-op on coherent memory
+    VkMappedMemoryRange range = {
+            .sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE,
+            .pNext = nullptr,
+            .memory = tex_obj->mem,
+            .offset = 0,
+            .size = VK_WHOLE_SIZE,
+    };
+    CALL_VK(vkFlushMappedMemoryRanges(tutorialDevice, 1, &range));
     vkUnmapMemory(tutorialDevice, tex_obj->mem);
-    delete[] imageData;
-  }
-  delete [] fileContent;
-
-  tex_obj->imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
- 
-  // If linear is supported, we are done
-  if (!needBlit) {
-    return VK_SUCCESS;
-  }
-
-  // save current image and mem as staging image and memory
-  VkImage stageImage = tex_obj->image;
-  VkDeviceMemory stageMem = tex_obj->mem;
-  tex_obj->image = VK_NULL_HANDLE;
-  tex_obj->mem   = VK_NULL_HANDLE;
-
-  // Create a tile texture to blit into
-  image_create_info.tiling = VK_IMAGE_TILING_OPTIMAL;
-  image_create_info.usage  = VK_IMAGE_USAGE_TRANSFER_DST_BIT |
-                             VK_IMAGE_USAGE_SAMPLED_BIT;
-  CALL_VK(vkCreateImage(tutorialDevice, &image_create_info,
-                                    nullptr, &tex_obj->image));
-  vkGetImageMemoryRequirements(tutorialDevice, tex_obj->image, &mem_reqs);
+    stbi_image_free(imageData);
 
-  mem_alloc.allocationSize = mem_reqs.size;
-  VK_CHECK(memory_type_from_properties(mem_reqs.memoryTypeBits,
-                                     VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
-                                     &mem_alloc.memoryTypeIndex));
-  CALL_VK(vkAllocateMemory(tutorialDevice, &mem_alloc, nullptr, &tex_obj->mem));
-  CALL_VK(vkBindImageMemory(tutorialDevice, tex_obj->image, tex_obj->mem, 0));
+    // the submit makes the host writes visible, the barrier the layout shaders read
+    setTextureLayout(gfxCmd, tex_obj->image, VK_IMAGE_LAYOUT_PREINITIALIZED,
+                     VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+                     VK_ACCESS_HOST_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT,
+                     VK_PIPELINE_STAGE_HOST_BIT,
+                     VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT);
+  } else {
+    // Staging buffer, the decoded pixels are tightly packed rows
+    VkDeviceSize stageSize = static_cast<VkDeviceSize>(imgWidth) * imgHeight * 4;
+    VkBufferCreateInfo buffer_create_info = {
+            .sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
+            .pNext = nullptr,
+            .flags = 0,
+            .size = stageSize,
+            .usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+            .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
+            .queueFamilyIndexCount = 0,
+            .pQueueFamilyIndices = nullptr,
+    };
+    CALL_VK(vkCreateBuffer(tutorialDevice, &buffer_create_info, nullptr, &stageBuf));
+    vkGetBufferMemoryRequirements(tutorialDevice, stageBuf, &mem_reqs);
+    mem_alloc.allocationSize = mem_reqs.size;
+    VK_CHECK(memory_type_from_properties(mem_reqs.memoryTypeBits,
+                                VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+                                VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                                &mem_alloc.memoryTypeIndex));
+    CALL_VK(vkAllocateMemory(tutorialDevice, &mem_alloc, nullptr, &stageMem));
+    CALL_VK(vkBindBufferMemory(tutorialDevice, stageBuf, stageMem, 0));
 
-  VkCommandBuffer gfxCmd;
-  const VkCommandBufferAllocateInfo cmd = {
-          .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
-          .pNext = nullptr,
-          .commandPool = cmdPool,
-          .level = VK_COMMAND_BUFFER_LEVEL_PRIMARY,
-          .commandBufferCount = 1,
-  };
+    void* data;
+    CALL_VK(vkMapMemory(tutorialDevice, stageMem, 0, stageSize, 0, &data));
+    memcpy(data, imageData, stageSize);
+    vkUnmapMemory(tutorialDevice, stageMem);
+    stbi_image_free(imageData);
 
-  CALL_VK(vkAllocateCommandBuffers(tutorialDevice, &cmd, &gfxCmd));
+    setTextureLayout(gfxCmd, tex_obj->image, VK_IMAGE_LAYOUT_UNDEFINED,
+                     VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 0,
+                     VK_ACCESS_TRANSFER_WRITE_BIT,
+                     VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+                     VK_PIPELINE_STAGE_TRANSFER_BIT);
 
-  VkCommandBufferBeginInfo cmd_buf_info = {
-          .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
-          .pNext = nullptr,
-          .flags = 0,
-          .pInheritanceInfo = nullptr};
-  CALL_VK(vkBeginCommandBuffer(gfxCmd, &cmd_buf_info));
+    VkBufferImageCopy copyInfo = {
+      .bufferOffset = 0,
+      .bufferRowLength = imgWidth,
+      .bufferImageHeight = imgHeight,
+      .imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+      .imageSubresource.mipLevel = 0,
+      .imageSubresource.baseArrayLayer = 0,
+      .imageSubresource.layerCount = 1,
+      .imageOffset.x = 0,
+      .imageOffset.y = 0,
+      .imageOffset.z = 0,
+      .imageExtent.width = imgWidth,
+      .imageExtent.height = imgHeight,
+      .imageExtent.depth = 1,
+    };
+    vkCmdCopyBufferToImage(gfxCmd, stageBuf, tex_obj->image,
+                           VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &copyInfo);
 
-  VkImageCopy bltInfo = {
-    .srcSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
-    .srcSubresource.mipLevel = 0,
-    .srcSubresource.baseArrayLayer = 0,
-    .srcSubresource.layerCount = 1,
-    .srcOffset.x = 0,
-    .srcOffset.y = 0,
-    .srcOffset.z = 0,
-    .dstSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
-    .dstSubresource.mipLevel = 0,
-    .dstSubresource.baseArrayLayer = 0,
-    .dstSubresource.layerCount = 1,
-    .dstOffset.x = 0,
-    .dstOffset.y = 0,
-    .dstOffset.z = 0,
-    .extent.width = imgWidth,
-    .extent.height = imgHeight,
-    .extent.depth = 1,
-  };
-  vkCmdCopyImage(gfxCmd, stageImage,
-                 VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, tex_obj->image,
-                 VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &bltInfo);
+    setTextureLayout(gfxCmd, tex_obj->image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                     VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+                     VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT,
+                     VK_PIPELINE_STAGE_TRANSFER_BIT,
+                     VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT);
+  }
 
   CALL_VK(vkEndCommandBuffer(gfxCmd));
   VkFenceCreateInfo fenceInfo = {
@@ -223,12 +284,14 @@ VkResult tutorialLoadTextureFromFile(const char* filePath,
     .signalSemaphoreCount = 0,
     .pSignalSemaphores = nullptr,
   };
-  CALL_VK(vkQueueSubmit(tutorialGraphicsQueue, 1, &submitInfo, fence) != VK_SUCCESS);
-  CALL_VK(vkWaitForFences(tutorialDevice, 1, &fence, VK_TRUE, 100000000) !=VK_SUCCESS);
+  CALL_VK(vkQueueSubmit(tutorialGraphicsQueue, 1, &submitInfo, fence));
+  CALL_VK(vkWaitForFences(tutorialDevice, 1, &fence, VK_TRUE, 100000000));
   vkDestroyFence(tutorialDevice, fence, nullptr);
 
   vkFreeCommandBuffers(tutorialDevice, cmdPool, 1, &gfxCmd);
-  vkDestroyImage(tutorialDevice, stageImage, nullptr);
-  vkFreeMemory(tutorialDevice, stageMem, nullptr);
+  if (stageBuf != VK_NULL_HANDLE) {
+    vkDestroyBuffer(tutorialDevice, stageBuf, nullptr);
+    vkFreeMemory(tutorialDevice, stageMem, nullptr);
+  }
   return VK_SUCCESS;
 }
@@ -20,6 +20,17 @@
 layout (binding = 0) uniform sampler2D tex;
 layout (location = 0) in vec2 texcoord;
 layout (location = 0) out vec4 uFragColor;
+// Specialization constants, set per pipeline; the driver folds them like literals
+layout (constant_id = 0) const int blurTaps = 1; // width of a horizontal box blur in texels, 1 samples once
 void main() {
-   uFragColor = texture(tex, texcoord);
+   if (blurTaps <= 1) {
+      uFragColor = texture(tex, texcoord);
+      return;
+   }
+   vec2 texel = vec2(1.0 / float(textureSize(tex, 0).x), 0.0);
+   vec4 color = vec4(0.0);
+   for (int i = 0; i < blurTaps; i++) {
+      color += texture(tex, texcoord + texel * (float(i) - float(blurTaps - 1) * 0.5));
+   }
+   uFragColor = color / float(blurTaps);
 }
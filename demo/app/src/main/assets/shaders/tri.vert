@@ -17,10 +17,14 @@
 #version 400
 #extension GL_ARB_separate_shader_objects : enable
 #extension GL_ARB_shading_language_420pack : enable
-layout (location = 0) in vec4 pos;
+layout (location = 0) in vec3 pos;
 layout (location = 1) in vec2 attr;
 layout (location = 0) out vec2 texcoord;
+// per-draw data, bound at a dynamic offset into the uniform ring
+layout (set = 1, binding = 0) uniform Object {
+   vec4 transform; // xy: offset, zw: scale
+} object;
 void main() {
    texcoord = attr;
-   gl_Position = pos;
+   gl_Position = vec4(pos.xy * object.transform.zw + object.transform.xy, pos.z, 1.0);
 }
@@ -0,0 +1,39 @@
+// Copyright 2016 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/*
+ * Fragment shader for tri demo in bindless mode: every texture sits in one
+ * array, the draw's material picks its texture through a push constant
+ */
+#version 450
+#extension GL_EXT_nonuniform_qualifier : require
+layout (binding = 0) uniform sampler2D textures[];
+layout (push_constant) uniform Material {
+   uint textureIndex; // BindlessTextureTable slot, the same for the whole draw
+} material;
+layout (location = 0) in vec2 texcoord;
+layout (location = 0) out vec4 uFragColor;
+// Specialization constants, set per pipeline; the driver folds them like literals
+layout (constant_id = 0) const int blurTaps = 1; // width of a horizontal box blur in texels, 1 samples once
+void main() {
+   if (blurTaps <= 1) {
+      uFragColor = texture(textures[material.textureIndex], texcoord);
+      return;
+   }
+   vec2 texel = vec2(1.0 / float(textureSize(textures[material.textureIndex], 0).x), 0.0);
+   vec4 color = vec4(0.0);
+   for (int i = 0; i < blurTaps; i++) {
+      color += texture(textures[material.textureIndex], texcoord + texel * (float(i) - float(blurTaps - 1) * 0.5));
+   }
+   uFragColor = color / float(blurTaps);
+}
@@ -24,7 +24,13 @@ void handle_cmd(android_app* app, int32_t cmd) {
             break;
         case APP_CMD_TERM_WINDOW:
             // The window is being hidden or closed, clean it up.
-            DeleteVulkan();
+            // The device is kept so the next APP_CMD_INIT_WINDOW is cheap.
+            DeleteVulkanWindow();
+            SaveVulkanPipelineCache();
+            break;
+        case APP_CMD_SAVE_STATE:
+            // The app may be killed without any further callback.
+            SaveVulkanPipelineCache();
             break;
         default:
             __android_log_print(ANDROID_LOG_INFO, "Vulkan Tutorials",
@@ -53,4 +59,6 @@ void android_main(struct android_app* app) {
             VulkanDrawFrame();
         }
     } while (app->destroyRequested == 0);
+
+    DeleteVulkan();
 }
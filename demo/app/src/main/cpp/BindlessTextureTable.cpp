@@ -0,0 +1,130 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include "BindlessTextureTable.h"
+#include <cassert>
+
+VkResult BindlessTextureTable::Init( VkDevice device, VkDescriptorSetLayout layout, uint32_t binding, VkDescriptorType type, uint32_t capacity )
+{
+    device_ = device;
+    binding_ = binding;
+    type_ = type;
+    capacity_ = capacity;
+    set_ = VK_NULL_HANDLE;
+    freeSlots_.clear();
+    for( uint32_t slot = capacity; slot > 0; slot-- )
+        freeSlots_.push_back( slot - 1 );
+    retired_.clear();
+    pendingSlots_.clear();
+    pendingImages_.clear();
+
+    // update-after-bind layouts need a pool of their own
+    VkDescriptorPoolSize poolSize;
+    poolSize.type = type;
+    poolSize.descriptorCount = capacity;
+
+    VkDescriptorPoolCreateInfo poolCreateInfo;
+    poolCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    poolCreateInfo.pNext = nullptr;
+    poolCreateInfo.flags = VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT_EXT;
+    poolCreateInfo.maxSets = 1;
+    poolCreateInfo.poolSizeCount = 1;
+    poolCreateInfo.pPoolSizes = &poolSize;
+    VkResult result = vkCreateDescriptorPool( device_, &poolCreateInfo, nullptr, &pool_ );
+    if( result != VK_SUCCESS )
+    {
+        pool_ = VK_NULL_HANDLE;
+        return result;
+    }
+
+    VkDescriptorSetAllocateInfo allocateInfo;
+    allocateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    allocateInfo.pNext = nullptr;
+    allocateInfo.descriptorPool = pool_;
+    allocateInfo.descriptorSetCount = 1;
+    allocateInfo.pSetLayouts = &layout;
+    return vkAllocateDescriptorSets( device_, &allocateInfo, &set_ );
+}
+
+void BindlessTextureTable::Shutdown( void )
+{
+    if( pool_ != VK_NULL_HANDLE )
+        vkDestroyDescriptorPool( device_, pool_, nullptr );
+    pool_ = VK_NULL_HANDLE;
+    set_ = VK_NULL_HANDLE;
+}
+
+uint32_t BindlessTextureTable::Add( VkSampler sampler, VkImageView imageView, VkImageLayout imageLayout )
+{
+    if( freeSlots_.empty() )
+        return kInvalidSlot;
+    uint32_t slot = freeSlots_.back();
+    freeSlots_.pop_back();
+
+    VkDescriptorImageInfo image;
+    image.sampler = sampler;
+    image.imageView = imageView;
+    image.imageLayout = imageLayout;
+    pendingSlots_.push_back( slot );
+    pendingImages_.push_back( image );
+    return slot;
+}
+
+void BindlessTextureTable::Remove( uint32_t slot, uint64_t freeFrame )
+{
+    assert( slot < capacity_ );
+    retired_.push_back( { slot, freeFrame } );
+}
+
+void BindlessTextureTable::FreeRetired( uint64_t frameNumber )
+{
+    for( size_t i = 0; i < retired_.size(); )
+    {
+        if( frameNumber >= retired_[i].freeFrame_ )
+        {
+            freeSlots_.push_back( retired_[i].slot_ );
+            retired_[i] = retired_.back();
+            retired_.pop_back();
+        }
+        else
+            i++;
+    }
+}
+
+void BindlessTextureTable::Flush( void )
+{
+    if( pendingSlots_.empty() )
+        return;
+
+    std::vector<VkWriteDescriptorSet> writes( pendingSlots_.size() );
+    for( size_t i = 0; i < writes.size(); i++ )
+    {
+        writes[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        writes[i].pNext = nullptr;
+        writes[i].dstSet = set_;
+        writes[i].dstBinding = binding_;
+        writes[i].dstArrayElement = pendingSlots_[i];
+        writes[i].descriptorCount = 1;
+        writes[i].descriptorType = type_;
+        writes[i].pImageInfo = &pendingImages_[i];
+        writes[i].pBufferInfo = nullptr;
+        writes[i].pTexelBufferView = nullptr;
+    }
+    vkUpdateDescriptorSets( device_, static_cast<uint32_t>( writes.size() ), writes.data(), 0, nullptr );
+    pendingSlots_.clear();
+    pendingImages_.clear();
+}
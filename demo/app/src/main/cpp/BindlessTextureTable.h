@@ -0,0 +1,82 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#ifndef TUTORIAL06_TEXTURE_BINDLESSTEXTURETABLE_H
+#define TUTORIAL06_TEXTURE_BINDLESSTEXTURETABLE_H
+
+#include <vulkan_wrapper.h>
+#include <vector>
+
+/*
+ * BindlessTextureTable
+ *   Every texture of the scene in one descriptor set: a single array
+ *   binding of VK_EXT_descriptor_indexing, partially bound and
+ *   update-after-bind (LayoutCache's runtime sized arrays). The set is bound
+ *   once per command buffer and draws pick their texture by slot, passed to
+ *   the shader as a push constant, so materials cost no descriptor binds.
+ *
+ *   Slots come from a free list. A removed slot is reused only once no
+ *   frame in flight can still sample it; until then it keeps its old
+ *   descriptor. Descriptors of new slots are written together in Flush(),
+ *   which may run while frames using other slots are in flight
+ *   (VK_DESCRIPTOR_BINDING_UPDATE_UNUSED_WHILE_PENDING_BIT_EXT).
+ *
+ *   Not thread safe, used by the render thread.
+ */
+class BindlessTextureTable
+{
+public:
+    static const uint32_t kInvalidSlot = ~0u;
+
+    // layout: set layout whose binding is the runtime array, capacity descriptors large
+    VkResult Init( VkDevice device, VkDescriptorSetLayout layout, uint32_t binding, VkDescriptorType type, uint32_t capacity );
+    // destroys the set's pool, no frame may use it anymore
+    void Shutdown( void );
+
+    // Slot the shaders index, kInvalidSlot if the table is full; sampled once Flush() ran
+    uint32_t Add( VkSampler sampler, VkImageView imageView, VkImageLayout imageLayout );
+    // slot may be handed out again from frame number freeFrame on
+    void Remove( uint32_t slot, uint64_t freeFrame );
+    // Returns the removed slots of frames up to frameNumber to the free list; call after waiting for the frame's fence
+    void FreeRetired( uint64_t frameNumber );
+    // Writes the descriptors Add() queued in one vkUpdateDescriptorSets call, before recording draws using them
+    void Flush( void );
+
+    VkDescriptorSet Set( void ) const { return set_; }
+    uint32_t Capacity( void ) const { return capacity_; }
+    uint32_t Count( void ) const { return capacity_ - static_cast<uint32_t>( freeSlots_.size() ); } // slots in use or retired
+
+private:
+    struct RetiredSlot
+    {
+        uint32_t slot_;
+        uint64_t freeFrame_;
+    };
+
+    VkDevice device_;
+    VkDescriptorPool pool_;
+    VkDescriptorSet set_;
+    uint32_t binding_;
+    VkDescriptorType type_;
+    uint32_t capacity_;
+    std::vector<uint32_t> freeSlots_; // lowest slot last, handed out first
+    std::vector<RetiredSlot> retired_;
+    std::vector<uint32_t> pendingSlots_;
+    std::vector<VkDescriptorImageInfo> pendingImages_;
+};
+
+#endif // TUTORIAL06_TEXTURE_BINDLESSTEXTURETABLE_H
@@ -0,0 +1,250 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include "BlockAllocator.h"
+#include <cassert>
+#include <cstring>
+
+static uint32_t FloorLog2( uint64_t value )
+{
+    return 63 - __builtin_clzll( value );
+}
+
+static uint64_t AlignUp( uint64_t value, uint64_t alignment )
+{
+    return ( value + alignment - 1 ) / alignment * alignment;
+}
+
+BlockAllocator::BlockAllocator( uint64_t size )
+    : flBitmap_( 0 ), size_( size / kMinAlignment * kMinAlignment ), used_( 0 ), allocationCount_( 0 )
+{
+    memset( slBitmap_, 0, sizeof( slBitmap_ ) );
+    memset( freeHeads_, 0xff, sizeof( freeHeads_ ) );
+
+    uint32_t block = NewBlock();
+    blocks_[block].offset_ = 0;
+    blocks_[block].size_ = size_;
+    InsertFree( block );
+}
+
+// size class a free block of this size is stored in
+void BlockAllocator::MappingInsert( uint64_t size, uint32_t* fl, uint32_t* sl )
+{
+    if( size < kSmallSize )
+    {
+        *fl = 0;
+        *sl = static_cast<uint32_t>( size / kMinAlignment );
+        return;
+    }
+    uint32_t log2 = FloorLog2( size );
+    *fl = log2 - FloorLog2( kSmallSize ) + 1;
+    *sl = static_cast<uint32_t>( size >> ( log2 - kSlBits ) ) ^ kSlCount;
+}
+
+// first size class whose blocks are all at least this big
+void BlockAllocator::MappingSearch( uint64_t size, uint32_t* fl, uint32_t* sl )
+{
+    if( size >= kSmallSize )
+    {
+        size += ( 1ull << ( FloorLog2( size ) - kSlBits ) ) - 1;
+    }
+    MappingInsert( size, fl, sl );
+}
+
+uint32_t BlockAllocator::NewBlock( void )
+{
+    Block empty = { 0, 0, kInvalidBlock, kInvalidBlock, kInvalidBlock, kInvalidBlock, false };
+    if( !unusedBlocks_.empty() )
+    {
+        uint32_t block = unusedBlocks_.back();
+        unusedBlocks_.pop_back();
+        blocks_[block] = empty;
+        return block;
+    }
+    blocks_.push_back( empty );
+    return static_cast<uint32_t>( blocks_.size() - 1 );
+}
+
+void BlockAllocator::InsertFree( uint32_t block )
+{
+    uint32_t fl, sl;
+    MappingInsert( blocks_[block].size_, &fl, &sl );
+
+    Block& b = blocks_[block];
+    b.free_ = true;
+    b.prevFree_ = kInvalidBlock;
+    b.nextFree_ = freeHeads_[fl][sl];
+    if( b.nextFree_ != kInvalidBlock )
+        blocks_[b.nextFree_].prevFree_ = block;
+    freeHeads_[fl][sl] = block;
+
+    flBitmap_ |= 1ull << fl;
+    slBitmap_[fl] |= 1u << sl;
+}
+
+void BlockAllocator::RemoveFree( uint32_t block )
+{
+    uint32_t fl, sl;
+    MappingInsert( blocks_[block].size_, &fl, &sl );
+
+    Block& b = blocks_[block];
+    if( b.prevFree_ != kInvalidBlock )
+        blocks_[b.prevFree_].nextFree_ = b.nextFree_;
+    else
+        freeHeads_[fl][sl] = b.nextFree_;
+    if( b.nextFree_ != kInvalidBlock )
+        blocks_[b.nextFree_].prevFree_ = b.prevFree_;
+    b.free_ = false;
+
+    if( freeHeads_[fl][sl] == kInvalidBlock )
+    {
+        slBitmap_[fl] &= ~( 1u << sl );
+        if( slBitmap_[fl] == 0 )
+            flBitmap_ &= ~( 1ull << fl );
+    }
+}
+
+uint32_t BlockAllocator::FindFree( uint64_t size )
+{
+    uint32_t fl, sl;
+    MappingSearch( size, &fl, &sl );
+    if( fl >= kFlCount )
+        return kInvalidBlock;
+
+    uint32_t slMap = sl < kSlCount ? slBitmap_[fl] & ( ~0u << sl ) : 0;
+    if( slMap == 0 )
+    {
+        uint64_t flMap = fl + 1 < kFlCount ? flBitmap_ & ( ~0ull << ( fl + 1 ) ) : 0;
+        if( flMap == 0 )
+            return kInvalidBlock;
+        fl = __builtin_ctzll( flMap );
+        slMap = slBitmap_[fl];
+    }
+    sl = __builtin_ctz( slMap );
+    return freeHeads_[fl][sl];
+}
+
+uint32_t BlockAllocator::Allocate( uint64_t size, uint64_t alignment, uint64_t* offset )
+{
+    size = AlignUp( size ? size : 1, kMinAlignment );
+    alignment = alignment > kMinAlignment ? alignment : kMinAlignment;
+
+    // worst case padding in front of an aligned offset
+    uint32_t block = FindFree( size + alignment - kMinAlignment );
+    if( block == kInvalidBlock )
+        return kInvalidBlock;
+    RemoveFree( block );
+
+    // split the alignment padding off the front
+    uint64_t padding = AlignUp( blocks_[block].offset_, alignment ) - blocks_[block].offset_;
+    if( padding )
+    {
+        uint32_t front = NewBlock();
+        Block& b = blocks_[block];
+        Block& f = blocks_[front];
+        f.offset_ = b.offset_;
+        f.size_ = padding;
+        f.prevPhysical_ = b.prevPhysical_;
+        f.nextPhysical_ = block;
+        if( f.prevPhysical_ != kInvalidBlock )
+            blocks_[f.prevPhysical_].nextPhysical_ = front;
+        b.prevPhysical_ = front;
+        b.offset_ += padding;
+        b.size_ -= padding;
+        InsertFree( front );
+    }
+
+    // return the tail to the free lists
+    if( blocks_[block].size_ - size >= kMinAlignment )
+    {
+        uint32_t tail = NewBlock();
+        Block& b = blocks_[block];
+        Block& t = blocks_[tail];
+        t.offset_ = b.offset_ + size;
+        t.size_ = b.size_ - size;
+        t.prevPhysical_ = block;
+        t.nextPhysical_ = b.nextPhysical_;
+        if( t.nextPhysical_ != kInvalidBlock )
+            blocks_[t.nextPhysical_].prevPhysical_ = tail;
+        b.nextPhysical_ = tail;
+        b.size_ = size;
+        InsertFree( tail );
+    }
+
+    used_ += blocks_[block].size_;
+    allocationCount_++;
+    *offset = blocks_[block].offset_;
+    return block;
+}
+
+void BlockAllocator::Free( uint32_t block )
+{
+    assert( block < blocks_.size() && !blocks_[block].free_ );
+    used_ -= blocks_[block].size_;
+    allocationCount_--;
+
+    // merge with the free block in front
+    uint32_t prev = blocks_[block].prevPhysical_;
+    if( prev != kInvalidBlock && blocks_[prev].free_ )
+    {
+        RemoveFree( prev );
+        Block& b = blocks_[block];
+        b.offset_ = blocks_[prev].offset_;
+        b.size_ += blocks_[prev].size_;
+        b.prevPhysical_ = blocks_[prev].prevPhysical_;
+        if( b.prevPhysical_ != kInvalidBlock )
+            blocks_[b.prevPhysical_].nextPhysical_ = block;
+        unusedBlocks_.push_back( prev );
+    }
+
+    // merge with the free block behind
+    uint32_t next = blocks_[block].nextPhysical_;
+    if( next != kInvalidBlock && blocks_[next].free_ )
+    {
+        RemoveFree( next );
+        Block& b = blocks_[block];
+        b.size_ += blocks_[next].size_;
+        b.nextPhysical_ = blocks_[next].nextPhysical_;
+        if( b.nextPhysical_ != kInvalidBlock )
+            blocks_[b.nextPhysical_].prevPhysical_ = block;
+        unusedBlocks_.push_back( next );
+    }
+
+    InsertFree( block );
+}
+
+uint64_t BlockAllocator::LargestFreeBlock( void ) const
+{
+    if( flBitmap_ == 0 )
+        return 0;
+
+    // every block of the highest non-empty class is a candidate
+    uint32_t fl = FloorLog2( flBitmap_ );
+    uint32_t sl = 31 - __builtin_clz( slBitmap_[fl] );
+    uint64_t largest = 0;
+    for( uint32_t block = freeHeads_[fl][sl]; block != kInvalidBlock; block = blocks_[block].nextFree_ )
+    {
+        if( blocks_[block].size_ > largest )
+            largest = blocks_[block].size_;
+    }
+    return largest;
+}
+
+uint32_t BlockAllocator::FreeBlockCount( void ) const
+{
+    return static_cast<uint32_t>( blocks_.size() - unusedBlocks_.size() ) - allocationCount_;
+}
@@ -0,0 +1,95 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#ifndef TUTORIAL06_TEXTURE_BLOCKALLOCATOR_H
+#define TUTORIAL06_TEXTURE_BLOCKALLOCATOR_H
+
+#include <cstdint>
+#include <vector>
+
+/*
+ * BlockAllocator
+ *   Two level segregated fit (TLSF) sub-allocator over the range [0, size).
+ *   It only hands out offsets, it never touches memory, so the same logic
+ *   sub-allocates VkDeviceMemory pages and runs on the CPU alone.
+ *
+ *   Free blocks are kept in size classes: the first level is the power of
+ *   two of the size, the second level splits it into kSlCount linear steps.
+ *   Allocate and Free are O(1); freed blocks merge with free neighbours.
+ *
+ *   Every offset and size is a multiple of kMinAlignment. Larger alignments
+ *   are honoured by over-searching and splitting the padding off as a free
+ *   block.
+ */
+class BlockAllocator
+{
+public:
+    static const uint32_t kInvalidBlock = ~0u;
+    static const uint64_t kMinAlignment = 16;
+
+    explicit BlockAllocator( uint64_t size );
+
+    // Returns the block id to pass to Free(), or kInvalidBlock if no free block fits
+    uint32_t Allocate( uint64_t size, uint64_t alignment, uint64_t* offset );
+    void Free( uint32_t block );
+
+    uint64_t Size( void ) const { return size_; }
+    uint64_t UsedSize( void ) const { return used_; }
+    uint32_t AllocationCount( void ) const { return allocationCount_; }
+    bool Empty( void ) const { return allocationCount_ == 0; }
+
+    // Size of the biggest free block and number of free blocks, for fragmentation stats
+    uint64_t LargestFreeBlock( void ) const;
+    uint32_t FreeBlockCount( void ) const;
+
+private:
+    static const uint32_t kSlBits = 4;
+    static const uint32_t kSlCount = 1u << kSlBits;
+    static const uint32_t kFlCount = 64;
+    // sizes below kSmallSize all live in first level 0, in kMinAlignment steps
+    static const uint64_t kSmallSize = kSlCount * kMinAlignment;
+
+    struct Block
+    {
+        uint64_t offset_;
+        uint64_t size_;
+        uint32_t prevPhysical_;
+        uint32_t nextPhysical_;
+        uint32_t prevFree_;
+        uint32_t nextFree_;
+        bool free_;
+    };
+
+    static void MappingInsert( uint64_t size, uint32_t* fl, uint32_t* sl );
+    static void MappingSearch( uint64_t size, uint32_t* fl, uint32_t* sl );
+
+    uint32_t NewBlock( void );
+    void InsertFree( uint32_t block );
+    void RemoveFree( uint32_t block );
+    uint32_t FindFree( uint64_t size );
+
+    std::vector<Block> blocks_;
+    std::vector<uint32_t> unusedBlocks_; // recycled entries of blocks_
+    uint64_t flBitmap_;
+    uint32_t slBitmap_[kFlCount];
+    uint32_t freeHeads_[kFlCount][kSlCount];
+    uint64_t size_;
+    uint64_t used_;
+    uint32_t allocationCount_;
+};
+
+#endif // TUTORIAL06_TEXTURE_BLOCKALLOCATOR_H
@@ -0,0 +1,345 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include "BlockDecoder.h"
+#include <cassert>
+#include <cstddef>
+
+// every decodable format has 4x4 texel blocks
+static const uint32_t kBlockExtent = 4;
+
+static uint8_t Clamp255( int32_t value )
+{
+    return static_cast<uint8_t>( value < 0 ? 0 : value > 255 ? 255 : value );
+}
+
+static uint64_t ReadBigEndian64( const uint8_t* bytes )
+{
+    uint64_t value = 0;
+    for( uint32_t i = 0; i < 8; i++ )
+        value = ( value << 8 ) | bytes[i];
+    return value;
+}
+
+static uint64_t ReadLittleEndian( const uint8_t* bytes, uint32_t count )
+{
+    uint64_t value = 0;
+    for( uint32_t i = count; i > 0; i-- )
+        value = ( value << 8 ) | bytes[i - 1];
+    return value;
+}
+
+static uint32_t Bits( uint64_t value, uint32_t high, uint32_t low )
+{
+    return static_cast<uint32_t>( ( value >> low ) & ( ( 1ull << ( high - low + 1 ) ) - 1 ) );
+}
+
+static uint8_t Extend4( uint32_t value ) { return static_cast<uint8_t>( ( value << 4 ) | value ); }
+static uint8_t Extend5( uint32_t value ) { return static_cast<uint8_t>( ( value << 3 ) | ( value >> 2 ) ); }
+static uint8_t Extend6( uint32_t value ) { return static_cast<uint8_t>( ( value << 2 ) | ( value >> 4 ) ); }
+static uint8_t Extend7( uint32_t value ) { return static_cast<uint8_t>( ( value << 1 ) | ( value >> 6 ) ); }
+
+static int32_t SignExtend3( uint32_t value )
+{
+    return value & 4 ? static_cast<int32_t>( value ) - 8 : static_cast<int32_t>( value );
+}
+
+// ETC2 RGB: writes 16 texels, column major like the index bits ( texel = x * 4 + y ), alpha untouched
+static void DecodeEtc2RgbBlock( const uint8_t* block, uint8_t texels[16][4] )
+{
+    static const int32_t kModifiers[8][2] = { { 2, 8 }, { 5, 17 }, { 9, 29 }, { 13, 42 }, { 18, 60 }, { 24, 80 }, { 33, 106 }, { 47, 183 } };
+    static const int32_t kDistances[8] = { 3, 6, 11, 16, 23, 32, 41, 64 };
+
+    uint64_t bits = ReadBigEndian64( block );
+    bool differential = Bits( bits, 33, 33 ) != 0;
+
+    int32_t base[2][3];
+    if( differential )
+    {
+        int32_t r = Bits( bits, 63, 59 ), g = Bits( bits, 55, 51 ), b = Bits( bits, 47, 43 );
+        int32_t r2 = r + SignExtend3( Bits( bits, 58, 56 ) );
+        int32_t g2 = g + SignExtend3( Bits( bits, 50, 48 ) );
+        int32_t b2 = b + SignExtend3( Bits( bits, 42, 40 ) );
+
+        if( r2 < 0 || r2 > 31 || g2 < 0 || g2 > 31 )
+        {
+            // T and H modes: two base colors and a distance, every texel picks one of four paint colors
+            int32_t colors[2][3];
+            uint32_t distanceIndex;
+            bool tMode = r2 < 0 || r2 > 31;
+            if( tMode )
+            {
+                colors[0][0] = Extend4( ( Bits( bits, 60, 59 ) << 2 ) | Bits( bits, 57, 56 ) );
+                colors[0][1] = Extend4( Bits( bits, 55, 52 ) );
+                colors[0][2] = Extend4( Bits( bits, 51, 48 ) );
+                colors[1][0] = Extend4( Bits( bits, 47, 44 ) );
+                colors[1][1] = Extend4( Bits( bits, 43, 40 ) );
+                colors[1][2] = Extend4( Bits( bits, 39, 36 ) );
+                distanceIndex = ( Bits( bits, 35, 34 ) << 1 ) | Bits( bits, 32, 32 );
+            }
+            else
+            {
+                colors[0][0] = Extend4( Bits( bits, 62, 59 ) );
+                colors[0][1] = Extend4( ( Bits( bits, 58, 56 ) << 1 ) | Bits( bits, 52, 52 ) );
+                colors[0][2] = Extend4( ( Bits( bits, 51, 51 ) << 3 ) | Bits( bits, 49, 47 ) );
+                colors[1][0] = Extend4( Bits( bits, 46, 43 ) );
+                colors[1][1] = Extend4( Bits( bits, 42, 39 ) );
+                colors[1][2] = Extend4( Bits( bits, 38, 35 ) );
+                uint32_t order0 = ( colors[0][0] << 16 ) | ( colors[0][1] << 8 ) | colors[0][2];
+                uint32_t order1 = ( colors[1][0] << 16 ) | ( colors[1][1] << 8 ) | colors[1][2];
+                distanceIndex = ( Bits( bits, 34, 34 ) << 2 ) | ( Bits( bits, 32, 32 ) << 1 ) | ( order0 >= order1 ? 1 : 0 );
+            }
+            int32_t distance = kDistances[distanceIndex];
+
+            int32_t paint[4][3];
+            for( uint32_t c = 0; c < 3; c++ )
+            {
+                if( tMode )
+                {
+                    paint[0][c] = colors[0][c];
+                    paint[1][c] = colors[1][c] + distance;
+                    paint[2][c] = colors[1][c];
+                    paint[3][c] = colors[1][c] - distance;
+                }
+                else
+                {
+                    paint[0][c] = colors[0][c] + distance;
+                    paint[1][c] = colors[0][c] - distance;
+                    paint[2][c] = colors[1][c] + distance;
+                    paint[3][c] = colors[1][c] - distance;
+                }
+            }
+            for( uint32_t i = 0; i < 16; i++ )
+            {
+                uint32_t index = ( Bits( bits, 16 + i, 16 + i ) << 1 ) | Bits( bits, i, i );
+                for( uint32_t c = 0; c < 3; c++ )
+                    texels[i][c] = Clamp255( paint[index][c] );
+            }
+            return;
+        }
+
+        if( b2 < 0 || b2 > 31 )
+        {
+            // planar mode: a color gradient from three corner colors
+            int32_t origin[3] = { Extend6( Bits( bits, 62, 57 ) ),
+                                  Extend7( ( Bits( bits, 56, 56 ) << 6 ) | Bits( bits, 54, 49 ) ),
+                                  Extend6( ( Bits( bits, 48, 48 ) << 5 ) | ( Bits( bits, 44, 43 ) << 3 ) | Bits( bits, 41, 39 ) ) };
+            int32_t horizontal[3] = { Extend6( ( Bits( bits, 38, 34 ) << 1 ) | Bits( bits, 32, 32 ) ), Extend7( Bits( bits, 31, 25 ) ), Extend6( Bits( bits, 24, 19 ) ) };
+            int32_t vertical[3] = { Extend6( Bits( bits, 18, 13 ) ), Extend7( Bits( bits, 12, 6 ) ), Extend6( Bits( bits, 5, 0 ) ) };
+            for( int32_t x = 0; x < 4; x++ )
+            {
+                for( int32_t y = 0; y < 4; y++ )
+                {
+                    for( uint32_t c = 0; c < 3; c++ )
+                        texels[x * 4 + y][c] = Clamp255( ( x * ( horizontal[c] - origin[c] ) + y * ( vertical[c] - origin[c] ) + 4 * origin[c] + 2 ) >> 2 );
+                }
+            }
+            return;
+        }
+
+        base[0][0] = Extend5( r );
+        base[0][1] = Extend5( g );
+        base[0][2] = Extend5( b );
+        base[1][0] = Extend5( r2 );
+        base[1][1] = Extend5( g2 );
+        base[1][2] = Extend5( b2 );
+    }
+    else
+    {
+        base[0][0] = Extend4( Bits( bits, 63, 60 ) );
+        base[1][0] = Extend4( Bits( bits, 59, 56 ) );
+        base[0][1] = Extend4( Bits( bits, 55, 52 ) );
+        base[1][1] = Extend4( Bits( bits, 51, 48 ) );
+        base[0][2] = Extend4( Bits( bits, 47, 44 ) );
+        base[1][2] = Extend4( Bits( bits, 43, 40 ) );
+    }
+
+    // individual and differential modes: two sub-blocks, each a base color plus a modifier table
+    uint32_t table[2] = { Bits( bits, 39, 37 ), Bits( bits, 36, 34 ) };
+    bool flip = Bits( bits, 32, 32 ) != 0;
+    for( uint32_t x = 0; x < 4; x++ )
+    {
+        for( uint32_t y = 0; y < 4; y++ )
+        {
+            uint32_t i = x * 4 + y;
+            uint32_t subBlock = flip ? y / 2 : x / 2;
+            uint32_t index = ( Bits( bits, 16 + i, 16 + i ) << 1 ) | Bits( bits, i, i );
+            int32_t modifier = kModifiers[table[subBlock]][index & 1];
+            if( index & 2 )
+                modifier = -modifier;
+            for( uint32_t c = 0; c < 3; c++ )
+                texels[i][c] = Clamp255( base[subBlock][c] + modifier );
+        }
+    }
+}
+
+// EAC alpha of an ETC2 RGBA8 block, column major
+static void DecodeEacAlphaBlock( const uint8_t* block, uint8_t texels[16][4] )
+{
+    static const int32_t kModifiers[16][8] = {
+        { -3, -6, -9, -15, 2, 5, 8, 14 }, { -3, -7, -10, -13, 2, 6, 9, 12 }, { -2, -5, -8, -13, 1, 4, 7, 12 }, { -2, -4, -6, -13, 1, 3, 5, 12 },
+        { -3, -6, -8, -12, 2, 5, 7, 11 },  { -3, -7, -9, -11, 2, 6, 8, 10 },  { -4, -7, -8, -11, 3, 6, 7, 10 },  { -3, -5, -8, -11, 2, 4, 7, 10 },
+        { -2, -6, -8, -10, 1, 5, 7, 9 },   { -2, -5, -8, -10, 1, 4, 7, 9 },   { -2, -4, -8, -10, 1, 3, 7, 9 },   { -2, -5, -7, -10, 1, 4, 6, 9 },
+        { -3, -4, -7, -10, 2, 3, 6, 9 },   { -1, -2, -3, -10, 0, 1, 2, 9 },   { -4, -6, -8, -9, 3, 5, 7, 8 },    { -3, -5, -7, -9, 2, 4, 6, 8 },
+    };
+
+    uint64_t bits = ReadBigEndian64( block );
+    int32_t base = Bits( bits, 63, 56 );
+    int32_t multiplier = Bits( bits, 55, 52 );
+    const int32_t* modifiers = kModifiers[Bits( bits, 51, 48 )];
+    for( uint32_t i = 0; i < 16; i++ )
+    {
+        uint32_t index = Bits( bits, 47 - i * 3, 45 - i * 3 );
+        texels[i][3] = Clamp255( base + modifiers[index] * multiplier );
+    }
+}
+
+// BC1 colors, row major ( texel = y * 4 + x ); alwaysFourColors for the color part of BC3
+static void DecodeBc1Block( const uint8_t* block, bool alwaysFourColors, bool punchThrough, uint8_t texels[16][4] )
+{
+    uint32_t c0 = static_cast<uint32_t>( ReadLittleEndian( block, 2 ) );
+    uint32_t c1 = static_cast<uint32_t>( ReadLittleEndian( block + 2, 2 ) );
+    uint32_t indices = static_cast<uint32_t>( ReadLittleEndian( block + 4, 4 ) );
+
+    int32_t colors[4][4];
+    colors[0][0] = Extend5( c0 >> 11 );
+    colors[0][1] = Extend6( ( c0 >> 5 ) & 63 );
+    colors[0][2] = Extend5( c0 & 31 );
+    colors[1][0] = Extend5( c1 >> 11 );
+    colors[1][1] = Extend6( ( c1 >> 5 ) & 63 );
+    colors[1][2] = Extend5( c1 & 31 );
+    colors[0][3] = colors[1][3] = colors[2][3] = colors[3][3] = 255;
+    for( uint32_t c = 0; c < 3; c++ )
+    {
+        if( c0 > c1 || alwaysFourColors )
+        {
+            colors[2][c] = ( 2 * colors[0][c] + colors[1][c] + 1 ) / 3;
+            colors[3][c] = ( colors[0][c] + 2 * colors[1][c] + 1 ) / 3;
+        }
+        else
+        {
+            colors[2][c] = ( colors[0][c] + colors[1][c] ) / 2;
+            colors[3][c] = 0;
+        }
+    }
+    if( c0 <= c1 && !alwaysFourColors && punchThrough )
+        colors[3][3] = 0;
+
+    for( uint32_t i = 0; i < 16; i++ )
+    {
+        const int32_t* color = colors[( indices >> ( i * 2 ) ) & 3];
+        for( uint32_t c = 0; c < 4; c++ )
+            texels[i][c] = static_cast<uint8_t>( color[c] );
+    }
+}
+
+// BC3 alpha, row major
+static void DecodeBc3AlphaBlock( const uint8_t* block, uint8_t texels[16][4] )
+{
+    int32_t alpha[8];
+    alpha[0] = block[0];
+    alpha[1] = block[1];
+    if( alpha[0] > alpha[1] )
+    {
+        for( int32_t i = 1; i < 7; i++ )
+            alpha[i + 1] = ( ( 7 - i ) * alpha[0] + i * alpha[1] + 3 ) / 7;
+    }
+    else
+    {
+        for( int32_t i = 1; i < 5; i++ )
+            alpha[i + 1] = ( ( 5 - i ) * alpha[0] + i * alpha[1] + 2 ) / 5;
+        alpha[6] = 0;
+        alpha[7] = 255;
+    }
+
+    uint64_t indices = ReadLittleEndian( block + 2, 6 );
+    for( uint32_t i = 0; i < 16; i++ )
+        texels[i][3] = static_cast<uint8_t>( alpha[( indices >> ( i * 3 ) ) & 7] );
+}
+
+VkFormat DecodedBlockFormat( VkFormat format )
+{
+    switch( format )
+    {
+        case VK_FORMAT_ETC2_R8G8B8_UNORM_BLOCK:
+        case VK_FORMAT_ETC2_R8G8B8A8_UNORM_BLOCK:
+        case VK_FORMAT_BC1_RGB_UNORM_BLOCK:
+        case VK_FORMAT_BC1_RGBA_UNORM_BLOCK:
+        case VK_FORMAT_BC3_UNORM_BLOCK:
+            return VK_FORMAT_R8G8B8A8_UNORM;
+        case VK_FORMAT_ETC2_R8G8B8_SRGB_BLOCK:
+        case VK_FORMAT_ETC2_R8G8B8A8_SRGB_BLOCK:
+        case VK_FORMAT_BC1_RGB_SRGB_BLOCK:
+        case VK_FORMAT_BC1_RGBA_SRGB_BLOCK:
+        case VK_FORMAT_BC3_SRGB_BLOCK:
+            return VK_FORMAT_R8G8B8A8_SRGB;
+        default:
+            return VK_FORMAT_UNDEFINED;
+    }
+}
+
+void DecodeBlocks( VkFormat format, const uint8_t* blocks, uint32_t width, uint32_t height, uint8_t* rgba )
+{
+    assert( DecodedBlockFormat( format ) != VK_FORMAT_UNDEFINED );
+
+    bool etc2 = format == VK_FORMAT_ETC2_R8G8B8_UNORM_BLOCK || format == VK_FORMAT_ETC2_R8G8B8_SRGB_BLOCK ||
+                format == VK_FORMAT_ETC2_R8G8B8A8_UNORM_BLOCK || format == VK_FORMAT_ETC2_R8G8B8A8_SRGB_BLOCK;
+    bool separateAlpha = format == VK_FORMAT_ETC2_R8G8B8A8_UNORM_BLOCK || format == VK_FORMAT_ETC2_R8G8B8A8_SRGB_BLOCK ||
+                         format == VK_FORMAT_BC3_UNORM_BLOCK || format == VK_FORMAT_BC3_SRGB_BLOCK;
+    bool punchThrough = format == VK_FORMAT_BC1_RGBA_UNORM_BLOCK || format == VK_FORMAT_BC1_RGBA_SRGB_BLOCK;
+    uint32_t blockSize = separateAlpha ? 16 : 8;
+
+    uint32_t blocksX = ( width + kBlockExtent - 1 ) / kBlockExtent;
+    uint32_t blocksY = ( height + kBlockExtent - 1 ) / kBlockExtent;
+    for( uint32_t by = 0; by < blocksY; by++ )
+    {
+        for( uint32_t bx = 0; bx < blocksX; bx++ )
+        {
+            const uint8_t* block = blocks + ( static_cast<size_t>( by ) * blocksX + bx ) * blockSize;
+
+            uint8_t texels[16][4];
+            if( etc2 )
+            {
+                for( auto& texel : texels )
+                    texel[3] = 255;
+                if( separateAlpha )
+                    DecodeEacAlphaBlock( block, texels );
+                DecodeEtc2RgbBlock( separateAlpha ? block + 8 : block, texels );
+            }
+            else
+            {
+                DecodeBc1Block( separateAlpha ? block + 8 : block, separateAlpha, punchThrough, texels );
+                if( separateAlpha )
+                    DecodeBc3AlphaBlock( block, texels );
+            }
+
+            // ETC2 numbers texels column by column, BC row by row
+            for( uint32_t y = 0; y < kBlockExtent && by * kBlockExtent + y < height; y++ )
+            {
+                for( uint32_t x = 0; x < kBlockExtent && bx * kBlockExtent + x < width; x++ )
+                {
+                    const uint8_t* texel = texels[etc2 ? x * 4 + y : y * 4 + x];
+                    uint8_t* dst = rgba + ( static_cast<size_t>( by * kBlockExtent + y ) * width + bx * kBlockExtent + x ) * 4;
+                    dst[0] = texel[0];
+                    dst[1] = texel[1];
+                    dst[2] = texel[2];
+                    dst[3] = texel[3];
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,40 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#ifndef TUTORIAL06_TEXTURE_BLOCKDECODER_H
+#define TUTORIAL06_TEXTURE_BLOCKDECODER_H
+
+#include <vulkan_wrapper.h>
+#include <cstdint>
+
+/*
+ * BlockDecoder
+ *   CPU decoding of block compressed texels into RGBA8, for devices that
+ *   cannot sample the compressed format. Decoding is the slow fallback,
+ *   the blocks are uploaded as they are whenever the device supports them.
+ *
+ *   Decodable: ETC2 RGB8, ETC2 RGBA8 (EAC alpha), BC1 and BC3, UNORM and
+ *   SRGB. ASTC, BC7 and the other formats are not.
+ */
+
+// VK_FORMAT_R8G8B8A8_UNORM / _SRGB matching format, VK_FORMAT_UNDEFINED if it cannot be decoded
+VkFormat DecodedBlockFormat( VkFormat format );
+
+// Decodes the blocks of a width x height level into tightly packed RGBA8 texels
+void DecodeBlocks( VkFormat format, const uint8_t* blocks, uint32_t width, uint32_t height, uint8_t* rgba );
+
+#endif // TUTORIAL06_TEXTURE_BLOCKDECODER_H
@@ -16,8 +16,135 @@
  */
 
 #include "CreateShaderModule.h"
+#include "FileUtils.h"
 #include <android/log.h>
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <unistd.h>
+#ifdef VKTUTS_BENCHMARK
+#include <chrono>
+#endif
+#ifdef VKTUTS_RUNTIME_SHADERC
 #include <shaderc/shaderc.hpp>
+#include "SpirvOptimizer.h"
+#endif
+
+static const uint32_t kSpirvMagic = 0x07230203;
+
+static VkResult createShaderModule(VkDevice vkDevice, const void* code, size_t size,
+                                   VkShaderModule* shaderOut) {
+    VkShaderModuleCreateInfo shaderModuleCreateInfo;
+    shaderModuleCreateInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+    shaderModuleCreateInfo.pNext = nullptr;
+    shaderModuleCreateInfo.codeSize = size;
+    shaderModuleCreateInfo.pCode = static_cast<const uint32_t*>(code);
+    shaderModuleCreateInfo.flags = 0;
+    return vkCreateShaderModule(vkDevice, &shaderModuleCreateInfo, nullptr, shaderOut);
+}
+
+static bool isSpirv(const std::vector<uint8_t>& code) {
+    return code.size() >= 4 && code.size() % 4 == 0 &&
+           *reinterpret_cast<const uint32_t*>(code.data()) == kSpirvMagic;
+}
+
+// Copies a SPIR-V file read as bytes into words, false if it is no SPIR-V
+static bool spirvWords(const std::vector<uint8_t>& code, std::vector<uint32_t>* spirv) {
+    if (!isSpirv(code)) {
+        return false;
+    }
+    spirv->resize(code.size() / sizeof(uint32_t));
+    memcpy(spirv->data(), code.data(), code.size());
+    return true;
+}
+
+#ifndef VKTUTS_RUNTIME_SHADERC
+
+VkResult buildShaderFromFile(android_app* appInfo, const char* filePath,
+                             VkShaderStageFlagBits type, VkDevice vkDevice,
+                             VkShaderModule* shaderOut) {
+    std::vector<uint32_t> spirv;
+    if (!loadShaderSpirv(appInfo, filePath, type, &spirv)) {
+        return static_cast<VkResult>(-1);
+    }
+    return createShaderModule(vkDevice, spirv.data(), spirv.size() * sizeof(uint32_t), shaderOut);
+}
+
+// SPIR-V the build compiled from the given glsl shader file
+// filePath: glsl shader file (including path ) in APK's asset folder, its SPIR-V is filePath + ".spv"
+bool loadShaderSpirv(android_app* appInfo, const char* filePath, VkShaderStageFlagBits,
+                     std::vector<uint32_t>* spirv) {
+    std::string spvPath = std::string(filePath) + ".spv";
+    AAsset* file = AAssetManager_open(appInfo->activity->assetManager, spvPath.c_str(),
+                                      AASSET_MODE_BUFFER);
+    if (!file) {
+        __android_log_print(ANDROID_LOG_ERROR, "Vulkan-Tutorial06",
+                            "%s missing, shaders are compiled by the build", spvPath.c_str());
+        return false;
+    }
+    std::vector<uint8_t> code(AAsset_getLength(file));
+    AAsset_read(file, code.data(), code.size());
+    AAsset_close(file);
+
+    return spirvWords(code, spirv);
+}
+
+#else  // VKTUTS_RUNTIME_SHADERC
+
+// Identifies the linked libshaderc.a (set by CMake), a different build may produce different SPIR-V
+#ifndef VKTUTS_SHADERC_VERSION
+#define VKTUTS_SHADERC_VERSION "unknown"
+#endif
+static const char* kEntryPoint = "main";
+
+// Directory whose files replace the APK's assets of the same path, empty for none
+static std::string shaderOverrideDir;
+
+void setShaderOverrideDirectory(const char* dir) {
+    shaderOverrideDir = dir ? dir : "";
+}
+
+// GLSL of filePath, from the override directory if it has the file, from the APK otherwise
+static bool readGlsl(android_app* appInfo, const char* filePath, std::vector<char>* glslShader) {
+    std::vector<uint8_t> content;
+    if (!shaderOverrideDir.empty() &&
+        ReadFile((shaderOverrideDir + "/" + filePath).c_str(), &content)) {
+        glslShader->assign(content.begin(), content.end());
+        return true;
+    }
+    AAsset* file = AAssetManager_open(appInfo->activity->assetManager, filePath,
+                                      AASSET_MODE_BUFFER);
+    if (!file) {
+        return false;
+    }
+    glslShader->resize(AAsset_getLength(file));
+    AAsset_read(file, glslShader->data(), glslShader->size());
+    AAsset_close(file);
+    return true;
+}
+
+// One compiler and option set for the whole run. shaderc_compile_into_spv only reads them,
+// so every job thread compiles with the same pair without locking.
+struct ShadercContext {
+    shaderc_compiler_t compiler;
+    shaderc_compile_options_t options;
+
+    ShadercContext()
+            : compiler(shaderc_compiler_initialize()),
+              options(shaderc_compile_options_initialize()) {
+        shaderc_compile_options_set_target_env(options, shaderc_target_env_vulkan, 0);
+    }
+    ~ShadercContext() {
+        shaderc_compile_options_release(options);
+        shaderc_compiler_release(compiler);
+    }
+};
+
+static const ShadercContext& shadercContext() {
+    static ShadercContext context;
+    return context;
+}
 
 // Translate Vulkan Shader Type to shaderc shader type
 shaderc_shader_kind getShadercShaderType(VkShaderStageFlagBits type) {
@@ -41,43 +168,234 @@ shaderc_shader_kind getShadercShaderType(VkShaderStageFlagBits type) {
     return static_cast<shaderc_shader_kind>(-1);
 }
 
-// Create VK shader module from given glsl shader file
+// Content address of a compiled shader: a hash of everything that changes the SPIR-V shaderc produces
+static uint64_t spirvCacheKey(const std::vector<char>& glslShader, shaderc_shader_kind kind) {
+    unsigned int spvVersion, spvRevision;
+    shaderc_get_spv_version(&spvVersion, &spvRevision);
+
+    uint64_t hash = Fnv1a64(glslShader.data(), glslShader.size());
+    hash = Fnv1a64(&kind, sizeof(kind), hash);
+    hash = Fnv1a64(kEntryPoint, strlen(kEntryPoint), hash);
+    hash = Fnv1a64(SpirvOptimizationName(), strlen(SpirvOptimizationName()), hash);
+    hash = Fnv1a64(VKTUTS_SHADERC_VERSION, strlen(VKTUTS_SHADERC_VERSION), hash);
+    hash = Fnv1a64(&spvVersion, sizeof(spvVersion), hash);
+    return Fnv1a64(&spvRevision, sizeof(spvRevision), hash);
+}
+
+// Cached SPIR-V file of a key, inside the app's private storage
+static std::string spirvCachePath(android_app* appInfo, uint64_t key) {
+    std::string dir = std::string(appInfo->activity->internalDataPath) + "/spirv_cache";
+    MakeDirectory(dir.c_str());
+    char name[32];
+    snprintf(name, sizeof(name), "/%016" PRIx64 ".spv", key);
+    return dir + name;
+}
+
+// Compiles glsl into spirv, run through the configured spirv-tools passes if optimize is set
+static bool compileGlsl(const std::vector<char>& glslShader, shaderc_shader_kind kind,
+                        const char* fileName, bool optimize, std::vector<uint32_t>* spirv) {
+    const ShadercContext& context = shadercContext();
+    shaderc_compilation_result_t spvShader = shaderc_compile_into_spv(
+            context.compiler, glslShader.data(), glslShader.size(), kind,
+            fileName, kEntryPoint, context.options);
+    bool compiled = shaderc_result_get_compilation_status(spvShader) ==
+                    shaderc_compilation_status_success;
+    if (compiled) {
+        const uint32_t* code = reinterpret_cast<const uint32_t*>(shaderc_result_get_bytes(spvShader));
+        size_t wordCount = shaderc_result_get_length(spvShader) / sizeof(uint32_t);
+        spirv->assign(code, code + wordCount);
+    } else {
+        __android_log_print(ANDROID_LOG_ERROR, "Vulkan-Tutorial06", "%s",
+                            shaderc_result_get_error_message(spvShader));
+    }
+    shaderc_result_release(spvShader);
+
+    if (compiled && optimize && !OptimizeSpirv(spirv->data(), spirv->size(), spirv)) {
+        return false;
+    }
+    return compiled;
+}
+
+// SPIR-V of the given glsl shader file, compiled on the device (dev mode)
 // filePath: glsl shader file (including path ) in APK's asset folder
-VkResult buildShaderFromFile(android_app* appInfo, const char* filePath,
-                             VkShaderStageFlagBits type, VkDevice vkDevice,
-                             VkShaderModule* shaderOut) {
+// Nothing is written to the cache, *cached tells whether spirv came from the file at *cachePath.
+static bool loadSpirv(android_app* appInfo, const char* filePath, VkShaderStageFlagBits type,
+                      bool useCache, std::vector<uint32_t>* spirv, std::string* cachePath,
+                      bool* cached) {
     // read file from Assets
-    AAsset* file = AAssetManager_open(appInfo->activity->assetManager, filePath,
-                                      AASSET_MODE_BUFFER);
-    size_t glslShaderLen = AAsset_getLength(file);
     std::vector<char> glslShader;
-    glslShader.resize(glslShaderLen);
+    if (!readGlsl(appInfo, filePath, &glslShader)) {
+        return false;
+    }
 
-    AAsset_read(file, static_cast<void*>(glslShader.data()), glslShaderLen);
-    AAsset_close(file);
+#ifdef VKTUTS_BENCHMARK
+    auto start = std::chrono::steady_clock::now();
+#endif
 
-    // compile into spir-V shader
-    shaderc_compiler_t compiler = shaderc_compiler_initialize();
-    shaderc_compilation_result_t spvShader = shaderc_compile_into_spv(
-            compiler, glslShader.data(), glslShaderLen, getShadercShaderType(type),
-            "shaderc_error", "main", nullptr);
-    if (shaderc_result_get_compilation_status(spvShader) !=
-        shaderc_compilation_status_success) {
-        return static_cast<VkResult>(-1);
+    // SPIR-V compiled by an earlier run from the same source and options
+    shaderc_shader_kind kind = getShadercShaderType(type);
+    *cachePath = spirvCachePath(appInfo, spirvCacheKey(glslShader, kind));
+    std::vector<uint8_t> content;
+    *cached = useCache && ReadFile(cachePath->c_str(), &content) && spirvWords(content, spirv);
+    if (*cached) {
+#ifdef VKTUTS_BENCHMARK
+        __android_log_print(ANDROID_LOG_INFO, "Vulkan-Tutorial06", "shader %s: cached, %.3f ms", filePath,
+                            std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+#endif
+        return true;
+    }
+    // compile into optimized spir-V shader
+    if (!compileGlsl(glslShader, kind, filePath, true, spirv)) {
+        return false;
     }
 
-    // build vulkan shader module
-    VkShaderModuleCreateInfo shaderModuleCreateInfo;
-    shaderModuleCreateInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
-    shaderModuleCreateInfo.pNext = nullptr;
-    shaderModuleCreateInfo.codeSize = shaderc_result_get_length(spvShader);
-    shaderModuleCreateInfo.pCode = (const uint32_t*)shaderc_result_get_bytes(spvShader);
-    shaderModuleCreateInfo.flags = 0;
-    VkResult result = vkCreateShaderModule(vkDevice, &shaderModuleCreateInfo,
-                                           nullptr, shaderOut);
+#ifdef VKTUTS_BENCHMARK
+    __android_log_print(ANDROID_LOG_INFO, "Vulkan-Tutorial06", "shader %s: compiled, %.3f ms", filePath,
+                        std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+#endif
+    return true;
+}
 
-    shaderc_result_release(spvShader);
-    shaderc_compiler_release(compiler);
+bool loadShaderSpirv(android_app* appInfo, const char* filePath, VkShaderStageFlagBits type,
+                     std::vector<uint32_t>* spirv) {
+    std::string cachePath;
+    bool cached;
+    return loadSpirv(appInfo, filePath, type, true, spirv, &cachePath, &cached);
+}
 
+VkResult buildShaderFromFile(android_app* appInfo, const char* filePath,
+                             VkShaderStageFlagBits type, VkDevice vkDevice,
+                             VkShaderModule* shaderOut) {
+    std::vector<uint32_t> spirv;
+    std::string cachePath;
+    bool cached;
+    if (!loadSpirv(appInfo, filePath, type, true, &spirv, &cachePath, &cached)) {
+        return static_cast<VkResult>(-1);
+    }
+    VkResult result = createShaderModule(vkDevice, spirv.data(), spirv.size() * sizeof(uint32_t), shaderOut);
+    if (result != VK_SUCCESS && cached) {
+        // the driver rejects what an earlier run cached: drop the file and compile once more
+        __android_log_print(ANDROID_LOG_WARN, "Vulkan-Tutorial06",
+                            "shader %s: cached SPIR-V rejected (%d), compiling again", filePath, result);
+        unlink(cachePath.c_str());
+        if (!loadSpirv(appInfo, filePath, type, false, &spirv, &cachePath, &cached)) {
+            return static_cast<VkResult>(-1);
+        }
+        result = createShaderModule(vkDevice, spirv.data(), spirv.size() * sizeof(uint32_t), shaderOut);
+    }
+    // only SPIR-V this driver accepted is kept for the next run
+    if (result == VK_SUCCESS && !cached) {
+        WriteFileAtomic(cachePath.c_str(), spirv.data(), spirv.size() * sizeof(uint32_t));
+    }
     return result;
 }
+
+#ifdef VKTUTS_BENCHMARK
+// Shader kind from the file extension, glslc's convention
+static bool shaderKindFromName(const std::string& name, shaderc_shader_kind* kind) {
+    static const struct {
+        const char* extension;
+        shaderc_shader_kind kind;
+    } kExtensions[] = {
+            {".vert", shaderc_glsl_vertex_shader},
+            {".frag", shaderc_glsl_fragment_shader},
+            {".comp", shaderc_glsl_compute_shader},
+            {".geom", shaderc_glsl_geometry_shader},
+            {".tesc", shaderc_glsl_tess_control_shader},
+            {".tese", shaderc_glsl_tess_evaluation_shader},
+    };
+    for (const auto& entry : kExtensions) {
+        size_t length = strlen(entry.extension);
+        if (name.size() > length && name.compare(name.size() - length, length, entry.extension) == 0) {
+            *kind = entry.kind;
+            return true;
+        }
+    }
+    return false;
+}
+
+void reportShaderOptimization(android_app* appInfo) {
+    AAssetDir* dir = AAssetManager_openDir(appInfo->activity->assetManager, "shaders");
+    while (const char* name = AAssetDir_getNextFileName(dir)) {
+        shaderc_shader_kind kind;
+        if (!shaderKindFromName(name, &kind)) {
+            continue;
+        }
+        std::string path = std::string("shaders/") + name;
+        AAsset* file = AAssetManager_open(appInfo->activity->assetManager, path.c_str(),
+                                          AASSET_MODE_BUFFER);
+        std::vector<char> glslShader(AAsset_getLength(file));
+        AAsset_read(file, glslShader.data(), glslShader.size());
+        AAsset_close(file);
+
+        std::vector<uint32_t> before, after;
+        if (!compileGlsl(glslShader, kind, name, false, &before) ||
+            !compileGlsl(glslShader, kind, name, true, &after)) {
+            continue;
+        }
+        SpirvStats beforeStats = GetSpirvStats(before.data(), before.size());
+        SpirvStats afterStats = GetSpirvStats(after.data(), after.size());
+        __android_log_print(ANDROID_LOG_INFO, "Vulkan-Tutorial06",
+                            "spirv-opt (%s) %s: %zu -> %zu bytes, %u -> %u instructions",
+                            SpirvOptimizationName(), name, beforeStats.bytes_, afterStats.bytes_,
+                            beforeStats.instructions_, afterStats.instructions_);
+    }
+    AAssetDir_close(dir);
+}
+
+// Fragment shader of a given variant, the loop count and constants differ between variants
+static std::vector<char> syntheticShader(uint32_t variant) {
+    char source[512];
+    int length = snprintf(source, sizeof(source),
+                          "#version 400\n"
+                          "layout (location = 0) in vec2 texcoord;\n"
+                          "layout (location = 0) out vec4 uFragColor;\n"
+                          "void main() {\n"
+                          "    vec4 color = vec4(0.0);\n"
+                          "    for (int i = 0; i < %u; i++) {\n"
+                          "        color += sin(vec4(texcoord, texcoord.yx) * float(i + %u));\n"
+                          "    }\n"
+                          "    uFragColor = color;\n"
+                          "}\n",
+                          4 + variant % 8, variant + 1);
+    return std::vector<char>(source, source + length);
+}
+
+void benchmarkShaderCompiles(JobSystem* jobSystem, uint32_t shaderCount) {
+    std::vector<std::vector<char>> sources;
+    for (uint32_t i = 0; i < shaderCount; i++) {
+        sources.push_back(syntheticShader(i));
+    }
+    std::vector<std::vector<uint32_t>> spirv(shaderCount);
+
+    // what every shader paid before the compiler was shared
+    auto start = std::chrono::steady_clock::now();
+    shaderc_compiler_release(shaderc_compiler_initialize());
+    double initMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < shaderCount; i++) {
+        compileGlsl(sources[i], shaderc_glsl_fragment_shader, "synthetic.frag", true, &spirv[i]);
+    }
+    double serialMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    // each job writes its own result slot
+    start = std::chrono::steady_clock::now();
+    JobCounter counter;
+    for (uint32_t i = 0; i < shaderCount; i++) {
+        jobSystem->Submit([&sources, &spirv, i]() {
+            compileGlsl(sources[i], shaderc_glsl_fragment_shader, "synthetic.frag", true, &spirv[i]);
+        }, &counter);
+    }
+    jobSystem->Wait(counter);
+    double parallelMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    __android_log_print(ANDROID_LOG_INFO, "Vulkan-Tutorial06",
+                        "shaderc: %u synthetic shaders, serial %.3f ms, %u threads %.3f ms (%.2fx), "
+                        "compiler init %.3f ms",
+                        shaderCount, serialMs, jobSystem->ThreadCount(), parallelMs,
+                        serialMs / parallelMs, initMs);
+}
+#endif
+
+#endif  // VKTUTS_RUNTIME_SHADERC
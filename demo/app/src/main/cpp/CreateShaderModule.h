@@ -20,9 +20,14 @@
 
 #include <vulkan_wrapper.h>
 #include <android_native_app_glue.h>
+#include <vector>
+#include "JobSystem.h"
 /*
  * buildShaderFromFile()
  *   Create a Vulkan shader module from the given glsl shader file
+ *   By default the build compiles every shader to SPIR-V with glslc and this
+ *   loads filePath + ".spv". With VKTUTS_RUNTIME_SHADERC (dev mode) the glsl
+ *   source is compiled on the device instead:
  *   Input shader is compiled with shaderc (https://github.com/google/shaderc)
  *   prebuilt binary on github (https://github.com/ggfan/shaderc/release)
  *
@@ -31,6 +36,12 @@
  *   Refer to full documentation from the above homepage
  *
  *   feedback for CDep is very welcome to the https://github.com/google/cdep
+ *
+ *   Runtime compiled SPIR-V is cached in the app's private storage (spirv_cache/),
+ *   keyed by a hash of the source, stage, entry point, compile options and
+ *   shaderc build; later runs load it instead of compiling again. It is
+ *   written once the driver accepted a module made from it; cached SPIR-V
+ *   the driver rejects is deleted and compiled again.
  * Input:
  *     appInfo:   android_app, from which get AAssertManager*
  *     filePaht:  shader file full name with path inside APK/assets
@@ -50,4 +61,32 @@ VkResult buildShaderFromFile(
         VkDevice vkDevice,
         VkShaderModule* shaderOut);
 
+/*
+ * loadShaderSpirv()
+ *   The SPIR-V buildShaderFromFile() makes its module from, for callers that
+ *   also need to look at the code itself (reflection). Same sources and
+ *   cache as buildShaderFromFile(), which alone writes the cache.
+ * Return:
+ *     true: the module's words are in spirv
+ */
+bool loadShaderSpirv(
+        android_app* appInfo,
+        const char* filePath,
+        VkShaderStageFlagBits type,
+        std::vector<uint32_t>* spirv);
+
+#ifdef VKTUTS_RUNTIME_SHADERC
+// Shaders are read from dir + "/" + filePath where that file exists, the APK's assets
+// otherwise. Set it before the first build; nullptr turns it off.
+void setShaderOverrideDirectory(const char* dir);
+#endif
+
+#if defined(VKTUTS_RUNTIME_SHADERC) && defined(VKTUTS_BENCHMARK)
+// Logs SPIR-V size and instruction count of every shader in assets/shaders before and after spirv-opt
+void reportShaderOptimization(android_app* appInfo);
+
+// Logs how long shaderCount synthetic shader variants take to compile, one after another and on jobSystem
+void benchmarkShaderCompiles(JobSystem* jobSystem, uint32_t shaderCount);
+#endif
+
 #endif // TUTORIAL06_TEXTURE_CREATESHADERMODULE_H
@@ -0,0 +1,238 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include "DescriptorAllocator.h"
+#include <android/log.h>
+#include <cassert>
+#ifdef VKTUTS_BENCHMARK
+#include <chrono>
+#endif
+
+void DescriptorAllocator::Init( VkDevice device, const std::vector<VkDescriptorPoolSize>& setSizes, uint32_t setsPerPool, uint32_t frameCount )
+{
+    assert( setsPerPool > 0 );
+    device_ = device;
+    setsPerPool_ = setsPerPool;
+    setSizes_ = setSizes;
+    poolSizes_ = setSizes;
+    for( auto& size : poolSizes_ )
+        size.descriptorCount *= setsPerPool;
+    static_ = PoolChain();
+    frames_.assign( frameCount, PoolChain() );
+    allocations_ = 0;
+    poolGrowths_ = 0;
+    frameResets_ = 0;
+}
+
+void DescriptorAllocator::Shutdown( void )
+{
+    for( auto pool : static_.pools_ )
+        vkDestroyDescriptorPool( device_, pool, nullptr );
+    for( auto& chain : frames_ )
+    {
+        for( auto pool : chain.pools_ )
+            vkDestroyDescriptorPool( device_, pool, nullptr );
+    }
+    static_ = PoolChain();
+    frames_.clear();
+}
+
+VkResult DescriptorAllocator::AllocateFromChain( PoolChain& chain, VkDescriptorSetLayout layout, VkDescriptorSet* set )
+{
+    for( ;; )
+    {
+        bool created = false;
+        if( chain.current_ == chain.pools_.size() )
+        {
+            VkDescriptorPoolCreateInfo poolCreateInfo;
+            poolCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+            poolCreateInfo.pNext = nullptr;
+            poolCreateInfo.flags = 0;
+            poolCreateInfo.maxSets = setsPerPool_;
+            poolCreateInfo.poolSizeCount = static_cast<uint32_t>( poolSizes_.size() );
+            poolCreateInfo.pPoolSizes = poolSizes_.data();
+
+            VkDescriptorPool pool;
+            VkResult result = vkCreateDescriptorPool( device_, &poolCreateInfo, nullptr, &pool );
+            if( result != VK_SUCCESS )
+                return result;
+            chain.pools_.push_back( pool );
+            chain.setsUsed_ = 0;
+            poolGrowths_++;
+            created = true;
+        }
+
+        // a full pool is skipped without asking the driver, Vulkan 1.0 drivers need not report it
+        if( chain.setsUsed_ < setsPerPool_ )
+        {
+            VkDescriptorSetAllocateInfo allocateInfo;
+            allocateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+            allocateInfo.pNext = nullptr;
+            allocateInfo.descriptorPool = chain.pools_[chain.current_];
+            allocateInfo.descriptorSetCount = 1;
+            allocateInfo.pSetLayouts = &layout;
+
+            VkResult result = vkAllocateDescriptorSets( device_, &allocateInfo, set );
+            if( result == VK_SUCCESS )
+            {
+                chain.setsUsed_++;
+                allocations_++;
+                return VK_SUCCESS;
+            }
+            // layout needs more descriptors than a whole pool holds, another pool would not help
+            if( created || ( result != VK_ERROR_OUT_OF_POOL_MEMORY_KHR && result != VK_ERROR_FRAGMENTED_POOL ) )
+                return result;
+        }
+        chain.current_++;
+        chain.setsUsed_ = 0;
+    }
+}
+
+VkResult DescriptorAllocator::Allocate( VkDescriptorSetLayout layout, VkDescriptorSet* set )
+{
+    return AllocateFromChain( static_, layout, set );
+}
+
+VkResult DescriptorAllocator::AllocateFrame( uint32_t frame, VkDescriptorSetLayout layout, VkDescriptorSet* set )
+{
+    assert( frame < frames_.size() );
+    return AllocateFromChain( frames_[frame], layout, set );
+}
+
+void DescriptorAllocator::ResetFrame( uint32_t frame )
+{
+    assert( frame < frames_.size() );
+    PoolChain& chain = frames_[frame];
+    // pools past current_ were not touched since the last reset
+    for( uint32_t i = 0; i <= chain.current_ && i < chain.pools_.size(); i++ )
+    {
+        vkResetDescriptorPool( device_, chain.pools_[i], 0 );
+        frameResets_++;
+    }
+    chain.current_ = 0;
+    chain.setsUsed_ = 0;
+}
+
+DescriptorAllocatorStats DescriptorAllocator::Stats( void ) const
+{
+    DescriptorAllocatorStats stats;
+    stats.poolCount_ = static_cast<uint32_t>( static_.pools_.size() );
+    for( const auto& chain : frames_ )
+        stats.poolCount_ += static_cast<uint32_t>( chain.pools_.size() );
+    stats.allocations_ = allocations_;
+    stats.poolGrowths_ = poolGrowths_;
+    stats.frameResets_ = frameResets_;
+    return stats;
+}
+
+std::vector<VkDescriptorPoolSize> DescriptorSetSizes( const std::vector<VkDescriptorSetLayoutBinding>& bindings )
+{
+    std::vector<VkDescriptorPoolSize> sizes;
+    for( const auto& binding : bindings )
+    {
+        // runtime sized arrays are sized by their own table, see BindlessTextureTable
+        if( binding.descriptorCount == 0 )
+            continue;
+        bool found = false;
+        for( auto& size : sizes )
+        {
+            if( size.type == binding.descriptorType )
+            {
+                size.descriptorCount += binding.descriptorCount;
+                found = true;
+            }
+        }
+        if( !found )
+            sizes.push_back( { binding.descriptorType, binding.descriptorCount } );
+    }
+    return sizes;
+}
+
+#ifdef VKTUTS_BENCHMARK
+void BenchmarkDescriptorAllocation( VkDevice device, VkDescriptorSetLayout layout, const std::vector<VkDescriptorPoolSize>& setSizes )
+{
+    // 100k sets over 100 frames of 1000 sets each
+    const uint32_t kSets = 100000;
+    const uint32_t kSetsPerFrame = 1000;
+    const uint32_t kFrames = 2;
+
+    // before: a pool sized for exactly one set, destroyed with its set
+    VkDescriptorPoolCreateInfo poolCreateInfo;
+    poolCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    poolCreateInfo.pNext = nullptr;
+    poolCreateInfo.flags = 0;
+    poolCreateInfo.maxSets = 1;
+    poolCreateInfo.poolSizeCount = static_cast<uint32_t>( setSizes.size() );
+    poolCreateInfo.pPoolSizes = setSizes.data();
+
+    VkDescriptorSetAllocateInfo allocateInfo;
+    allocateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    allocateInfo.pNext = nullptr;
+    allocateInfo.descriptorSetCount = 1;
+    allocateInfo.pSetLayouts = &layout;
+
+    std::vector<VkDescriptorPool> framePools;
+    framePools.reserve( kSetsPerFrame );
+    uint32_t failures = 0;
+    auto start = std::chrono::steady_clock::now();
+    for( uint32_t i = 0; i < kSets; i++ )
+    {
+        VkDescriptorPool pool;
+        VkDescriptorSet set;
+        if( vkCreateDescriptorPool( device, &poolCreateInfo, nullptr, &pool ) != VK_SUCCESS )
+        {
+            failures++;
+            continue;
+        }
+        allocateInfo.descriptorPool = pool;
+        if( vkAllocateDescriptorSets( device, &allocateInfo, &set ) != VK_SUCCESS )
+            failures++;
+        framePools.push_back( pool );
+        if( framePools.size() == kSetsPerFrame )
+        {
+            for( auto framePool : framePools )
+                vkDestroyDescriptorPool( device, framePool, nullptr );
+            framePools.clear();
+        }
+    }
+    for( auto framePool : framePools )
+        vkDestroyDescriptorPool( device, framePool, nullptr );
+    double poolPerSetSeconds = std::chrono::duration<double>( std::chrono::steady_clock::now() - start ).count();
+
+    // after: per-frame pool chains, reset when the frame comes around again
+    DescriptorAllocator allocator;
+    allocator.Init( device, setSizes, 256, kFrames );
+    start = std::chrono::steady_clock::now();
+    for( uint32_t i = 0; i < kSets; i++ )
+    {
+        uint32_t frame = ( i / kSetsPerFrame ) % kFrames;
+        if( i % kSetsPerFrame == 0 )
+            allocator.ResetFrame( frame );
+        VkDescriptorSet set;
+        if( allocator.AllocateFrame( frame, layout, &set ) != VK_SUCCESS )
+            failures++;
+    }
+    double allocatorSeconds = std::chrono::duration<double>( std::chrono::steady_clock::now() - start ).count();
+    DescriptorAllocatorStats stats = allocator.Stats();
+    allocator.Shutdown();
+
+    __android_log_print( ANDROID_LOG_INFO, "Vulkan-Tutorial06",
+                         "descriptor sets: pool per set %.0f sets/s, frame pools %.0f sets/s (%u pools, %llu resets), %u failed",
+                         kSets / poolPerSetSeconds, kSets / allocatorSeconds, stats.poolCount_,
+                         static_cast<unsigned long long>( stats.frameResets_ ), failures );
+}
+#endif
@@ -0,0 +1,95 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#ifndef TUTORIAL06_TEXTURE_DESCRIPTORALLOCATOR_H
+#define TUTORIAL06_TEXTURE_DESCRIPTORALLOCATOR_H
+
+#include <vulkan_wrapper.h>
+#include <vector>
+
+struct DescriptorAllocatorStats
+{
+    uint32_t poolCount_;     // live VkDescriptorPools, frame pools included
+    uint64_t allocations_;   // sets allocated since Init()
+    uint64_t poolGrowths_;   // pools created because a chain was full
+    uint64_t frameResets_;   // vkResetDescriptorPool calls
+};
+
+/*
+ * DescriptorAllocator
+ *   Hands out descriptor sets from chains of pools that grow on demand.
+ *   Every pool holds setsPerPool sets of the size given to Init(); once one
+ *   is full, or the driver reports VK_ERROR_OUT_OF_POOL_MEMORY or
+ *   VK_ERROR_FRAGMENTED_POOL, the next pool of the chain is used and a new
+ *   one is created when there is none.
+ *
+ *   Allocate() sets live until Shutdown(). AllocateFrame() sets belong to
+ *   one frame in flight: ResetFrame() returns all of them at once with
+ *   vkResetDescriptorPool after that frame's fence, keeping the pools for
+ *   the next time the frame comes around. No pool is created with
+ *   VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT, sets are never freed
+ *   one by one.
+ *
+ *   Not thread safe, sets are allocated by the render thread.
+ */
+class DescriptorAllocator
+{
+public:
+    // setSizes: descriptors of each type one set needs at most
+    void Init( VkDevice device, const std::vector<VkDescriptorPoolSize>& setSizes, uint32_t setsPerPool, uint32_t frameCount );
+    // destroys every pool and with them every set
+    void Shutdown( void );
+
+    VkResult Allocate( VkDescriptorSetLayout layout, VkDescriptorSet* set );
+    VkResult AllocateFrame( uint32_t frame, VkDescriptorSetLayout layout, VkDescriptorSet* set );
+    // frame's sets become invalid, the GPU must be done with them
+    void ResetFrame( uint32_t frame );
+
+    DescriptorAllocatorStats Stats( void ) const;
+    const std::vector<VkDescriptorPoolSize>& SetSizes( void ) const { return setSizes_; }
+
+private:
+    struct PoolChain
+    {
+        std::vector<VkDescriptorPool> pools_;
+        uint32_t current_;   // pool allocations come from, pools_.size() when a new one is needed
+        uint32_t setsUsed_;  // sets allocated from pools_[current_]
+    };
+
+    VkResult AllocateFromChain( PoolChain& chain, VkDescriptorSetLayout layout, VkDescriptorSet* set );
+
+    VkDevice device_;
+    std::vector<VkDescriptorPoolSize> setSizes_;
+    std::vector<VkDescriptorPoolSize> poolSizes_; // setSizes scaled to setsPerPool
+    uint32_t setsPerPool_;
+    PoolChain static_;
+    std::vector<PoolChain> frames_;
+    uint64_t allocations_;
+    uint64_t poolGrowths_;
+    uint64_t frameResets_;
+};
+
+// Descriptors of each type a set with these bindings holds, for DescriptorAllocator::Init()
+std::vector<VkDescriptorPoolSize> DescriptorSetSizes( const std::vector<VkDescriptorSetLayoutBinding>& bindings );
+
+#ifdef VKTUTS_BENCHMARK
+// Allocates sets of layout the way CreateDescriptorSet() used to, one pool per set,
+// and from per-frame DescriptorAllocator pools; logs sets per second for both
+void BenchmarkDescriptorAllocation( VkDevice device, VkDescriptorSetLayout layout, const std::vector<VkDescriptorPoolSize>& setSizes );
+#endif
+
+#endif // TUTORIAL06_TEXTURE_DESCRIPTORALLOCATOR_H
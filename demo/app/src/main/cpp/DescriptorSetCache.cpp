@@ -0,0 +1,305 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include "DescriptorSetCache.h"
+#include <android/log.h>
+#include <cassert>
+#include <cstring>
+#ifdef VKTUTS_BENCHMARK
+#include <chrono>
+#endif
+
+// Image and buffer descriptors of one binding are read as arrays of DescriptorResource
+static_assert( sizeof( DescriptorResource ) == sizeof( VkDescriptorImageInfo ) && sizeof( DescriptorResource ) == sizeof( VkDescriptorBufferInfo ),
+               "VkWriteDescriptorSet reads DescriptorResource arrays as image or buffer info arrays" );
+
+static bool IsImageDescriptor( VkDescriptorType type )
+{
+    return type == VK_DESCRIPTOR_TYPE_SAMPLER || type == VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER || type == VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE ||
+           type == VK_DESCRIPTOR_TYPE_STORAGE_IMAGE || type == VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT;
+}
+
+static bool IsTexelBufferDescriptor( VkDescriptorType type )
+{
+    return type == VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER || type == VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER;
+}
+
+template <typename T>
+static void AppendKey( std::vector<uint64_t>* key, const T& value )
+{
+    // handles are pointers on 64 bit and uint64_t on 32 bit
+    uint64_t bits = 0;
+    memcpy( &bits, &value, sizeof( value ) );
+    key->push_back( bits );
+}
+
+// One entry per binding, reading DescriptorResource arrays laid out the way Get() takes them
+static VkResult CreateUpdateTemplate( VkDevice device, VkDescriptorSetLayout layout, const std::vector<VkDescriptorSetLayoutBinding>& bindings,
+                                      VkDescriptorUpdateTemplateKHR* updateTemplate )
+{
+    std::vector<VkDescriptorUpdateTemplateEntryKHR> entries;
+    size_t offset = 0;
+    for( const auto& binding : bindings )
+    {
+        if( binding.descriptorCount == 0 )
+            continue;
+        VkDescriptorUpdateTemplateEntryKHR entry;
+        entry.dstBinding = binding.binding;
+        entry.dstArrayElement = 0;
+        entry.descriptorCount = binding.descriptorCount;
+        entry.descriptorType = binding.descriptorType;
+        entry.offset = offset;
+        entry.stride = sizeof( DescriptorResource );
+        entries.push_back( entry );
+        offset += binding.descriptorCount * sizeof( DescriptorResource );
+    }
+
+    VkDescriptorUpdateTemplateCreateInfoKHR createInfo;
+    createInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_UPDATE_TEMPLATE_CREATE_INFO_KHR;
+    createInfo.pNext = nullptr;
+    createInfo.flags = 0;
+    createInfo.descriptorUpdateEntryCount = static_cast<uint32_t>( entries.size() );
+    createInfo.pDescriptorUpdateEntries = entries.data();
+    createInfo.templateType = VK_DESCRIPTOR_UPDATE_TEMPLATE_TYPE_DESCRIPTOR_SET_KHR;
+    createInfo.descriptorSetLayout = layout;
+    // only used by push descriptor templates
+    createInfo.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+    createInfo.pipelineLayout = VK_NULL_HANDLE;
+    createInfo.set = 0;
+    return vkCreateDescriptorUpdateTemplateKHR( device, &createInfo, nullptr, updateTemplate );
+}
+
+void AppendDescriptorWrites( VkDescriptorSet set, const std::vector<VkDescriptorSetLayoutBinding>& bindings, const DescriptorResource* resources,
+                             std::vector<VkWriteDescriptorSet>* writes )
+{
+    VkWriteDescriptorSet write;
+    write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    write.pNext = nullptr;
+    write.dstSet = set;
+    write.pImageInfo = nullptr;
+    write.pBufferInfo = nullptr;
+    write.pTexelBufferView = nullptr;
+
+    for( const auto& binding : bindings )
+    {
+        write.dstBinding = binding.binding;
+        write.descriptorType = binding.descriptorType;
+        if( IsTexelBufferDescriptor( binding.descriptorType ) )
+        {
+            // buffer views are not contiguous in a DescriptorResource array, one write each
+            for( uint32_t i = 0; i < binding.descriptorCount; i++ )
+            {
+                write.dstArrayElement = i;
+                write.descriptorCount = 1;
+                write.pTexelBufferView = &resources[i].texelBufferView_;
+                writes->push_back( write );
+            }
+            write.pTexelBufferView = nullptr;
+        }
+        else if( binding.descriptorCount > 0 )
+        {
+            write.dstArrayElement = 0;
+            write.descriptorCount = binding.descriptorCount;
+            write.pImageInfo = IsImageDescriptor( binding.descriptorType ) ? &resources->image_ : nullptr;
+            write.pBufferInfo = IsImageDescriptor( binding.descriptorType ) ? nullptr : &resources->buffer_;
+            writes->push_back( write );
+        }
+        resources += binding.descriptorCount;
+    }
+}
+
+void DescriptorSetCache::Init( VkDevice device, DescriptorAllocator* allocator, bool useTemplates )
+{
+    device_ = device;
+    allocator_ = allocator;
+    useTemplates_ = useTemplates;
+    memset( &stats_, 0, sizeof( stats_ ) );
+}
+
+void DescriptorSetCache::Shutdown( void )
+{
+    // the sets themselves go with the allocator's pools
+    for( auto& entry : layouts_ )
+    {
+        if( entry.second.template_ != VK_NULL_HANDLE )
+            vkDestroyDescriptorUpdateTemplateKHR( device_, entry.second.template_, nullptr );
+    }
+    layouts_.clear();
+    sets_.clear();
+    pending_.clear();
+}
+
+VkResult DescriptorSetCache::AddLayout( VkDescriptorSetLayout layout, const std::vector<VkDescriptorSetLayoutBinding>& bindings )
+{
+    if( layouts_.count( layout ) )
+        return VK_SUCCESS;
+
+    Layout entry;
+    entry.bindings_ = bindings;
+    entry.resourceCount_ = 0;
+    for( const auto& binding : bindings )
+        entry.resourceCount_ += binding.descriptorCount;
+    entry.template_ = VK_NULL_HANDLE;
+    if( useTemplates_ && entry.resourceCount_ > 0 )
+    {
+        VkResult result = CreateUpdateTemplate( device_, layout, bindings, &entry.template_ );
+        if( result != VK_SUCCESS )
+            return result;
+    }
+    layouts_.emplace( layout, std::move( entry ) );
+    return VK_SUCCESS;
+}
+
+VkDescriptorSet DescriptorSetCache::Get( VkDescriptorSetLayout layout, const DescriptorResource* resources, uint32_t resourceCount )
+{
+    auto foundLayout = layouts_.find( layout );
+    assert( foundLayout != layouts_.end() );
+    const Layout& layoutEntry = foundLayout->second;
+    assert( resourceCount == layoutEntry.resourceCount_ );
+
+    // the handles a descriptor reads make the key, padding and unused union members do not
+    SetKey key;
+    key.first = layout;
+    const DescriptorResource* resource = resources;
+    for( const auto& binding : layoutEntry.bindings_ )
+    {
+        for( uint32_t i = 0; i < binding.descriptorCount; i++, resource++ )
+        {
+            if( IsImageDescriptor( binding.descriptorType ) )
+            {
+                AppendKey( &key.second, resource->image_.sampler );
+                AppendKey( &key.second, resource->image_.imageView );
+                AppendKey( &key.second, resource->image_.imageLayout );
+            }
+            else if( IsTexelBufferDescriptor( binding.descriptorType ) )
+                AppendKey( &key.second, resource->texelBufferView_ );
+            else
+            {
+                AppendKey( &key.second, resource->buffer_.buffer );
+                AppendKey( &key.second, resource->buffer_.offset );
+                AppendKey( &key.second, resource->buffer_.range );
+            }
+        }
+    }
+
+    stats_.lookups_++;
+    auto found = sets_.find( key );
+    if( found != sets_.end() )
+    {
+        stats_.hits_++;
+        return found->second.set_;
+    }
+
+    Set set;
+    if( allocator_->Allocate( layout, &set.set_ ) != VK_SUCCESS )
+        return VK_NULL_HANDLE;
+    set.resources_.assign( resources, resources + resourceCount );
+    auto inserted = sets_.emplace( std::move( key ), std::move( set ) ).first;
+    pending_.push_back( { &layoutEntry, &inserted->second } );
+    stats_.sets_++;
+    return inserted->second.set_;
+}
+
+void DescriptorSetCache::Flush( void )
+{
+    if( pending_.empty() )
+        return;
+
+    if( useTemplates_ )
+    {
+        for( const auto& pending : pending_ )
+        {
+            if( pending.first->template_ == VK_NULL_HANDLE )
+                continue;
+            vkUpdateDescriptorSetWithTemplateKHR( device_, pending.second->set_, pending.first->template_, pending.second->resources_.data() );
+            stats_.updateCalls_++;
+        }
+    }
+    else
+    {
+        std::vector<VkWriteDescriptorSet> writes;
+        for( const auto& pending : pending_ )
+            AppendDescriptorWrites( pending.second->set_, pending.first->bindings_, pending.second->resources_.data(), &writes );
+        vkUpdateDescriptorSets( device_, static_cast<uint32_t>( writes.size() ), writes.data(), 0, nullptr );
+        stats_.updateCalls_++;
+    }
+    pending_.clear();
+}
+
+#ifdef VKTUTS_BENCHMARK
+void BenchmarkDescriptorUpdates( VkDevice device, VkDescriptorSetLayout layout, const std::vector<VkDescriptorSetLayoutBinding>& bindings,
+                                 const std::vector<DescriptorResource>& resources, const std::vector<VkDescriptorPoolSize>& setSizes, bool useTemplates )
+{
+    // sets of many draws written every frame
+    const uint32_t kSets = 10000;
+
+    DescriptorAllocator allocator;
+    allocator.Init( device, setSizes, 256, 1 );
+    std::vector<VkDescriptorSet> sets( kSets );
+    for( auto& set : sets )
+    {
+        if( allocator.AllocateFrame( 0, layout, &set ) != VK_SUCCESS )
+        {
+            allocator.Shutdown();
+            return;
+        }
+    }
+
+    // one call per set, the way CreateDescriptorSet() wrote its set
+    std::vector<VkWriteDescriptorSet> writes;
+    auto start = std::chrono::steady_clock::now();
+    for( auto set : sets )
+    {
+        writes.clear();
+        AppendDescriptorWrites( set, bindings, resources.data(), &writes );
+        vkUpdateDescriptorSets( device, static_cast<uint32_t>( writes.size() ), writes.data(), 0, nullptr );
+    }
+    double perSetSeconds = std::chrono::duration<double>( std::chrono::steady_clock::now() - start ).count();
+
+    start = std::chrono::steady_clock::now();
+    writes.clear();
+    for( auto set : sets )
+        AppendDescriptorWrites( set, bindings, resources.data(), &writes );
+    vkUpdateDescriptorSets( device, static_cast<uint32_t>( writes.size() ), writes.data(), 0, nullptr );
+    double batchedSeconds = std::chrono::duration<double>( std::chrono::steady_clock::now() - start ).count();
+
+    double templateSeconds = 0.0;
+    VkDescriptorUpdateTemplateKHR updateTemplate;
+    if( useTemplates && CreateUpdateTemplate( device, layout, bindings, &updateTemplate ) == VK_SUCCESS )
+    {
+        start = std::chrono::steady_clock::now();
+        for( auto set : sets )
+            vkUpdateDescriptorSetWithTemplateKHR( device, set, updateTemplate, resources.data() );
+        templateSeconds = std::chrono::duration<double>( std::chrono::steady_clock::now() - start ).count();
+        vkDestroyDescriptorUpdateTemplateKHR( device, updateTemplate, nullptr );
+    }
+    allocator.Shutdown();
+
+    if( templateSeconds > 0.0 )
+    {
+        __android_log_print( ANDROID_LOG_INFO, "Vulkan-Tutorial06",
+                             "descriptor updates: call per set %.0f sets/s, batched %.0f sets/s, template %.0f sets/s", kSets / perSetSeconds,
+                             kSets / batchedSeconds, kSets / templateSeconds );
+    }
+    else
+    {
+        __android_log_print( ANDROID_LOG_INFO, "Vulkan-Tutorial06",
+                             "descriptor updates: call per set %.0f sets/s, batched %.0f sets/s, no update templates", kSets / perSetSeconds,
+                             kSets / batchedSeconds );
+    }
+}
+#endif
@@ -0,0 +1,113 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#ifndef TUTORIAL06_TEXTURE_DESCRIPTORSETCACHE_H
+#define TUTORIAL06_TEXTURE_DESCRIPTORSETCACHE_H
+
+#include <vulkan_wrapper.h>
+#include <map>
+#include <utility>
+#include <vector>
+#include "DescriptorAllocator.h"
+
+// What one descriptor points at, the member read depends on the descriptor type
+union DescriptorResource
+{
+    VkDescriptorImageInfo image_;   // samplers and images
+    VkDescriptorBufferInfo buffer_; // uniform and storage buffers
+    VkBufferView texelBufferView_;  // texel buffers
+};
+
+struct DescriptorSetCacheStats
+{
+    uint32_t lookups_;
+    uint32_t hits_;        // lookups that returned an existing set
+    uint32_t sets_;        // sets created and written
+    uint32_t updateCalls_; // vkUpdateDescriptorSets or vkUpdateDescriptorSetWithTemplateKHR calls
+};
+
+/*
+ * DescriptorSetCache
+ *   Gives out descriptor sets by the resources bound to them: asking twice
+ *   for the same layout and resources returns the same set, written once.
+ *
+ *   Sets are written in Flush(), which must run before they are recorded.
+ *   With VK_KHR_descriptor_update_template each layout gets a template and
+ *   a set is written by one vkUpdateDescriptorSetWithTemplateKHR straight
+ *   from its DescriptorResource array. Without it, the writes of every set
+ *   created since the last Flush() go to the driver in one
+ *   vkUpdateDescriptorSets call.
+ *
+ *   Sets come from DescriptorAllocator::Allocate() and live until
+ *   Shutdown(), so the resources bound to them must too. Not thread safe.
+ */
+class DescriptorSetCache
+{
+public:
+    void Init( VkDevice device, DescriptorAllocator* allocator, bool useTemplates );
+    void Shutdown( void );
+
+    // bindings as in the layout's VkDescriptorSetLayoutCreateInfo
+    VkResult AddLayout( VkDescriptorSetLayout layout, const std::vector<VkDescriptorSetLayoutBinding>& bindings );
+
+    // resources of each binding of layout in binding order, descriptorCount of them per binding;
+    // VK_NULL_HANDLE if no set could be allocated
+    VkDescriptorSet Get( VkDescriptorSetLayout layout, const DescriptorResource* resources, uint32_t resourceCount );
+    // Writes the sets Get() created
+    void Flush( void );
+
+    // bindings AddLayout() was given for layout
+    const std::vector<VkDescriptorSetLayoutBinding>& LayoutBindings( VkDescriptorSetLayout layout ) const { return layouts_.at( layout ).bindings_; }
+    bool UsesTemplates( void ) const { return useTemplates_; }
+    DescriptorSetCacheStats Stats( void ) const { return stats_; }
+
+private:
+    struct Layout
+    {
+        std::vector<VkDescriptorSetLayoutBinding> bindings_;
+        uint32_t resourceCount_;
+        VkDescriptorUpdateTemplateKHR template_; // VK_NULL_HANDLE without templates or descriptors
+    };
+    struct Set
+    {
+        VkDescriptorSet set_;
+        std::vector<DescriptorResource> resources_;
+    };
+    typedef std::pair<VkDescriptorSetLayout, std::vector<uint64_t>> SetKey;
+
+    VkDevice device_;
+    DescriptorAllocator* allocator_;
+    bool useTemplates_;
+    std::map<VkDescriptorSetLayout, Layout> layouts_;
+    std::map<SetKey, Set> sets_;
+    std::vector<std::pair<const Layout*, const Set*>> pending_;
+    DescriptorSetCacheStats stats_;
+};
+
+// Writes resources into set with one VkWriteDescriptorSet per binding, appended to writes;
+// the writes point into resources
+void AppendDescriptorWrites( VkDescriptorSet set, const std::vector<VkDescriptorSetLayoutBinding>& bindings, const DescriptorResource* resources,
+                             std::vector<VkWriteDescriptorSet>* writes );
+
+#ifdef VKTUTS_BENCHMARK
+// Writes the same resources into many sets one vkUpdateDescriptorSets per set, batched in one call
+// and, when the device has VK_KHR_descriptor_update_template, through a template; logs sets per second
+void BenchmarkDescriptorUpdates( VkDevice device, VkDescriptorSetLayout layout, const std::vector<VkDescriptorSetLayoutBinding>& bindings,
+                                 const std::vector<DescriptorResource>& resources, const std::vector<VkDescriptorPoolSize>& setSizes, bool useTemplates );
+#endif
+
+#endif // TUTORIAL06_TEXTURE_DESCRIPTORSETCACHE_H
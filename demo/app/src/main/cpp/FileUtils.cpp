@@ -0,0 +1,87 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include "FileUtils.h"
+#include <cerrno>
+#include <cstdio>
+#include <fcntl.h>
+#include <string>
+#include <sys/stat.h>
+#include <unistd.h>
+
+uint64_t Fnv1a64( const void* data, size_t size, uint64_t hash )
+{
+    const uint8_t* bytes = static_cast<const uint8_t*>( data );
+    for( size_t i = 0; i < size; i++ )
+    {
+        hash ^= bytes[i];
+        hash *= 0x100000001b3ull;
+    }
+    return hash;
+}
+
+bool ReadFile( const char* path, std::vector<uint8_t>* content )
+{
+    int fd = open( path, O_RDONLY | O_CLOEXEC );
+    if( fd < 0 )
+        return false;
+
+    off_t size = lseek( fd, 0, SEEK_END );
+    bool ok = size >= 0 && lseek( fd, 0, SEEK_SET ) == 0;
+    if( ok )
+    {
+        content->resize( static_cast<size_t>( size ) );
+        ok = read( fd, content->data(), content->size() ) == static_cast<ssize_t>( content->size() );
+    }
+    close( fd );
+    return ok;
+}
+
+bool WriteFileAtomic( const char* path, const void* data, size_t size )
+{
+    std::string tmpPath = std::string( path ) + ".tmp";
+    int fd = open( tmpPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600 );
+    if( fd < 0 )
+        return false;
+
+    const uint8_t* bytes = static_cast<const uint8_t*>( data );
+    bool ok = true;
+    while( ok && size )
+    {
+        ssize_t written = write( fd, bytes, size );
+        ok = written > 0;
+        if( ok )
+        {
+            bytes += written;
+            size -= static_cast<size_t>( written );
+        }
+    }
+    // the data has to be on disk before the rename makes it visible
+    ok = ok && fsync( fd ) == 0;
+    ok = close( fd ) == 0 && ok;
+    if( !ok || rename( tmpPath.c_str(), path ) != 0 )
+    {
+        unlink( tmpPath.c_str() );
+        return false;
+    }
+    return true;
+}
+
+bool MakeDirectory( const char* path )
+{
+    return mkdir( path, 0700 ) == 0 || errno == EEXIST;
+}
@@ -0,0 +1,41 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#ifndef TUTORIAL06_TEXTURE_FILEUTILS_H
+#define TUTORIAL06_TEXTURE_FILEUTILS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Helpers for the caches kept in the app's private storage
+
+static const uint64_t kFnv1aSeed = 0xcbf29ce484222325ull;
+
+// 64 bit FNV-1a of data, continuing from hash so several pieces can be hashed one after the other
+uint64_t Fnv1a64( const void* data, size_t size, uint64_t hash = kFnv1aSeed );
+
+// Whole file in content, false if it does not exist or cannot be read
+bool ReadFile( const char* path, std::vector<uint8_t>* content );
+
+// Writes a temporary file next to path and renames it over path, readers see the old or the new file, never a part
+bool WriteFileAtomic( const char* path, const void* data, size_t size );
+
+// Creates the directory if needed, false if it does not exist afterwards
+bool MakeDirectory( const char* path );
+
+#endif // TUTORIAL06_TEXTURE_FILEUTILS_H
@@ -0,0 +1,108 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include "GeometryBuffer.h"
+#include <cstring>
+
+static VkDeviceSize IndexSize( VkIndexType indexType )
+{
+    return indexType == VK_INDEX_TYPE_UINT16 ? 2 : 4;
+}
+
+VkResult CreateGeometryBuffer( VkDevice device, MemoryAllocator* allocator, UploadQueue* uploads, const GeometryData& data, GeometryMemory memory,
+                               GeometryBuffer* geometry )
+{
+    VkDeviceSize vertexSize = data.vertexStride_ * data.vertexCount_;
+    uint32_t indexCount = data.indices_ ? data.indexCount_ : 0;
+    VkDeviceSize indexSize = IndexSize( data.indexType_ ) * indexCount;
+
+    geometry->buffer_ = VK_NULL_HANDLE;
+    // vkCmdBindIndexBuffer wants an offset that is a multiple of the index size
+    geometry->indexOffset_ = ( vertexSize + 3 ) & ~VkDeviceSize( 3 );
+    geometry->indexType_ = data.indexType_;
+    geometry->vertexCount_ = data.vertexCount_;
+    geometry->indexCount_ = indexCount;
+
+    VkBufferCreateInfo createBufferInfo;
+    createBufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    createBufferInfo.pNext = nullptr;
+    createBufferInfo.size = geometry->indexOffset_ + indexSize;
+    createBufferInfo.usage = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | ( indexCount ? VK_BUFFER_USAGE_INDEX_BUFFER_BIT : 0 ) |
+                             ( memory == GEOMETRY_MEMORY_DEVICE_LOCAL ? VK_BUFFER_USAGE_TRANSFER_DST_BIT : 0 );
+    createBufferInfo.flags = 0;
+    createBufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    createBufferInfo.queueFamilyIndexCount = 0;
+    createBufferInfo.pQueueFamilyIndices = nullptr;
+
+    VkResult result = vkCreateBuffer( device, &createBufferInfo, nullptr, &geometry->buffer_ );
+    if( result != VK_SUCCESS )
+    {
+        geometry->buffer_ = VK_NULL_HANDLE;
+        return result;
+    }
+
+    VkMemoryPropertyFlags required = memory == GEOMETRY_MEMORY_DEVICE_LOCAL ? VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
+                                                                           : VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+    result = allocator->AllocateForBuffer( geometry->buffer_, required, &geometry->memory_ );
+    if( result != VK_SUCCESS )
+    {
+        vkDestroyBuffer( device, geometry->buffer_, nullptr );
+        geometry->buffer_ = VK_NULL_HANDLE;
+        return result;
+    }
+
+    if( memory == GEOMETRY_MEMORY_DEVICE_LOCAL )
+    {
+        uploads->UploadBuffer( geometry->buffer_, 0, data.vertices_, vertexSize );
+        if( indexCount )
+            uploads->UploadBuffer( geometry->buffer_, geometry->indexOffset_, data.indices_, indexSize );
+    }
+    else
+    {
+        // persistently mapped and coherent, no map, unmap or flush
+        uint8_t* mapped = static_cast<uint8_t*>( geometry->memory_.mapped_ );
+        memcpy( mapped, data.vertices_, vertexSize );
+        if( indexCount )
+            memcpy( mapped + geometry->indexOffset_, data.indices_, indexSize );
+    }
+    return VK_SUCCESS;
+}
+
+void DestroyGeometryBuffer( VkDevice device, MemoryAllocator* allocator, GeometryBuffer* geometry )
+{
+    if( geometry->buffer_ == VK_NULL_HANDLE )
+        return;
+    vkDestroyBuffer( device, geometry->buffer_, nullptr );
+    allocator->Free( geometry->memory_ );
+    geometry->buffer_ = VK_NULL_HANDLE;
+}
+
+void BindGeometryBuffer( VkCommandBuffer cmdBuffer, const GeometryBuffer& geometry )
+{
+    VkDeviceSize offset = 0;
+    vkCmdBindVertexBuffers( cmdBuffer, 0, 1, &geometry.buffer_, &offset );
+    if( geometry.indexCount_ )
+        vkCmdBindIndexBuffer( cmdBuffer, geometry.buffer_, geometry.indexOffset_, geometry.indexType_ );
+}
+
+void DrawGeometryBuffer( VkCommandBuffer cmdBuffer, const GeometryBuffer& geometry, uint32_t instanceCount )
+{
+    if( geometry.indexCount_ )
+        vkCmdDrawIndexed( cmdBuffer, geometry.indexCount_, instanceCount, 0, 0, 0 );
+    else
+        vkCmdDraw( cmdBuffer, geometry.vertexCount_, instanceCount, 0, 0 );
+}
@@ -0,0 +1,74 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#ifndef TUTORIAL06_TEXTURE_GEOMETRYBUFFER_H
+#define TUTORIAL06_TEXTURE_GEOMETRYBUFFER_H
+
+#include <vulkan_wrapper.h>
+#include "MemoryAllocator.h"
+#include "UploadQueue.h"
+
+// Where the vertices and indices of a geometry buffer live
+enum GeometryMemory
+{
+    GEOMETRY_MEMORY_DEVICE_LOCAL, // copied from the staging ring, what draws should use
+    GEOMETRY_MEMORY_HOST_VISIBLE, // written by the CPU in place; on discrete GPUs every vertex fetch crosses the bus
+};
+
+// CPU side of a mesh
+struct GeometryData
+{
+    const void* vertices_;
+    VkDeviceSize vertexStride_;
+    uint32_t vertexCount_;
+    const void* indices_;   // nullptr for geometry drawn without indices
+    VkIndexType indexType_; // VK_INDEX_TYPE_UINT16 or VK_INDEX_TYPE_UINT32
+    uint32_t indexCount_;
+};
+
+// Vertices and indices of a mesh in one buffer
+struct GeometryBuffer
+{
+    VkBuffer buffer_;          // vertices from offset 0, then the indices
+    MemoryAllocation memory_;
+    VkDeviceSize indexOffset_;
+    VkIndexType indexType_;
+    uint32_t vertexCount_;
+    uint32_t indexCount_;      // 0 for geometry drawn without indices
+};
+
+/*
+ * CreateGeometryBuffer()
+ *   Creates a buffer for the vertices and indices of data and fills it.
+ *   Device local buffers are filled through uploads: the data is staged
+ *   now and copied by the GPU with the next uploads->Flush(). Frames
+ *   submitted after that flush read the finished copy, so draws may be
+ *   recorded right away.
+ * Return:
+ *     the error of buffer creation or memory allocation; nothing is left to destroy then
+ */
+VkResult CreateGeometryBuffer( VkDevice device, MemoryAllocator* allocator, UploadQueue* uploads, const GeometryData& data, GeometryMemory memory,
+                               GeometryBuffer* geometry );
+// No submitted command buffer may use it anymore
+void DestroyGeometryBuffer( VkDevice device, MemoryAllocator* allocator, GeometryBuffer* geometry );
+
+// Binds the vertices to binding 0, and the indices if there are any
+void BindGeometryBuffer( VkCommandBuffer cmdBuffer, const GeometryBuffer& geometry );
+// vkCmdDrawIndexed for indexed geometry, vkCmdDraw otherwise
+void DrawGeometryBuffer( VkCommandBuffer cmdBuffer, const GeometryBuffer& geometry, uint32_t instanceCount );
+
+#endif // TUTORIAL06_TEXTURE_GEOMETRYBUFFER_H
@@ -0,0 +1,167 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include "JobSystem.h"
+
+// slot of the current thread; threads not owned by the job system are slot 0
+static thread_local uint32_t tlsThreadIndex = 0;
+
+JobSystem::JobSystem( uint32_t workerCount ) : quit_( false )
+{
+    if( workerCount == 0 )
+    {
+        uint32_t cores = std::thread::hardware_concurrency();
+        workerCount = cores > 1 ? cores - 1 : 1;
+    }
+
+    for( uint32_t i = 0; i < workerCount + 1; i++ )
+        queues_.emplace_back( new JobQueue );
+
+    for( uint32_t i = 1; i <= workerCount; i++ )
+        workers_.emplace_back( &JobSystem::WorkerMain, this, i );
+}
+
+JobSystem::~JobSystem()
+{
+    {
+        std::lock_guard<std::mutex> lock( sleepMutex_ );
+        quit_ = true;
+    }
+    wakeUp_.notify_all();
+    for( auto& worker : workers_ )
+        worker.join();
+}
+
+uint32_t JobSystem::ThreadIndex( void )
+{
+    return tlsThreadIndex;
+}
+
+void JobSystem::Submit( std::function<void()> job, JobCounter* counter )
+{
+    if( counter )
+    {
+        counter->pending_.fetch_add( 1, std::memory_order_relaxed );
+        counter->queued_.fetch_add( 1, std::memory_order_relaxed );
+    }
+
+    // A worker keeps the jobs it spawns, everyone else spreads them over the workers
+    uint32_t queueIndex = tlsThreadIndex;
+    if( queueIndex == 0 && !workers_.empty() )
+        queueIndex = 1 + nextQueue_.fetch_add( 1, std::memory_order_relaxed ) % WorkerCount();
+
+    {
+        std::lock_guard<std::mutex> lock( queues_[queueIndex]->mutex_ );
+        queues_[queueIndex]->jobs_.push_back( Job{ std::move( job ), counter } );
+    }
+
+    {
+        std::lock_guard<std::mutex> lock( sleepMutex_ );
+        queuedJobs_.fetch_add( 1, std::memory_order_release );
+    }
+    wakeUp_.notify_one();
+
+    // a Wait() on counter may be asleep; notified under the lock since the job may finish any moment now
+    if( counter )
+    {
+        std::lock_guard<std::mutex> lock( counter->mutex_ );
+        counter->changed_.notify_all();
+    }
+}
+
+void JobSystem::Wait( JobCounter& counter )
+{
+    Job job;
+    for( ;; )
+    {
+        if( PopOrSteal( tlsThreadIndex, job, &counter ) )
+        {
+            Execute( job );
+            continue;
+        }
+
+        // the rest runs on workers; returning with the lock held means no Execute() still touches counter
+        std::unique_lock<std::mutex> lock( counter.mutex_ );
+        counter.changed_.wait( lock, [&counter] {
+            return counter.pending_.load( std::memory_order_acquire ) == 0 || counter.queued_.load( std::memory_order_acquire ) != 0;
+        } );
+        if( counter.pending_.load( std::memory_order_acquire ) == 0 )
+            return;
+    }
+}
+
+void JobSystem::WorkerMain( uint32_t threadIndex )
+{
+    tlsThreadIndex = threadIndex;
+
+    Job job;
+    for( ;; )
+    {
+        if( PopOrSteal( threadIndex, job ) )
+        {
+            Execute( job );
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock( sleepMutex_ );
+        wakeUp_.wait( lock, [this] { return quit_ || queuedJobs_.load( std::memory_order_acquire ) != 0; } );
+        if( quit_ && queuedJobs_.load( std::memory_order_acquire ) == 0 )
+            return;
+    }
+}
+
+// Own queue is LIFO (cache-warm), stealing is FIFO (oldest, usually biggest job)
+bool JobSystem::PopOrSteal( uint32_t threadIndex, Job& job, const JobCounter* counter )
+{
+    uint32_t queueCount = static_cast<uint32_t>( queues_.size() );
+    for( uint32_t i = 0; i < queueCount; i++ )
+    {
+        JobQueue& queue = *queues_[( threadIndex + i ) % queueCount];
+        std::lock_guard<std::mutex> lock( queue.mutex_ );
+        size_t count = queue.jobs_.size();
+        size_t found = count;
+        for( size_t n = 0; n < count && found == count; n++ )
+        {
+            size_t index = i == 0 ? count - 1 - n : n;
+            if( !counter || queue.jobs_[index].counter_ == counter )
+                found = index;
+        }
+        if( found == count )
+            continue;
+
+        job = std::move( queue.jobs_[found] );
+        queue.jobs_.erase( queue.jobs_.begin() + found );
+        queuedJobs_.fetch_sub( 1, std::memory_order_relaxed );
+        if( job.counter_ )
+            job.counter_->queued_.fetch_sub( 1, std::memory_order_relaxed );
+        return true;
+    }
+    return false;
+}
+
+void JobSystem::Execute( Job& job )
+{
+    job.func_();
+    job.func_ = nullptr;
+    if( job.counter_ )
+    {
+        // under the lock: a Wait() that sees zero cannot return, and destroy the counter, before this is done with it
+        std::lock_guard<std::mutex> lock( job.counter_->mutex_ );
+        if( job.counter_->pending_.fetch_sub( 1, std::memory_order_acq_rel ) == 1 )
+            job.counter_->changed_.notify_all();
+    }
+}
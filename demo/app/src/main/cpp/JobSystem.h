@@ -0,0 +1,105 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#ifndef TUTORIAL06_TEXTURE_JOBSYSTEM_H
+#define TUTORIAL06_TEXTURE_JOBSYSTEM_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/*
+ * JobCounter
+ *   Number of outstanding jobs of one batch; JobSystem::Wait() returns
+ *   once it drops to zero.
+ */
+struct JobCounter
+{
+    std::atomic<uint32_t> pending_{ 0 };
+    std::atomic<uint32_t> queued_{ 0 }; // of pending_, not picked up by a thread yet
+    std::mutex mutex_;                  // Wait() sleeps on changed_ while none of its jobs is queued
+    std::condition_variable changed_;
+};
+
+/*
+ * JobSystem
+ *   Fixed pool of worker threads with one job deque per thread.
+ *   A worker pops its own newest job first and steals the oldest job of
+ *   another thread when its deque is empty, so unevenly sized jobs still
+ *   keep every core busy.
+ *
+ *   The thread that calls Wait() executes jobs too, it is thread slot 0.
+ *   It only takes jobs of the counter it waits for, so waiting for a
+ *   frame's jobs never runs a long background job (a pipeline build) on
+ *   the render thread; once none of them is left in a queue it sleeps
+ *   until the last one finished. Workers are slots 1..WorkerCount(). ThreadIndex() returns the slot of
+ *   the calling thread, which is what per-thread resources (for example
+ *   command pools) are indexed with; ThreadCount() is the number of slots.
+ */
+class JobSystem
+{
+public:
+    // workerCount == 0 picks one worker per core besides the calling thread
+    explicit JobSystem( uint32_t workerCount = 0 );
+    ~JobSystem();
+
+    JobSystem( const JobSystem& ) = delete;
+    JobSystem& operator=( const JobSystem& ) = delete;
+
+    uint32_t WorkerCount( void ) const { return static_cast<uint32_t>( workers_.size() ); }
+    uint32_t ThreadCount( void ) const { return WorkerCount() + 1; }
+    static uint32_t ThreadIndex( void );
+
+    // Queue a job; counter (optional) is incremented now and decremented when the job is done
+    void Submit( std::function<void()> job, JobCounter* counter = nullptr );
+
+    // Run queued jobs of counter on the calling thread until it reaches zero
+    void Wait( JobCounter& counter );
+
+private:
+    struct Job
+    {
+        std::function<void()> func_;
+        JobCounter* counter_;
+    };
+
+    struct JobQueue
+    {
+        std::mutex mutex_;
+        std::deque<Job> jobs_;
+    };
+
+    void WorkerMain( uint32_t threadIndex );
+    // counter (optional) limits the search to its jobs
+    bool PopOrSteal( uint32_t threadIndex, Job& job, const JobCounter* counter = nullptr );
+    void Execute( Job& job );
+
+    std::vector<std::thread> workers_;
+    std::vector<std::unique_ptr<JobQueue>> queues_; // one per thread slot
+    std::atomic<uint32_t> nextQueue_{ 0 };
+    std::atomic<uint32_t> queuedJobs_{ 0 };
+    std::mutex sleepMutex_;
+    std::condition_variable wakeUp_;
+    bool quit_;
+};
+
+#endif // TUTORIAL06_TEXTURE_JOBSYSTEM_H
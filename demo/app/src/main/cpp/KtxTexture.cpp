@@ -0,0 +1,173 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include "KtxTexture.h"
+#include <android/log.h>
+#include <cstring>
+
+// «KTX 20»\r\n\x1A\n
+static const uint8_t kKtx2Identifier[12] = { 0xAB, 0x4B, 0x54, 0x58, 0x20, 0x32, 0x30, 0xBB, 0x0D, 0x0A, 0x1A, 0x0A };
+// identifier, 9 header fields and the index ( dfd, kvd offset/length, sgd offset/length )
+static const size_t kKtx2HeaderSize = 80;
+static const size_t kKtx2LevelIndexEntrySize = 24;
+
+struct FormatBlockInfo
+{
+    VkFormat format_;
+    uint32_t width_;
+    uint32_t height_;
+    uint32_t size_;
+};
+
+static const FormatBlockInfo kFormatBlocks[] = {
+    { VK_FORMAT_R8G8B8A8_UNORM, 1, 1, 4 },
+    { VK_FORMAT_R8G8B8A8_SRGB, 1, 1, 4 },
+    { VK_FORMAT_BC1_RGB_UNORM_BLOCK, 4, 4, 8 },
+    { VK_FORMAT_BC1_RGB_SRGB_BLOCK, 4, 4, 8 },
+    { VK_FORMAT_BC1_RGBA_UNORM_BLOCK, 4, 4, 8 },
+    { VK_FORMAT_BC1_RGBA_SRGB_BLOCK, 4, 4, 8 },
+    { VK_FORMAT_BC2_UNORM_BLOCK, 4, 4, 16 },
+    { VK_FORMAT_BC2_SRGB_BLOCK, 4, 4, 16 },
+    { VK_FORMAT_BC3_UNORM_BLOCK, 4, 4, 16 },
+    { VK_FORMAT_BC3_SRGB_BLOCK, 4, 4, 16 },
+    { VK_FORMAT_BC4_UNORM_BLOCK, 4, 4, 8 },
+    { VK_FORMAT_BC4_SNORM_BLOCK, 4, 4, 8 },
+    { VK_FORMAT_BC5_UNORM_BLOCK, 4, 4, 16 },
+    { VK_FORMAT_BC5_SNORM_BLOCK, 4, 4, 16 },
+    { VK_FORMAT_BC7_UNORM_BLOCK, 4, 4, 16 },
+    { VK_FORMAT_BC7_SRGB_BLOCK, 4, 4, 16 },
+    { VK_FORMAT_ETC2_R8G8B8_UNORM_BLOCK, 4, 4, 8 },
+    { VK_FORMAT_ETC2_R8G8B8_SRGB_BLOCK, 4, 4, 8 },
+    { VK_FORMAT_ETC2_R8G8B8A1_UNORM_BLOCK, 4, 4, 8 },
+    { VK_FORMAT_ETC2_R8G8B8A1_SRGB_BLOCK, 4, 4, 8 },
+    { VK_FORMAT_ETC2_R8G8B8A8_UNORM_BLOCK, 4, 4, 16 },
+    { VK_FORMAT_ETC2_R8G8B8A8_SRGB_BLOCK, 4, 4, 16 },
+    { VK_FORMAT_EAC_R11_UNORM_BLOCK, 4, 4, 8 },
+    { VK_FORMAT_EAC_R11_SNORM_BLOCK, 4, 4, 8 },
+    { VK_FORMAT_EAC_R11G11_UNORM_BLOCK, 4, 4, 16 },
+    { VK_FORMAT_EAC_R11G11_SNORM_BLOCK, 4, 4, 16 },
+    { VK_FORMAT_ASTC_4x4_UNORM_BLOCK, 4, 4, 16 },
+    { VK_FORMAT_ASTC_4x4_SRGB_BLOCK, 4, 4, 16 },
+    { VK_FORMAT_ASTC_5x4_UNORM_BLOCK, 5, 4, 16 },
+    { VK_FORMAT_ASTC_5x4_SRGB_BLOCK, 5, 4, 16 },
+    { VK_FORMAT_ASTC_5x5_UNORM_BLOCK, 5, 5, 16 },
+    { VK_FORMAT_ASTC_5x5_SRGB_BLOCK, 5, 5, 16 },
+    { VK_FORMAT_ASTC_6x5_UNORM_BLOCK, 6, 5, 16 },
+    { VK_FORMAT_ASTC_6x5_SRGB_BLOCK, 6, 5, 16 },
+    { VK_FORMAT_ASTC_6x6_UNORM_BLOCK, 6, 6, 16 },
+    { VK_FORMAT_ASTC_6x6_SRGB_BLOCK, 6, 6, 16 },
+    { VK_FORMAT_ASTC_8x5_UNORM_BLOCK, 8, 5, 16 },
+    { VK_FORMAT_ASTC_8x5_SRGB_BLOCK, 8, 5, 16 },
+    { VK_FORMAT_ASTC_8x6_UNORM_BLOCK, 8, 6, 16 },
+    { VK_FORMAT_ASTC_8x6_SRGB_BLOCK, 8, 6, 16 },
+    { VK_FORMAT_ASTC_8x8_UNORM_BLOCK, 8, 8, 16 },
+    { VK_FORMAT_ASTC_8x8_SRGB_BLOCK, 8, 8, 16 },
+    { VK_FORMAT_ASTC_10x5_UNORM_BLOCK, 10, 5, 16 },
+    { VK_FORMAT_ASTC_10x5_SRGB_BLOCK, 10, 5, 16 },
+    { VK_FORMAT_ASTC_10x6_UNORM_BLOCK, 10, 6, 16 },
+    { VK_FORMAT_ASTC_10x6_SRGB_BLOCK, 10, 6, 16 },
+    { VK_FORMAT_ASTC_10x8_UNORM_BLOCK, 10, 8, 16 },
+    { VK_FORMAT_ASTC_10x8_SRGB_BLOCK, 10, 8, 16 },
+    { VK_FORMAT_ASTC_10x10_UNORM_BLOCK, 10, 10, 16 },
+    { VK_FORMAT_ASTC_10x10_SRGB_BLOCK, 10, 10, 16 },
+    { VK_FORMAT_ASTC_12x10_UNORM_BLOCK, 12, 10, 16 },
+    { VK_FORMAT_ASTC_12x10_SRGB_BLOCK, 12, 10, 16 },
+    { VK_FORMAT_ASTC_12x12_UNORM_BLOCK, 12, 12, 16 },
+    { VK_FORMAT_ASTC_12x12_SRGB_BLOCK, 12, 12, 16 },
+};
+
+static uint32_t ReadUint32( const uint8_t* data )
+{
+    uint32_t value;
+    memcpy( &value, data, sizeof( value ) ); // KTX2 is little endian, like every Android ABI
+    return value;
+}
+
+static uint64_t ReadUint64( const uint8_t* data )
+{
+    uint64_t value;
+    memcpy( &value, data, sizeof( value ) );
+    return value;
+}
+
+static bool Fail( const char* reason )
+{
+    __android_log_print( ANDROID_LOG_ERROR, "Vulkan-Tutorial06", "KTX2: %s", reason );
+    return false;
+}
+
+bool KtxTexture::FormatBlock( VkFormat format, uint32_t* width, uint32_t* height, uint32_t* size )
+{
+    for( const FormatBlockInfo& info : kFormatBlocks )
+    {
+        if( info.format_ == format )
+        {
+            *width = info.width_;
+            *height = info.height_;
+            *size = info.size_;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool KtxTexture::Parse( const uint8_t* data, size_t size )
+{
+    if( size < kKtx2HeaderSize || memcmp( data, kKtx2Identifier, sizeof( kKtx2Identifier ) ) )
+        return Fail( "not a KTX2 file" );
+
+    format_ = static_cast<VkFormat>( ReadUint32( data + 12 ) );
+    uint32_t width = ReadUint32( data + 20 );
+    uint32_t height = ReadUint32( data + 24 );
+    uint32_t depth = ReadUint32( data + 28 );
+    uint32_t layerCount = ReadUint32( data + 32 );
+    uint32_t faceCount = ReadUint32( data + 36 );
+    uint32_t levelCount = ReadUint32( data + 40 );
+    uint32_t supercompression = ReadUint32( data + 44 );
+
+    if( format_ == VK_FORMAT_UNDEFINED || supercompression != 0 )
+        return Fail( "supercompressed (Basis Universal / zstd) files are not supported" );
+    if( !FormatBlock( format_, &blockWidth_, &blockHeight_, &blockSize_ ) )
+        return Fail( "unsupported vkFormat" );
+    if( width == 0 || height == 0 || depth > 1 || layerCount > 1 || faceCount != 1 )
+        return Fail( "only 2D textures are supported" );
+
+    // levelCount 0 asks the loader to generate the mip chain, the file only holds the base level
+    levelCount = levelCount ? levelCount : 1;
+    if( levelCount > 32 || kKtx2HeaderSize + levelCount * kKtx2LevelIndexEntrySize > size )
+        return Fail( "truncated level index" );
+
+    levels_.resize( levelCount );
+    for( uint32_t i = 0; i < levelCount; i++ )
+    {
+        const uint8_t* entry = data + kKtx2HeaderSize + i * kKtx2LevelIndexEntrySize;
+        uint64_t offset = ReadUint64( entry );
+        uint64_t length = ReadUint64( entry + 8 );
+
+        Level& level = levels_[i];
+        level.width_ = width >> i ? width >> i : 1;
+        level.height_ = height >> i ? height >> i : 1;
+        uint64_t expected = static_cast<uint64_t>( ( level.width_ + blockWidth_ - 1 ) / blockWidth_ ) *
+                            ( ( level.height_ + blockHeight_ - 1 ) / blockHeight_ ) * blockSize_;
+        if( offset > size || length > size - offset || length < expected )
+            return Fail( "level data out of bounds" );
+
+        level.data_ = data + offset;
+        level.size_ = expected;
+    }
+    return true;
+}
@@ -0,0 +1,70 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#ifndef TUTORIAL06_TEXTURE_KTXTEXTURE_H
+#define TUTORIAL06_TEXTURE_KTXTEXTURE_H
+
+#include <vulkan_wrapper.h>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/*
+ * KtxTexture
+ *   Reads a KTX2 file kept in memory. The level data is used in place, the
+ *   blocks can be staged for upload without any decoding.
+ *
+ *   Only plain 2D textures are read: one layer, one face, no
+ *   supercompression (Basis Universal / zstd files are rejected) and a
+ *   vkFormat whose block layout is known, see FormatBlock().
+ */
+class KtxTexture
+{
+public:
+    struct Level
+    {
+        const uint8_t* data_;
+        uint64_t size_;
+        uint32_t width_;
+        uint32_t height_;
+    };
+
+    // Block extent and bytes per block of an uncompressed RGBA8, BC, ETC2/EAC or ASTC format; false for others
+    static bool FormatBlock( VkFormat format, uint32_t* width, uint32_t* height, uint32_t* size );
+
+    // data has to outlive the KtxTexture; returns false, with a log, for malformed or unsupported files
+    bool Parse( const uint8_t* data, size_t size );
+
+    VkFormat Format( void ) const { return format_; }
+    uint32_t Width( void ) const { return levels_[0].width_; }
+    uint32_t Height( void ) const { return levels_[0].height_; }
+    uint32_t BlockWidth( void ) const { return blockWidth_; }
+    uint32_t BlockHeight( void ) const { return blockHeight_; }
+    uint32_t BlockSize( void ) const { return blockSize_; }
+    // level 0 is the full size image; a file may ask for its mip chain to be generated and hold only level 0
+    uint32_t LevelCount( void ) const { return static_cast<uint32_t>( levels_.size() ); }
+    const Level& GetLevel( uint32_t level ) const { return levels_[level]; }
+
+private:
+    VkFormat format_;
+    uint32_t blockWidth_;
+    uint32_t blockHeight_;
+    uint32_t blockSize_;
+    std::vector<Level> levels_;
+};
+
+#endif // TUTORIAL06_TEXTURE_KTXTEXTURE_H
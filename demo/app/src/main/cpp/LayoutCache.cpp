@@ -0,0 +1,139 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include "LayoutCache.h"
+#include <tuple>
+
+bool LayoutCache::PipelineLayoutKey::operator<( const PipelineLayoutKey& other ) const
+{
+    return std::tie( setLayouts_, pushConstantSize_, pushConstantStages_ ) <
+           std::tie( other.setLayouts_, other.pushConstantSize_, other.pushConstantStages_ );
+}
+
+void LayoutCache::Init( VkDevice device, uint32_t runtimeArraySize )
+{
+    device_ = device;
+    runtimeArraySize_ = runtimeArraySize;
+    lookups_ = 0;
+    hits_ = 0;
+}
+
+void LayoutCache::Shutdown( void )
+{
+    for( auto& entry : pipelineLayouts_ )
+        vkDestroyPipelineLayout( device_, entry.second, nullptr );
+    for( auto& entry : setLayouts_ )
+        vkDestroyDescriptorSetLayout( device_, entry.second, nullptr );
+    pipelineLayouts_.clear();
+    setLayouts_.clear();
+}
+
+VkDescriptorSetLayout LayoutCache::GetSetLayout( const ShaderReflection& reflection, uint32_t set )
+{
+    std::vector<VkDescriptorSetLayoutBinding> bindings = ReflectedSetBindings( reflection, set );
+    std::vector<VkDescriptorBindingFlagsEXT> bindingFlags( bindings.size(), 0 );
+    bool updateAfterBind = false;
+    std::vector<uint32_t> key;
+    for( size_t i = 0; i < bindings.size(); i++ )
+    {
+        VkDescriptorSetLayoutBinding& binding = bindings[i];
+        if( binding.descriptorCount == 0 )
+        {
+            if( runtimeArraySize_ == 0 )
+                return VK_NULL_HANDLE;
+            // unused slots may hold nothing, and slots the GPU is not reading may change while frames are in flight
+            binding.descriptorCount = runtimeArraySize_;
+            bindingFlags[i] = VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT_EXT | VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT_EXT |
+                              VK_DESCRIPTOR_BINDING_UPDATE_UNUSED_WHILE_PENDING_BIT_EXT;
+            updateAfterBind = true;
+        }
+        key.push_back( binding.binding );
+        key.push_back( binding.descriptorType );
+        key.push_back( binding.descriptorCount );
+        key.push_back( binding.stageFlags );
+        key.push_back( bindingFlags[i] );
+    }
+
+    lookups_++;
+    auto found = setLayouts_.find( key );
+    if( found != setLayouts_.end() )
+    {
+        hits_++;
+        return found->second;
+    }
+
+    VkDescriptorSetLayoutBindingFlagsCreateInfoEXT bindingFlagsCreateInfo;
+    bindingFlagsCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO_EXT;
+    bindingFlagsCreateInfo.pNext = nullptr;
+    bindingFlagsCreateInfo.bindingCount = static_cast<uint32_t>( bindingFlags.size() );
+    bindingFlagsCreateInfo.pBindingFlags = bindingFlags.data();
+
+    VkDescriptorSetLayoutCreateInfo createInfo;
+    createInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    createInfo.pNext = updateAfterBind ? &bindingFlagsCreateInfo : nullptr;
+    createInfo.flags = updateAfterBind ? VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT_EXT : 0;
+    createInfo.bindingCount = static_cast<uint32_t>( bindings.size() );
+    createInfo.pBindings = bindings.data();
+
+    VkDescriptorSetLayout layout = VK_NULL_HANDLE;
+    if( vkCreateDescriptorSetLayout( device_, &createInfo, nullptr, &layout ) != VK_SUCCESS )
+        return VK_NULL_HANDLE;
+    setLayouts_.emplace( key, layout );
+    return layout;
+}
+
+VkPipelineLayout LayoutCache::GetPipelineLayout( const ShaderReflection& reflection )
+{
+    PipelineLayoutKey key;
+    for( uint32_t set = 0; set < ReflectedSetCount( reflection ); set++ )
+    {
+        VkDescriptorSetLayout setLayout = GetSetLayout( reflection, set );
+        if( setLayout == VK_NULL_HANDLE )
+            return VK_NULL_HANDLE;
+        key.setLayouts_.push_back( setLayout );
+    }
+    key.pushConstantSize_ = reflection.pushConstantSize_;
+    key.pushConstantStages_ = reflection.pushConstantSize_ ? reflection.pushConstantStages_ : 0;
+
+    lookups_++;
+    auto found = pipelineLayouts_.find( key );
+    if( found != pipelineLayouts_.end() )
+    {
+        hits_++;
+        return found->second;
+    }
+
+    VkPushConstantRange pushConstantRange;
+    pushConstantRange.stageFlags = key.pushConstantStages_;
+    pushConstantRange.offset = 0;
+    pushConstantRange.size = key.pushConstantSize_;
+
+    VkPipelineLayoutCreateInfo createInfo;
+    createInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    createInfo.pNext = nullptr;
+    createInfo.flags = 0;
+    createInfo.setLayoutCount = static_cast<uint32_t>( key.setLayouts_.size() );
+    createInfo.pSetLayouts = key.setLayouts_.data();
+    createInfo.pushConstantRangeCount = key.pushConstantSize_ ? 1 : 0;
+    createInfo.pPushConstantRanges = key.pushConstantSize_ ? &pushConstantRange : nullptr;
+
+    VkPipelineLayout layout = VK_NULL_HANDLE;
+    if( vkCreatePipelineLayout( device_, &createInfo, nullptr, &layout ) != VK_SUCCESS )
+        return VK_NULL_HANDLE;
+    pipelineLayouts_.emplace( key, layout );
+    return layout;
+}
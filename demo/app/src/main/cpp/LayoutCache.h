@@ -0,0 +1,80 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#ifndef TUTORIAL06_TEXTURE_LAYOUTCACHE_H
+#define TUTORIAL06_TEXTURE_LAYOUTCACHE_H
+
+#include <vulkan_wrapper.h>
+#include <cstdint>
+#include <map>
+#include <vector>
+#include "SpirvReflect.h"
+
+/*
+ * LayoutCache
+ *   Creates descriptor set layouts and pipeline layouts from shader
+ *   reflection and hands out the same object for the same interface, so
+ *   pipelines whose shaders declare identical bindings share their layouts
+ *   (and descriptor sets stay compatible between them).
+ *
+ *   Set layouts are keyed by their bindings, pipeline layouts by their set
+ *   layout handles and push constant range. Every object lives until
+ *   Shutdown(). Used from the render thread only.
+ *
+ *   Runtime sized arrays (bindless tables, VK_EXT_descriptor_indexing) get
+ *   runtimeArraySize descriptors, partially bound and update-after-bind;
+ *   their sets must come from pools created with
+ *   VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT_EXT. With a
+ *   runtimeArraySize of 0 shaders declaring one get no layout.
+ */
+class LayoutCache
+{
+public:
+    // runtimeArraySize: 0 unless the device was created with the descriptor indexing features BindlessTextureTable needs
+    void Init( VkDevice device, uint32_t runtimeArraySize = 0 );
+    // destroys every layout, the pipelines using them must be gone
+    void Shutdown( void );
+
+    // Layout of one set of reflection; sets without bindings get an empty layout, VK_NULL_HANDLE if it cannot be created
+    VkDescriptorSetLayout GetSetLayout( const ShaderReflection& reflection, uint32_t set );
+    // Layout of sets 0 .. ReflectedSetCount() - 1 and the push constant block of reflection
+    VkPipelineLayout GetPipelineLayout( const ShaderReflection& reflection );
+
+    uint32_t SetLayoutCount( void ) const { return static_cast<uint32_t>( setLayouts_.size() ); }
+    uint32_t PipelineLayoutCount( void ) const { return static_cast<uint32_t>( pipelineLayouts_.size() ); }
+    uint32_t Lookups( void ) const { return lookups_; }
+    uint32_t Hits( void ) const { return hits_; } // lookups that found an existing layout
+
+private:
+    struct PipelineLayoutKey
+    {
+        std::vector<VkDescriptorSetLayout> setLayouts_;
+        uint32_t pushConstantSize_;
+        VkShaderStageFlags pushConstantStages_;
+
+        bool operator<( const PipelineLayoutKey& other ) const;
+    };
+
+    VkDevice device_;
+    uint32_t runtimeArraySize_;
+    std::map<std::vector<uint32_t>, VkDescriptorSetLayout> setLayouts_; // flattened bindings -> layout
+    std::map<PipelineLayoutKey, VkPipelineLayout> pipelineLayouts_;
+    uint32_t lookups_;
+    uint32_t hits_;
+};
+
+#endif // TUTORIAL06_TEXTURE_LAYOUTCACHE_H
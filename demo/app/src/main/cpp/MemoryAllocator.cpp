@@ -0,0 +1,344 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include "MemoryAllocator.h"
+#include <android/log.h>
+#include <cassert>
+
+#ifdef VKTUTS_BENCHMARK
+#include <chrono>
+#include <random>
+#endif
+
+// Pages of big heaps, small heaps (integrated GPUs with little carve-out) use 1/8 of the heap
+static const VkDeviceSize kDefaultPageSize = 64ull * 1024 * 1024;
+static const VkDeviceSize kMinPageSize = 1ull * 1024 * 1024;
+
+void MemoryAllocator::Init( VkPhysicalDevice gpu, VkDevice device )
+{
+    device_ = device;
+    vkGetPhysicalDeviceMemoryProperties( gpu, &memoryProperties_ );
+
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties( gpu, &properties );
+    bufferImageGranularity_ = properties.limits.bufferImageGranularity;
+
+    for( uint32_t i = 0; i < memoryProperties_.memoryTypeCount; i++ )
+    {
+        VkDeviceSize heapSize = memoryProperties_.memoryHeaps[memoryProperties_.memoryTypes[i].heapIndex].size;
+        VkDeviceSize pageSize = heapSize / 8 < kDefaultPageSize ? heapSize / 8 : kDefaultPageSize;
+        pageSize_[i] = pageSize < kMinPageSize ? kMinPageSize : pageSize / kMinPageSize * kMinPageSize;
+    }
+
+    dedicatedCount_ = 0;
+    dedicatedBytes_ = 0;
+}
+
+void MemoryAllocator::Shutdown( void )
+{
+    std::lock_guard<std::mutex> lock( mutex_ );
+    for( auto& page : pages_ )
+    {
+        if( page.memory_ == VK_NULL_HANDLE )
+            continue;
+        assert( page.blocks_->Empty() );
+        if( page.mapped_ )
+            vkUnmapMemory( device_, page.memory_ );
+        vkFreeMemory( device_, page.memory_, nullptr );
+    }
+    pages_.clear();
+    assert( dedicatedCount_ == 0 );
+}
+
+// A help function to map required memory property into a VK memory type
+// memory type is an index into the array of 32 entries; or the bit index
+// for the memory type ( each BIT of an 32 bit integer is a type ).
+VkResult MemoryAllocator::FindMemoryType( uint32_t typeBits, VkMemoryPropertyFlags required, uint32_t* typeIndex ) const
+{
+    // GPU가 가진 메모리 타입중에, 필요로하는 메모리 특성을 모두 가지고 있는 메모리 타입의 index를 반환한다.
+    // requirementMask                      : 필요한 메모리 특성을 flag로 전달
+
+    // VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT  : 이 타입으로 할당된 메모리는 vkMapMemory를 통해 host가 접근 가능하다.
+    // VK_MEMORY_PROPERTY_HOST_COHERENT_BIT : host와 device가 밀착된 메모리
+    //                                      : 호스트게 메모리에 쓴 글을 flush하지 않아도 device가 바로 읽을 수 있고
+    //                                      : device가 메모리에 쓴 글도 호스트에게 visible함
+
+    // Search memtypes to find first index with those properties
+    for( uint32_t i = 0; i < memoryProperties_.memoryTypeCount; i++ )
+    {
+        if( ( typeBits & ( 1u << i ) ) && ( memoryProperties_.memoryTypes[i].propertyFlags & required ) == required )
+        {
+            *typeIndex = i;
+            return VK_SUCCESS;
+        }
+    }
+    // No memory types matched, return failure
+    return VK_ERROR_MEMORY_MAP_FAILED;
+}
+
+VkResult MemoryAllocator::AllocateDeviceMemory( uint32_t memoryType, VkDeviceSize size, VkDeviceMemory* memory, void** mapped )
+{
+    VkMemoryAllocateInfo memoryAllocateInfo;
+    memoryAllocateInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+    memoryAllocateInfo.pNext = nullptr;
+    memoryAllocateInfo.allocationSize = size;
+    memoryAllocateInfo.memoryTypeIndex = memoryType;
+    VkResult result = vkAllocateMemory( device_, &memoryAllocateInfo, nullptr, memory );
+    if( result != VK_SUCCESS )
+        return result;
+
+    *mapped = nullptr;
+    if( memoryProperties_.memoryTypes[memoryType].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT )
+    {
+        result = vkMapMemory( device_, *memory, 0, VK_WHOLE_SIZE, 0, mapped );
+        if( result != VK_SUCCESS )
+        {
+            vkFreeMemory( device_, *memory, nullptr );
+            *memory = VK_NULL_HANDLE;
+        }
+    }
+    return result;
+}
+
+VkResult MemoryAllocator::AllocateFromType( uint32_t memoryType, const VkMemoryRequirements& requirements, MemoryResourceKind kind, MemoryAllocation* allocation )
+{
+    allocation->memoryType_ = memoryType;
+
+    // dedicated allocation: a big resource would waste most of a page
+    if( requirements.size > pageSize_[memoryType] / 2 )
+    {
+        VkResult result = AllocateDeviceMemory( memoryType, requirements.size, &allocation->memory_, &allocation->mapped_ );
+        if( result != VK_SUCCESS )
+            return result;
+        allocation->offset_ = 0;
+        allocation->size_ = requirements.size;
+        allocation->page_ = kDedicatedPage;
+        allocation->block_ = BlockAllocator::kInvalidBlock;
+        dedicatedCount_++;
+        dedicatedBytes_ += requirements.size;
+        return VK_SUCCESS;
+    }
+
+    // without a granularity restriction every resource kind can share a page
+    if( bufferImageGranularity_ <= 1 )
+        kind = MEMORY_RESOURCE_LINEAR;
+
+    uint32_t freeSlot = kDedicatedPage;
+    for( uint32_t i = 0; i < pages_.size(); i++ )
+    {
+        Page& page = pages_[i];
+        if( page.memory_ == VK_NULL_HANDLE )
+        {
+            freeSlot = i;
+            continue;
+        }
+        if( page.memoryType_ != memoryType || page.kind_ != kind )
+            continue;
+
+        uint32_t block = page.blocks_->Allocate( requirements.size, requirements.alignment, &allocation->offset_ );
+        if( block == BlockAllocator::kInvalidBlock )
+            continue;
+
+        allocation->memory_ = page.memory_;
+        allocation->size_ = requirements.size;
+        allocation->mapped_ = page.mapped_ ? static_cast<char*>( page.mapped_ ) + allocation->offset_ : nullptr;
+        allocation->page_ = i;
+        allocation->block_ = block;
+        return VK_SUCCESS;
+    }
+
+    // no page of this type has room, open a new one
+    Page page;
+    page.memoryType_ = memoryType;
+    page.kind_ = kind;
+    VkResult result = AllocateDeviceMemory( memoryType, pageSize_[memoryType], &page.memory_, &page.mapped_ );
+    if( result != VK_SUCCESS )
+        return result;
+    page.blocks_.reset( new BlockAllocator( pageSize_[memoryType] ) );
+
+    uint32_t block = page.blocks_->Allocate( requirements.size, requirements.alignment, &allocation->offset_ );
+    assert( block != BlockAllocator::kInvalidBlock );
+
+    allocation->memory_ = page.memory_;
+    allocation->size_ = requirements.size;
+    allocation->mapped_ = page.mapped_ ? static_cast<char*>( page.mapped_ ) + allocation->offset_ : nullptr;
+    allocation->block_ = block;
+    if( freeSlot != kDedicatedPage )
+    {
+        pages_[freeSlot] = std::move( page );
+        allocation->page_ = freeSlot;
+    }
+    else
+    {
+        pages_.push_back( std::move( page ) );
+        allocation->page_ = static_cast<uint32_t>( pages_.size() - 1 );
+    }
+    return VK_SUCCESS;
+}
+
+VkResult MemoryAllocator::Allocate( const VkMemoryRequirements& requirements, VkMemoryPropertyFlags required, MemoryResourceKind kind, MemoryAllocation* allocation )
+{
+    std::lock_guard<std::mutex> lock( mutex_ );
+
+    // A heap can run out while another type with the same properties still has room
+    VkResult result = VK_ERROR_MEMORY_MAP_FAILED;
+    uint32_t typeBits = requirements.memoryTypeBits;
+    uint32_t memoryType;
+    while( FindMemoryType( typeBits, required, &memoryType ) == VK_SUCCESS )
+    {
+        result = AllocateFromType( memoryType, requirements, kind, allocation );
+        if( result == VK_SUCCESS )
+            break;
+        typeBits &= ~( 1u << memoryType );
+    }
+    return result;
+}
+
+VkResult MemoryAllocator::AllocateForImage( VkImage image, VkImageTiling tiling, VkMemoryPropertyFlags required, MemoryAllocation* allocation )
+{
+    VkMemoryRequirements memoryRequirements;
+    vkGetImageMemoryRequirements( device_, image, &memoryRequirements );
+
+    VkResult result = Allocate( memoryRequirements, required, tiling == VK_IMAGE_TILING_OPTIMAL ? MEMORY_RESOURCE_OPTIMAL : MEMORY_RESOURCE_LINEAR, allocation );
+    if( result != VK_SUCCESS )
+        return result;
+    return vkBindImageMemory( device_, image, allocation->memory_, allocation->offset_ );
+}
+
+VkResult MemoryAllocator::AllocateForBuffer( VkBuffer buffer, VkMemoryPropertyFlags required, MemoryAllocation* allocation )
+{
+    VkMemoryRequirements memoryRequirements;
+    vkGetBufferMemoryRequirements( device_, buffer, &memoryRequirements );
+
+    VkResult result = Allocate( memoryRequirements, required, MEMORY_RESOURCE_LINEAR, allocation );
+    if( result != VK_SUCCESS )
+        return result;
+    return vkBindBufferMemory( device_, buffer, allocation->memory_, allocation->offset_ );
+}
+
+void MemoryAllocator::Free( MemoryAllocation& allocation )
+{
+    if( allocation.memory_ == VK_NULL_HANDLE )
+        return;
+
+    std::lock_guard<std::mutex> lock( mutex_ );
+    if( allocation.page_ == kDedicatedPage )
+    {
+        if( allocation.mapped_ )
+            vkUnmapMemory( device_, allocation.memory_ );
+        vkFreeMemory( device_, allocation.memory_, nullptr );
+        dedicatedCount_--;
+        dedicatedBytes_ -= allocation.size_;
+    }
+    else
+    {
+        Page& page = pages_[allocation.page_];
+        page.blocks_->Free( allocation.block_ );
+
+        // keep one empty page per type so alloc/free cycles do not hit vkAllocateMemory
+        if( page.blocks_->Empty() )
+        {
+            for( uint32_t i = 0; i < pages_.size(); i++ )
+            {
+                Page& other = pages_[i];
+                if( i == allocation.page_ || other.memory_ == VK_NULL_HANDLE || other.memoryType_ != page.memoryType_ || other.kind_ != page.kind_ || !other.blocks_->Empty() )
+                    continue;
+                if( page.mapped_ )
+                    vkUnmapMemory( device_, page.memory_ );
+                vkFreeMemory( device_, page.memory_, nullptr );
+                page.memory_ = VK_NULL_HANDLE;
+                page.blocks_.reset();
+                break;
+            }
+        }
+    }
+    allocation.memory_ = VK_NULL_HANDLE;
+    allocation.mapped_ = nullptr;
+}
+
+MemoryAllocatorStats MemoryAllocator::Stats( void ) const
+{
+    std::lock_guard<std::mutex> lock( mutex_ );
+
+    MemoryAllocatorStats stats;
+    stats.deviceMemoryCount_ = dedicatedCount_;
+    stats.allocationCount_ = dedicatedCount_;
+    stats.reservedBytes_ = dedicatedBytes_;
+    stats.usedBytes_ = dedicatedBytes_;
+    stats.fragmentation_ = 0.0f;
+
+    uint32_t fragmentedPages = 0;
+    for( auto& page : pages_ )
+    {
+        if( page.memory_ == VK_NULL_HANDLE )
+            continue;
+        stats.deviceMemoryCount_++;
+        stats.allocationCount_ += page.blocks_->AllocationCount();
+        stats.reservedBytes_ += page.blocks_->Size();
+        stats.usedBytes_ += page.blocks_->UsedSize();
+
+        VkDeviceSize freeBytes = page.blocks_->Size() - page.blocks_->UsedSize();
+        if( freeBytes )
+        {
+            stats.fragmentation_ += 1.0f - static_cast<float>( page.blocks_->LargestFreeBlock() ) / freeBytes;
+            fragmentedPages++;
+        }
+    }
+    if( fragmentedPages )
+        stats.fragmentation_ /= fragmentedPages;
+    return stats;
+}
+
+#ifdef VKTUTS_BENCHMARK
+void BenchmarkBlockAllocatorChurn( void )
+{
+    // one 64MB page, allocations between 256B and 1MB with power of two alignments
+    const uint32_t kOperations = 1000000;
+    BlockAllocator blocks( kDefaultPageSize );
+    std::vector<uint32_t> live;
+    std::mt19937 random( 1 );
+    uint32_t failures = 0;
+
+    auto start = std::chrono::steady_clock::now();
+    for( uint32_t i = 0; i < kOperations; i++ )
+    {
+        if( live.empty() || random() % 2 )
+        {
+            uint64_t offset;
+            uint32_t block = blocks.Allocate( 256 + random() % ( 1024 * 1024 ), 1u << ( random() % 12 ), &offset );
+            if( block == BlockAllocator::kInvalidBlock )
+                failures++;
+            else
+                live.push_back( block );
+        }
+        else
+        {
+            size_t index = random() % live.size();
+            blocks.Free( live[index] );
+            live[index] = live.back();
+            live.pop_back();
+        }
+    }
+    double seconds = std::chrono::duration<double>( std::chrono::steady_clock::now() - start ).count();
+
+    uint64_t freeBytes = blocks.Size() - blocks.UsedSize();
+    __android_log_print( ANDROID_LOG_INFO, "Vulkan-Tutorial06",
+                         "block allocator churn: %.0f ops/s, %u live, %u failed, %u free blocks, fragmentation %.2f",
+                         kOperations / seconds, static_cast<uint32_t>( live.size() ), failures, blocks.FreeBlockCount(),
+                         freeBytes ? 1.0 - static_cast<double>( blocks.LargestFreeBlock() ) / freeBytes : 0.0 );
+}
+#endif
@@ -0,0 +1,116 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#ifndef TUTORIAL06_TEXTURE_MEMORYALLOCATOR_H
+#define TUTORIAL06_TEXTURE_MEMORYALLOCATOR_H
+
+#include <vulkan_wrapper.h>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "BlockAllocator.h"
+
+// Buffers and linear images must not share a bufferImageGranularity page with optimal images
+enum MemoryResourceKind
+{
+    MEMORY_RESOURCE_LINEAR,  // buffers, VK_IMAGE_TILING_LINEAR images
+    MEMORY_RESOURCE_OPTIMAL, // VK_IMAGE_TILING_OPTIMAL images
+};
+
+struct MemoryAllocation
+{
+    VkDeviceMemory memory_;
+    VkDeviceSize offset_;
+    VkDeviceSize size_;
+    void* mapped_;        // host pointer to offset_, nullptr if the memory is not host visible
+    uint32_t memoryType_;
+    uint32_t page_;       // MemoryAllocator::kDedicatedPage for dedicated allocations
+    uint32_t block_;
+};
+
+struct MemoryAllocatorStats
+{
+    uint32_t deviceMemoryCount_; // live vkAllocateMemory allocations
+    uint32_t allocationCount_;   // live sub-allocations, dedicated ones included
+    VkDeviceSize reservedBytes_;
+    VkDeviceSize usedBytes_;
+    float fragmentation_;        // 1 - largest free block / free bytes, averaged over pages
+};
+
+/*
+ * MemoryAllocator
+ *   Replaces one vkAllocateMemory per resource with sub-allocation out of
+ *   large per-memory-type pages. Each page is carved up by a BlockAllocator
+ *   (TLSF), so the alignment from VkMemoryRequirements is honoured and freed
+ *   ranges are reused. When the device reports a bufferImageGranularity
+ *   bigger than 1, linear and optimal resources get separate pages and can
+ *   never alias inside one granularity page.
+ *
+ *   Resources bigger than half a page get their own dedicated
+ *   VkDeviceMemory. Host visible pages are mapped once for their whole
+ *   lifetime; MemoryAllocation::mapped_ points at the resource.
+ *
+ *   All methods are thread safe.
+ */
+class MemoryAllocator
+{
+public:
+    static const uint32_t kDedicatedPage = ~0u;
+
+    void Init( VkPhysicalDevice gpu, VkDevice device );
+    // every allocation must have been freed
+    void Shutdown( void );
+
+    VkResult FindMemoryType( uint32_t typeBits, VkMemoryPropertyFlags required, uint32_t* typeIndex ) const;
+
+    VkResult Allocate( const VkMemoryRequirements& requirements, VkMemoryPropertyFlags required, MemoryResourceKind kind, MemoryAllocation* allocation );
+    // Allocate and bind memory for the resource
+    VkResult AllocateForImage( VkImage image, VkImageTiling tiling, VkMemoryPropertyFlags required, MemoryAllocation* allocation );
+    VkResult AllocateForBuffer( VkBuffer buffer, VkMemoryPropertyFlags required, MemoryAllocation* allocation );
+    void Free( MemoryAllocation& allocation );
+
+    MemoryAllocatorStats Stats( void ) const;
+
+private:
+    struct Page
+    {
+        VkDeviceMemory memory_;
+        void* mapped_;
+        uint32_t memoryType_;
+        MemoryResourceKind kind_;
+        std::unique_ptr<BlockAllocator> blocks_;
+    };
+
+    VkResult AllocateDeviceMemory( uint32_t memoryType, VkDeviceSize size, VkDeviceMemory* memory, void** mapped );
+    VkResult AllocateFromType( uint32_t memoryType, const VkMemoryRequirements& requirements, MemoryResourceKind kind, MemoryAllocation* allocation );
+
+    VkDevice device_;
+    VkPhysicalDeviceMemoryProperties memoryProperties_;
+    VkDeviceSize bufferImageGranularity_;
+    VkDeviceSize pageSize_[VK_MAX_MEMORY_TYPES];
+    std::vector<Page> pages_; // freed pages keep their slot with memory_ == VK_NULL_HANDLE
+    uint32_t dedicatedCount_;
+    VkDeviceSize dedicatedBytes_;
+    mutable std::mutex mutex_;
+};
+
+#ifdef VKTUTS_BENCHMARK
+// Random allocate/free churn on a BlockAllocator, logs allocations per second and fragmentation
+void BenchmarkBlockAllocatorChurn( void );
+#endif
+
+#endif // TUTORIAL06_TEXTURE_MEMORYALLOCATOR_H
@@ -0,0 +1,143 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include "PipelineCacheFile.h"
+#include "FileUtils.h"
+#include <android/log.h>
+#include <unistd.h>
+#include <cstring>
+#include <vector>
+
+// "VKPC"
+static const uint32_t kFileMagic = 0x43504B56;
+static const uint32_t kFileVersion = 1;
+// a pipeline cache of a small app is a few hundred KB, anything this big is garbage
+static const uint32_t kMaxDataSize = 64 * 1024 * 1024;
+// headerSize, headerVersion, vendorID, deviceID, pipelineCacheUUID of VK_PIPELINE_CACHE_HEADER_VERSION_ONE
+static const uint32_t kCacheHeaderSize = 16 + VK_UUID_SIZE;
+
+struct PipelineCacheFileHeader
+{
+    uint32_t magic_;
+    uint32_t version_;
+    uint32_t dataSize_;
+    uint32_t reserved_;
+    uint64_t checksum_;
+};
+
+static uint32_t ReadUint32( const uint8_t* data )
+{
+    uint32_t value;
+    memcpy( &value, data, sizeof( value ) );
+    return value;
+}
+
+// Cache blob of path, empty if the file is missing, broken or made by another device or driver
+static std::vector<uint8_t> LoadCacheData( VkPhysicalDevice gpu, const char* path )
+{
+    std::vector<uint8_t> content;
+    if( !ReadFile( path, &content ) )
+        return std::vector<uint8_t>();
+
+    const char* problem = nullptr;
+    PipelineCacheFileHeader header;
+    if( content.size() < sizeof( header ) )
+        problem = "truncated";
+    else
+    {
+        memcpy( &header, content.data(), sizeof( header ) );
+        const uint8_t* data = content.data() + sizeof( header );
+        if( header.magic_ != kFileMagic || header.version_ != kFileVersion )
+            problem = "unknown format";
+        else if( header.dataSize_ > kMaxDataSize || header.dataSize_ != content.size() - sizeof( header ) || header.dataSize_ < kCacheHeaderSize )
+            problem = "truncated";
+        else if( header.checksum_ != Fnv1a64( data, header.dataSize_ ) )
+            problem = "checksum mismatch";
+        else
+        {
+            VkPhysicalDeviceProperties properties;
+            vkGetPhysicalDeviceProperties( gpu, &properties );
+            if( ReadUint32( data ) < kCacheHeaderSize || ReadUint32( data + 4 ) != VK_PIPELINE_CACHE_HEADER_VERSION_ONE )
+                problem = "unknown cache header";
+            else if( ReadUint32( data + 8 ) != properties.vendorID || ReadUint32( data + 12 ) != properties.deviceID )
+                problem = "made by another device";
+            else if( memcmp( data + 16, properties.pipelineCacheUUID, VK_UUID_SIZE ) )
+                problem = "made by another driver version";
+        }
+    }
+
+    if( problem )
+    {
+        __android_log_print( ANDROID_LOG_WARN, "Vulkan-Tutorial06", "pipeline cache %s: %s, starting empty", path, problem );
+        unlink( path );
+        return std::vector<uint8_t>();
+    }
+    return std::vector<uint8_t>( content.begin() + sizeof( header ), content.end() );
+}
+
+VkResult CreatePipelineCacheFromFile( VkPhysicalDevice gpu, VkDevice device, const char* path, VkPipelineCache* cache, bool* warm )
+{
+    std::vector<uint8_t> data = LoadCacheData( gpu, path );
+
+    VkPipelineCacheCreateInfo pipelineCacheInfo;
+    pipelineCacheInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+    pipelineCacheInfo.pNext = nullptr;
+    pipelineCacheInfo.initialDataSize = data.size();
+    pipelineCacheInfo.pInitialData = data.empty() ? nullptr : data.data();
+    pipelineCacheInfo.flags = 0;  // reserved, must be 0
+
+    VkResult result = vkCreatePipelineCache( device, &pipelineCacheInfo, nullptr, cache );
+    if( result != VK_SUCCESS && !data.empty() )
+    {
+        // the driver rejected data that passed every check, drop it rather than failing
+        __android_log_print( ANDROID_LOG_WARN, "Vulkan-Tutorial06", "pipeline cache %s: rejected by the driver, starting empty", path );
+        unlink( path );
+        data.clear();
+        pipelineCacheInfo.initialDataSize = 0;
+        pipelineCacheInfo.pInitialData = nullptr;
+        result = vkCreatePipelineCache( device, &pipelineCacheInfo, nullptr, cache );
+    }
+    *warm = !data.empty();
+    return result;
+}
+
+bool SavePipelineCacheToFile( VkDevice device, VkPipelineCache cache, const char* path )
+{
+    size_t size = 0;
+    if( vkGetPipelineCacheData( device, cache, &size, nullptr ) != VK_SUCCESS || size == 0 || size > kMaxDataSize )
+        return false;
+
+    // header and blob in one buffer, written in one go
+    PipelineCacheFileHeader header;
+    std::vector<uint8_t> content( sizeof( header ) + size );
+    if( vkGetPipelineCacheData( device, cache, &size, content.data() + sizeof( header ) ) != VK_SUCCESS )
+        return false;
+
+    header.magic_ = kFileMagic;
+    header.version_ = kFileVersion;
+    header.dataSize_ = static_cast<uint32_t>( size );
+    header.reserved_ = 0;
+    header.checksum_ = Fnv1a64( content.data() + sizeof( header ), size );
+    memcpy( content.data(), &header, sizeof( header ) );
+
+    if( !WriteFileAtomic( path, content.data(), sizeof( header ) + size ) )
+    {
+        __android_log_print( ANDROID_LOG_WARN, "Vulkan-Tutorial06", "pipeline cache %s: could not be saved", path );
+        return false;
+    }
+    return true;
+}
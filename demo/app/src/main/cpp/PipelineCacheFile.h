@@ -0,0 +1,42 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#ifndef TUTORIAL06_TEXTURE_PIPELINECACHEFILE_H
+#define TUTORIAL06_TEXTURE_PIPELINECACHEFILE_H
+
+#include <vulkan_wrapper.h>
+
+/*
+ * PipelineCacheFile
+ *   Keeps the VkPipelineCache contents on disk, so pipelines compiled in one
+ *   run are not compiled again in the next.
+ *
+ *   The file is the vkGetPipelineCacheData blob behind a small header with
+ *   its size and checksum. On load the blob's own header has to match this
+ *   device's vendorID, deviceID and pipelineCacheUUID (a driver update
+ *   changes the UUID); a truncated, corrupt or foreign file is deleted and
+ *   the cache starts empty. Saving writes a temporary file and renames it
+ *   over the old one, so a crash mid-write never leaves half a file behind.
+ */
+
+// Creates cache from the file at path if it is valid for gpu, empty otherwise; warm tells which one it was
+VkResult CreatePipelineCacheFromFile( VkPhysicalDevice gpu, VkDevice device, const char* path, VkPipelineCache* cache, bool* warm );
+
+// Writes the contents of cache to path, returns false if that failed
+bool SavePipelineCacheToFile( VkDevice device, VkPipelineCache cache, const char* path );
+
+#endif // TUTORIAL06_TEXTURE_PIPELINECACHEFILE_H
@@ -0,0 +1,137 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include "PipelineDesc.h"
+#include "FileUtils.h"
+#include <cassert>
+#include <cstring>
+
+PipelineDesc DefaultPipelineDesc( void )
+{
+    PipelineDesc desc;
+    // unused vertex attributes included
+    memset( &desc, 0, sizeof( desc ) );
+    desc.topology_ = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+    desc.polygonMode_ = VK_POLYGON_MODE_FILL;
+    desc.cullMode_ = VK_CULL_MODE_NONE;
+    desc.frontFace_ = VK_FRONT_FACE_CLOCKWISE;
+    desc.depthTestEnable_ = VK_FALSE;
+    desc.depthWriteEnable_ = VK_FALSE;
+    desc.depthCompareOp_ = VK_COMPARE_OP_LESS_OR_EQUAL;
+    desc.blendEnable_ = VK_FALSE;
+    desc.srcBlendFactor_ = VK_BLEND_FACTOR_ONE;
+    desc.dstBlendFactor_ = VK_BLEND_FACTOR_ZERO;
+    desc.blendOp_ = VK_BLEND_OP_ADD;
+    desc.colorWriteMask_ = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
+    return desc;
+}
+
+void SetSpecialization( PipelineDesc* desc, uint32_t constantId, uint32_t value )
+{
+    // kept sorted by id, so the order constants are set in changes neither equality nor the hash
+    uint32_t i = 0;
+    while( i < desc->specializationCount_ && desc->specializations_[i].constantId_ < constantId )
+        i++;
+    if( i < desc->specializationCount_ && desc->specializations_[i].constantId_ == constantId )
+    {
+        desc->specializations_[i].value_ = value;
+        return;
+    }
+    assert( desc->specializationCount_ < kMaxSpecializationConstants );
+    for( uint32_t j = desc->specializationCount_; j > i; j-- )
+        desc->specializations_[j] = desc->specializations_[j - 1];
+    desc->specializations_[i] = { constantId, value };
+    desc->specializationCount_++;
+}
+
+static bool SameShader( const char* a, const char* b )
+{
+    return a == b || ( a && b && strcmp( a, b ) == 0 );
+}
+
+bool operator==( const PipelineDesc& a, const PipelineDesc& b )
+{
+    if( !SameShader( a.vertexShader_, b.vertexShader_ ) || !SameShader( a.fragmentShader_, b.fragmentShader_ ) )
+        return false;
+    if( a.vertexStride_ != b.vertexStride_ || a.vertexAttributeCount_ != b.vertexAttributeCount_ || a.topology_ != b.topology_ )
+        return false;
+    for( uint32_t i = 0; i < a.vertexAttributeCount_; i++ )
+    {
+        const PipelineVertexAttribute& attributeA = a.vertexAttributes_[i];
+        const PipelineVertexAttribute& attributeB = b.vertexAttributes_[i];
+        if( attributeA.location_ != attributeB.location_ || attributeA.format_ != attributeB.format_ || attributeA.offset_ != attributeB.offset_ )
+            return false;
+    }
+    if( a.specializationCount_ != b.specializationCount_ )
+        return false;
+    for( uint32_t i = 0; i < a.specializationCount_; i++ )
+    {
+        if( a.specializations_[i].constantId_ != b.specializations_[i].constantId_ || a.specializations_[i].value_ != b.specializations_[i].value_ )
+            return false;
+    }
+    return a.polygonMode_ == b.polygonMode_ && a.cullMode_ == b.cullMode_ && a.frontFace_ == b.frontFace_ &&
+           a.depthTestEnable_ == b.depthTestEnable_ && a.depthWriteEnable_ == b.depthWriteEnable_ && a.depthCompareOp_ == b.depthCompareOp_ &&
+           a.blendEnable_ == b.blendEnable_ && a.srcBlendFactor_ == b.srcBlendFactor_ && a.dstBlendFactor_ == b.dstBlendFactor_ &&
+           a.blendOp_ == b.blendOp_ && a.colorWriteMask_ == b.colorWriteMask_ && a.layout_ == b.layout_ && a.renderPass_ == b.renderPass_ && a.subpass_ == b.subpass_;
+}
+
+template <typename T>
+static uint64_t HashValue( const T& value, uint64_t hash )
+{
+    return Fnv1a64( &value, sizeof( value ), hash );
+}
+
+static uint64_t HashShader( const char* path, uint64_t hash )
+{
+    return path ? Fnv1a64( path, strlen( path ) + 1, hash ) : HashValue( '\0', hash );
+}
+
+// field by field, the same fields operator== compares
+uint64_t HashPipelineDesc( const PipelineDesc& desc )
+{
+    uint64_t hash = HashShader( desc.vertexShader_, kFnv1aSeed );
+    hash = HashShader( desc.fragmentShader_, hash );
+    hash = HashValue( desc.vertexStride_, hash );
+    hash = HashValue( desc.vertexAttributeCount_, hash );
+    for( uint32_t i = 0; i < desc.vertexAttributeCount_; i++ )
+    {
+        hash = HashValue( desc.vertexAttributes_[i].location_, hash );
+        hash = HashValue( desc.vertexAttributes_[i].format_, hash );
+        hash = HashValue( desc.vertexAttributes_[i].offset_, hash );
+    }
+    hash = HashValue( desc.topology_, hash );
+    hash = HashValue( desc.specializationCount_, hash );
+    for( uint32_t i = 0; i < desc.specializationCount_; i++ )
+    {
+        hash = HashValue( desc.specializations_[i].constantId_, hash );
+        hash = HashValue( desc.specializations_[i].value_, hash );
+    }
+    hash = HashValue( desc.polygonMode_, hash );
+    hash = HashValue( desc.cullMode_, hash );
+    hash = HashValue( desc.frontFace_, hash );
+    hash = HashValue( desc.depthTestEnable_, hash );
+    hash = HashValue( desc.depthWriteEnable_, hash );
+    hash = HashValue( desc.depthCompareOp_, hash );
+    hash = HashValue( desc.blendEnable_, hash );
+    hash = HashValue( desc.srcBlendFactor_, hash );
+    hash = HashValue( desc.dstBlendFactor_, hash );
+    hash = HashValue( desc.blendOp_, hash );
+    hash = HashValue( desc.colorWriteMask_, hash );
+    hash = HashValue( desc.layout_, hash );
+    hash = HashValue( desc.renderPass_, hash );
+    return HashValue( desc.subpass_, hash );
+}
@@ -0,0 +1,110 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#ifndef TUTORIAL06_TEXTURE_PIPELINEDESC_H
+#define TUTORIAL06_TEXTURE_PIPELINEDESC_H
+
+#include <vulkan_wrapper.h>
+#include <cstddef>
+#include <cstdint>
+
+static const uint32_t kMaxVertexAttributes = 4;
+static const uint32_t kMaxSpecializationConstants = 4;
+
+struct PipelineVertexAttribute
+{
+    uint32_t location_;
+    VkFormat format_;
+    uint32_t offset_;
+};
+
+// Value of one shader specialization constant: int, uint, bool (VK_TRUE/VK_FALSE) or the bits of a float
+struct PipelineSpecialization
+{
+    uint32_t constantId_;
+    uint32_t value_;
+};
+
+/*
+ * PipelineDesc
+ *   The state that tells two graphics pipelines of this app apart, as a
+ *   plain value that can be compared and hashed; the Vk*StateCreateInfo
+ *   structs are only filled in from it when a pipeline is actually built.
+ *
+ *   Shaders are asset paths compared by their text, the strings have to
+ *   outlive every pipeline made from the desc (literals do). The pipeline
+ *   layout and render pass are compared by handle: LayoutCache hands out one
+ *   layout per shader interface, and compatible but different render passes
+ *   get pipelines of their own. Viewport and scissor are not part of it,
+ *   they are dynamic state set where the draws are recorded, so one
+ *   pipeline serves every swapchain size.
+ *
+ *   Shader variants are specializations of the same shaders: their
+ *   constant_id values are part of the desc, so each variant is a pipeline
+ *   of its own (and an entry of its own in the pipeline cache) while the
+ *   shaders are compiled once.
+ */
+struct PipelineDesc
+{
+    const char* vertexShader_;
+    const char* fragmentShader_;
+
+    uint32_t vertexStride_;
+    uint32_t vertexAttributeCount_;
+    PipelineVertexAttribute vertexAttributes_[kMaxVertexAttributes];
+    VkPrimitiveTopology topology_;
+
+    // set in both stages, a stage ignores ids it does not declare; sorted by constantId_
+    uint32_t specializationCount_;
+    PipelineSpecialization specializations_[kMaxSpecializationConstants];
+
+    VkPolygonMode polygonMode_;
+    VkCullModeFlags cullMode_;
+    VkFrontFace frontFace_;
+
+    VkBool32 depthTestEnable_;
+    VkBool32 depthWriteEnable_;
+    VkCompareOp depthCompareOp_;
+
+    VkBool32 blendEnable_;
+    VkBlendFactor srcBlendFactor_; // color and alpha
+    VkBlendFactor dstBlendFactor_;
+    VkBlendOp blendOp_;
+    VkColorComponentFlags colorWriteMask_;
+
+    VkPipelineLayout layout_;
+    VkRenderPass renderPass_;
+    uint32_t subpass_;
+};
+
+// Opaque filled triangle lists without culling, depth or blending; shaders, vertex layout, layout and render pass are left empty
+PipelineDesc DefaultPipelineDesc( void );
+
+// Sets constant constantId of desc's shaders to value, replacing an earlier value of it
+void SetSpecialization( PipelineDesc* desc, uint32_t constantId, uint32_t value );
+
+bool operator==( const PipelineDesc& a, const PipelineDesc& b );
+inline bool operator!=( const PipelineDesc& a, const PipelineDesc& b ) { return !( a == b ); }
+
+uint64_t HashPipelineDesc( const PipelineDesc& desc );
+
+struct PipelineDescHash
+{
+    size_t operator()( const PipelineDesc& desc ) const { return static_cast<size_t>( HashPipelineDesc( desc ) ); }
+};
+
+#endif // TUTORIAL06_TEXTURE_PIPELINEDESC_H
@@ -0,0 +1,238 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include "PipelineManager.h"
+#include <cstring>
+
+static double MillisecondsBetween( std::chrono::steady_clock::time_point from, std::chrono::steady_clock::time_point to )
+{
+    return std::chrono::duration<double, std::milli>( to - from ).count();
+}
+
+void PipelineManager::Init( VkDevice device, JobSystem* jobSystem, PipelineBuilder builder )
+{
+    device_ = device;
+    jobSystem_ = jobSystem;
+    builder_ = std::move( builder );
+    lookups_ = 0;
+    hits_ = 0;
+    builds_ = 0;
+}
+
+void PipelineManager::Shutdown( void )
+{
+    Wait();
+    for( auto& entry : entries_ )
+    {
+        vkDestroyPipeline( device_, entry->pipeline_, nullptr );
+        if( entry->rebuilding_ )
+            vkDestroyPipeline( device_, entry->rebuilt_, nullptr );
+    }
+    entries_.clear();
+    lookup_.clear();
+}
+
+uint32_t PipelineManager::Create( const char* name, const PipelineDesc& desc )
+{
+    uint32_t id = Add( name, desc, kNoFallback, false );
+    // an earlier async request of the same desc may still be building
+    if( !IsReady( id ) )
+        Wait();
+    return id;
+}
+
+uint32_t PipelineManager::CreateAsync( const char* name, const PipelineDesc& desc, uint32_t fallback )
+{
+    return Add( name, desc, fallback, true );
+}
+
+uint32_t PipelineManager::Add( const char* name, const PipelineDesc& desc, uint32_t fallback, bool async )
+{
+    lookups_++;
+    auto found = lookup_.find( desc );
+    if( found != lookup_.end() )
+    {
+        hits_++;
+        return found->second;
+    }
+
+    std::unique_ptr<Entry> entry( new Entry );
+    entry->name_ = name;
+    entry->desc_ = desc;
+    entry->fallback_ = fallback;
+    entry->async_ = async;
+    entry->pipeline_ = VK_NULL_HANDLE;
+    entry->ready_.store( false, std::memory_order_relaxed );
+    entry->stats_ = PipelineStats{ entry->name_.c_str(), 0.0, 0.0, 0.0 };
+    entry->rebuilt_ = VK_NULL_HANDLE;
+    entry->rebuildDone_.store( false, std::memory_order_relaxed );
+    entry->rebuilding_ = false;
+    entry->dirty_ = false;
+    entry->rebuildStats_ = entry->stats_;
+
+    uint32_t id = static_cast<uint32_t>( entries_.size() );
+    entries_.push_back( std::move( entry ) );
+    lookup_.emplace( desc, id );
+    Start( *entries_.back() );
+    return id;
+}
+
+void PipelineManager::Wait( void )
+{
+    if( pending_.pending_.load( std::memory_order_acquire ) != 0 )
+        jobSystem_->Wait( pending_ );
+}
+
+void PipelineManager::Start( Entry& entry )
+{
+    builds_++;
+    entry.requested_ = std::chrono::steady_clock::now();
+    if( !entry.async_ )
+    {
+        Build( entry, false );
+        return;
+    }
+    Entry* buildEntry = &entry;
+    jobSystem_->Submit( [this, buildEntry]() { Build( *buildEntry, false ); }, &pending_ );
+}
+
+void PipelineManager::StartRebuild( Entry& entry )
+{
+    builds_++;
+    entry.dirty_ = false;
+    entry.rebuilding_ = true;
+    entry.rebuildDone_.store( false, std::memory_order_relaxed );
+    entry.requested_ = std::chrono::steady_clock::now();
+    Entry* buildEntry = &entry;
+    jobSystem_->Submit( [this, buildEntry]() { Build( *buildEntry, true ); }, &pending_ );
+}
+
+void PipelineManager::Build( Entry& entry, bool rebuild ) const
+{
+    auto start = std::chrono::steady_clock::now();
+    VkPipeline pipeline = builder_( entry.desc_ );
+    auto end = std::chrono::steady_clock::now();
+
+    PipelineStats& stats = rebuild ? entry.rebuildStats_ : entry.stats_;
+    stats.queueMs_ = MillisecondsBetween( entry.requested_, start );
+    stats.compileMs_ = MillisecondsBetween( start, end );
+    stats.readyMs_ = MillisecondsBetween( entry.requested_, end );
+    if( rebuild )
+    {
+        entry.rebuilt_ = pipeline;
+        entry.rebuildDone_.store( true, std::memory_order_release );
+        return;
+    }
+    entry.pipeline_ = pipeline;
+    entry.ready_.store( true, std::memory_order_release );
+}
+
+static bool UsesShader( const PipelineDesc& desc, const char* shaderPath )
+{
+    return ( desc.vertexShader_ && strcmp( desc.vertexShader_, shaderPath ) == 0 ) ||
+           ( desc.fragmentShader_ && strcmp( desc.fragmentShader_, shaderPath ) == 0 );
+}
+
+uint32_t PipelineManager::Rebuild( const char* shaderPath )
+{
+    uint32_t count = 0;
+    for( auto& entry : entries_ )
+    {
+        if( !UsesShader( entry->desc_, shaderPath ) )
+            continue;
+        count++;
+        // a build already running may have read the old shader, go again once it is done
+        if( entry->rebuilding_ || !entry->ready_.load( std::memory_order_acquire ) )
+            entry->dirty_ = true;
+        else
+            StartRebuild( *entry );
+    }
+    return count;
+}
+
+bool PipelineManager::Update( std::vector<VkPipeline>* replaced )
+{
+    bool finished = false;
+    for( auto& entry : entries_ )
+    {
+        if( entry->rebuilding_ && entry->rebuildDone_.load( std::memory_order_acquire ) )
+        {
+            entry->rebuilding_ = false;
+            finished = true;
+            if( entry->rebuilt_ != VK_NULL_HANDLE )
+            {
+                if( entry->pipeline_ != VK_NULL_HANDLE )
+                    replaced->push_back( entry->pipeline_ );
+                entry->pipeline_ = entry->rebuilt_;
+                entry->stats_ = entry->rebuildStats_;
+            }
+            entry->rebuilt_ = VK_NULL_HANDLE;
+        }
+        if( entry->dirty_ && !entry->rebuilding_ && entry->ready_.load( std::memory_order_acquire ) )
+            StartRebuild( *entry );
+    }
+    return finished;
+}
+
+bool PipelineManager::Rebuilding( void ) const
+{
+    for( const auto& entry : entries_ )
+    {
+        if( entry->rebuilding_ || entry->dirty_ )
+            return true;
+    }
+    return false;
+}
+
+bool PipelineManager::IsReady( uint32_t id ) const
+{
+    return entries_[id]->ready_.load( std::memory_order_acquire );
+}
+
+bool PipelineManager::AllReady( void ) const
+{
+    for( const auto& entry : entries_ )
+    {
+        if( !entry->ready_.load( std::memory_order_acquire ) )
+            return false;
+    }
+    return true;
+}
+
+PipelineLookupStats PipelineManager::LookupStats( void ) const
+{
+    PipelineLookupStats stats = { lookups_, hits_, 0, 0.0 };
+    for( const auto& entry : entries_ )
+    {
+        if( !entry->ready_.load( std::memory_order_acquire ) )
+            continue;
+        stats.pipelines_++;
+        stats.buildMs_ += entry->stats_.compileMs_;
+    }
+    return stats;
+}
+
+VkPipeline PipelineManager::Get( uint32_t id ) const
+{
+    const Entry& entry = *entries_[id];
+    // a pipeline whose shaders did not build falls back too
+    if( entry.ready_.load( std::memory_order_acquire ) && entry.pipeline_ != VK_NULL_HANDLE )
+        return entry.pipeline_;
+    if( entry.fallback_ != kNoFallback )
+        return Get( entry.fallback_ );
+    return VK_NULL_HANDLE;
+}
@@ -0,0 +1,151 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#ifndef TUTORIAL06_TEXTURE_PIPELINEMANAGER_H
+#define TUTORIAL06_TEXTURE_PIPELINEMANAGER_H
+
+#include <vulkan_wrapper.h>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "JobSystem.h"
+#include "PipelineDesc.h"
+
+// Creates the pipeline of a desc; async builds run it on a job system thread
+typedef std::function<VkPipeline( const PipelineDesc& desc )> PipelineBuilder;
+
+// Timing of the last build of a pipeline
+struct PipelineStats
+{
+    const char* name_;
+    double queueMs_;   // request until a thread started the build
+    double compileMs_; // build function
+    double readyMs_;   // request until ready
+};
+
+// How well requests are served by pipelines that already exist
+struct PipelineLookupStats
+{
+    uint32_t lookups_;
+    uint32_t hits_;     // lookups that found a pipeline of an identical desc
+    uint32_t pipelines_;
+    double buildMs_;    // sum of the last build of every ready pipeline
+};
+
+/*
+ * PipelineManager
+ *   Builds graphics pipelines on the job system so that compiling them does
+ *   not hold up the frame loop. The builder passes the same VkPipelineCache
+ *   to every build; Vulkan synchronizes caches internally.
+ *
+ *   Pipelines are requested by PipelineDesc. A request for a desc that was
+ *   requested before returns the existing pipeline instead of building an
+ *   identical one, so many materials sharing a few states cost a few builds.
+ *
+ *   An async pipeline may name a fallback, usually a simpler pipeline built
+ *   up front with Create(). Until the build has finished Get() returns the
+ *   fallback, so draws recorded meanwhile use it and the first frame recorded
+ *   afterwards picks up the real pipeline; nothing waits for the compile.
+ *
+ *   Pipelines can be rebuilt when a shader changed (hot reload). The current
+ *   pipeline stays in use while the new one builds on the job system, and
+ *   Update() swaps it in between frames, handing the old one back so it can
+ *   be destroyed once no frame in flight uses it. A shader that no longer
+ *   compiles leaves the current pipeline in place.
+ *
+ *   The builder runs on other threads and must only read state that stays
+ *   alive and unchanged until its pipeline is ready. Everything else is
+ *   called from the render thread only.
+ */
+class PipelineManager
+{
+public:
+    static const uint32_t kNoFallback = ~0u;
+
+    void Init( VkDevice device, JobSystem* jobSystem, PipelineBuilder builder );
+    // waits for outstanding builds and destroys every pipeline
+    void Shutdown( void );
+
+    // Pipeline of desc, built on the calling thread unless it exists; ready on return
+    uint32_t Create( const char* name, const PipelineDesc& desc );
+    // Pipeline of desc, queued on the job system unless it exists; until it is ready Get() returns the fallback's
+    // pipeline. An existing pipeline keeps its name and fallback.
+    uint32_t CreateAsync( const char* name, const PipelineDesc& desc, uint32_t fallback = kNoFallback );
+    // Waits for outstanding builds, running jobs on the calling thread meanwhile
+    void Wait( void );
+    // Builds are queued or running
+    bool Building( void ) const { return pending_.pending_.load( std::memory_order_acquire ) != 0; }
+
+    // Rebuilds every pipeline that uses the shader, returns how many do
+    uint32_t Rebuild( const char* shaderPath );
+    // Swaps in finished rebuilds and appends the pipelines they replace to replaced; true if any rebuild finished
+    bool Update( std::vector<VkPipeline>* replaced );
+    // Rebuilds have been requested that Update() has not swapped in yet
+    bool Rebuilding( void ) const;
+
+    bool IsReady( uint32_t id ) const;
+    bool AllReady( void ) const;
+    // The pipeline once it is ready, otherwise its fallback's, VK_NULL_HANDLE if neither is
+    VkPipeline Get( uint32_t id ) const;
+
+    uint32_t PipelineCount( void ) const { return static_cast<uint32_t>( entries_.size() ); }
+    // Builds started since Init()
+    uint32_t BuildCount( void ) const { return builds_; }
+    // Only complete once IsReady( id )
+    const PipelineStats& Stats( uint32_t id ) const { return entries_[id]->stats_; }
+    PipelineLookupStats LookupStats( void ) const;
+
+private:
+    struct Entry
+    {
+        std::string name_;
+        PipelineDesc desc_;
+        uint32_t fallback_;
+        bool async_;
+        VkPipeline pipeline_;
+        std::atomic<bool> ready_; // pipeline_ and stats_ are written before it is set
+        std::chrono::steady_clock::time_point requested_;
+        PipelineStats stats_;
+
+        VkPipeline rebuilt_;
+        std::atomic<bool> rebuildDone_; // rebuilt_ and rebuildStats_ are written before it is set
+        bool rebuilding_;               // a rebuild job was started and not swapped in yet
+        bool dirty_;                    // a shader changed while the pipeline was (re)building, rebuild once more
+        PipelineStats rebuildStats_;
+    };
+
+    uint32_t Add( const char* name, const PipelineDesc& desc, uint32_t fallback, bool async );
+    void Start( Entry& entry );
+    void StartRebuild( Entry& entry );
+    void Build( Entry& entry, bool rebuild ) const;
+
+    VkDevice device_;
+    JobSystem* jobSystem_;
+    PipelineBuilder builder_;
+    JobCounter pending_;
+    std::vector<std::unique_ptr<Entry>> entries_;
+    std::unordered_map<PipelineDesc, uint32_t, PipelineDescHash> lookup_; // desc -> index into entries_
+    uint32_t lookups_;
+    uint32_t hits_;
+    uint32_t builds_;
+};
+
+#endif // TUTORIAL06_TEXTURE_PIPELINEMANAGER_H
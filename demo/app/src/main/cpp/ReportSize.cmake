@@ -0,0 +1,7 @@
+# cmake -DFILE=<path> -P ReportSize.cmake
+# Prints the size of a build output
+# file(SIZE) needs CMake 3.14, the SDK's CMake is older: two hex digits per byte
+file(READ ${FILE} FILE_HEX HEX)
+string(LENGTH "${FILE_HEX}" FILE_HEX_LENGTH)
+math(EXPR FILE_KB "${FILE_HEX_LENGTH} / 2 / 1024")
+message(STATUS "${FILE}: ${FILE_KB} KB")
@@ -0,0 +1,94 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include "ShaderModuleCache.h"
+#include "CreateShaderModule.h"
+
+void ShaderModuleCache::Init( VkDevice device, android_app* app )
+{
+    device_ = device;
+    app_ = app;
+}
+
+void ShaderModuleCache::Shutdown( void )
+{
+    FreeRetired();
+    std::lock_guard<std::mutex> lock( mutex_ );
+    for( auto& entry : modules_ )
+    {
+        VkShaderModule module = entry.second.get();
+        if( module != VK_NULL_HANDLE )
+            vkDestroyShaderModule( device_, module, nullptr );
+    }
+    modules_.clear();
+}
+
+void ShaderModuleCache::Invalidate( const char* filePath )
+{
+    std::lock_guard<std::mutex> lock( mutex_ );
+    for( auto entry = modules_.begin(); entry != modules_.end(); )
+    {
+        if( entry->first.first == filePath )
+        {
+            retired_.push_back( entry->second );
+            entry = modules_.erase( entry );
+        }
+        else
+            ++entry;
+    }
+}
+
+void ShaderModuleCache::FreeRetired( void )
+{
+    std::lock_guard<std::mutex> lock( mutex_ );
+    for( auto& retired : retired_ )
+    {
+        VkShaderModule module = retired.get();
+        if( module != VK_NULL_HANDLE )
+            vkDestroyShaderModule( device_, module, nullptr );
+    }
+    retired_.clear();
+}
+
+VkShaderModule ShaderModuleCache::Get( const char* filePath, VkShaderStageFlagBits stage )
+{
+    std::unique_lock<std::mutex> lock( mutex_ );
+    auto key = std::make_pair( std::string( filePath ), stage );
+    auto found = modules_.find( key );
+    if( found != modules_.end() )
+    {
+        // a copy, the map may change while this thread waits
+        std::shared_future<VkShaderModule> module = found->second;
+        lock.unlock();
+        return module.get();
+    }
+    std::promise<VkShaderModule> promise;
+    modules_.emplace( key, promise.get_future().share() );
+    lock.unlock();
+
+    VkShaderModule module = VK_NULL_HANDLE;
+    if( buildShaderFromFile( app_, filePath, stage, device_, &module ) != VK_SUCCESS )
+        module = VK_NULL_HANDLE;
+    promise.set_value( module );
+    return module;
+}
+
+uint32_t ShaderModuleCache::ModuleCount( void )
+{
+    std::lock_guard<std::mutex> lock( mutex_ );
+    return static_cast<uint32_t>( modules_.size() );
+}
@@ -0,0 +1,67 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#ifndef TUTORIAL06_TEXTURE_SHADERMODULECACHE_H
+#define TUTORIAL06_TEXTURE_SHADERMODULECACHE_H
+
+#include <vulkan_wrapper.h>
+#include <android_native_app_glue.h>
+#include <future>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/*
+ * ShaderModuleCache
+ *   One VkShaderModule per shader file and stage for the whole run.
+ *   Variants of a shader are pipelines specialized from the same module
+ *   (PipelineDesc::specializations_), so however many variants are built,
+ *   every shader is loaded or compiled once.
+ *
+ *   Thread safe, pipeline builds on the job system share it. The first
+ *   thread asking for a module builds it on the spot; threads asking for it
+ *   meanwhile wait for that thread, which is running and never waits on
+ *   queued jobs itself. Modules live until Shutdown(), or until they are
+ *   invalidated (hot reload) and no build can still be using them.
+ */
+class ShaderModuleCache
+{
+public:
+    void Init( VkDevice device, android_app* app );
+    // destroys every module, no build may be running
+    void Shutdown( void );
+
+    // Module of filePath, VK_NULL_HANDLE if it does not build
+    VkShaderModule Get( const char* filePath, VkShaderStageFlagBits stage );
+
+    // The next Get() of filePath builds it again; the old modules are kept for builds that may still use them
+    void Invalidate( const char* filePath );
+    // Destroys the modules Invalidate() replaced, no build may be running
+    void FreeRetired( void );
+
+    uint32_t ModuleCount( void );
+
+private:
+    VkDevice device_;
+    android_app* app_;
+    std::mutex mutex_;
+    std::map<std::pair<std::string, VkShaderStageFlagBits>, std::shared_future<VkShaderModule>> modules_;
+    std::vector<std::shared_future<VkShaderModule>> retired_;
+};
+
+#endif // TUTORIAL06_TEXTURE_SHADERMODULECACHE_H
@@ -0,0 +1,88 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include "ShaderWatcher.h"
+#include "FileUtils.h"
+#include <sys/inotify.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+bool ShaderWatcher::Start( const char* dir )
+{
+    Stop();
+    if( !MakeDirectory( dir ) )
+        return false;
+    fd_ = inotify_init1( IN_NONBLOCK | IN_CLOEXEC );
+    if( fd_ < 0 )
+        return false;
+    if( inotify_add_watch( fd_, dir, IN_CLOSE_WRITE | IN_MOVED_TO ) < 0 )
+    {
+        Stop();
+        return false;
+    }
+    dir_ = dir;
+    return true;
+}
+
+void ShaderWatcher::Stop( void )
+{
+    if( fd_ >= 0 )
+        close( fd_ );
+    fd_ = -1;
+}
+
+std::vector<ShaderChange> ShaderWatcher::Poll( void )
+{
+    std::vector<ShaderChange> changes;
+    if( fd_ < 0 )
+        return changes;
+
+    // aligned for the inotify_event structs read into it
+    alignas( inotify_event ) char buffer[4096];
+    ssize_t length;
+    while( ( length = read( fd_, buffer, sizeof( buffer ) ) ) > 0 )
+    {
+        for( char* next = buffer; next < buffer + length; )
+        {
+            const inotify_event* event = reinterpret_cast<const inotify_event*>( next );
+            next += sizeof( inotify_event ) + event->len;
+            if( event->len == 0 )
+                continue;
+
+            std::string name( event->name );
+            bool seen = false;
+            for( const auto& change : changes )
+                seen = seen || change.name_ == name;
+            if( !seen )
+                changes.push_back( { name, std::chrono::system_clock::time_point(), std::chrono::system_clock::now() } );
+        }
+    }
+
+    for( auto& change : changes )
+    {
+        struct stat status;
+        if( stat( ( dir_ + "/" + change.name_ ).c_str(), &status ) == 0 )
+        {
+            change.modified_ = std::chrono::system_clock::time_point(
+                    std::chrono::duration_cast<std::chrono::system_clock::duration>(
+                            std::chrono::seconds( status.st_mtim.tv_sec ) + std::chrono::nanoseconds( status.st_mtim.tv_nsec ) ) );
+        }
+        else
+            change.modified_ = change.detected_;
+    }
+    return changes;
+}
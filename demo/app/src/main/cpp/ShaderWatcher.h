@@ -0,0 +1,58 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#ifndef TUTORIAL06_TEXTURE_SHADERWATCHER_H
+#define TUTORIAL06_TEXTURE_SHADERWATCHER_H
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+// A file of the watched directory that was written
+struct ShaderChange
+{
+    std::string name_;                               // file name inside the directory
+    std::chrono::system_clock::time_point modified_; // mtime, when the edit landed on the device
+    std::chrono::system_clock::time_point detected_; // when Poll() saw it
+};
+
+/*
+ * ShaderWatcher
+ *   Reports files of one directory that were written, through inotify.
+ *   Both ways a new version arrives are seen: written in place (adb push,
+ *   IN_CLOSE_WRITE) and written elsewhere and renamed over it (most
+ *   editors, IN_MOVED_TO). Poll() never blocks, so the render loop can call
+ *   it every frame.
+ */
+class ShaderWatcher
+{
+public:
+    ~ShaderWatcher() { Stop(); }
+
+    // Creates dir if needed and starts watching it, false if inotify is unavailable
+    bool Start( const char* dir );
+    void Stop( void );
+
+    // Files written since the last call, each name once
+    std::vector<ShaderChange> Poll( void );
+
+private:
+    std::string dir_;
+    int fd_ = -1;
+};
+
+#endif // TUTORIAL06_TEXTURE_SHADERWATCHER_H
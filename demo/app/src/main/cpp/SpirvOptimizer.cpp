@@ -0,0 +1,79 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include "SpirvOptimizer.h"
+#include <android/log.h>
+#include <spirv-tools/optimizer.hpp>
+
+// magic, version, generator, bound, schema
+static const size_t kSpirvHeaderWords = 5;
+
+SpirvStats GetSpirvStats( const uint32_t* code, size_t wordCount )
+{
+    SpirvStats stats = { wordCount * sizeof( uint32_t ), 0 };
+    size_t word = kSpirvHeaderWords;
+    while( word < wordCount )
+    {
+        // every instruction starts with its word count in the high half
+        uint32_t instructionWords = code[word] >> 16;
+        if( instructionWords == 0 )
+            break;
+        word += instructionWords;
+        stats.instructions_++;
+    }
+    return stats;
+}
+
+const char* SpirvOptimizationName( void )
+{
+    switch( kSpirvOptimization )
+    {
+        case SPIRV_OPT_PERFORMANCE:
+            return kSpirvStripDebug ? "performance, strip debug" : "performance";
+        case SPIRV_OPT_SIZE:
+            return kSpirvStripDebug ? "size, strip debug" : "size";
+        default:
+            return kSpirvStripDebug ? "none, strip debug" : "none";
+    }
+}
+
+bool OptimizeSpirv( const uint32_t* code, size_t wordCount, std::vector<uint32_t>* optimized )
+{
+    spvtools::Optimizer optimizer( SPV_ENV_VULKAN_1_0 );
+    optimizer.SetMessageConsumer( []( spv_message_level_t level, const char*, const spv_position_t&, const char* message ) {
+        if( level <= SPV_MSG_ERROR )
+            __android_log_print( ANDROID_LOG_ERROR, "Vulkan-Tutorial06", "spirv-opt: %s", message );
+    } );
+
+    if( kSpirvStripDebug )
+        optimizer.RegisterPass( spvtools::CreateStripDebugInfoPass() );
+    if( kSpirvOptimization == SPIRV_OPT_PERFORMANCE )
+    {
+        // inlining first exposes constants across calls to the folding passes
+        optimizer.RegisterPass( spvtools::CreateInlinePass() );
+        optimizer.RegisterPass( spvtools::CreateFoldSpecConstantOpAndCompositePass() );
+        optimizer.RegisterPass( spvtools::CreateUnifyConstantPass() );
+        optimizer.RegisterPass( spvtools::CreateEliminateDeadConstantPass() );
+    }
+    else if( kSpirvOptimization == SPIRV_OPT_SIZE )
+    {
+        optimizer.RegisterPass( spvtools::CreateUnifyConstantPass() );
+        optimizer.RegisterPass( spvtools::CreateEliminateDeadConstantPass() );
+        optimizer.RegisterPass( spvtools::CreateCompactIdsPass() );
+    }
+    return optimizer.Run( code, wordCount, optimized );
+}
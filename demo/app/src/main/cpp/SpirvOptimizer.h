@@ -0,0 +1,76 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#ifndef TUTORIAL06_TEXTURE_SPIRVOPTIMIZER_H
+#define TUTORIAL06_TEXTURE_SPIRVOPTIMIZER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/*
+ * SpirvOptimizer
+ *   Runs the spirv-tools optimizer bundled with shaderc over the SPIR-V of
+ *   runtime compiled shaders (VKTUTS_RUNTIME_SHADERC); the build time glslc
+ *   step gets the matching flags from CMake.
+ *
+ *   VKTUTS_SPIRV_OPT picks the passes:
+ *     performance: inline into the entry points, fold spec constant ops,
+ *                  unify and drop dead constants
+ *     size       : unify and drop dead constants, compact ids
+ *     none       : nothing
+ *   VKTUTS_SPIRV_STRIP_DEBUG (release builds) also strips debug info.
+ *
+ *   The bundled spirv-tools predates the dead code elimination and scalar
+ *   replacement passes, the lists above are what it offers.
+ */
+
+enum SpirvOptimization
+{
+    SPIRV_OPT_NONE,
+    SPIRV_OPT_PERFORMANCE,
+    SPIRV_OPT_SIZE,
+};
+#if defined( VKTUTS_SPIRV_OPT_NONE )
+static const SpirvOptimization kSpirvOptimization = SPIRV_OPT_NONE;
+#elif defined( VKTUTS_SPIRV_OPT_SIZE )
+static const SpirvOptimization kSpirvOptimization = SPIRV_OPT_SIZE;
+#else
+static const SpirvOptimization kSpirvOptimization = SPIRV_OPT_PERFORMANCE;
+#endif
+#ifdef VKTUTS_SPIRV_STRIP_DEBUG
+static const bool kSpirvStripDebug = true;
+#else
+static const bool kSpirvStripDebug = false;
+#endif
+
+struct SpirvStats
+{
+    size_t bytes_;
+    uint32_t instructions_;
+};
+
+// Size and instruction count of a SPIR-V module
+SpirvStats GetSpirvStats( const uint32_t* code, size_t wordCount );
+
+// Describes the configured passes, for cache keys and logs
+const char* SpirvOptimizationName( void );
+
+// Runs the configured passes; false, with optimized left unusable, if spirv-tools failed
+bool OptimizeSpirv( const uint32_t* code, size_t wordCount, std::vector<uint32_t>* optimized );
+
+#endif // TUTORIAL06_TEXTURE_SPIRVOPTIMIZER_H
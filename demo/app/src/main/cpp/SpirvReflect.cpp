@@ -0,0 +1,426 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include "SpirvReflect.h"
+#include <algorithm>
+#include <unordered_map>
+
+// The few parts of the SPIR-V spec this needs, numbered as in spirv.h
+static const uint32_t kSpirvMagic = 0x07230203;
+static const size_t kSpirvHeaderWords = 5;
+
+enum SpirvOp
+{
+    OP_ENTRY_POINT = 15,
+    OP_TYPE_INT = 21,
+    OP_TYPE_FLOAT = 22,
+    OP_TYPE_VECTOR = 23,
+    OP_TYPE_MATRIX = 24,
+    OP_TYPE_IMAGE = 25,
+    OP_TYPE_SAMPLER = 26,
+    OP_TYPE_SAMPLED_IMAGE = 27,
+    OP_TYPE_ARRAY = 28,
+    OP_TYPE_RUNTIME_ARRAY = 29,
+    OP_TYPE_STRUCT = 30,
+    OP_TYPE_POINTER = 32,
+    OP_CONSTANT = 43,
+    OP_VARIABLE = 59,
+    OP_DECORATE = 71,
+    OP_MEMBER_DECORATE = 72,
+};
+
+enum SpirvDecoration
+{
+    DECORATION_BLOCK = 2,
+    DECORATION_BUFFER_BLOCK = 3,
+    DECORATION_ARRAY_STRIDE = 6,
+    DECORATION_MATRIX_STRIDE = 7,
+    DECORATION_BUILT_IN = 11,
+    DECORATION_LOCATION = 30,
+    DECORATION_BINDING = 33,
+    DECORATION_DESCRIPTOR_SET = 34,
+    DECORATION_OFFSET = 35,
+};
+
+enum SpirvStorageClass
+{
+    STORAGE_UNIFORM_CONSTANT = 0,
+    STORAGE_INPUT = 1,
+    STORAGE_UNIFORM = 2,
+    STORAGE_PUSH_CONSTANT = 9,
+    STORAGE_STORAGE_BUFFER = 12,
+};
+
+static const uint32_t kDimBuffer = 5;
+static const uint32_t kDimSubpassData = 6;
+static const uint32_t kImageStorage = 2; // "Sampled" operand of OpTypeImage
+
+// Decorations of one id or struct member, the ones that matter here
+struct SpirvDecorations
+{
+    bool block_;
+    bool bufferBlock_;
+    bool builtIn_;
+    bool hasLocation_;
+    uint32_t location_;
+    uint32_t binding_;
+    uint32_t set_;
+    uint32_t offset_;
+    uint32_t arrayStride_;
+    uint32_t matrixStride_;
+};
+
+struct SpirvType
+{
+    uint32_t op_;
+    std::vector<uint32_t> operands_; // words after the result id
+};
+
+// Everything of a module the reflection looks at, indexed by id
+struct SpirvModule
+{
+    VkShaderStageFlags stage_;
+    std::unordered_map<uint32_t, SpirvType> types_;
+    std::unordered_map<uint32_t, uint32_t> constants_;
+    std::unordered_map<uint32_t, SpirvDecorations> decorations_;
+    std::unordered_map<uint32_t, std::vector<SpirvDecorations>> memberDecorations_;
+    std::vector<const uint32_t*> variables_; // OpVariable instructions
+};
+
+static VkShaderStageFlags StageOfExecutionModel( uint32_t model )
+{
+    static const VkShaderStageFlags kStages[] = {
+        VK_SHADER_STAGE_VERTEX_BIT,
+        VK_SHADER_STAGE_TESSELLATION_CONTROL_BIT,
+        VK_SHADER_STAGE_TESSELLATION_EVALUATION_BIT,
+        VK_SHADER_STAGE_GEOMETRY_BIT,
+        VK_SHADER_STAGE_FRAGMENT_BIT,
+        VK_SHADER_STAGE_COMPUTE_BIT,
+    };
+    return model < sizeof( kStages ) / sizeof( kStages[0] ) ? kStages[model] : 0;
+}
+
+static void Decorate( SpirvDecorations& decorations, uint32_t decoration, const uint32_t* literals, uint32_t literalCount )
+{
+    uint32_t value = literalCount ? literals[0] : 0;
+    switch( decoration )
+    {
+        case DECORATION_BLOCK: decorations.block_ = true; break;
+        case DECORATION_BUFFER_BLOCK: decorations.bufferBlock_ = true; break;
+        case DECORATION_BUILT_IN: decorations.builtIn_ = true; break;
+        case DECORATION_LOCATION: decorations.hasLocation_ = true; decorations.location_ = value; break;
+        case DECORATION_BINDING: decorations.binding_ = value; break;
+        case DECORATION_DESCRIPTOR_SET: decorations.set_ = value; break;
+        case DECORATION_OFFSET: decorations.offset_ = value; break;
+        case DECORATION_ARRAY_STRIDE: decorations.arrayStride_ = value; break;
+        case DECORATION_MATRIX_STRIDE: decorations.matrixStride_ = value; break;
+        default: break;
+    }
+}
+
+static bool ParseModule( const uint32_t* code, size_t wordCount, SpirvModule* module )
+{
+    if( wordCount < kSpirvHeaderWords || code[0] != kSpirvMagic )
+        return false;
+
+    module->stage_ = 0;
+    size_t word = kSpirvHeaderWords;
+    while( word < wordCount )
+    {
+        const uint32_t* instruction = code + word;
+        uint32_t op = instruction[0] & 0xffff;
+        uint32_t length = instruction[0] >> 16;
+        if( length == 0 || word + length > wordCount )
+            return false;
+        word += length;
+
+        switch( op )
+        {
+            case OP_ENTRY_POINT:
+                if( length >= 3 )
+                    module->stage_ |= StageOfExecutionModel( instruction[1] );
+                break;
+            case OP_DECORATE:
+                if( length >= 3 )
+                    Decorate( module->decorations_[instruction[1]], instruction[2], instruction + 3, length - 3 );
+                break;
+            case OP_MEMBER_DECORATE:
+                if( length >= 4 )
+                {
+                    std::vector<SpirvDecorations>& members = module->memberDecorations_[instruction[1]];
+                    if( members.size() <= instruction[2] )
+                        members.resize( instruction[2] + 1, SpirvDecorations() );
+                    Decorate( members[instruction[2]], instruction[3], instruction + 4, length - 4 );
+                }
+                break;
+            case OP_TYPE_INT:
+            case OP_TYPE_FLOAT:
+            case OP_TYPE_VECTOR:
+            case OP_TYPE_MATRIX:
+            case OP_TYPE_IMAGE:
+            case OP_TYPE_SAMPLER:
+            case OP_TYPE_SAMPLED_IMAGE:
+            case OP_TYPE_ARRAY:
+            case OP_TYPE_RUNTIME_ARRAY:
+            case OP_TYPE_STRUCT:
+            case OP_TYPE_POINTER:
+                if( length >= 2 )
+                    module->types_[instruction[1]] = SpirvType{ op, std::vector<uint32_t>( instruction + 2, instruction + length ) };
+                break;
+            case OP_CONSTANT:
+                if( length >= 4 )
+                    module->constants_[instruction[2]] = instruction[3];
+                break;
+            case OP_VARIABLE:
+                if( length >= 4 )
+                    module->variables_.push_back( instruction );
+                break;
+            default:
+                break;
+        }
+    }
+    return module->stage_ != 0;
+}
+
+static const SpirvType* FindType( const SpirvModule& module, uint32_t id )
+{
+    auto found = module.types_.find( id );
+    return found != module.types_.end() ? &found->second : nullptr;
+}
+
+static SpirvDecorations DecorationsOf( const SpirvModule& module, uint32_t id )
+{
+    auto found = module.decorations_.find( id );
+    return found != module.decorations_.end() ? found->second : SpirvDecorations();
+}
+
+// Bytes a push constant member of type id occupies, the strides are explicit in Vulkan SPIR-V
+static uint32_t TypeSize( const SpirvModule& module, uint32_t id, uint32_t matrixStride )
+{
+    const SpirvType* type = FindType( module, id );
+    if( !type || type->operands_.empty() )
+        return 0;
+
+    switch( type->op_ )
+    {
+        case OP_TYPE_INT:
+        case OP_TYPE_FLOAT:
+            return type->operands_[0] / 8;
+        case OP_TYPE_VECTOR:
+            return type->operands_.size() >= 2 ? TypeSize( module, type->operands_[0], 0 ) * type->operands_[1] : 0;
+        case OP_TYPE_MATRIX:
+            if( type->operands_.size() < 2 )
+                return 0;
+            return ( matrixStride ? matrixStride : TypeSize( module, type->operands_[0], 0 ) ) * type->operands_[1];
+        case OP_TYPE_ARRAY:
+        {
+            auto length = type->operands_.size() >= 2 ? module.constants_.find( type->operands_[1] ) : module.constants_.end();
+            if( length == module.constants_.end() )
+                return 0;
+            uint32_t stride = DecorationsOf( module, id ).arrayStride_;
+            return ( stride ? stride : TypeSize( module, type->operands_[0], matrixStride ) ) * length->second;
+        }
+        case OP_TYPE_STRUCT:
+        {
+            auto members = module.memberDecorations_.find( id );
+            uint32_t size = 0;
+            for( size_t i = 0; i < type->operands_.size(); i++ )
+            {
+                SpirvDecorations member = {};
+                if( members != module.memberDecorations_.end() && i < members->second.size() )
+                    member = members->second[i];
+                size = std::max( size, member.offset_ + TypeSize( module, type->operands_[i], member.matrixStride_ ) );
+            }
+            return size;
+        }
+        default:
+            return 0;
+    }
+}
+
+// Descriptor type and count of a resource variable's pointee type, false if it is no descriptor
+static bool DescriptorOf( const SpirvModule& module, uint32_t typeId, uint32_t storageClass, VkDescriptorType* descriptorType, uint32_t* count )
+{
+    *count = 1;
+    const SpirvType* type = FindType( module, typeId );
+    if( type && ( type->op_ == OP_TYPE_ARRAY || type->op_ == OP_TYPE_RUNTIME_ARRAY ) && !type->operands_.empty() )
+    {
+        if( type->op_ == OP_TYPE_ARRAY )
+        {
+            auto length = type->operands_.size() >= 2 ? module.constants_.find( type->operands_[1] ) : module.constants_.end();
+            *count = length != module.constants_.end() ? length->second : 1;
+        }
+        else
+            *count = 0;
+        typeId = type->operands_[0];
+        type = FindType( module, typeId );
+    }
+    if( !type )
+        return false;
+
+    // a combined image sampler takes its dimension from the image it wraps
+    const SpirvType* image = type;
+    if( type->op_ == OP_TYPE_SAMPLED_IMAGE && !type->operands_.empty() )
+        image = FindType( module, type->operands_[0] );
+    uint32_t dim = image && image->op_ == OP_TYPE_IMAGE && image->operands_.size() >= 6 ? image->operands_[1] : 0;
+    uint32_t sampled = image && image->op_ == OP_TYPE_IMAGE && image->operands_.size() >= 6 ? image->operands_[5] : 0;
+
+    switch( type->op_ )
+    {
+        case OP_TYPE_SAMPLER:
+            *descriptorType = VK_DESCRIPTOR_TYPE_SAMPLER;
+            return true;
+        case OP_TYPE_SAMPLED_IMAGE:
+            *descriptorType = dim == kDimBuffer ? VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER : VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+            return true;
+        case OP_TYPE_IMAGE:
+            if( dim == kDimSubpassData )
+                *descriptorType = VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT;
+            else if( dim == kDimBuffer )
+                *descriptorType = sampled == kImageStorage ? VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER : VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER;
+            else
+                *descriptorType = sampled == kImageStorage ? VK_DESCRIPTOR_TYPE_STORAGE_IMAGE : VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+            return true;
+        case OP_TYPE_STRUCT:
+        {
+            SpirvDecorations decorations = DecorationsOf( module, typeId );
+            if( storageClass == STORAGE_STORAGE_BUFFER || ( storageClass == STORAGE_UNIFORM && decorations.bufferBlock_ ) )
+                *descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+            else if( storageClass == STORAGE_UNIFORM && decorations.block_ )
+                *descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+            else
+                return false;
+            return true;
+        }
+        default:
+            return false;
+    }
+}
+
+// Vertex buffer format of an input of type id: scalars and vectors of 32 bit components
+static bool VertexFormatOf( const SpirvModule& module, uint32_t id, VkFormat* format, uint32_t* size )
+{
+    static const VkFormat kFloatFormats[] = { VK_FORMAT_R32_SFLOAT, VK_FORMAT_R32G32_SFLOAT, VK_FORMAT_R32G32B32_SFLOAT, VK_FORMAT_R32G32B32A32_SFLOAT };
+    static const VkFormat kSintFormats[] = { VK_FORMAT_R32_SINT, VK_FORMAT_R32G32_SINT, VK_FORMAT_R32G32B32_SINT, VK_FORMAT_R32G32B32A32_SINT };
+    static const VkFormat kUintFormats[] = { VK_FORMAT_R32_UINT, VK_FORMAT_R32G32_UINT, VK_FORMAT_R32G32B32_UINT, VK_FORMAT_R32G32B32A32_UINT };
+
+    const SpirvType* type = FindType( module, id );
+    uint32_t components = 1;
+    if( type && type->op_ == OP_TYPE_VECTOR && type->operands_.size() >= 2 )
+    {
+        components = type->operands_[1];
+        type = FindType( module, type->operands_[0] );
+    }
+    if( !type || type->operands_.empty() || type->operands_[0] != 32 || components < 1 || components > 4 )
+        return false;
+
+    if( type->op_ == OP_TYPE_FLOAT )
+        *format = kFloatFormats[components - 1];
+    else if( type->op_ == OP_TYPE_INT && type->operands_.size() >= 2 )
+        *format = type->operands_[1] ? kSintFormats[components - 1] : kUintFormats[components - 1];
+    else
+        return false;
+    *size = components * 4;
+    return true;
+}
+
+static bool AddBinding( ShaderReflection* reflection, const ReflectedBinding& binding )
+{
+    for( auto& existing : reflection->bindings_ )
+    {
+        if( existing.set_ != binding.set_ || existing.binding_ != binding.binding_ )
+            continue;
+        if( existing.type_ != binding.type_ || existing.count_ != binding.count_ )
+            return false;
+        existing.stages_ |= binding.stages_;
+        return true;
+    }
+    reflection->bindings_.push_back( binding );
+    return true;
+}
+
+bool ReflectSpirv( const uint32_t* code, size_t wordCount, ShaderReflection* reflection )
+{
+    SpirvModule module;
+    if( !ParseModule( code, wordCount, &module ) )
+        return false;
+    reflection->stages_ |= module.stage_;
+
+    for( const uint32_t* variable : module.variables_ )
+    {
+        uint32_t id = variable[2];
+        uint32_t storageClass = variable[3];
+        const SpirvType* pointer = FindType( module, variable[1] );
+        if( !pointer || pointer->op_ != OP_TYPE_POINTER || pointer->operands_.size() < 2 )
+            continue;
+        uint32_t typeId = pointer->operands_[1];
+        SpirvDecorations decorations = DecorationsOf( module, id );
+
+        if( storageClass == STORAGE_UNIFORM_CONSTANT || storageClass == STORAGE_UNIFORM || storageClass == STORAGE_STORAGE_BUFFER )
+        {
+            ReflectedBinding binding = { decorations.set_, decorations.binding_, VK_DESCRIPTOR_TYPE_SAMPLER, 1, module.stage_ };
+            if( DescriptorOf( module, typeId, storageClass, &binding.type_, &binding.count_ ) && !AddBinding( reflection, binding ) )
+                return false;
+        }
+        else if( storageClass == STORAGE_PUSH_CONSTANT )
+        {
+            reflection->pushConstantSize_ = std::max( reflection->pushConstantSize_, TypeSize( module, typeId, 0 ) );
+            reflection->pushConstantStages_ |= module.stage_;
+        }
+        else if( storageClass == STORAGE_INPUT && module.stage_ == VK_SHADER_STAGE_VERTEX_BIT && !decorations.builtIn_ )
+        {
+            ReflectedVertexInput input = { decorations.location_, VK_FORMAT_UNDEFINED, 0 };
+            if( !decorations.hasLocation_ || !VertexFormatOf( module, typeId, &input.format_, &input.size_ ) )
+                return false;
+            reflection->vertexInputs_.push_back( input );
+        }
+    }
+
+    std::sort( reflection->bindings_.begin(), reflection->bindings_.end(), []( const ReflectedBinding& a, const ReflectedBinding& b ) {
+        return a.set_ != b.set_ ? a.set_ < b.set_ : a.binding_ < b.binding_;
+    } );
+    std::sort( reflection->vertexInputs_.begin(), reflection->vertexInputs_.end(), []( const ReflectedVertexInput& a, const ReflectedVertexInput& b ) {
+        return a.location_ < b.location_;
+    } );
+    return true;
+}
+
+std::vector<VkDescriptorSetLayoutBinding> ReflectedSetBindings( const ShaderReflection& reflection, uint32_t set )
+{
+    std::vector<VkDescriptorSetLayoutBinding> bindings;
+    for( const auto& binding : reflection.bindings_ )
+    {
+        if( binding.set_ != set )
+            continue;
+        VkDescriptorSetLayoutBinding layoutBinding;
+        layoutBinding.binding = binding.binding_;
+        layoutBinding.descriptorType = binding.type_;
+        layoutBinding.descriptorCount = binding.count_;
+        layoutBinding.stageFlags = binding.stages_;
+        layoutBinding.pImmutableSamplers = nullptr;
+        bindings.push_back( layoutBinding );
+    }
+    return bindings;
+}
+
+uint32_t ReflectedSetCount( const ShaderReflection& reflection )
+{
+    uint32_t count = 0;
+    for( const auto& binding : reflection.bindings_ )
+        count = std::max( count, binding.set_ + 1 );
+    return count;
+}
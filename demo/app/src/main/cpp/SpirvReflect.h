@@ -0,0 +1,76 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#ifndef TUTORIAL06_TEXTURE_SPIRVREFLECT_H
+#define TUTORIAL06_TEXTURE_SPIRVREFLECT_H
+
+#include <vulkan_wrapper.h>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// One descriptor binding, merged over every stage that declares it
+struct ReflectedBinding
+{
+    uint32_t set_;
+    uint32_t binding_;
+    VkDescriptorType type_;
+    uint32_t count_;            // array size, 0 for runtime sized arrays
+    VkShaderStageFlags stages_;
+};
+
+// One vertex shader input
+struct ReflectedVertexInput
+{
+    uint32_t location_;
+    VkFormat format_; // 32 bit components of the declared type
+    uint32_t size_;   // bytes
+};
+
+// Interface of the shader modules of one pipeline
+struct ShaderReflection
+{
+    VkShaderStageFlags stages_;
+    std::vector<ReflectedBinding> bindings_;         // by set, then binding
+    uint32_t pushConstantSize_;                      // one range from offset 0, 0 without push constants
+    VkShaderStageFlags pushConstantStages_;
+    std::vector<ReflectedVertexInput> vertexInputs_; // by location
+};
+
+/*
+ * ReflectSpirv()
+ *   Reads descriptor bindings, the push constant block and vertex inputs
+ *   from a SPIR-V module and merges them into reflection, so calling it for
+ *   each stage of a pipeline yields the interface of the whole pipeline.
+ *   Plain CPU code, no device involved.
+ * Input:
+ *     code, wordCount:  the SPIR-V module
+ *     reflection:       empty ( = {} ) or filled by earlier calls
+ * Return:
+ *     false if the module is not SPIR-V, has no entry point, declares an
+ *     input this app cannot feed from a vertex buffer, or redeclares a
+ *     binding of another stage with a different type or size
+ */
+bool ReflectSpirv( const uint32_t* code, size_t wordCount, ShaderReflection* reflection );
+
+// Bindings of one set, for vkCreateDescriptorSetLayout
+std::vector<VkDescriptorSetLayoutBinding> ReflectedSetBindings( const ShaderReflection& reflection, uint32_t set );
+
+// Number of sets a pipeline layout needs: the highest set used plus one
+uint32_t ReflectedSetCount( const ShaderReflection& reflection );
+
+#endif // TUTORIAL06_TEXTURE_SPIRVREFLECT_H
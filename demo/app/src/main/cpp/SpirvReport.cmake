@@ -0,0 +1,43 @@
+# cmake -DBEFORE=<spv> -DAFTER=<spv> -P SpirvReport.cmake
+# Prints size and instruction count of a SPIR-V module before and after optimization
+# file(SIZE) needs CMake 3.14 and hex literals in math(EXPR) 3.13, the SDK's CMake is older: digit by digit
+function(hex_to_decimal HEX_DIGITS VALUE_VAR)
+    string(LENGTH "${HEX_DIGITS}" DIGIT_COUNT)
+    set(VALUE 0)
+    set(INDEX 0)
+    while(INDEX LESS DIGIT_COUNT)
+        string(SUBSTRING "${HEX_DIGITS}" ${INDEX} 1 DIGIT)
+        string(FIND "0123456789abcdef" "${DIGIT}" DIGIT_VALUE)
+        math(EXPR VALUE "${VALUE} * 16 + ${DIGIT_VALUE}")
+        math(EXPR INDEX "${INDEX} + 1")
+    endwhile()
+    set(${VALUE_VAR} ${VALUE} PARENT_SCOPE)
+endfunction()
+
+function(spirv_stats FILE SIZE_VAR COUNT_VAR)
+    file(READ ${FILE} HEX HEX)
+    string(LENGTH "${HEX}" LENGTH)
+    math(EXPR SIZE "${LENGTH} / 2")
+    # skip the 5 word header, every instruction starts with its little endian word count in the high half
+    set(OFFSET 40)
+    set(COUNT 0)
+    while(OFFSET LESS LENGTH)
+        math(EXPR LOW "${OFFSET} + 4")
+        math(EXPR HIGH "${OFFSET} + 6")
+        string(SUBSTRING "${HEX}" ${LOW} 2 LOW_BYTE)
+        string(SUBSTRING "${HEX}" ${HIGH} 2 HIGH_BYTE)
+        hex_to_decimal(${HIGH_BYTE}${LOW_BYTE} WORDS)
+        if(WORDS EQUAL 0)
+            break()
+        endif()
+        math(EXPR OFFSET "${OFFSET} + ${WORDS} * 8")
+        math(EXPR COUNT "${COUNT} + 1")
+    endwhile()
+    set(${SIZE_VAR} ${SIZE} PARENT_SCOPE)
+    set(${COUNT_VAR} ${COUNT} PARENT_SCOPE)
+endfunction()
+
+spirv_stats(${BEFORE} BEFORE_SIZE BEFORE_COUNT)
+spirv_stats(${AFTER} AFTER_SIZE AFTER_COUNT)
+get_filename_component(NAME ${AFTER} NAME)
+message(STATUS "${NAME}: ${BEFORE_SIZE} -> ${AFTER_SIZE} bytes, ${BEFORE_COUNT} -> ${AFTER_COUNT} instructions")
@@ -0,0 +1,134 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include "TextureMipmaps.h"
+
+#if defined( __ARM_NEON ) || defined( __ARM_NEON__ )
+#include <arm_neon.h>
+#define TEXTURE_MIPMAPS_NEON
+#elif defined( __SSE2__ )
+#include <emmintrin.h>
+#define TEXTURE_MIPMAPS_SSE2
+#endif
+
+uint32_t MipLevelCount( uint32_t width, uint32_t height )
+{
+    uint32_t extent = width > height ? width : height;
+    uint32_t levels = 1;
+    while( extent > 1 )
+    {
+        extent >>= 1;
+        levels++;
+    }
+    return levels;
+}
+
+// rounded average of the four texels, per channel
+static void AverageTexels( const uint8_t* a, const uint8_t* b, const uint8_t* c, const uint8_t* d, uint8_t* dst )
+{
+    for( uint32_t channel = 0; channel < 4; channel++ )
+    {
+        dst[channel] = static_cast<uint8_t>( ( a[channel] + b[channel] + c[channel] + d[channel] + 2 ) >> 2 );
+    }
+}
+
+// SIMD part of a destination row, four texels at a time; returns the texels done
+static uint32_t DownsampleRow( const uint8_t* row0, const uint8_t* row1, uint8_t* dst, uint32_t dstWidth )
+{
+    uint32_t x = 0;
+#if defined( TEXTURE_MIPMAPS_NEON )
+    for( ; x + 4 <= dstWidth; x += 4 )
+    {
+        // split even and odd texels, each texel is one 32 bit lane
+        uint32x4x2_t top = vuzpq_u32( vreinterpretq_u32_u8( vld1q_u8( row0 + x * 8 ) ), vreinterpretq_u32_u8( vld1q_u8( row0 + x * 8 + 16 ) ) );
+        uint32x4x2_t bottom = vuzpq_u32( vreinterpretq_u32_u8( vld1q_u8( row1 + x * 8 ) ), vreinterpretq_u32_u8( vld1q_u8( row1 + x * 8 + 16 ) ) );
+        uint8x16_t a = vreinterpretq_u8_u32( top.val[0] );
+        uint8x16_t b = vreinterpretq_u8_u32( top.val[1] );
+        uint8x16_t c = vreinterpretq_u8_u32( bottom.val[0] );
+        uint8x16_t d = vreinterpretq_u8_u32( bottom.val[1] );
+
+        uint16x8_t low = vaddq_u16( vaddl_u8( vget_low_u8( a ), vget_low_u8( b ) ), vaddl_u8( vget_low_u8( c ), vget_low_u8( d ) ) );
+        uint16x8_t high = vaddq_u16( vaddl_u8( vget_high_u8( a ), vget_high_u8( b ) ), vaddl_u8( vget_high_u8( c ), vget_high_u8( d ) ) );
+        vst1q_u8( dst + x * 4, vcombine_u8( vrshrn_n_u16( low, 2 ), vrshrn_n_u16( high, 2 ) ) );
+    }
+#elif defined( TEXTURE_MIPMAPS_SSE2 )
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i two = _mm_set1_epi16( 2 );
+    for( ; x + 4 <= dstWidth; x += 4 )
+    {
+        // split even and odd texels, each texel is one 32 bit lane
+        __m128 top0 = _mm_castsi128_ps( _mm_loadu_si128( reinterpret_cast<const __m128i*>( row0 + x * 8 ) ) );
+        __m128 top1 = _mm_castsi128_ps( _mm_loadu_si128( reinterpret_cast<const __m128i*>( row0 + x * 8 + 16 ) ) );
+        __m128 bottom0 = _mm_castsi128_ps( _mm_loadu_si128( reinterpret_cast<const __m128i*>( row1 + x * 8 ) ) );
+        __m128 bottom1 = _mm_castsi128_ps( _mm_loadu_si128( reinterpret_cast<const __m128i*>( row1 + x * 8 + 16 ) ) );
+        __m128i a = _mm_castps_si128( _mm_shuffle_ps( top0, top1, _MM_SHUFFLE( 2, 0, 2, 0 ) ) );
+        __m128i b = _mm_castps_si128( _mm_shuffle_ps( top0, top1, _MM_SHUFFLE( 3, 1, 3, 1 ) ) );
+        __m128i c = _mm_castps_si128( _mm_shuffle_ps( bottom0, bottom1, _MM_SHUFFLE( 2, 0, 2, 0 ) ) );
+        __m128i d = _mm_castps_si128( _mm_shuffle_ps( bottom0, bottom1, _MM_SHUFFLE( 3, 1, 3, 1 ) ) );
+
+        __m128i low = _mm_add_epi16( _mm_add_epi16( _mm_unpacklo_epi8( a, zero ), _mm_unpacklo_epi8( b, zero ) ),
+                                     _mm_add_epi16( _mm_unpacklo_epi8( c, zero ), _mm_unpacklo_epi8( d, zero ) ) );
+        __m128i high = _mm_add_epi16( _mm_add_epi16( _mm_unpackhi_epi8( a, zero ), _mm_unpackhi_epi8( b, zero ) ),
+                                      _mm_add_epi16( _mm_unpackhi_epi8( c, zero ), _mm_unpackhi_epi8( d, zero ) ) );
+        low = _mm_srli_epi16( _mm_add_epi16( low, two ), 2 );
+        high = _mm_srli_epi16( _mm_add_epi16( high, two ), 2 );
+        _mm_storeu_si128( reinterpret_cast<__m128i*>( dst + x * 4 ), _mm_packus_epi16( low, high ) );
+    }
+#endif
+    return x;
+}
+
+void DownsampleRGBA8( const uint8_t* src, uint32_t srcWidth, uint32_t srcHeight, uint8_t* dst )
+{
+    uint32_t dstWidth = MipExtent( srcWidth, 1 );
+    uint32_t dstHeight = MipExtent( srcHeight, 1 );
+    size_t srcPitch = static_cast<size_t>( srcWidth ) * 4;
+
+    for( uint32_t y = 0; y < dstHeight; y++ )
+    {
+        const uint8_t* row0 = src + srcPitch * ( y * 2 );
+        const uint8_t* row1 = srcHeight > 1 ? row0 + srcPitch : row0;
+        uint8_t* dstRow = dst + static_cast<size_t>( dstWidth ) * 4 * y;
+
+        uint32_t x = srcWidth > 1 ? DownsampleRow( row0, row1, dstRow, dstWidth ) : 0;
+        for( ; x < dstWidth; x++ )
+        {
+            uint32_t x0 = x * 2;
+            uint32_t x1 = srcWidth > 1 ? x0 + 1 : x0;
+            AverageTexels( row0 + x0 * 4, row0 + x1 * 4, row1 + x0 * 4, row1 + x1 * 4, dstRow + x * 4 );
+        }
+    }
+}
+
+void BuildMipChainRGBA8( const uint8_t* level0, uint32_t width, uint32_t height, uint32_t mipLevels, std::vector<uint8_t>* chain )
+{
+    size_t size = 0;
+    for( uint32_t level = 1; level < mipLevels; level++ )
+    {
+        size += static_cast<size_t>( MipExtent( width, level ) ) * MipExtent( height, level ) * 4;
+    }
+    chain->resize( size );
+
+    const uint8_t* src = level0;
+    uint8_t* dst = chain->data();
+    for( uint32_t level = 1; level < mipLevels; level++ )
+    {
+        DownsampleRGBA8( src, MipExtent( width, level - 1 ), MipExtent( height, level - 1 ), dst );
+        src = dst;
+        dst += static_cast<size_t>( MipExtent( width, level ) ) * MipExtent( height, level ) * 4;
+    }
+}
@@ -0,0 +1,48 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#ifndef TUTORIAL06_TEXTURE_TEXTUREMIPMAPS_H
+#define TUTORIAL06_TEXTURE_TEXTUREMIPMAPS_H
+
+#include <cstdint>
+#include <vector>
+
+// Levels of a full mip chain, down to 1x1
+uint32_t MipLevelCount( uint32_t width, uint32_t height );
+
+// Size of mip level `level` of a width x height image, never below 1
+inline uint32_t MipExtent( uint32_t extent, uint32_t level )
+{
+    return extent >> level ? extent >> level : 1;
+}
+
+/*
+ * DownsampleRGBA8
+ *   2x2 box filter from a tightly packed RGBA8 image into one of
+ *   MipExtent( srcWidth, 1 ) x MipExtent( srcHeight, 1 ). An odd last
+ *   row/column is dropped, a 1 texel wide side is repeated.
+ *   Uses NEON on ARM and SSE2 on x86, with a scalar tail.
+ *
+ *   This is the CPU fallback for formats the GPU cannot blit with
+ *   linear filtering.
+ */
+void DownsampleRGBA8( const uint8_t* src, uint32_t srcWidth, uint32_t srcHeight, uint8_t* dst );
+
+// Builds levels 1 to mipLevels - 1 from level 0 into chain, tightly packed one after the other
+void BuildMipChainRGBA8( const uint8_t* level0, uint32_t width, uint32_t height, uint32_t mipLevels, std::vector<uint8_t>* chain );
+
+#endif // TUTORIAL06_TEXTURE_TEXTUREMIPMAPS_H
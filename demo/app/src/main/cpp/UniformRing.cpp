@@ -0,0 +1,93 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include "UniformRing.h"
+
+static VkDeviceSize AlignUp( VkDeviceSize value, VkDeviceSize alignment )
+{
+    return ( value + alignment - 1 ) / alignment * alignment;
+}
+
+VkResult UniformRing::Init( VkDevice device, MemoryAllocator* allocator, VkDeviceSize alignment, VkDeviceSize frameSize, uint32_t frameCount,
+                            VkDeviceSize persistentSize )
+{
+    device_ = device;
+    allocator_ = allocator;
+    alignment_ = alignment;
+    frameSize_ = AlignUp( frameSize, alignment );
+    persistentSize_ = AlignUp( persistentSize, alignment );
+    persistentHead_ = 0;
+    frameStart_ = persistentSize_;
+    head_ = frameStart_;
+
+    VkBufferCreateInfo createBufferInfo;
+    createBufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    createBufferInfo.pNext = nullptr;
+    createBufferInfo.size = persistentSize_ + frameSize_ * frameCount;
+    createBufferInfo.usage = VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT;
+    createBufferInfo.flags = 0;
+    createBufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    createBufferInfo.queueFamilyIndexCount = 0;
+    createBufferInfo.pQueueFamilyIndices = nullptr;
+
+    VkResult result = vkCreateBuffer( device_, &createBufferInfo, nullptr, &buffer_ );
+    if( result != VK_SUCCESS )
+        return result;
+    // coherent: writes need no flush before the submit that reads them
+    result = allocator_->AllocateForBuffer( buffer_, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, &memory_ );
+    if( result != VK_SUCCESS )
+    {
+        vkDestroyBuffer( device_, buffer_, nullptr );
+        buffer_ = VK_NULL_HANDLE;
+    }
+    return result;
+}
+
+void UniformRing::Shutdown( void )
+{
+    if( buffer_ == VK_NULL_HANDLE )
+        return;
+    vkDestroyBuffer( device_, buffer_, nullptr );
+    allocator_->Free( memory_ );
+    buffer_ = VK_NULL_HANDLE;
+}
+
+void UniformRing::BeginFrame( uint32_t frame )
+{
+    frameStart_ = persistentSize_ + frameSize_ * frame;
+    head_ = frameStart_;
+}
+
+bool UniformRing::Allocate( VkDeviceSize size, UniformAllocation* allocation )
+{
+    VkDeviceSize offset = head_.fetch_add( AlignUp( size, alignment_ ) );
+    if( offset + size > frameStart_ + frameSize_ )
+        return false;
+    allocation->offset_ = static_cast<uint32_t>( offset );
+    allocation->data_ = static_cast<uint8_t*>( memory_.mapped_ ) + offset;
+    return true;
+}
+
+bool UniformRing::AllocatePersistent( VkDeviceSize size, UniformAllocation* allocation )
+{
+    if( persistentHead_ + size > persistentSize_ )
+        return false;
+    allocation->offset_ = static_cast<uint32_t>( persistentHead_ );
+    allocation->data_ = static_cast<uint8_t*>( memory_.mapped_ ) + persistentHead_;
+    persistentHead_ += AlignUp( size, alignment_ );
+    return true;
+}
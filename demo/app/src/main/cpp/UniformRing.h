@@ -0,0 +1,84 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#ifndef TUTORIAL06_TEXTURE_UNIFORMRING_H
+#define TUTORIAL06_TEXTURE_UNIFORMRING_H
+
+#include <vulkan_wrapper.h>
+#include <atomic>
+#include <vector>
+#include "MemoryAllocator.h"
+
+// Part of the ring handed out for one block of uniforms
+struct UniformAllocation
+{
+    uint32_t offset_; // dynamic offset into UniformRing::Buffer()
+    void* data_;      // host pointer the uniforms are written to
+};
+
+/*
+ * UniformRing
+ *   Per-draw uniform data without a buffer, a descriptor set or a memory
+ *   map per draw. One persistently mapped, host coherent buffer is split
+ *   into a region per frame in flight; Allocate() bumps an offset through
+ *   the region of the current frame and BeginFrame() rewinds it once the
+ *   GPU is done with that frame. Draws bind a single
+ *   VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC set on Buffer() and pass
+ *   UniformAllocation::offset_ as its dynamic offset.
+ *
+ *   Every allocation starts on a multiple of the alignment, which must be
+ *   at least minUniformBufferOffsetAlignment. Data recorded once and
+ *   executed by every frame (static secondary command buffers) comes from
+ *   a persistent region in front of the frame regions that is never
+ *   rewound. Payloads of a few bytes per draw are cheaper as push
+ *   constants.
+ *
+ *   Allocate() is thread safe; BeginFrame() and AllocatePersistent() are not.
+ */
+class UniformRing
+{
+public:
+    VkResult Init( VkDevice device, MemoryAllocator* allocator, VkDeviceSize alignment, VkDeviceSize frameSize, uint32_t frameCount,
+                   VkDeviceSize persistentSize );
+    void Shutdown( void );
+
+    // Rewinds the region of frame, the caller waited for the GPU to finish the frame that used it last
+    void BeginFrame( uint32_t frame );
+
+    // false when the region is full
+    bool Allocate( VkDeviceSize size, UniformAllocation* allocation );
+    bool AllocatePersistent( VkDeviceSize size, UniformAllocation* allocation );
+
+    VkBuffer Buffer( void ) const { return buffer_; }
+    VkDeviceSize Alignment( void ) const { return alignment_; }
+    // bytes allocated from the current frame's region
+    VkDeviceSize FrameBytes( void ) const { return head_.load() - frameStart_; }
+
+private:
+    VkDevice device_;
+    MemoryAllocator* allocator_;
+    VkBuffer buffer_;
+    MemoryAllocation memory_;
+    VkDeviceSize alignment_;
+    VkDeviceSize frameSize_;
+    VkDeviceSize persistentSize_;
+    VkDeviceSize persistentHead_;
+    VkDeviceSize frameStart_;
+    std::atomic<VkDeviceSize> head_;
+};
+
+#endif // TUTORIAL06_TEXTURE_UNIFORMRING_H
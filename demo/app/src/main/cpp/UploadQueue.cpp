@@ -0,0 +1,408 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include "UploadQueue.h"
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+
+static VkResult CreateStagingBuffer( VkDevice device, MemoryAllocator* allocator, VkDeviceSize size, VkBuffer* buffer, MemoryAllocation* memory )
+{
+    VkBufferCreateInfo bufferCreateInfo;
+    bufferCreateInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    bufferCreateInfo.pNext = nullptr;
+    bufferCreateInfo.flags = 0;
+    bufferCreateInfo.size = size;
+    bufferCreateInfo.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+    bufferCreateInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    bufferCreateInfo.queueFamilyIndexCount = 0;
+    bufferCreateInfo.pQueueFamilyIndices = nullptr;
+    VkResult result = vkCreateBuffer( device, &bufferCreateInfo, nullptr, buffer );
+    if( result != VK_SUCCESS )
+        return result;
+
+    // coherent, so the CPU writes need no vkFlushMappedMemoryRanges before the submit
+    return allocator->AllocateForBuffer( *buffer, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, memory );
+}
+
+void UploadQueue::Init( VkDevice device, VkQueue queue, uint32_t queueFamilyIndex, MemoryAllocator* allocator, VkDeviceSize ringSize )
+{
+    device_ = device;
+    queue_ = queue;
+    allocator_ = allocator;
+
+    ringSize_ = ringSize / kRingAlignment * kRingAlignment;
+    ringHead_ = 0;
+    ringTail_ = 0;
+    VkResult result = CreateStagingBuffer( device_, allocator_, ringSize_, &ring_.buffer_, &ring_.memory_ );
+    assert( result == VK_SUCCESS && ring_.memory_.mapped_ );
+    (void) result;
+
+    for( auto& batch : batches_ )
+    {
+        VkCommandPoolCreateInfo commandPoolCreateInfo;
+        commandPoolCreateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+        commandPoolCreateInfo.pNext = nullptr;
+        commandPoolCreateInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+        commandPoolCreateInfo.queueFamilyIndex = queueFamilyIndex;
+        vkCreateCommandPool( device_, &commandPoolCreateInfo, nullptr, &batch.cmdPool_ );
+
+        VkCommandBufferAllocateInfo commandBufferAllocateInfo;
+        commandBufferAllocateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+        commandBufferAllocateInfo.pNext = nullptr;
+        commandBufferAllocateInfo.commandPool = batch.cmdPool_;
+        commandBufferAllocateInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+        commandBufferAllocateInfo.commandBufferCount = 1;
+        vkAllocateCommandBuffers( device_, &commandBufferAllocateInfo, &batch.cmdBuffer_ );
+
+        VkFenceCreateInfo fenceCreateInfo;
+        fenceCreateInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+        fenceCreateInfo.pNext = nullptr;
+        fenceCreateInfo.flags = 0;
+        vkCreateFence( device_, &fenceCreateInfo, nullptr, &batch.fence_ );
+
+        batch.ticket_ = 0;
+        batch.ringEnd_ = 0;
+    }
+    oldestBatch_ = 0;
+    batchesInFlight_ = 0;
+    submittedTicket_ = 0;
+    completedTicket_ = 0;
+}
+
+void UploadQueue::Shutdown( void )
+{
+    WaitIdle();
+
+    for( auto& batch : batches_ )
+    {
+        vkDestroyFence( device_, batch.fence_, nullptr );
+        vkDestroyCommandPool( device_, batch.cmdPool_, nullptr );
+    }
+    vkDestroyBuffer( device_, ring_.buffer_, nullptr );
+    allocator_->Free( ring_.memory_ );
+}
+
+void* UploadQueue::Stage( VkDeviceSize size, VkBuffer* buffer, VkDeviceSize* offset )
+{
+    if( size > ringSize_ )
+    {
+        StagingBuffer staging;
+        VkResult result = CreateStagingBuffer( device_, allocator_, size, &staging.buffer_, &staging.memory_ );
+        assert( result == VK_SUCCESS );
+        (void) result;
+        pendingOversized_.push_back( staging );
+        *buffer = staging.buffer_;
+        *offset = 0;
+        return staging.memory_.mapped_;
+    }
+
+    for( ;; )
+    {
+        uint64_t start = ( ringHead_ + kRingAlignment - 1 ) / kRingAlignment * kRingAlignment;
+        // a staged range never wraps around the end of the ring
+        if( start % ringSize_ + size > ringSize_ )
+            start += ringSize_ - start % ringSize_;
+        if( start + size - ringTail_ <= ringSize_ )
+        {
+            ringHead_ = start + size;
+            *buffer = ring_.buffer_;
+            *offset = start % ringSize_;
+            return static_cast<char*>( ring_.memory_.mapped_ ) + *offset;
+        }
+
+        // ring full: free the space of the oldest batch, submitting our own copies first if nothing else is in flight
+        if( batchesInFlight_ )
+            RetireOldest( true );
+        else if( !imageUploads_.empty() || !bufferCopies_.empty() || !hostImages_.empty() )
+            Flush();
+        else
+            ringHead_ = ringTail_ = 0;
+    }
+}
+
+void UploadQueue::UploadBuffer( VkBuffer dst, VkDeviceSize dstOffset, const void* data, VkDeviceSize size )
+{
+    BufferCopy copy;
+    memcpy( Stage( size, &copy.src_, &copy.region_.srcOffset ), data, size );
+    copy.dst_ = dst;
+    copy.region_.dstOffset = dstOffset;
+    copy.region_.size = size;
+    bufferCopies_.push_back( copy );
+}
+
+void UploadQueue::UploadImage( VkImage dst, uint32_t mipLevels, const UploadImageBlock& block, const UploadImageLevel* levels, uint32_t levelCount )
+{
+    assert( levelCount >= 1 && levelCount <= mipLevels );
+
+    // all levels are staged as one range: should staging flush, it does so before any of this image is queued,
+    // so the image's copies, blits and layout transitions always end up in the same batch
+    std::vector<VkDeviceSize> levelOffsets( levelCount );
+    std::vector<VkDeviceSize> levelSizes( levelCount );
+    VkDeviceSize totalSize = 0;
+    for( uint32_t i = 0; i < levelCount; i++ )
+    {
+        const UploadImageLevel& level = levels[i];
+        assert( level.rowLength_ >= level.width_ && level.rowLength_ % block.width_ == 0 );
+        uint32_t blocksY = ( level.height_ + block.height_ - 1 ) / block.height_;
+        uint32_t blocksX = ( level.width_ + block.width_ - 1 ) / block.width_;
+        totalSize = ( totalSize + kRingAlignment - 1 ) / kRingAlignment * kRingAlignment;
+        levelOffsets[i] = totalSize;
+        levelSizes[i] = ( static_cast<VkDeviceSize>( level.rowLength_ / block.width_ ) * ( blocksY - 1 ) + blocksX ) * block.size_;
+        totalSize += levelSizes[i];
+    }
+    VkBuffer src;
+    VkDeviceSize srcOffset;
+    char* staged = static_cast<char*>( Stage( totalSize, &src, &srcOffset ) );
+    imageUploads_.push_back( ImageUpload{ dst, levels[0].width_, levels[0].height_, mipLevels, levelCount } );
+
+    for( uint32_t i = 0; i < levelCount; i++ )
+    {
+        const UploadImageLevel& level = levels[i];
+        uint32_t blocksY = ( level.height_ + block.height_ - 1 ) / block.height_;
+
+        ImageCopy copy;
+        memcpy( staged + levelOffsets[i], level.texels_, levelSizes[i] );
+        copy.src_ = src;
+        copy.region_.bufferOffset = srcOffset + levelOffsets[i];
+        copy.dst_ = dst;
+        copy.region_.bufferRowLength = level.rowLength_;
+        copy.region_.bufferImageHeight = blocksY * block.height_;
+        copy.region_.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        copy.region_.imageSubresource.mipLevel = i;
+        copy.region_.imageSubresource.baseArrayLayer = 0;
+        copy.region_.imageSubresource.layerCount = 1;
+        copy.region_.imageOffset = { 0, 0, 0 };
+        copy.region_.imageExtent = { level.width_, level.height_, 1 };
+        imageCopies_.push_back( copy );
+    }
+}
+
+void UploadQueue::TransitionHostImage( VkImage image )
+{
+    hostImages_.push_back( image );
+}
+
+uint64_t UploadQueue::Flush( void )
+{
+    if( imageUploads_.empty() && bufferCopies_.empty() && hostImages_.empty() )
+        return submittedTicket_;
+
+    // collect batches the GPU already finished, then make sure one is free
+    while( batchesInFlight_ && RetireOldest( false ) )
+        ;
+    if( batchesInFlight_ == kBatchCount )
+        RetireOldest( true );
+
+    Batch& batch = batches_[( oldestBatch_ + batchesInFlight_ ) % kBatchCount];
+    vkResetCommandPool( device_, batch.cmdPool_, 0 );
+
+    VkCommandBufferBeginInfo commandBufferBeginInfo;
+    commandBufferBeginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    commandBufferBeginInfo.pNext = nullptr;
+    commandBufferBeginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    commandBufferBeginInfo.pInheritanceInfo = nullptr;
+    vkBeginCommandBuffer( batch.cmdBuffer_, &commandBufferBeginInfo );
+
+    // every image goes UNDEFINED -> TRANSFER_DST -> SHADER_READ_ONLY, all in two barriers
+    std::vector<VkImageMemoryBarrier> toTransfer( imageUploads_.size() );
+    std::vector<VkImageMemoryBarrier> toShader;
+    for( size_t i = 0; i < imageUploads_.size(); i++ )
+    {
+        const ImageUpload& upload = imageUploads_[i];
+        VkImageMemoryBarrier& barrier = toTransfer[i];
+        barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        barrier.pNext = nullptr;
+        barrier.srcAccessMask = 0;
+        barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+        barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.image = upload.image_;
+        barrier.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, upload.mipLevels_, 0, 1 };
+
+        VkImageMemoryBarrier shaderBarrier = barrier;
+        shaderBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+        shaderBarrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+        if( upload.uploadedLevels_ < upload.mipLevels_ )
+        {
+            // after RecordMipBlits() every level but the last is a blit source
+            shaderBarrier.srcAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+            shaderBarrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+            shaderBarrier.subresourceRange.levelCount = upload.mipLevels_ - 1;
+            toShader.push_back( shaderBarrier );
+            shaderBarrier.subresourceRange.baseMipLevel = upload.mipLevels_ - 1;
+            shaderBarrier.subresourceRange.levelCount = 1;
+        }
+        shaderBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        shaderBarrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+        toShader.push_back( shaderBarrier );
+    }
+    for( auto image : hostImages_ )
+    {
+        VkImageMemoryBarrier barrier;
+        barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        barrier.pNext = nullptr;
+        barrier.srcAccessMask = VK_ACCESS_HOST_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+        barrier.oldLayout = VK_IMAGE_LAYOUT_PREINITIALIZED;
+        barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+        barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.image = image;
+        barrier.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 };
+        toShader.push_back( barrier );
+    }
+
+    if( !toTransfer.empty() )
+        vkCmdPipelineBarrier( batch.cmdBuffer_, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr,
+                              static_cast<uint32_t>( toTransfer.size() ), toTransfer.data() );
+
+    for( auto& copy : imageCopies_ )
+        vkCmdCopyBufferToImage( batch.cmdBuffer_, copy.src_, copy.dst_, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &copy.region_ );
+    for( auto& upload : imageUploads_ )
+    {
+        if( upload.uploadedLevels_ < upload.mipLevels_ )
+            RecordMipBlits( batch.cmdBuffer_, upload );
+    }
+    for( auto& copy : bufferCopies_ )
+        vkCmdCopyBuffer( batch.cmdBuffer_, copy.src_, copy.dst_, 1, &copy.region_ );
+
+    // buffers may be read as vertices, indices or uniforms afterwards
+    VkMemoryBarrier bufferBarrier;
+    bufferBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    bufferBarrier.pNext = nullptr;
+    bufferBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    bufferBarrier.dstAccessMask = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_INDEX_READ_BIT | VK_ACCESS_UNIFORM_READ_BIT;
+    vkCmdPipelineBarrier( batch.cmdBuffer_, VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_HOST_BIT,
+                          VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0,
+                          bufferCopies_.empty() ? 0 : 1, &bufferBarrier, 0, nullptr,
+                          static_cast<uint32_t>( toShader.size() ), toShader.data() );
+
+    vkEndCommandBuffer( batch.cmdBuffer_ );
+
+    VkSubmitInfo submitInfo;
+    submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submitInfo.pNext = nullptr;
+    submitInfo.waitSemaphoreCount = 0;
+    submitInfo.pWaitSemaphores = nullptr;
+    submitInfo.pWaitDstStageMask = nullptr;
+    submitInfo.commandBufferCount = 1;
+    submitInfo.pCommandBuffers = &batch.cmdBuffer_;
+    submitInfo.signalSemaphoreCount = 0;
+    submitInfo.pSignalSemaphores = nullptr;
+    vkResetFences( device_, 1, &batch.fence_ );
+    vkQueueSubmit( queue_, 1, &submitInfo, batch.fence_ );
+
+    batch.ticket_ = ++submittedTicket_;
+    batch.ringEnd_ = ringHead_;
+    batch.oversized_.swap( pendingOversized_ );
+    batchesInFlight_++;
+
+    imageUploads_.clear();
+    imageCopies_.clear();
+    bufferCopies_.clear();
+    hostImages_.clear();
+    return batch.ticket_;
+}
+
+// Level i is blitted from level i - 1 once the copy or blit into i - 1 is done;
+// source levels end up in TRANSFER_SRC, the last level stays in TRANSFER_DST
+void UploadQueue::RecordMipBlits( VkCommandBuffer cmdBuffer, const ImageUpload& upload )
+{
+    VkImageMemoryBarrier barrier;
+    barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    barrier.pNext = nullptr;
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+    barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.image = upload.image_;
+
+    // the uploaded levels become sources all at once
+    barrier.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, upload.uploadedLevels_, 0, 1 };
+    vkCmdPipelineBarrier( cmdBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier );
+
+    for( uint32_t level = upload.uploadedLevels_; level < upload.mipLevels_; level++ )
+    {
+        if( level > upload.uploadedLevels_ )
+        {
+            barrier.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, level - 1, 1, 0, 1 };
+            vkCmdPipelineBarrier( cmdBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier );
+        }
+
+        VkImageBlit blit;
+        blit.srcSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, level - 1, 0, 1 };
+        blit.srcOffsets[0] = { 0, 0, 0 };
+        blit.srcOffsets[1] = { static_cast<int32_t>( std::max( upload.width_ >> ( level - 1 ), 1u ) ), static_cast<int32_t>( std::max( upload.height_ >> ( level - 1 ), 1u ) ), 1 };
+        blit.dstSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, level, 0, 1 };
+        blit.dstOffsets[0] = { 0, 0, 0 };
+        blit.dstOffsets[1] = { static_cast<int32_t>( std::max( upload.width_ >> level, 1u ) ), static_cast<int32_t>( std::max( upload.height_ >> level, 1u ) ), 1 };
+        vkCmdBlitImage( cmdBuffer, upload.image_, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, upload.image_, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &blit, VK_FILTER_LINEAR );
+    }
+}
+
+bool UploadQueue::RetireOldest( bool wait )
+{
+    if( batchesInFlight_ == 0 )
+        return false;
+
+    Batch& batch = batches_[oldestBatch_];
+    if( wait )
+        vkWaitForFences( device_, 1, &batch.fence_, VK_TRUE, UINT64_MAX );
+    else if( vkGetFenceStatus( device_, batch.fence_ ) != VK_SUCCESS )
+        return false;
+
+    ReleaseBatch( batch );
+    oldestBatch_ = ( oldestBatch_ + 1 ) % kBatchCount;
+    batchesInFlight_--;
+    return true;
+}
+
+void UploadQueue::ReleaseBatch( Batch& batch )
+{
+    ringTail_ = batch.ringEnd_;
+    completedTicket_ = batch.ticket_;
+    for( auto& staging : batch.oversized_ )
+    {
+        vkDestroyBuffer( device_, staging.buffer_, nullptr );
+        allocator_->Free( staging.memory_ );
+    }
+    batch.oversized_.clear();
+}
+
+bool UploadQueue::IsComplete( uint64_t ticket )
+{
+    while( completedTicket_ < ticket && RetireOldest( false ) )
+        ;
+    return completedTicket_ >= ticket;
+}
+
+void UploadQueue::Wait( uint64_t ticket )
+{
+    assert( ticket <= submittedTicket_ );
+    while( completedTicket_ < ticket )
+        RetireOldest( true );
+}
+
+void UploadQueue::WaitIdle( void )
+{
+    Wait( Flush() );
+}
@@ -0,0 +1,156 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#ifndef TUTORIAL06_TEXTURE_UPLOADQUEUE_H
+#define TUTORIAL06_TEXTURE_UPLOADQUEUE_H
+
+#include <vulkan_wrapper.h>
+#include <vector>
+#include "MemoryAllocator.h"
+
+// Source data of one mip level
+struct UploadImageLevel
+{
+    const void* texels_;
+    uint32_t width_;
+    uint32_t height_;
+    uint32_t rowLength_; // texels from one row start to the next, >= width_
+};
+
+// Texel block of the image format, 1 x 1 texels for uncompressed formats
+struct UploadImageBlock
+{
+    uint32_t width_;
+    uint32_t height_;
+    uint32_t size_;      // bytes per block
+};
+
+/*
+ * UploadQueue
+ *   Copies data from the CPU into device local buffers and images.
+ *
+ *   Source data is copied into one persistently mapped staging buffer that
+ *   is used as a ring. The copy commands of many uploads are collected and
+ *   recorded into a single command buffer when Flush() is called, with one
+ *   pipeline barrier before and one after all copies. Mip levels that are
+ *   not uploaded are blitted in the same command buffer. Every flushed batch
+ *   is tracked by a fence; its part of the ring is reused once the fence
+ *   has signaled, so loading never waits for the GPU unless the ring is full.
+ *
+ *   Uploads bigger than the whole ring get a staging buffer of their own
+ *   that is released with their batch.
+ *
+ *   Batches are submitted to the render queue, so frames submitted later
+ *   see the uploaded data without waiting on a ticket. Not thread safe.
+ */
+class UploadQueue
+{
+public:
+    void Init( VkDevice device, VkQueue queue, uint32_t queueFamilyIndex, MemoryAllocator* allocator, VkDeviceSize ringSize );
+    // waits for every batch
+    void Shutdown( void );
+
+    void UploadBuffer( VkBuffer dst, VkDeviceSize dstOffset, const void* data, VkDeviceSize size );
+    // Uploads levels [0, levelCount) of an image in VK_IMAGE_LAYOUT_UNDEFINED. Source rows are staged
+    // as they are, padding included; the copy skips the padding through bufferRowLength.
+    // Block compressed levels are rows of whole blocks, rowLength_ a multiple of the block width.
+    // Levels [levelCount, mipLevels) are generated on the GPU, each one blitted with linear filtering
+    // from the level above, so the format has to support that (compressed formats never do). The whole image ends up in
+    // VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL.
+    void UploadImage( VkImage dst, uint32_t mipLevels, const UploadImageBlock& block, const UploadImageLevel* levels, uint32_t levelCount );
+    // Moves a linear image the CPU wrote in VK_IMAGE_LAYOUT_PREINITIALIZED to VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
+    void TransitionHostImage( VkImage image );
+
+    // Submits the collected copies, returns the ticket to wait for
+    uint64_t Flush( void );
+    bool IsComplete( uint64_t ticket );
+    void Wait( uint64_t ticket );
+    void WaitIdle( void );
+
+private:
+    static const uint32_t kBatchCount = 4;
+    static const VkDeviceSize kRingAlignment = 16;
+
+    struct StagingBuffer
+    {
+        VkBuffer buffer_;
+        MemoryAllocation memory_;
+    };
+
+    struct ImageUpload
+    {
+        VkImage image_;
+        uint32_t width_;
+        uint32_t height_;
+        uint32_t mipLevels_;
+        uint32_t uploadedLevels_; // levels after these are blitted
+    };
+
+    struct ImageCopy
+    {
+        VkBuffer src_;
+        VkImage dst_;
+        VkBufferImageCopy region_;
+    };
+
+    struct BufferCopy
+    {
+        VkBuffer src_;
+        VkBuffer dst_;
+        VkBufferCopy region_;
+    };
+
+    struct Batch
+    {
+        VkCommandPool cmdPool_;
+        VkCommandBuffer cmdBuffer_;
+        VkFence fence_;
+        uint64_t ticket_;
+        uint64_t ringEnd_;                      // ring position to release once the fence signaled
+        std::vector<StagingBuffer> oversized_;
+    };
+
+    // Returns the mapped staging memory for size bytes and the buffer/offset to copy from
+    void* Stage( VkDeviceSize size, VkBuffer* buffer, VkDeviceSize* offset );
+    void RecordMipBlits( VkCommandBuffer cmdBuffer, const ImageUpload& upload );
+    bool RetireOldest( bool wait );
+    void ReleaseBatch( Batch& batch );
+
+    VkDevice device_;
+    VkQueue queue_;
+    MemoryAllocator* allocator_;
+
+    StagingBuffer ring_;
+    VkDeviceSize ringSize_;
+    uint64_t ringHead_;                         // positions grow forever, ring offset is position % ringSize_
+    uint64_t ringTail_;
+
+    Batch batches_[kBatchCount];
+    uint32_t oldestBatch_;
+    uint32_t batchesInFlight_;
+    uint64_t submittedTicket_;
+    uint64_t completedTicket_;
+
+    // copies collected for the next Flush()
+    std::vector<ImageUpload> imageUploads_;
+    std::vector<ImageCopy> imageCopies_;
+    std::vector<BufferCopy> bufferCopies_;
+    std::vector<VkImage> hostImages_;
+    std::vector<StagingBuffer> pendingOversized_;
+};
+
+#endif // TUTORIAL06_TEXTURE_UPLOADQUEUE_H
@@ -13,9 +13,16 @@
 // limitations under the License.
 
 #include <android/log.h>
+#include <algorithm>
 #include <cassert>
 #include <vector>
 #include <array>
+#include <chrono>
+#include <future>
+#include <memory>
+#include <string>
+#include <cstring>
+#include <cmath>
 #include "vulkan_wrapper.h"
 
 using namespace std;
@@ -25,6 +32,25 @@ using namespace std;
 
 #include <stb/stb_image.h>
 #include "CreateShaderModule.h"
+#include "JobSystem.h"
+#include "MemoryAllocator.h"
+#include "UploadQueue.h"
+#include "TextureMipmaps.h"
+#include "KtxTexture.h"
+#include "BlockDecoder.h"
+#include "PipelineCacheFile.h"
+#include "PipelineManager.h"
+#include "LayoutCache.h"
+#include "SpirvReflect.h"
+#include "ShaderModuleCache.h"
+#include "DescriptorAllocator.h"
+#include "DescriptorSetCache.h"
+#include "BindlessTextureTable.h"
+#include "UniformRing.h"
+#include "GeometryBuffer.h"
+#ifdef VKTUTS_SHADER_HOT_RELOAD
+#include "ShaderWatcher.h"
+#endif
 #include "VulkanMain.hpp"
 
 static const char* kTAG = "Vulkan-Tutorial06";
@@ -56,9 +82,18 @@ struct VulkanDeviceInfo
     uint32_t queueFamilyIndex_;
     VkSurfaceKHR surface_;
     VkQueue queue_;
+    bool descriptorUpdateTemplate_; // VK_KHR_descriptor_update_template is enabled
+    uint32_t bindlessTextures_;     // slots of the bindless texture table, 0 in the classic descriptor set mode
 };
 VulkanDeviceInfo device;
 
+// every image and buffer memory is sub-allocated from here
+MemoryAllocator memoryAllocator;
+
+// staging memory all texture data goes through
+static const VkDeviceSize kStagingRingSize = 16 * 1024 * 1024;
+UploadQueue uploadQueue;
+
 struct VulkanSwapchainInfo
 {
     VkSwapchainKHR swapchain_;
@@ -76,49 +111,271 @@ struct TextureObject
 {
     VkSampler sampler_;
     VkImage image_;
-    VkDeviceMemory deviceMemory_;
+    MemoryAllocation memory_;
     VkImageView imageView_;
+    VkFormat format_;
     int32_t width_;
     int32_t height_;
+    uint32_t mipLevels_;
+    uint32_t bindlessSlot_; // index into the bindless texture table
 };
-static const VkFormat kTexFmt = VK_FORMAT_R8G8B8A8_UNORM;
+static const VkFormat kTexFmt = VK_FORMAT_R8G8B8A8_UNORM;  // format png files are decoded to
 #define TUTORIAL_TEXTURE_COUNT 1
 const char* texFiles[TUTORIAL_TEXTURE_COUNT] = { "sample_tex.png", };
+// Compressed versions of a texture sit next to its png as <name>.<variant>.ktx2 ( e.g. sample_tex.astc.ktx2 ).
+// The first variant the device samples natively wins; without one the first the CPU can decode is transcoded,
+// and the png is the last resort
+const char* kKtxVariants[] = { "astc", "etc2", "bc", };
 struct TextureObject textures[TUTORIAL_TEXTURE_COUNT];
 
+// Where the texels of a loaded texture live
+enum TextureTiling
+{
+    TEXTURE_TILING_OPTIMAL, // copied from a staging buffer into a device local optimal image
+    TEXTURE_TILING_LINEAR,  // written by the CPU into a linear image and sampled from there, when supported
+};
+#ifdef VKTUTS_TEXTURE_LINEAR
+static const TextureTiling kTextureTiling = TEXTURE_TILING_LINEAR;
+#else
+static const TextureTiling kTextureTiling = TEXTURE_TILING_OPTIMAL;
+#endif
+
 struct VulkanBufferInfo
 {
-    VkBuffer vertexBuf_;
+    GeometryBuffer scene_; // the textured triangle, device local
 };
 VulkanBufferInfo buffers;
 
+// Per-draw uniforms, laid out like tri.vert's Object block
+struct ObjectUniforms
+{
+    float transform_[4]; // xy: offset, zw: scale
+};
+// Set of the scene whose uniform blocks are bound at dynamic offsets into uniformRing
+static const uint32_t kObjectSet = 1;
+UniformRing uniformRing;
+
 struct VulkanGfxPipelineInfo
 {
-    VkDescriptorSetLayout dscLayout_;
-    VkDescriptorPool descPool_;
-    VkDescriptorSet descSet_;
-    VkPipelineLayout layout_;
+    VkDescriptorSetLayout dscLayout_; // set 0 of layout_, owned by layoutCache
+    VkDescriptorSet descSet_;         // owned by descriptorAllocator, or by bindlessTextures in bindless mode
+    VkDescriptorSetLayout objectLayout_; // set 1 of layout_, owned by layoutCache
+    VkDescriptorSet objectSet_;          // uniformRing's buffer, each draw binds it at its own dynamic offset
+    VkPipelineLayout layout_;         // owned by layoutCache
+    const char* sceneShader_;         // fragment shader of the scene, tri_bindless.frag in bindless mode
+    uint32_t materialCount_;          // bindless mode: draw i samples table slot i % materialCount_
+    PipelineDesc sceneDesc_;          // vertex input and layout reflected from the scene's shaders
     VkPipelineCache cache_;
-    VkPipeline pipeline_;
+    bool cacheFromDisk_;        // cache_ started with the data saved by the previous run
+    bool cacheSaved_;           // cache_ was saved once every pipeline had been built
+    uint32_t fallbackPipeline_; // pipelineManager id, drawn until scenePipeline_ is ready
+    uint32_t scenePipeline_;    // pipelineManager id, built on the job system
+    VkPipeline boundPipeline_;  // what recorded draws bind, the scene pipeline or its fallback
 };
 VulkanGfxPipelineInfo gfxPipeline;
 
+// Number of frames the CPU may record ahead of the GPU.
+// 1 reproduces the old behaviour (CPU waits for every frame), 2~3 lets CPU and GPU overlap.
+#ifndef VKTUTS_FRAMES_IN_FLIGHT
+#define VKTUTS_FRAMES_IN_FLIGHT 2
+#endif
+static const uint32_t kFramesInFlight = VKTUTS_FRAMES_IN_FLIGHT;
+
+// How the per-frame primary command buffer gets its draw commands
+enum RecordMode
+{
+    RECORD_DYNAMIC,            // all commands are recorded into the primary every frame
+    RECORD_STATIC_SECONDARY,   // unchanging draws live in a secondary buffer recorded once
+    RECORD_PARALLEL_SECONDARY, // draws are split into secondary buffers recorded by the job system
+};
+#if defined( VKTUTS_RECORD_MODE_STATIC )
+static const RecordMode kRecordMode = RECORD_STATIC_SECONDARY;
+#elif defined( VKTUTS_RECORD_MODE_PARALLEL )
+static const RecordMode kRecordMode = RECORD_PARALLEL_SECONDARY;
+#else
+static const RecordMode kRecordMode = RECORD_DYNAMIC;
+#endif
+
+// Number of draws recorded per frame, raise it to stress command recording
+#ifndef VKTUTS_DRAW_COUNT
+#define VKTUTS_DRAW_COUNT 1
+#endif
+static const uint32_t kDrawCount = VKTUTS_DRAW_COUNT;
+
+// Secondary command buffers one job system thread records into during one frame.
+// A command pool must only be used by one thread at a time, so each thread gets its own.
+struct VulkanThreadCommandInfo
+{
+    VkCommandPool cmdPool_;
+    std::vector<VkCommandBuffer> cmdBuffers_;
+    uint32_t used_;
+};
+
+// Everything one in-flight frame owns; it can only be reused once fence_ is signaled
+struct VulkanFrameInfo
+{
+    VkCommandPool cmdPool_;      // transient pool, reset in bulk every frame
+    VkCommandBuffer cmdBuffer_;
+    VkFence fence_;              // signaled when the GPU finished this frame's submission
+    VkSemaphore imageAvailable_; // acquire -> submit
+    VkSemaphore renderFinished_; // submit -> present
+    std::vector<VulkanThreadCommandInfo> threadCmds_;  // parallel mode, indexed by JobSystem::ThreadIndex()
+    std::vector<VkCommandBuffer> secondaryCmdBuffers_; // parallel mode, recorded chunks in draw order
+};
+
+// Command buffer replaced while frames in flight may still execute it
+struct VulkanRetiredCmdBuffer
+{
+    VkCommandBuffer cmdBuffer_;
+    uint64_t freeFrame_; // no frame in flight uses it once frameNumber_ got here
+};
+
+// Pipeline replaced (hot reload) while frames in flight may still use it
+struct VulkanRetiredPipeline
+{
+    VkPipeline pipeline_;
+    uint64_t freeFrame_;
+};
+
 struct VulkanRenderInfo
 {
     VkRenderPass renderPass_;
-    VkCommandPool cmdPool_;
-    VkCommandBuffer* cmdBuffer_;
-    uint32_t cmdBufferLen_;
-    VkSemaphore semaphore_;
-    VkFence fence_;
+    VkCommandPool cmdPool_;            // long-lived command buffers (static secondary)
+    VkCommandBuffer staticCmdBuffer_;
+    RecordMode recordMode_;
+    uint32_t drawCount_;
+    uint32_t recordThreads_; // parallel mode: number of chunks recorded concurrently
+    std::vector<VulkanFrameInfo> frames_;
+    uint32_t currentFrame_;
+    uint64_t frameNumber_;   // frames submitted so far
+    std::vector<VulkanRetiredCmdBuffer> retiredCmdBuffers_;
+    std::vector<VulkanRetiredPipeline> retiredPipelines_;
+    std::vector<uint32_t> objectOffsets_; // per draw: dynamic offset of its ObjectUniforms in uniformRing
 };
 VulkanRenderInfo render;
 
+std::unique_ptr<JobSystem> jobSystem;
+PipelineManager pipelineManager;
+LayoutCache layoutCache;
+ShaderModuleCache shaderModules;
+
+// Sets per descriptor pool; the allocator adds pools when more sets are needed
+static const uint32_t kDescriptorSetsPerPool = 64;
+DescriptorAllocator descriptorAllocator;
+DescriptorSetCache descriptorSets;
+
+#ifdef VKTUTS_BINDLESS
+// Slots of the bindless texture table, lowered to what the device can bind
+static const uint32_t kBindlessTextureCapacity = 4096;
+#endif
+BindlessTextureTable bindlessTextures;
+
+#ifdef VKTUTS_BENCHMARK
+// Frame throughput is logged every kBenchmarkFrames frames
+static const uint32_t kBenchmarkFrames = 600;
+#ifdef VKTUTS_RUNTIME_SHADERC
+// Shader variants compiled by the shaderc startup benchmark
+static const uint32_t kBenchmarkShaderCount = 32;
+#endif
+struct VulkanBenchmarkInfo
+{
+    std::chrono::steady_clock::time_point start_;
+    uint32_t frames_;
+    double recordSeconds_; // CPU time spent resetting and recording command buffers
+    bool pipelinesLogged_; // build statistics are logged once every pipeline is ready
+};
+VulkanBenchmarkInfo benchmark;
+#endif
+
+// Time from APP_CMD_INIT_WINDOW to the first presented frame, logged once per window
+struct VulkanResumeInfo
+{
+    std::chrono::steady_clock::time_point start_;
+    bool pending_;
+    bool coldStart_; // the device had to be created as well
+};
+VulkanResumeInfo resume;
+
+#ifdef VKTUTS_SHADER_HOT_RELOAD
+// Shaders edited while the app runs, from the edit to the first frame drawn with them
+struct VulkanHotReloadInfo
+{
+    ShaderWatcher watcher_;
+    bool pending_;                                // pipelines of change_ are rebuilding
+    bool presenting_;                             // the frame being drawn is the first with them
+    ShaderChange change_;                         // latest change, the one the latency is logged for
+    std::chrono::system_clock::time_point ready_; // every rebuilt pipeline was swapped in
+};
+VulkanHotReloadInfo hotReload;
+#endif
+#ifdef VKTUTS_RUNTIME_SHADERC
+static const char* kShaderSource = "runtime compiled";
+#else
+static const char* kShaderSource = "precompiled";
+#endif
+
 android_app* androidAppCtx = nullptr;
 
 void setImageLayout( VkCommandBuffer cmdBuffer, VkImage image, VkImageLayout oldImageLayout, VkImageLayout newImageLayout, VkPipelineStageFlags srcStages, VkPipelineStageFlags destStages );
+VkPipeline BuildPipeline( const PipelineDesc& desc );
+void RecordStaticCommandBuffer( void );
+void DeleteFrameBuffers( void );
+
+bool HasExtension( const vector<VkExtensionProperties>& extensions, const char* name )
+{
+    return any_of( extensions.begin(), extensions.end(), [name]( const VkExtensionProperties& extension ) {
+        return strcmp( extension.extensionName, name ) == 0;
+    } );
+}
 
-void CreateVulkanDevice( ANativeWindow* platformWindow )
+#ifdef VKTUTS_BINDLESS
+// Slots of a bindless texture table the device can bind, 0 without the descriptor indexing features it needs.
+// enabled receives the features to create the device with.
+uint32_t QueryBindlessTextures( const vector<VkExtensionProperties>& extensions, VkPhysicalDeviceDescriptorIndexingFeaturesEXT* enabled )
+{
+    memset( enabled, 0, sizeof( *enabled ) );
+    enabled->sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES_EXT;
+    if( vkGetPhysicalDeviceFeatures2KHR == nullptr || vkGetPhysicalDeviceProperties2KHR == nullptr ||
+        !HasExtension( extensions, VK_KHR_MAINTENANCE3_EXTENSION_NAME ) || !HasExtension( extensions, VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME ) )
+        return 0;
+
+    VkPhysicalDeviceDescriptorIndexingFeaturesEXT indexingFeatures;
+    memset( &indexingFeatures, 0, sizeof( indexingFeatures ) );
+    indexingFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES_EXT;
+    VkPhysicalDeviceFeatures2KHR features;
+    memset( &features, 0, sizeof( features ) );
+    features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2_KHR;
+    features.pNext = &indexingFeatures;
+    vkGetPhysicalDeviceFeatures2KHR( device.physicalDevice_, &features );
+    // the slot is a push constant, dynamically uniform, so non-uniform indexing is not needed
+    if( !indexingFeatures.runtimeDescriptorArray || !indexingFeatures.descriptorBindingPartiallyBound ||
+        !indexingFeatures.descriptorBindingSampledImageUpdateAfterBind || !indexingFeatures.descriptorBindingUpdateUnusedWhilePending )
+        return 0;
+
+    VkPhysicalDeviceDescriptorIndexingPropertiesEXT indexingProperties;
+    memset( &indexingProperties, 0, sizeof( indexingProperties ) );
+    indexingProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_PROPERTIES_EXT;
+    VkPhysicalDeviceProperties2KHR properties;
+    memset( &properties, 0, sizeof( properties ) );
+    properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2_KHR;
+    properties.pNext = &indexingProperties;
+    vkGetPhysicalDeviceProperties2KHR( device.physicalDevice_, &properties );
+
+    enabled->runtimeDescriptorArray = VK_TRUE;
+    enabled->descriptorBindingPartiallyBound = VK_TRUE;
+    enabled->descriptorBindingSampledImageUpdateAfterBind = VK_TRUE;
+    enabled->descriptorBindingUpdateUnusedWhilePending = VK_TRUE;
+    // a combined image sampler counts against the sampler and the sampled image limits
+    return std::min( { kBindlessTextureCapacity, indexingProperties.maxUpdateAfterBindDescriptorsInAllPools,
+                       indexingProperties.maxPerStageDescriptorUpdateAfterBindSamplers,
+                       indexingProperties.maxPerStageDescriptorUpdateAfterBindSampledImages,
+                       indexingProperties.maxPerStageUpdateAfterBindResources,
+                       indexingProperties.maxDescriptorSetUpdateAfterBindSamplers,
+                       indexingProperties.maxDescriptorSetUpdateAfterBindSampledImages } );
+}
+#endif
+
+void CreateVulkanDevice( void )
 {
     // instance         : vulkan instance. surface와 physical device 생성에 쓰임
     // surface          : ANativeWindow와 vulkan instance를 통해 vulkan surface 생성
@@ -136,6 +393,15 @@ void CreateVulkanDevice( ANativeWindow* platformWindow )
 
     std::vector<const char*> instanceExtensions{ "VK_KHR_surface", "VK_KHR_android_surface" };
     std::vector<const char*> deviceExtensions{ "VK_KHR_swapchain" };
+#ifdef VKTUTS_BINDLESS
+    // descriptor indexing support is queried through VK_KHR_get_physical_device_properties2
+    uint32_t instanceExtensionCount{ 0 };
+    vkEnumerateInstanceExtensionProperties( nullptr, &instanceExtensionCount, nullptr );
+    vector<VkExtensionProperties> instanceExtensionProperties( instanceExtensionCount );
+    vkEnumerateInstanceExtensionProperties( nullptr, &instanceExtensionCount, instanceExtensionProperties.data() );
+    if( HasExtension( instanceExtensionProperties, VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME ) )
+        instanceExtensions.push_back( VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME );
+#endif
 
     VkApplicationInfo applicationInfo;
     applicationInfo.sType = VK_STRUCTURE_TYPE_APPLICATION_INFO;
@@ -156,13 +422,7 @@ void CreateVulkanDevice( ANativeWindow* platformWindow )
     instanceCreateInfo.enabledExtensionCount = instanceExtensions.size();
     instanceCreateInfo.ppEnabledExtensionNames = instanceExtensions.data();
     vkCreateInstance( &instanceCreateInfo, nullptr, &device.instance_ );
-
-    VkAndroidSurfaceCreateInfoKHR androidSurfaceCreateInfo;
-    androidSurfaceCreateInfo.sType = VK_STRUCTURE_TYPE_ANDROID_SURFACE_CREATE_INFO_KHR;
-    androidSurfaceCreateInfo.pNext = nullptr;
-    androidSurfaceCreateInfo.flags = 0;
-    androidSurfaceCreateInfo.window = platformWindow;
-    vkCreateAndroidSurfaceKHR( device.instance_, &androidSurfaceCreateInfo, nullptr, &device.surface_ );
+    InitVulkanInstance( device.instance_, instanceExtensions.data(), static_cast<uint32_t>( instanceExtensions.size() ) );
 
     uint32_t gpuCount{ 0 };
     vkEnumeratePhysicalDevices( device.instance_, &gpuCount, nullptr );
@@ -170,6 +430,27 @@ void CreateVulkanDevice( ANativeWindow* platformWindow )
     vkEnumeratePhysicalDevices( device.instance_, &gpuCount, gpus.data() );
     device.physicalDevice_ = gpus[0];
 
+    // optional device extensions are enabled when the GPU has them
+    uint32_t extensionCount{ 0 };
+    vkEnumerateDeviceExtensionProperties( device.physicalDevice_, nullptr, &extensionCount, nullptr );
+    vector<VkExtensionProperties> extensions( extensionCount );
+    vkEnumerateDeviceExtensionProperties( device.physicalDevice_, nullptr, &extensionCount, extensions.data() );
+    device.descriptorUpdateTemplate_ = HasExtension( extensions, VK_KHR_DESCRIPTOR_UPDATE_TEMPLATE_EXTENSION_NAME );
+    if( device.descriptorUpdateTemplate_ )
+        deviceExtensions.push_back( VK_KHR_DESCRIPTOR_UPDATE_TEMPLATE_EXTENSION_NAME );
+#ifdef VKTUTS_BINDLESS
+    // without it textures stay in the classic per-material descriptor set
+    VkPhysicalDeviceDescriptorIndexingFeaturesEXT indexingFeatures;
+    device.bindlessTextures_ = QueryBindlessTextures( extensions, &indexingFeatures );
+    if( device.bindlessTextures_ )
+    {
+        deviceExtensions.push_back( VK_KHR_MAINTENANCE3_EXTENSION_NAME );
+        deviceExtensions.push_back( VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME );
+    }
+#else
+    device.bindlessTextures_ = 0;
+#endif
+
     vkGetPhysicalDeviceMemoryProperties( device.physicalDevice_, &device.gpuMemoryProperties_ );
 
     uint32_t indexCount{ 0 };
@@ -203,12 +484,35 @@ void CreateVulkanDevice( ANativeWindow* platformWindow )
     deviceCreateInfo.enabledExtensionCount = deviceExtensions.size();
     deviceCreateInfo.ppEnabledExtensionNames = deviceExtensions.data();
     deviceCreateInfo.pEnabledFeatures = nullptr;
+#ifdef VKTUTS_BINDLESS
+    deviceCreateInfo.pNext = device.bindlessTextures_ ? &indexingFeatures : nullptr;
+#endif
     vkCreateDevice( device.physicalDevice_, &deviceCreateInfo, nullptr, &device.device_ );
+    InitVulkanDevice( device.device_ );
+    device.descriptorUpdateTemplate_ = device.descriptorUpdateTemplate_ && vkUpdateDescriptorSetWithTemplateKHR != nullptr;
 
     vkGetDeviceQueue( device.device_, device.queueFamilyIndex_, 0, &device.queue_ );
 }
 
-void CreateSwapChain( void )
+// The surface is the only instance object tied to the window.
+// It is recreated on every APP_CMD_INIT_WINDOW while the instance and device stay alive.
+void CreateSurface( ANativeWindow* platformWindow )
+{
+    VkAndroidSurfaceCreateInfoKHR androidSurfaceCreateInfo;
+    androidSurfaceCreateInfo.sType = VK_STRUCTURE_TYPE_ANDROID_SURFACE_CREATE_INFO_KHR;
+    androidSurfaceCreateInfo.pNext = nullptr;
+    androidSurfaceCreateInfo.flags = 0;
+    androidSurfaceCreateInfo.window = platformWindow;
+    CALL_VK( vkCreateAndroidSurfaceKHR( device.instance_, &androidSurfaceCreateInfo, nullptr, &device.surface_ ) );
+
+    VkBool32 supported = VK_FALSE;
+    vkGetPhysicalDeviceSurfaceSupportKHR( device.physicalDevice_, device.queueFamilyIndex_, device.surface_, &supported );
+    assert( supported );
+}
+
+// oldSwapchain : 교체될 swapchain. 넘겨주면 드라이버가 기존 swapchain의 자원을 재사용할 수 있고,
+//              : 이미 acquire된 이미지의 present도 정상적으로 끝낼 수 있다. (생성 후 old swapchain은 직접 destroy 해야함)
+void CreateSwapChain( VkSwapchainKHR oldSwapchain = VK_NULL_HANDLE )
 {
     // GPU가 android surface에게 지원하는 capability를 가져온다.
     // GPU가 android surface에게 지원하는 format을 가져온다. => VK_FORMAT_R8G8B8_UNORM format에 대한 index를 얻는다.
@@ -251,7 +555,7 @@ void CreateSwapChain( void )
     swapchainCreateInfo.compositeAlpha = VK_COMPOSITE_ALPHA_INHERIT_BIT_KHR;
     swapchainCreateInfo.presentMode = VK_PRESENT_MODE_FIFO_KHR;
     swapchainCreateInfo.clipped = VK_TRUE;
-    swapchainCreateInfo.oldSwapchain = VK_NULL_HANDLE;
+    swapchainCreateInfo.oldSwapchain = oldSwapchain;
     vkCreateSwapchainKHR( device.device_, &swapchainCreateInfo, nullptr, &swapchain.swapchain_ );
 }
 
@@ -337,6 +641,8 @@ void CreateFrameBuffers( VkImageView depthView = VK_NULL_HANDLE )
     //                      : layerCount        : VkImage가 멀티뷰일때 그중 몇개의 이미지를 사용하는가
     //                      : baseArrayLayer    : 사용하는 이미지들(imageArrayLayers)중 몇개의 이미지를 접근 가능한 이미지로 지정할것인가
 
+    // the driver may create more images than minImageCount
+    vkGetSwapchainImagesKHR( device.device_, swapchain.swapchain_, &swapchain.swapchainLength_, nullptr );
     swapchain.displayImages_.resize( swapchain.swapchainLength_ );
     swapchain.displayViews_.resize( swapchain.swapchainLength_ );
     swapchain.framebuffers_.resize( swapchain.swapchainLength_ );
@@ -381,44 +687,213 @@ void CreateFrameBuffers( VkImageView depthView = VK_NULL_HANDLE )
     }
 }
 
-// A help function to map required memory property into a VK memory type
-// memory type is an index into the array of 32 entries; or the bit index
-// for the memory type ( each BIT of an 32 bit integer is a type ).
-VkResult findMemoryTypeIndex( uint32_t typeBits, VkFlags requirementsMask, uint32_t* typeIndex )
+// Texels of a texture file: the decoded pixels of a png, or the blocks of a KTX2 file
+struct TextureFileData
+{
+    VkFormat format_;
+    UploadImageBlock block_;
+    uint32_t width_;
+    uint32_t height_;
+    std::vector<UploadImageLevel> levels_;  // levels stored in the file, level 0 first
+    std::vector<uint8_t> storage_;          // KTX2 file or CPU decoded blocks, levels_ point into it
+    unsigned char* pixels_;                 // png pixels from stbi, nullptr for KTX2 files
+};
+
+// Whole asset in memory, false if the apk does not have it
+bool ReadAsset( const char* filePath, std::vector<uint8_t>* content )
+{
+    AAsset* file = AAssetManager_open( androidAppCtx->activity->assetManager, filePath, AASSET_MODE_BUFFER );
+    if( !file )
+        return false;
+    content->resize( static_cast<size_t>( AAsset_getLength( file ) ) );
+    AAsset_read( file, content->data(), content->size() );
+    AAsset_close( file );
+    return true;
+}
+
+bool CanSampleOptimal( VkFormat format )
+{
+    VkFormatProperties props;
+    vkGetPhysicalDeviceFormatProperties( device.physicalDevice_, format, &props );
+    return ( props.optimalTilingFeatures & VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT ) != 0;
+}
+
+void DecodePngTextureFile( const char* filePath, TextureFileData* fileData )
 {
-    // GPU가 가진 메모리 타입중에, 필요로하는 메모리 특성을 모두 가지고 있는 메모리 타입의 index를 반환한다.
-    // requirementMask                      : 필요한 메모리 특성을 flag로 전달
+    std::vector<uint8_t> fileContent;
+    bool found = ReadAsset( filePath, &fileContent );
+    assert( found );
+
+    uint32_t n;
+    fileData->pixels_ = stbi_load_from_memory( fileContent.data(), static_cast<int>( fileContent.size() ), reinterpret_cast<int*>(&fileData->width_), reinterpret_cast<int*>(&fileData->height_), reinterpret_cast<int*>(&n), 4 );
+    assert( n == 4 );
 
-    // VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT  : 이 타입으로 할당된 메모리는 vkMapMemory를 통해 host가 접근 가능하다.
-    // VK_MEMORY_PROPERTY_HOST_COHERENT_BIT : host와 device가 밀착된 메모리
-    //                                      : 호스트게 메모리에 쓴 글을 flush하지 않아도 device가 바로 읽을 수 있고
-    //                                      : device가 메모리에 쓴 글도 호스트에게 visible함
+    fileData->format_ = kTexFmt;
+    fileData->block_ = { 1, 1, 4 };
+    fileData->levels_.assign( 1, { fileData->pixels_, fileData->width_, fileData->height_, fileData->width_ } );
+}
 
-    // Search memtypes to find first index with those properties
-    for( uint32_t i = 0; i < 32; i++ )
+// Picks one of the KTX2 variants of a png, see kKtxVariants; false if there is none the device can use
+bool DecodeKtxTextureFile( const char* filePath, TextureFileData* fileData )
+{
+    // KTX2         : Khronos의 텍스쳐 컨테이너, vkFormat과 mip level들의 block 데이터가 그대로 들어있다.
+    //              : ETC2/ASTC/BC block은 GPU가 압축된 채로 샘플링하므로 디코딩 없이 staging buffer로 바로 복사한다.
+    //              : 메모리 사용량과 대역폭도 RGBA8의 1/4 ~ 1/8 정도로 줄어든다.
+    //              : 지원 format은 기기마다 다르다. (모바일은 보통 ETC2/ASTC, 데스크탑은 BC)
+
+    // the variants replace the extension, a path without one has none
+    const char* extension = strrchr( filePath, '.' );
+    if( !extension )
+        return false;
+    std::string baseName( filePath, extension );
+    std::vector<uint8_t> transcodable;      // first file the CPU can decode, in case none is supported natively
+    for( const char* variant : kKtxVariants )
     {
-        if( ( typeBits & 1 ) == 1 )
+        std::vector<uint8_t> content;
+        if( !ReadAsset( ( baseName + "." + variant + ".ktx2" ).c_str(), &content ) )
+            continue;
+
+        KtxTexture ktx;
+        if( !ktx.Parse( content.data(), content.size() ) )
+            continue;
+
+        if( CanSampleOptimal( ktx.Format() ) )
         {
-            // Type is available, does it match user properties?
-            if( ( device.gpuMemoryProperties_.memoryTypes[i].propertyFlags & requirementsMask ) == requirementsMask )
+            // swapping keeps the vector's buffer, the levels stay valid
+            fileData->storage_.swap( content );
+            fileData->format_ = ktx.Format();
+            fileData->block_ = { ktx.BlockWidth(), ktx.BlockHeight(), ktx.BlockSize() };
+            fileData->width_ = ktx.Width();
+            fileData->height_ = ktx.Height();
+            fileData->pixels_ = nullptr;
+            fileData->levels_.clear();
+            for( uint32_t i = 0; i < ktx.LevelCount(); i++ )
             {
-                *typeIndex = i;
-                return VK_SUCCESS;
+                const KtxTexture::Level& level = ktx.GetLevel( i );
+                uint32_t rowLength = ( level.width_ + ktx.BlockWidth() - 1 ) / ktx.BlockWidth() * ktx.BlockWidth();
+                fileData->levels_.push_back( { level.data_, level.width_, level.height_, rowLength } );
             }
+            LOGI( "%s: %s.ktx2, format %d, %u levels", filePath, variant, fileData->format_, ktx.LevelCount() );
+            return true;
         }
-        typeBits >>= 1;
+        if( transcodable.empty() && DecodedBlockFormat( ktx.Format() ) != VK_FORMAT_UNDEFINED )
+            transcodable.swap( content );
+    }
+    if( transcodable.empty() )
+        return false;
+
+    // no native format, decode every level into RGBA8 on the CPU
+    KtxTexture ktx;
+    ktx.Parse( transcodable.data(), transcodable.size() );
+    size_t decodedSize = 0;
+    for( uint32_t i = 0; i < ktx.LevelCount(); i++ )
+        decodedSize += static_cast<size_t>( ktx.GetLevel( i ).width_ ) * ktx.GetLevel( i ).height_ * 4;
+    fileData->storage_.resize( decodedSize );
+
+    fileData->format_ = DecodedBlockFormat( ktx.Format() );
+    fileData->block_ = { 1, 1, 4 };
+    fileData->width_ = ktx.Width();
+    fileData->height_ = ktx.Height();
+    fileData->pixels_ = nullptr;
+    fileData->levels_.clear();
+    uint8_t* texels = fileData->storage_.data();
+    for( uint32_t i = 0; i < ktx.LevelCount(); i++ )
+    {
+        const KtxTexture::Level& level = ktx.GetLevel( i );
+        DecodeBlocks( ktx.Format(), level.data_, level.width_, level.height_, texels );
+        fileData->levels_.push_back( { texels, level.width_, level.height_, level.width_ } );
+        texels += static_cast<size_t>( level.width_ ) * level.height_ * 4;
     }
-    // No memory types matched, return failure
-    return VK_ERROR_MEMORY_MAP_FAILED;
+    LOGW( "%s: format %d is not supported by the device, decoded to RGBA8 on the CPU", filePath, ktx.Format() );
+    return true;
 }
 
-VkResult LoadTextureFromFile( const char* filePath, struct TextureObject* textureObject )
+// Reads and decodes a texture asset, safe to call from any thread
+void DecodeTextureFile( const char* filePath, TextureFileData* fileData )
 {
-    // blit         : bit block transfer의 약어, 데이터 배열을 목적지 배열에 복사하는것을 뜻함
-    //              : linearTilingFeatures가 VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT 플래그를 갖고 있으면, PRE_INITIALIZED -> READ_ONLY로 layout 변경가능
-    //              : VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT 플래그가 없으면, 새로운 VkImage를 READ_ONLY로 만들어 거기에다가 기존의 이미지 데이터를 copy한다.
-    //              : 위 과정은 VkImage를 READ_ONLY로 만들기 위함인데, CPU_ACCESSIBLE 한 layout보다 read_only가 더 빠르기 때문이다
+    if( !DecodeKtxTextureFile( filePath, fileData ) )
+        DecodePngTextureFile( filePath, fileData );
+}
+
+void FreeTextureFileData( TextureFileData* fileData )
+{
+    if( fileData->pixels_ )
+        stbi_image_free( fileData->pixels_ );
+    fileData->pixels_ = nullptr;
+    fileData->levels_.clear();
+    fileData->storage_.clear();
+}
+
+// Linear images can only be sampled when the format supports it, and their size limits are often small
+bool CanSampleLinear( VkFormat format, uint32_t width, uint32_t height )
+{
+    VkFormatProperties props;
+    vkGetPhysicalDeviceFormatProperties( device.physicalDevice_, format, &props );
+    if( !( props.linearTilingFeatures & VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT ) )
+        return false;
+
+    VkImageFormatProperties imageFormatProperties;
+    if( vkGetPhysicalDeviceImageFormatProperties( device.physicalDevice_, format, VK_IMAGE_TYPE_2D, VK_IMAGE_TILING_LINEAR, VK_IMAGE_USAGE_SAMPLED_BIT, 0, &imageFormatProperties ) != VK_SUCCESS )
+        return false;
+    return width <= imageFormatProperties.maxExtent.width && height <= imageFormatProperties.maxExtent.height;
+}
+
+// The CPU writes the rows of an uncompressed level 0 straight into a linear image which is then sampled as it is
+VkResult CreateLinearTexture( const TextureFileData& fileData, struct TextureObject* textureObject )
+{
+    // VK_IMAGE_LAYOUT_PREINITIALIZED   : UNDEFINED layout과 마찬가지로 initialLayout이나, oldLayout으로 쓰인다.
+    //                                  : 다만 undefined와 다르게, transition이전에 값을 쓰면 그 값이 transition 이후에 보존된다.
+
+    VkImageCreateInfo imageCreateInfo;
+    imageCreateInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+    imageCreateInfo.pNext = nullptr;
+    imageCreateInfo.flags = 0;
+    imageCreateInfo.imageType = VK_IMAGE_TYPE_2D;
+    imageCreateInfo.format = fileData.format_;
+    imageCreateInfo.extent = { fileData.width_, fileData.height_, 1 };
+    imageCreateInfo.mipLevels = 1;
+    imageCreateInfo.arrayLayers = 1;
+    imageCreateInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+    imageCreateInfo.tiling = VK_IMAGE_TILING_LINEAR;
+    imageCreateInfo.usage = VK_IMAGE_USAGE_SAMPLED_BIT;
+    imageCreateInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    imageCreateInfo.queueFamilyIndexCount = 1;
+    imageCreateInfo.pQueueFamilyIndices = &device.queueFamilyIndex_;
+    imageCreateInfo.initialLayout = VK_IMAGE_LAYOUT_PREINITIALIZED;
+    CALL_VK( vkCreateImage( device.device_, &imageCreateInfo, nullptr, &textureObject->image_ ) );
+
+    // host visible page, stays mapped for the allocator's lifetime
+    CALL_VK( memoryAllocator.AllocateForImage( textureObject->image_, VK_IMAGE_TILING_LINEAR, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, &textureObject->memory_ ) );
+
+    VkImageSubresource imageSubresource;
+    imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    imageSubresource.mipLevel = 0;
+    imageSubresource.arrayLayer = 0;
+
+    VkSubresourceLayout subresourceLayout;
+    vkGetImageSubresourceLayout( device.device_, textureObject->image_, &imageSubresource, &subresourceLayout );
+
+    // the driver picks rowPitch, copy row by row
+    char* data = static_cast<char*>( textureObject->memory_.mapped_ ) + subresourceLayout.offset;
+    const UploadImageLevel& level = fileData.levels_[0];
+    size_t rowSize = fileData.width_ * 4;
+    for( uint32_t y = 0; y < fileData.height_; ++y )
+    {
+        memcpy( data + subresourceLayout.rowPitch * y, static_cast<const char*>( level.texels_ ) + level.rowLength_ * 4 * y, rowSize );
+    }
+
+    uploadQueue.TransitionHostImage( textureObject->image_ );
+
+    textureObject->format_ = fileData.format_;
+    textureObject->width_ = fileData.width_;
+    textureObject->height_ = fileData.height_;
+    textureObject->mipLevels_ = 1;
+    return VK_SUCCESS;
+}
 
+// The texels go through the staging ring into a device local optimal image
+VkResult CreateOptimalTexture( const TextureFileData& fileData, struct TextureObject* textureObject )
+{
     // VK_IMAGE_USAGE_SAMPLED_BIT   : 텍스쳐를 쉐이더가 샘플링 할 수 있도록 하는 bit
     //                              : image를 샘플링 하려면 imageView 형태로 쉐이더에 전달해줘야함)
     //                              : imageView 형태로 어떻게 쉐이더에 전달하느냐? => DescriptorSet, DescriptorSetLayout를 이용함
@@ -435,218 +910,215 @@ VkResult LoadTextureFromFile( const char* filePath, struct TextureObject* textur
     //                                  : 당연하게도, ImageMemoryBarrier의 oldLayout으로 쓰일 때, 이 메모 내용은 보존되지 않는다.
     //                                  : (즉, memory barrier를 통해 transition하기 전에 어떤 값을 쓰더라도 무의미 하다. 뭔가를 쓰려면 preinitialized layout을 써야함)
 
-    // VK_IMAGE_LAYOUT_PREINITIALIZED   : UNDEFINED layout과 마찬가지로 initialLayout이나, oldLayout으로 쓰인다.
-    //                                  : 다만 undefined와 다르게, transition이전에 값을 쓰면 그 값이 transition 이후에 보존된다.
+    // mipmap        : 원본 텍스쳐를 가로 세로 절반씩 줄여가며 1x1까지 만든 이미지 체인
+    //               : 멀리 있어 작게 그려지는 텍스쳐는 작은 level을 샘플링하므로 texture cache miss와 memory bandwidth가 줄어든다.
+    //               : level 0만 올리고 나머지는 GPU에서 vkCmdBlitImage로 한 level씩 줄여서 만든다.
+    //               : format이 linear filter blit을 지원하지 않으면 CPU에서 box filter로 만들어 함께 올린다.
+    //               : KTX2 파일에 mip level이 들어있으면 그대로 올린다. 압축 format은 blit 할 수 없으므로 파일에 있는 level만 쓴다.
 
     VkFormatProperties props;
-    vkGetPhysicalDeviceFormatProperties( device.physicalDevice_, kTexFmt, &props );
-    assert( ( props.linearTilingFeatures | props.optimalTilingFeatures ) & VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT );
-
-    bool needBlit = static_cast<bool>( props.linearTilingFeatures & VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT );
-
-    AAsset* file = AAssetManager_open( androidAppCtx->activity->assetManager, filePath, AASSET_MODE_BUFFER );
-    auto fileLength = static_cast<size_t>(AAsset_getLength( file ));
-    stbi_uc* fileContent = new unsigned char[fileLength];
-    AAsset_read( file, fileContent, fileLength );
-    AAsset_close( file );
+    vkGetPhysicalDeviceFormatProperties( device.physicalDevice_, fileData.format_, &props );
+    assert( props.optimalTilingFeatures & VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT );
 
-    uint32_t imgWidth, imgHeight, n;
-    unsigned char* imageData = stbi_load_from_memory( fileContent, fileLength, reinterpret_cast<int*>(&imgWidth), reinterpret_cast<int*>(&imgHeight), reinterpret_cast<int*>(&n), 4 );
-    assert( n == 4 );
+    const VkFormatFeatureFlags blitFeatures = VK_FORMAT_FEATURE_BLIT_SRC_BIT | VK_FORMAT_FEATURE_BLIT_DST_BIT | VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT;
+    bool gpuMipmaps = ( props.optimalTilingFeatures & blitFeatures ) == blitFeatures;
+    bool compressed = fileData.block_.width_ > 1;
+    uint32_t mipLevels = static_cast<uint32_t>( fileData.levels_.size() );
+    if( mipLevels == 1 && !compressed )
+        mipLevels = MipLevelCount( fileData.width_, fileData.height_ );
 
     VkImageCreateInfo imageCreateInfo;
     imageCreateInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
     imageCreateInfo.pNext = nullptr;
     imageCreateInfo.flags = 0;
     imageCreateInfo.imageType = VK_IMAGE_TYPE_2D;
-    imageCreateInfo.format = kTexFmt;
-    imageCreateInfo.extent = { imgWidth, imgHeight, 1 };
-    imageCreateInfo.mipLevels = 1;
+    imageCreateInfo.format = fileData.format_;
+    imageCreateInfo.extent = { fileData.width_, fileData.height_, 1 };
+    imageCreateInfo.mipLevels = mipLevels;
     imageCreateInfo.arrayLayers = 1;
     imageCreateInfo.samples = VK_SAMPLE_COUNT_1_BIT;
-    imageCreateInfo.tiling = VK_IMAGE_TILING_LINEAR;
-    imageCreateInfo.usage = needBlit ? VK_IMAGE_USAGE_TRANSFER_SRC_BIT : VK_IMAGE_USAGE_SAMPLED_BIT;
+    imageCreateInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+    imageCreateInfo.usage = VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
     imageCreateInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
     imageCreateInfo.queueFamilyIndexCount = 1;
     imageCreateInfo.pQueueFamilyIndices = &device.queueFamilyIndex_;
-    imageCreateInfo.initialLayout = VK_IMAGE_LAYOUT_PREINITIALIZED;
-    vkCreateImage( device.device_, &imageCreateInfo, nullptr, &textureObject->image_ );
+    imageCreateInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    CALL_VK( vkCreateImage( device.device_, &imageCreateInfo, nullptr, &textureObject->image_ ) );
 
-    VkMemoryRequirements memoryRequirements;
-    vkGetImageMemoryRequirements( device.device_, textureObject->image_, &memoryRequirements );
+    // only the GPU touches the image, keep it in device local memory
+    CALL_VK( memoryAllocator.AllocateForImage( textureObject->image_, VK_IMAGE_TILING_OPTIMAL, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, &textureObject->memory_ ) );
 
-    VkMemoryAllocateInfo memoryAllocateInfo;
-    memoryAllocateInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-    memoryAllocateInfo.pNext = nullptr;
-    memoryAllocateInfo.allocationSize = memoryRequirements.size;
-    findMemoryTypeIndex( memoryRequirements.memoryTypeBits, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT, &memoryAllocateInfo.memoryTypeIndex );
-    vkAllocateMemory( device.device_, &memoryAllocateInfo, nullptr, &textureObject->deviceMemory_ );
+    // the texels go into the staging ring now, the GPU copy runs with the next uploadQueue.Flush()
+    std::vector<UploadImageLevel> levels = fileData.levels_;
+    std::vector<uint8_t> mipChain;
+    if( levels.size() < mipLevels && !gpuMipmaps )
+    {
+        // only png and RGBA8 files get here, tightly packed
+        BuildMipChainRGBA8( static_cast<const uint8_t*>( levels[0].texels_ ), fileData.width_, fileData.height_, mipLevels, &mipChain );
+        const uint8_t* texels = mipChain.data();
+        for( uint32_t level = 1; level < mipLevels; level++ )
+        {
+            uint32_t width = MipExtent( fileData.width_, level );
+            uint32_t height = MipExtent( fileData.height_, level );
+            levels.push_back( { texels, width, height, width } );
+            texels += static_cast<size_t>( width ) * height * 4;
+        }
+    }
+    uploadQueue.UploadImage( textureObject->image_, mipLevels, fileData.block_, levels.data(), static_cast<uint32_t>( levels.size() ) );
 
-    vkBindImageMemory( device.device_, textureObject->image_, textureObject->deviceMemory_, 0 );
+    textureObject->format_ = fileData.format_;
+    textureObject->width_ = fileData.width_;
+    textureObject->height_ = fileData.height_;
+    textureObject->mipLevels_ = mipLevels;
+    return VK_SUCCESS;
+}
 
-    {
-        VkImageSubresource imageSubresource;
-        imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-        imageSubresource.mipLevel = 0;
-        imageSubresource.arrayLayer = 0;
+VkResult LoadTextureFromFile( const TextureFileData& fileData, struct TextureObject* textureObject )
+{
+    // blit         : bit block transfer의 약어, 데이터 배열을 목적지 배열에 복사하는것을 뜻함
+    //              : linearTilingFeatures가 VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT 플래그를 갖고 있으면, PRE_INITIALIZED -> READ_ONLY로 layout 변경가능
+    //              : VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT 플래그가 없으면, 새로운 VkImage를 READ_ONLY로 만들어 거기에다가 기존의 이미지 데이터를 copy한다.
+    //              : 위 과정은 VkImage를 READ_ONLY로 만들기 위함인데, CPU_ACCESSIBLE 한 layout보다 read_only가 더 빠르기 때문이다
+    //              : 여기서는 linear image 대신 staging buffer에서 vkCmdCopyBufferToImage로 copy한다.
 
-        VkSubresourceLayout subresourceLayout;
-        vkGetImageSubresourceLayout( device.device_, textureObject->image_, &imageSubresource, &subresourceLayout );
+    // compressed and multi level files always go through the buffer copy
+    if( kTextureTiling == TEXTURE_TILING_LINEAR && fileData.block_.width_ == 1 && fileData.levels_.size() == 1 && CanSampleLinear( fileData.format_, fileData.width_, fileData.height_ ) )
+        return CreateLinearTexture( fileData, textureObject );
+    return CreateOptimalTexture( fileData, textureObject );
+}
 
-        void* data;
-        vkMapMemory( device.device_, textureObject->deviceMemory_, 0, memoryAllocateInfo.allocationSize, 0, &data );
+#ifdef VKTUTS_BENCHMARK
+// Upload throughput through the staging ring for batches of 1, 16 and 256 textures
+void BenchmarkTextureUpload( const TextureFileData& fileData )
+{
+    const uint32_t kBatchSizes[] = { 1, 16, 256 };
+    for( uint32_t batchSize : kBatchSizes )
+    {
+        std::vector<TextureObject> scratch( batchSize );
+        uploadQueue.WaitIdle();
 
-        for( uint32_t y = 0; y < imgHeight; ++y )
+        auto start = std::chrono::steady_clock::now();
+        for( auto& texture : scratch )
         {
-            unsigned char* row = ( unsigned char* ) ( ( char* ) data + subresourceLayout.rowPitch * y );
-            for( uint32_t x = 0; x < imgWidth; ++x )
-            {
-                row[x * 4 + 0] = imageData[( x + y * imgWidth ) * 4 + 0];
-                row[x * 4 + 1] = imageData[( x + y * imgWidth ) * 4 + 1];
-                row[x * 4 + 2] = imageData[( x + y * imgWidth ) * 4 + 2];
-                row[x * 4 + 3] = imageData[( x + y * imgWidth ) * 4 + 3];
-            }
+            LoadTextureFromFile( fileData, &texture );
         }
+        uploadQueue.WaitIdle();
+        double seconds = std::chrono::duration<double>( std::chrono::steady_clock::now() - start ).count();
 
-        vkUnmapMemory( device.device_, textureObject->deviceMemory_ );
-        stbi_image_free( imageData );
-    }
-
-    VkCommandPool cmdPool;
-    VkCommandPoolCreateInfo commandPoolCreateInfo;
-    commandPoolCreateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
-    commandPoolCreateInfo.pNext = nullptr;
-    commandPoolCreateInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
-    commandPoolCreateInfo.queueFamilyIndex = device.queueFamilyIndex_;
-    vkCreateCommandPool( device.device_, &commandPoolCreateInfo, nullptr, &cmdPool );
+        double megabytes = 0.0;
+        for( const UploadImageLevel& level : fileData.levels_ )
+            megabytes += batchSize * static_cast<double>( level.rowLength_ ) * level.height_ * fileData.block_.size_ / ( fileData.block_.width_ * fileData.block_.height_ ) / ( 1024.0 * 1024.0 );
+        LOGI( "texture upload, %u x %ux%u: %.1f MB/s", batchSize, fileData.width_, fileData.height_, megabytes / seconds );
 
-    VkCommandBuffer cmdBuf;
-    VkCommandBufferAllocateInfo commandBufferAllocateInfo;
-    commandBufferAllocateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
-    commandBufferAllocateInfo.pNext = nullptr;
-    commandBufferAllocateInfo.commandPool = cmdPool;
-    commandBufferAllocateInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
-    commandBufferAllocateInfo.commandBufferCount = 1;
-    vkAllocateCommandBuffers( device.device_, &commandBufferAllocateInfo, &cmdBuf );
-
-    VkCommandBufferBeginInfo commandBufferBeginInfo;
-    commandBufferBeginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
-    commandBufferBeginInfo.pNext = nullptr;
-    commandBufferBeginInfo.flags = 0;
-    commandBufferBeginInfo.pInheritanceInfo = nullptr;
-    vkBeginCommandBuffer( cmdBuf, &commandBufferBeginInfo );
+        for( auto& texture : scratch )
+        {
+            vkDestroyImage( device.device_, texture.image_, nullptr );
+            memoryAllocator.Free( texture.memory_ );
+        }
+    }
+}
+#endif
 
-    VkImage stageImage = VK_NULL_HANDLE;
-    VkDeviceMemory stageMemory = VK_NULL_HANDLE;
-    if( !needBlit )
+#ifdef VKTUTS_BENCHMARK
+// Time to create and upload one texture through each path, 256x256 up to 4096x4096
+void BenchmarkTextureUploadPaths( void )
+{
+    for( uint32_t size = 256; size <= 4096; size *= 2 )
     {
-        setImageLayout( cmdBuf, textureObject->image_, VK_IMAGE_LAYOUT_PREINITIALIZED, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_PIPELINE_STAGE_HOST_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT );
+        std::vector<unsigned char> pixels( size * size * 4, 0x80 );
+        TextureFileData fileData;
+        fileData.format_ = kTexFmt;
+        fileData.block_ = { 1, 1, 4 };
+        fileData.width_ = size;
+        fileData.height_ = size;
+        fileData.levels_.assign( 1, { pixels.data(), size, size, size } );
+        fileData.pixels_ = nullptr;
+
+        double milliseconds[2] = { -1.0, -1.0 };
+        for( uint32_t linear = 0; linear < 2; linear++ )
+        {
+            if( linear && !CanSampleLinear( kTexFmt, size, size ) )
+                continue;
+
+            TextureObject texture = {};
+            uploadQueue.WaitIdle();
+            auto start = std::chrono::steady_clock::now();
+            if( linear )
+                CreateLinearTexture( fileData, &texture );
+            else
+                CreateOptimalTexture( fileData, &texture );
+            uploadQueue.WaitIdle();
+            milliseconds[linear] = std::chrono::duration<double, std::milli>( std::chrono::steady_clock::now() - start ).count();
+
+            vkDestroyImage( device.device_, texture.image_, nullptr );
+            memoryAllocator.Free( texture.memory_ );
+        }
+        LOGI( "texture %ux%u: buffer copy %.2f ms, linear image %.2f ms (-1: unsupported)", size, size, milliseconds[0], milliseconds[1] );
     }
-    else
+}
+#endif
+
+#ifdef VKTUTS_BENCHMARK
+// Load time ( read + decode, then create + upload ) and memory footprint of a texture's png against its KTX2 version
+void BenchmarkTextureFormats( const char* filePath )
+{
+    const char* kSources[] = { "png", "ktx2" };
+    for( uint32_t ktx = 0; ktx < 2; ktx++ )
     {
-        stageImage = textureObject->image_;
-        stageMemory = textureObject->deviceMemory_;
-
-        textureObject->image_ = VK_NULL_HANDLE;
-        textureObject->deviceMemory_ = VK_NULL_HANDLE;
-
-        VkImageCreateInfo imageCreateInfo;
-        imageCreateInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
-        imageCreateInfo.pNext = nullptr;
-        imageCreateInfo.flags = 0;
-        imageCreateInfo.imageType = VK_IMAGE_TYPE_2D;
-        imageCreateInfo.format = kTexFmt;
-        imageCreateInfo.extent = { imgWidth, imgHeight, 1 };
-        imageCreateInfo.mipLevels = 1;
-        imageCreateInfo.arrayLayers = 1;
-        imageCreateInfo.samples = VK_SAMPLE_COUNT_1_BIT;
-        imageCreateInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
-        imageCreateInfo.usage = VK_IMAGE_USAGE_TRANSFER_DST_BIT & VK_IMAGE_USAGE_SAMPLED_BIT;
-        imageCreateInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
-        imageCreateInfo.queueFamilyIndexCount = 1;
-        imageCreateInfo.pQueueFamilyIndices = &device.queueFamilyIndex_;
-        imageCreateInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-        vkCreateImage( device.device_, &imageCreateInfo, nullptr, &textureObject->image_ );
-
-        VkMemoryRequirements memoryRequirements;
-        vkGetImageMemoryRequirements( device.device_, textureObject->image_, &memoryRequirements );
-
-        VkMemoryAllocateInfo memoryAllocateInfo;
-        memoryAllocateInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-        memoryAllocateInfo.pNext = nullptr;
-        memoryAllocateInfo.allocationSize = memoryRequirements.size;
-        findMemoryTypeIndex( memoryRequirements.memoryTypeBits, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT, &memoryAllocateInfo.memoryTypeIndex );
-        vkAllocateMemory( device.device_, &memoryAllocateInfo, nullptr, &textureObject->deviceMemory_ );
-
-        vkBindImageMemory( device.device_, textureObject->image_, textureObject->deviceMemory_, 0 );
-
-        setImageLayout( cmdBuf, stageImage, VK_IMAGE_LAYOUT_PREINITIALIZED, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_PIPELINE_STAGE_HOST_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT );
-        setImageLayout( cmdBuf, textureObject->image_, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_PIPELINE_STAGE_HOST_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT );
-
-        VkImageCopy imageCopy;
-        imageCopy.srcSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-        imageCopy.srcSubresource.mipLevel = 0;
-        imageCopy.srcSubresource.baseArrayLayer = 0;
-        imageCopy.srcSubresource.layerCount = 1;
-        imageCopy.srcOffset = { 0, 0, 0 };
-        imageCopy.dstSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-        imageCopy.dstSubresource.mipLevel = 0;
-        imageCopy.dstSubresource.baseArrayLayer = 0;
-        imageCopy.dstSubresource.layerCount = 1;
-        imageCopy.dstOffset = { 0, 0, 0 };
-        imageCopy.extent = { imgWidth, imgHeight, 1 };
-        vkCmdCopyImage( cmdBuf, stageImage, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, textureObject->image_, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &imageCopy );
-
-        setImageLayout( cmdBuf, textureObject->image_, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT );
-    }
-
-    vkEndCommandBuffer( cmdBuf );
+        TextureFileData fileData;
+        uploadQueue.WaitIdle();
+        auto start = std::chrono::steady_clock::now();
+        if( ktx )
+        {
+            if( !DecodeKtxTextureFile( filePath, &fileData ) )
+            {
+                LOGI( "texture %s: no usable KTX2 version to compare with", filePath );
+                break;
+            }
+        }
+        else
+        {
+            DecodePngTextureFile( filePath, &fileData );
+        }
+        double decodeMilliseconds = std::chrono::duration<double, std::milli>( std::chrono::steady_clock::now() - start ).count();
 
-    VkFence fence;
-    VkFenceCreateInfo fenceCreateInfo;
-    fenceCreateInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
-    fenceCreateInfo.pNext = nullptr;
-    fenceCreateInfo.flags = 0;
-    vkCreateFence( device.device_, &fenceCreateInfo, nullptr, &fence );
-
-    VkSubmitInfo submitInfo;
-    submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-    submitInfo.pNext = nullptr;
-    submitInfo.waitSemaphoreCount = 0;
-    submitInfo.pWaitSemaphores = nullptr;
-    submitInfo.pWaitDstStageMask = nullptr;
-    submitInfo.commandBufferCount = 1;
-    submitInfo.pCommandBuffers = &cmdBuf;
-    submitInfo.signalSemaphoreCount = 0;
-    submitInfo.pSignalSemaphores = nullptr;
-    vkResetFences( device.device_, 1, &fence );
-    vkQueueSubmit( device.queue_, 1, &submitInfo, fence );
-    vkWaitForFences( device.device_, 1, &fence, VK_TRUE, UINT64_MAX );
+        TextureObject texture = {};
+        CreateOptimalTexture( fileData, &texture );
+        uploadQueue.WaitIdle();
+        double loadMilliseconds = std::chrono::duration<double, std::milli>( std::chrono::steady_clock::now() - start ).count();
 
-    vkDestroyFence( device.device_, fence, nullptr );
-    vkFreeCommandBuffers( device.device_, cmdPool, 1, &cmdBuf );
-    vkDestroyCommandPool( device.device_, cmdPool, nullptr );
-    if( stageImage != VK_NULL_HANDLE )
-    {
-        vkDestroyImage( device.device_, stageImage, nullptr );
-        vkFreeMemory( device.device_, stageMemory, nullptr );
-    }
+        size_t cpuBytes = fileData.storage_.size() + ( fileData.pixels_ ? static_cast<size_t>( fileData.width_ ) * fileData.height_ * 4 : 0 );
+        LOGI( "texture %s, %s ( format %d ): decode %.2f ms, load %.2f ms, %zu KB CPU memory, %llu KB GPU memory", filePath, kSources[ktx], texture.format_,
+              decodeMilliseconds, loadMilliseconds, cpuBytes / 1024, static_cast<unsigned long long>( texture.memory_.size_ / 1024 ) );
 
-    return VK_SUCCESS;
+        vkDestroyImage( device.device_, texture.image_, nullptr );
+        memoryAllocator.Free( texture.memory_ );
+        FreeTextureFileData( &fileData );
+    }
 }
+#endif
 
 void CreateTexture( void )
 {
+    // png decoding and KTX2 transcoding are the slow part of loading, decode every file on its own core
+    TextureFileData fileData[TUTORIAL_TEXTURE_COUNT];
+    JobCounter counter;
+    for( uint32_t i = 0; i < TUTORIAL_TEXTURE_COUNT; i++ )
+    {
+        jobSystem->Submit( [&fileData, i]() { DecodeTextureFile( texFiles[i], &fileData[i] ); }, &counter );
+    }
+    jobSystem->Wait( counter );
+
     for( uint32_t i = 0; i < TUTORIAL_TEXTURE_COUNT; i++ )
     {
-        LoadTextureFromFile( texFiles[i], &textures[i] );
+        LoadTextureFromFile( fileData[i], &textures[i] );
 
         VkSamplerCreateInfo sampler;
         sampler.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
         sampler.pNext = nullptr;
         sampler.magFilter = VK_FILTER_NEAREST;
-        sampler.minFilter = VK_FILTER_NEAREST;
-        sampler.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+        sampler.minFilter = VK_FILTER_LINEAR;
+        sampler.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
         sampler.addressModeU = VK_SAMPLER_ADDRESS_MODE_REPEAT;
         sampler.addressModeV = VK_SAMPLER_ADDRESS_MODE_REPEAT;
         sampler.addressModeW = VK_SAMPLER_ADDRESS_MODE_REPEAT;
@@ -654,7 +1126,7 @@ void CreateTexture( void )
         sampler.maxAnisotropy = 1;
         sampler.compareOp = VK_COMPARE_OP_NEVER;
         sampler.minLod = 0.0f;
-        sampler.maxLod = 0.0f;
+        sampler.maxLod = static_cast<float>( textures[i].mipLevels_ );
         sampler.borderColor = VK_BORDER_COLOR_FLOAT_OPAQUE_WHITE;
         sampler.unnormalizedCoordinates = VK_FALSE;
         CALL_VK( vkCreateSampler( device.device_, &sampler, nullptr, &textures[i].sampler_ ) );
@@ -665,12 +1137,35 @@ void CreateTexture( void )
         view.flags = 0;
         view.image = VK_NULL_HANDLE;
         view.viewType = VK_IMAGE_VIEW_TYPE_2D;
-        view.format = kTexFmt;
+        view.format = textures[i].format_;
         view.components = { VK_COMPONENT_SWIZZLE_R, VK_COMPONENT_SWIZZLE_G, VK_COMPONENT_SWIZZLE_B, VK_COMPONENT_SWIZZLE_A, };
-        view.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 };
+        view.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, textures[i].mipLevels_, 0, 1 };
         view.image = textures[i].image_;
         CALL_VK( vkCreateImageView( device.device_, &view, nullptr, &textures[i].imageView_ ) );
     }
+
+#ifdef VKTUTS_BENCHMARK
+    BenchmarkTextureUpload( fileData[0] );
+    BenchmarkTextureUploadPaths();
+    for( uint32_t i = 0; i < TUTORIAL_TEXTURE_COUNT; i++ )
+    {
+        BenchmarkTextureFormats( texFiles[i] );
+    }
+#endif
+
+    for( uint32_t i = 0; i < TUTORIAL_TEXTURE_COUNT; i++ )
+    {
+        FreeTextureFileData( &fileData[i] );
+    }
+
+    // one submission for every texture; frames are submitted to the same queue later, so nobody waits for it
+    uploadQueue.Flush();
+}
+
+// Bytes one ObjectUniforms takes in a uniform ring
+VkDeviceSize ObjectUniformsStride( VkDeviceSize alignment )
+{
+    return ( sizeof( ObjectUniforms ) + alignment - 1 ) / alignment * alignment;
 }
 
 void CreateBuffers( void )
@@ -685,39 +1180,158 @@ void CreateBuffers( void )
     // VkImage는 draw call에 쓰이지 못함
 
     const float vertexData[] = { -1.0f, -1.0f, 0.0f, 0.0f, 0.0f, 1.0f, -1.0f, 0.0f, 1.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.5f, 1.0f, };
+    const uint16_t indexData[] = { 0, 1, 2, };
+
+    GeometryData geometryData;
+    geometryData.vertices_ = vertexData;
+    geometryData.vertexStride_ = 5 * sizeof( float );
+    geometryData.vertexCount_ = 3;
+    geometryData.indices_ = indexData;
+    geometryData.indexType_ = VK_INDEX_TYPE_UINT16;
+    geometryData.indexCount_ = 3;
+
+    // device local: vertex fetch stays on the GPU side of the bus; the copy is submitted ahead of the first frame
+    CALL_VK( CreateGeometryBuffer( device.device_, &memoryAllocator, &uploadQueue, geometryData, GEOMETRY_MEMORY_DEVICE_LOCAL, &buffers.scene_ ) );
+    uploadQueue.Flush();
+
+    // per-draw uniforms: a region per frame in flight, and one written once for the static secondary
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties( device.physicalDevice_, &properties );
+    VkDeviceSize alignment = properties.limits.minUniformBufferOffsetAlignment;
+    VkDeviceSize frameSize = ObjectUniformsStride( alignment ) * kDrawCount;
+    CALL_VK( uniformRing.Init( device.device_, &memoryAllocator, alignment, frameSize, kFramesInFlight,
+                               kRecordMode == RECORD_STATIC_SECONDARY ? frameSize : 0 ) );
+}
 
-    VkBufferCreateInfo createBufferInfo;
-    createBufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
-    createBufferInfo.pNext = nullptr;
-    createBufferInfo.size = sizeof( vertexData );
-    createBufferInfo.usage = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT;
-    createBufferInfo.flags = 0;
-    createBufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
-    createBufferInfo.queueFamilyIndexCount = 1;
-    createBufferInfo.pQueueFamilyIndices = &device.queueFamilyIndex_;
+// Pipeline cache file in the app's private storage
+std::string PipelineCachePath( void )
+{
+    return std::string( androidAppCtx->activity->internalDataPath ) + "/pipeline_cache.bin";
+}
+
+// Reflects the scene's shaders into gfxPipeline.sceneDesc_ and its layouts.
+// The fallback fragment shader is reflected too, so both pipelines share one layout and the same descriptor set.
+bool ReflectSceneShaders( void )
+{
+    const struct
+    {
+        const char* path_;
+        VkShaderStageFlagBits stage_;
+    } kShaders[] = {
+        { "shaders/tri.vert", VK_SHADER_STAGE_VERTEX_BIT },
+        { device.bindlessTextures_ ? "shaders/tri_bindless.frag" : "shaders/tri.frag", VK_SHADER_STAGE_FRAGMENT_BIT },
+        { "shaders/tri_fallback.frag", VK_SHADER_STAGE_FRAGMENT_BIT },
+    };
+
+    ShaderReflection reflection = {};
+    for( const auto& shader : kShaders )
+    {
+        std::vector<uint32_t> spirv;
+        if( !loadShaderSpirv( androidAppCtx, shader.path_, shader.stage_, &spirv ) || !ReflectSpirv( spirv.data(), spirv.size(), &reflection ) )
+        {
+            LOGE( "cannot reflect %s", shader.path_ );
+            return false;
+        }
+    }
+    if( reflection.vertexInputs_.size() > kMaxVertexAttributes )
+    {
+        LOGE( "%zu vertex inputs, pipelines take %u", reflection.vertexInputs_.size(), kMaxVertexAttributes );
+        return false;
+    }
+
+    // the uniform ring hands out every draw's uniforms, so the blocks of the object set take a dynamic offset
+    for( auto& binding : reflection.bindings_ )
+    {
+        if( binding.set_ == kObjectSet && binding.type_ == VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER )
+            binding.type_ = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+    }
+
+    PipelineDesc& desc = gfxPipeline.sceneDesc_;
+    desc = DefaultPipelineDesc();
+    desc.vertexShader_ = kShaders[0].path_;
+    // one interleaved binding, attributes packed in location order the way CreateBuffers writes the vertices
+    for( const auto& input : reflection.vertexInputs_ )
+    {
+        desc.vertexAttributes_[desc.vertexAttributeCount_++] = { input.location_, input.format_, desc.vertexStride_ };
+        desc.vertexStride_ += input.size_;
+    }
+    desc.layout_ = layoutCache.GetPipelineLayout( reflection );
+    desc.renderPass_ = render.renderPass_;
+    desc.subpass_ = 0;
+
+    gfxPipeline.layout_ = desc.layout_;
+    gfxPipeline.dscLayout_ = layoutCache.GetSetLayout( reflection, 0 );
+    gfxPipeline.objectLayout_ = layoutCache.GetSetLayout( reflection, kObjectSet );
+    gfxPipeline.sceneShader_ = kShaders[1].path_;
+    if( gfxPipeline.layout_ == VK_NULL_HANDLE || gfxPipeline.dscLayout_ == VK_NULL_HANDLE || gfxPipeline.objectLayout_ == VK_NULL_HANDLE )
+        return false;
 
-    CALL_VK( vkCreateBuffer( device.device_, &createBufferInfo, nullptr, &buffers.vertexBuf_ ) );
+    // descriptor pools are sized in sets of each of the scene's sets
+    std::vector<VkDescriptorSetLayoutBinding> bindings = ReflectedSetBindings( reflection, 0 );
+    std::vector<VkDescriptorSetLayoutBinding> objectBindings = ReflectedSetBindings( reflection, kObjectSet );
+    std::vector<VkDescriptorSetLayoutBinding> sceneBindings = bindings;
+    sceneBindings.insert( sceneBindings.end(), objectBindings.begin(), objectBindings.end() );
+    descriptorAllocator.Init( device.device_, DescriptorSetSizes( sceneBindings ), kDescriptorSetsPerPool, kFramesInFlight );
+    descriptorSets.Init( device.device_, &descriptorAllocator, device.descriptorUpdateTemplate_ );
+    if( descriptorSets.AddLayout( gfxPipeline.objectLayout_, objectBindings ) != VK_SUCCESS )
+        return false;
+    if( device.bindlessTextures_ )
+    {
+        // set 0 is the texture table, the runtime sized array of tri_bindless.frag
+        for( const auto& binding : bindings )
+        {
+            if( binding.descriptorCount == 0 )
+                return bindlessTextures.Init( device.device_, gfxPipeline.dscLayout_, binding.binding, binding.descriptorType, device.bindlessTextures_ ) == VK_SUCCESS;
+        }
+        return false;
+    }
+    return descriptorSets.AddLayout( gfxPipeline.dscLayout_, bindings ) == VK_SUCCESS;
+}
 
-    VkMemoryRequirements memReq;
-    vkGetBufferMemoryRequirements( device.device_, buffers.vertexBuf_, &memReq );
+// constant_id of tri.frag's (and tri_bindless.frag's) blur width
+static const uint32_t kBlurTapsConstant = 0;
 
-    VkMemoryAllocateInfo allocInfo;
-    allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-    allocInfo.pNext = nullptr;
-    allocInfo.allocationSize = memReq.size;
-    allocInfo.memoryTypeIndex = 0;
+// Desc of the textured triangle's pipeline with the given fragment shader
+PipelineDesc ScenePipelineDesc( const char* fragmentShader )
+{
+    PipelineDesc desc = gfxPipeline.sceneDesc_;
+    desc.fragmentShader_ = fragmentShader;
+    return desc;
+}
 
-    VK_CHECK( findMemoryTypeIndex( memReq.memoryTypeBits, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, &allocInfo.memoryTypeIndex ) );
+#ifdef VKTUTS_BENCHMARK
+// Materials of a made up scene, they share sixteen states between them:
+// culling, blending and four blur widths, the widths being variants of one fragment shader
+static const uint32_t kBenchmarkMaterialCount = 256;
+static const uint32_t kBenchmarkBlurTaps[] = { 1, 3, 5, 9 };
 
-    VkDeviceMemory deviceMemory;
-    CALL_VK( vkAllocateMemory( device.device_, &allocInfo, nullptr, &deviceMemory ) );
-    CALL_VK( vkBindBufferMemory( device.device_, buffers.vertexBuf_, deviceMemory, 0 ) );
+// Requests a pipeline per material the way a material system would; only new states get built
+void BenchmarkPipelineLookups( void )
+{
+    PipelineLookupStats before = pipelineManager.LookupStats();
+    auto start = std::chrono::steady_clock::now();
+    for( uint32_t i = 0; i < kBenchmarkMaterialCount; i++ )
+    {
+        PipelineDesc desc = ScenePipelineDesc( gfxPipeline.sceneShader_ );
+        desc.cullMode_ = ( i & 1 ) ? VK_CULL_MODE_BACK_BIT : VK_CULL_MODE_NONE;
+        if( i & 2 )
+        {
+            desc.blendEnable_ = VK_TRUE;
+            desc.srcBlendFactor_ = VK_BLEND_FACTOR_SRC_ALPHA;
+            desc.dstBlendFactor_ = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+        }
+        SetSpecialization( &desc, kBlurTapsConstant, kBenchmarkBlurTaps[( i >> 2 ) & 3] );
+        pipelineManager.CreateAsync( "material", desc, gfxPipeline.fallbackPipeline_ );
+    }
+    double us = std::chrono::duration<double, std::micro>( std::chrono::steady_clock::now() - start ).count();
 
-    void* data;
-    CALL_VK( vkMapMemory( device.device_, deviceMemory, 0, allocInfo.allocationSize, 0, &data ) );
-    memcpy( data, vertexData, sizeof( vertexData ) );
-    vkUnmapMemory( device.device_, deviceMemory );
+    PipelineLookupStats after = pipelineManager.LookupStats();
+    uint32_t lookups = after.lookups_ - before.lookups_;
+    uint32_t hits = after.hits_ - before.hits_;
+    LOGI( "pipeline lookups: %u materials, %u new pipelines, %.1f%% hits, %.2f us per lookup", lookups, lookups - hits,
+          100.0 * hits / lookups, us / lookups );
 }
+#endif
 
 void CreateGraphicsPipeline( void )
 {
@@ -744,39 +1358,74 @@ void CreateGraphicsPipeline( void )
 
     memset( &gfxPipeline, 0, sizeof( gfxPipeline ) );
 
-    VkDescriptorSetLayoutBinding descriptorSetLayoutBinding;
-    descriptorSetLayoutBinding.binding = 0;
-    descriptorSetLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-    descriptorSetLayoutBinding.descriptorCount = TUTORIAL_TEXTURE_COUNT;
-    descriptorSetLayoutBinding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
-    descriptorSetLayoutBinding.pImmutableSamplers = nullptr;
-
-    VkDescriptorSetLayoutCreateInfo descriptorSetLayoutCreateInfo;
-    descriptorSetLayoutCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
-    descriptorSetLayoutCreateInfo.pNext = nullptr;
-    descriptorSetLayoutCreateInfo.bindingCount = 1;
-    descriptorSetLayoutCreateInfo.pBindings = &descriptorSetLayoutBinding;
-    CALL_VK( vkCreateDescriptorSetLayout( device.device_, &descriptorSetLayoutCreateInfo, nullptr, &gfxPipeline.dscLayout_ ) );
-
-    VkPipelineLayoutCreateInfo pipelineLayoutCreateInfo;
-    pipelineLayoutCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-    pipelineLayoutCreateInfo.pNext = nullptr;
-    pipelineLayoutCreateInfo.setLayoutCount = 1;
-    pipelineLayoutCreateInfo.pSetLayouts = &gfxPipeline.dscLayout_;
-    pipelineLayoutCreateInfo.pushConstantRangeCount = 0;
-    pipelineLayoutCreateInfo.pPushConstantRanges = nullptr;
-    CALL_VK( vkCreatePipelineLayout( device.device_, &pipelineLayoutCreateInfo, nullptr, &gfxPipeline.layout_ ) );
-
-    // No dynamic state in that tutorial
+    // descriptor set layout, pipeline layout and vertex input all come from the SPIR-V
+    layoutCache.Init( device.device_, device.bindlessTextures_ );
+    bool reflected = ReflectSceneShaders();
+    assert( reflected );
+
+    // the previous run's cache turns pipeline compilation into a lookup
+    CALL_VK( CreatePipelineCacheFromFile( device.physicalDevice_, device.device_, PipelineCachePath().c_str(), &gfxPipeline.cache_, &gfxPipeline.cacheFromDisk_ ) );
+    gfxPipeline.cacheSaved_ = false;
+
+    // the first frames draw with the quickly built fallback while the scene pipeline compiles on the job system
+    shaderModules.Init( device.device_, androidAppCtx );
+    pipelineManager.Init( device.device_, jobSystem.get(), BuildPipeline );
+    gfxPipeline.fallbackPipeline_ = pipelineManager.Create( "fallback", ScenePipelineDesc( "shaders/tri_fallback.frag" ) );
+    assert( pipelineManager.Get( gfxPipeline.fallbackPipeline_ ) != VK_NULL_HANDLE );
+    gfxPipeline.scenePipeline_ = pipelineManager.CreateAsync( "scene", ScenePipelineDesc( gfxPipeline.sceneShader_ ), gfxPipeline.fallbackPipeline_ );
+    gfxPipeline.boundPipeline_ = pipelineManager.Get( gfxPipeline.scenePipeline_ );
+#ifdef VKTUTS_BENCHMARK
+    BenchmarkPipelineLookups();
+#endif
+}
+
+// Build the pipeline of desc, it works with any display size.
+// Runs on job system threads too: it only reads state that stays unchanged while pipelineManager builds.
+VkPipeline BuildPipeline( const PipelineDesc& desc )
+{
+    // both stages build on the job system while the fixed function state below is filled in;
+    // every variant of a shader shares its module, only the first pipeline using a shader builds it
+    JobCounter shaderJobs;
+    VkShaderModule vertexShader = VK_NULL_HANDLE;
+    VkShaderModule fragmentShader = VK_NULL_HANDLE;
+    jobSystem->Submit( [&desc, &vertexShader]() { vertexShader = shaderModules.Get( desc.vertexShader_, VK_SHADER_STAGE_VERTEX_BIT ); }, &shaderJobs );
+    jobSystem->Submit( [&desc, &fragmentShader]() { fragmentShader = shaderModules.Get( desc.fragmentShader_, VK_SHADER_STAGE_FRAGMENT_BIT ); }, &shaderJobs );
+
+    // specialization constants : 파이프라인을 만들 때 값이 정해지는 쉐이더 상수 (layout(constant_id = N))
+    //                          : 드라이버가 상수로 접어서 컴파일하므로, variant마다 GLSL을 따로 컴파일하지 않아도 분기/루프가 사라진 코드를 얻는다.
+    VkSpecializationMapEntry specializationEntries[kMaxSpecializationConstants];
+    uint32_t specializationData[kMaxSpecializationConstants];
+    for( uint32_t i = 0; i < desc.specializationCount_; i++ )
+    {
+        specializationEntries[i].constantID = desc.specializations_[i].constantId_;
+        specializationEntries[i].offset = i * sizeof( uint32_t );
+        specializationEntries[i].size = sizeof( uint32_t );
+        specializationData[i] = desc.specializations_[i].value_;
+    }
+    VkSpecializationInfo specializationInfo;
+    specializationInfo.mapEntryCount = desc.specializationCount_;
+    specializationInfo.pMapEntries = specializationEntries;
+    specializationInfo.dataSize = desc.specializationCount_ * sizeof( uint32_t );
+    specializationInfo.pData = specializationData;
+    const VkSpecializationInfo* stageSpecialization = desc.specializationCount_ ? &specializationInfo : nullptr;
+
+    // dynamic state : 파이프라인에 굽지 않고 command buffer 레코딩 때 vkCmdSet*으로 정하는 상태
+    //               : viewport/scissor가 dynamic이면 화면 크기가 바뀌어도(회전, 분할화면) 파이프라인을 다시 만들 필요가 없다.
+    VkDynamicState dynamicStates[] = { VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR };
     VkPipelineDynamicStateCreateInfo dynamicStateInfo;
     dynamicStateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
     dynamicStateInfo.pNext = nullptr;
-    dynamicStateInfo.dynamicStateCount = 0;
-    dynamicStateInfo.pDynamicStates = nullptr;
+    dynamicStateInfo.flags = 0;
+    dynamicStateInfo.dynamicStateCount = 2;
+    dynamicStateInfo.pDynamicStates = dynamicStates;
 
-    VkShaderModule vertexShader, fragmentShader;
-    buildShaderFromFile( androidAppCtx, "shaders/tri.vert", VK_SHADER_STAGE_VERTEX_BIT, device.device_, &vertexShader );
-    buildShaderFromFile( androidAppCtx, "shaders/tri.frag", VK_SHADER_STAGE_FRAGMENT_BIT, device.device_, &fragmentShader );
+    jobSystem->Wait( shaderJobs );
+    if( vertexShader == VK_NULL_HANDLE || fragmentShader == VK_NULL_HANDLE )
+    {
+        // Get() falls back, or a hot reload keeps the pipeline it had
+        LOGE( "pipeline of %s and %s: a shader did not build", desc.vertexShader_, desc.fragmentShader_ );
+        return VK_NULL_HANDLE;
+    }
     // Specify vertex and fragment shader stages
     VkPipelineShaderStageCreateInfo shaderStages[2];
 
@@ -784,7 +1433,7 @@ void CreateGraphicsPipeline( void )
     shaderStages[0].pNext = nullptr;
     shaderStages[0].stage = VK_SHADER_STAGE_VERTEX_BIT;
     shaderStages[0].module = vertexShader;
-    shaderStages[0].pSpecializationInfo = nullptr;
+    shaderStages[0].pSpecializationInfo = stageSpecialization;
     shaderStages[0].flags = 0;
     shaderStages[0].pName = "main";
 
@@ -792,30 +1441,19 @@ void CreateGraphicsPipeline( void )
     shaderStages[1].pNext = nullptr;
     shaderStages[1].stage = VK_SHADER_STAGE_FRAGMENT_BIT;
     shaderStages[1].module = fragmentShader;
-    shaderStages[1].pSpecializationInfo = nullptr;
+    shaderStages[1].pSpecializationInfo = stageSpecialization;
     shaderStages[1].flags = 0;
     shaderStages[1].pName = "main";
 
-    VkViewport viewports;
-    viewports.minDepth = 0.0f;
-    viewports.maxDepth = 1.0f;
-    viewports.x = 0;
-    viewports.y = 0;
-    viewports.width = ( float ) swapchain.displaySize_.width;
-    viewports.height = ( float ) swapchain.displaySize_.height;
-
-    VkRect2D scissor;
-    scissor.extent = swapchain.displaySize_;
-    scissor.offset = { .x = 0, .y = 0, };
-
-    // Specify viewport info
+    // Specify viewport info, the viewport and scissor themselves are dynamic
     VkPipelineViewportStateCreateInfo viewportInfo;
     viewportInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
     viewportInfo.pNext = nullptr;
+    viewportInfo.flags = 0;
     viewportInfo.viewportCount = 1;
-    viewportInfo.pViewports = &viewports;
+    viewportInfo.pViewports = nullptr;
     viewportInfo.scissorCount = 1;
-    viewportInfo.pScissors = &scissor;
+    viewportInfo.pScissors = nullptr;
 
     VkSampleMask sampleMask = ~0u;
     VkPipelineMultisampleStateCreateInfo multisampleInfo;
@@ -829,8 +1467,14 @@ void CreateGraphicsPipeline( void )
     multisampleInfo.alphaToOneEnable = VK_FALSE;
 
     VkPipelineColorBlendAttachmentState attachmentStates;
-    attachmentStates.colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
-    attachmentStates.blendEnable = VK_FALSE;
+    attachmentStates.colorWriteMask = desc.colorWriteMask_;
+    attachmentStates.blendEnable = desc.blendEnable_;
+    attachmentStates.srcColorBlendFactor = desc.srcBlendFactor_;
+    attachmentStates.dstColorBlendFactor = desc.dstBlendFactor_;
+    attachmentStates.colorBlendOp = desc.blendOp_;
+    attachmentStates.srcAlphaBlendFactor = desc.srcBlendFactor_;
+    attachmentStates.dstAlphaBlendFactor = desc.dstBlendFactor_;
+    attachmentStates.alphaBlendOp = desc.blendOp_;
 
     VkPipelineColorBlendStateCreateInfo colorBlendInfo;
     colorBlendInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
@@ -846,51 +1490,48 @@ void CreateGraphicsPipeline( void )
     rasterInfo.pNext = nullptr;
     rasterInfo.depthClampEnable = VK_FALSE;
     rasterInfo.rasterizerDiscardEnable = VK_FALSE;
-    rasterInfo.polygonMode = VK_POLYGON_MODE_FILL;
-    rasterInfo.cullMode = VK_CULL_MODE_NONE;
-    rasterInfo.frontFace = VK_FRONT_FACE_CLOCKWISE;
+    rasterInfo.polygonMode = desc.polygonMode_;
+    rasterInfo.cullMode = desc.cullMode_;
+    rasterInfo.frontFace = desc.frontFace_;
     rasterInfo.depthBiasEnable = VK_FALSE;
     rasterInfo.lineWidth = 1;
 
     VkPipelineInputAssemblyStateCreateInfo inputAssemblyInfo;
     inputAssemblyInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
     inputAssemblyInfo.pNext = nullptr;
-    inputAssemblyInfo.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+    inputAssemblyInfo.topology = desc.topology_;
     inputAssemblyInfo.primitiveRestartEnable = VK_FALSE;
 
+    VkPipelineDepthStencilStateCreateInfo depthStencilInfo;
+    memset( &depthStencilInfo, 0, sizeof( depthStencilInfo ) );
+    depthStencilInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
+    depthStencilInfo.depthTestEnable = desc.depthTestEnable_;
+    depthStencilInfo.depthWriteEnable = desc.depthWriteEnable_;
+    depthStencilInfo.depthCompareOp = desc.depthCompareOp_;
+    depthStencilInfo.maxDepthBounds = 1.0f;
+
     VkVertexInputBindingDescription vertex_input_bindings;
     vertex_input_bindings.binding = 0;
-    vertex_input_bindings.stride = 5 * sizeof( float );
+    vertex_input_bindings.stride = desc.vertexStride_;
     vertex_input_bindings.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
-    VkVertexInputAttributeDescription vertex_input_attributes[2];
+    VkVertexInputAttributeDescription vertex_input_attributes[kMaxVertexAttributes];
 
-    vertex_input_attributes[0].binding = 0;
-    vertex_input_attributes[0].location = 0;
-    vertex_input_attributes[0].format = VK_FORMAT_R32G32B32_SFLOAT;
-    vertex_input_attributes[0].offset = 0;
-
-    vertex_input_attributes[1].binding = 0;
-    vertex_input_attributes[1].location = 1;
-    vertex_input_attributes[1].format = VK_FORMAT_R32G32_SFLOAT;
-    vertex_input_attributes[1].offset = sizeof( float ) * 3;
+    for( uint32_t i = 0; i < desc.vertexAttributeCount_; i++ )
+    {
+        vertex_input_attributes[i].binding = 0;
+        vertex_input_attributes[i].location = desc.vertexAttributes_[i].location_;
+        vertex_input_attributes[i].format = desc.vertexAttributes_[i].format_;
+        vertex_input_attributes[i].offset = desc.vertexAttributes_[i].offset_;
+    }
 
     VkPipelineVertexInputStateCreateInfo vertexInputInfo;
     vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
     vertexInputInfo.pNext = nullptr;
     vertexInputInfo.vertexBindingDescriptionCount = 1;
     vertexInputInfo.pVertexBindingDescriptions = &vertex_input_bindings;
-    vertexInputInfo.vertexAttributeDescriptionCount = 2;
+    vertexInputInfo.vertexAttributeDescriptionCount = desc.vertexAttributeCount_;
     vertexInputInfo.pVertexAttributeDescriptions = vertex_input_attributes;
 
-    VkPipelineCacheCreateInfo pipelineCacheInfo;
-    pipelineCacheInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
-    pipelineCacheInfo.pNext = nullptr;
-    pipelineCacheInfo.initialDataSize = 0;
-    pipelineCacheInfo.pInitialData = nullptr;
-    pipelineCacheInfo.flags = 0;  // reserved, must be 0
-
-    CALL_VK( vkCreatePipelineCache( device.device_, &pipelineCacheInfo, nullptr, &gfxPipeline.cache_ ) );
-
     VkGraphicsPipelineCreateInfo pipelineCreateInfo;
     pipelineCreateInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
     pipelineCreateInfo.pNext = nullptr;
@@ -903,67 +1544,258 @@ void CreateGraphicsPipeline( void )
     pipelineCreateInfo.pViewportState = &viewportInfo;
     pipelineCreateInfo.pRasterizationState = &rasterInfo;
     pipelineCreateInfo.pMultisampleState = &multisampleInfo;
-    pipelineCreateInfo.pDepthStencilState = nullptr;
+    pipelineCreateInfo.pDepthStencilState = &depthStencilInfo; // ignored by render passes without depth
     pipelineCreateInfo.pColorBlendState = &colorBlendInfo;
     pipelineCreateInfo.pDynamicState = &dynamicStateInfo;
-    pipelineCreateInfo.layout = gfxPipeline.layout_;
-    pipelineCreateInfo.renderPass = render.renderPass_;
-    pipelineCreateInfo.subpass = 0;
+    pipelineCreateInfo.layout = desc.layout_;
+    pipelineCreateInfo.renderPass = desc.renderPass_;
+    pipelineCreateInfo.subpass = desc.subpass_;
     pipelineCreateInfo.basePipelineHandle = VK_NULL_HANDLE;
     pipelineCreateInfo.basePipelineIndex = 0;
 
-    CALL_VK( vkCreateGraphicsPipelines( device.device_, gfxPipeline.cache_, 1, &pipelineCreateInfo, nullptr, &gfxPipeline.pipeline_ ) );
+    VkPipeline pipeline;
+    CALL_VK( vkCreateGraphicsPipelines( device.device_, gfxPipeline.cache_, 1, &pipelineCreateInfo, nullptr, &pipeline ) );
+
+    return pipeline;
+}
+
+#ifdef VKTUTS_BENCHMARK
+// Materials of the bindless benchmark scene, each with a table slot of its own
+static const uint32_t kBenchmarkBindlessMaterials = 2048;
+#endif
+
+// Bindless mode: every texture gets a slot of the table, and the table's set is the only one draws bind
+VkResult CreateBindlessTextures( void )
+{
+    for( int32_t idx = 0; idx < TUTORIAL_TEXTURE_COUNT; idx++ )
+    {
+        textures[idx].bindlessSlot_ = bindlessTextures.Add( textures[idx].sampler_, textures[idx].imageView_, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL );
+        if( textures[idx].bindlessSlot_ == BindlessTextureTable::kInvalidSlot )
+            return VK_ERROR_OUT_OF_POOL_MEMORY_KHR;
+    }
+    gfxPipeline.materialCount_ = TUTORIAL_TEXTURE_COUNT;
+#ifdef VKTUTS_BENCHMARK
+    // thousands of materials, as many slots; draws walk through them and still bind one set
+    while( gfxPipeline.materialCount_ < kBenchmarkBindlessMaterials && bindlessTextures.Count() < bindlessTextures.Capacity() )
+    {
+        const TextureObject& texture = textures[gfxPipeline.materialCount_ % TUTORIAL_TEXTURE_COUNT];
+        bindlessTextures.Add( texture.sampler_, texture.imageView_, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL );
+        gfxPipeline.materialCount_++;
+    }
+#endif
+    bindlessTextures.Flush();
+    gfxPipeline.descSet_ = bindlessTextures.Set();
+    return VK_SUCCESS;
+}
 
-    vkDestroyShaderModule( device.device_, vertexShader, nullptr );
-    vkDestroyShaderModule( device.device_, fragmentShader, nullptr );
+// Set 1 of every draw: one set on the whole ring, draws select their uniforms through its dynamic offset
+VkResult CreateObjectDescriptorSet( void )
+{
+    DescriptorResource resource;
+    memset( &resource, 0, sizeof( resource ) );
+    resource.buffer_.buffer = uniformRing.Buffer();
+    resource.buffer_.offset = 0;
+    resource.buffer_.range = sizeof( ObjectUniforms );
+
+    gfxPipeline.objectSet_ = descriptorSets.Get( gfxPipeline.objectLayout_, &resource, 1 );
+    if( gfxPipeline.objectSet_ == VK_NULL_HANDLE )
+        return VK_ERROR_OUT_OF_POOL_MEMORY_KHR;
+    descriptorSets.Flush();
+    return VK_SUCCESS;
 }
 
 VkResult CreateDescriptorSet( void )
 {
-    VkDescriptorPoolSize descriptorPoolSize;
-    descriptorPoolSize.type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-    descriptorPoolSize.descriptorCount = TUTORIAL_TEXTURE_COUNT;
-
-    VkDescriptorPoolCreateInfo descriptorPoolCreateInfo;
-    descriptorPoolCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
-    descriptorPoolCreateInfo.pNext = nullptr;
-    descriptorPoolCreateInfo.maxSets = 1;
-    descriptorPoolCreateInfo.poolSizeCount = 1;
-    descriptorPoolCreateInfo.pPoolSizes = &descriptorPoolSize;
-    CALL_VK( vkCreateDescriptorPool( device.device_, &descriptorPoolCreateInfo, nullptr, &gfxPipeline.descPool_ ) );
-
-    VkDescriptorSetAllocateInfo descriptorSetAllocateInfo;
-    descriptorSetAllocateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
-    descriptorSetAllocateInfo.pNext = nullptr;
-    descriptorSetAllocateInfo.descriptorPool = gfxPipeline.descPool_;
-    descriptorSetAllocateInfo.descriptorSetCount = 1;
-    descriptorSetAllocateInfo.pSetLayouts = &gfxPipeline.dscLayout_;
-    CALL_VK( vkAllocateDescriptorSets( device.device_, &descriptorSetAllocateInfo, &gfxPipeline.descSet_ ) );
-
-    VkDescriptorImageInfo descriptorImageInfo[TUTORIAL_TEXTURE_COUNT];
-    memset( descriptorImageInfo, 0, sizeof( descriptorImageInfo ) );
+    VkResult result = CreateObjectDescriptorSet();
+    if( result != VK_SUCCESS )
+        return result;
+    if( device.bindlessTextures_ )
+        return CreateBindlessTextures();
+
+    // set 0 binds the textures, in binding order
+    std::vector<DescriptorResource> resources( TUTORIAL_TEXTURE_COUNT );
+    memset( resources.data(), 0, resources.size() * sizeof( DescriptorResource ) );
     for( int32_t idx = 0; idx < TUTORIAL_TEXTURE_COUNT; idx++ )
     {
-        descriptorImageInfo[idx].sampler = textures[idx].sampler_;
-        descriptorImageInfo[idx].imageView = textures[idx].imageView_;
-        descriptorImageInfo[idx].imageLayout = VK_IMAGE_LAYOUT_GENERAL;
-    }
-
-    VkWriteDescriptorSet writeDescriptorSet;
-    writeDescriptorSet.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-    writeDescriptorSet.pNext = nullptr;
-    writeDescriptorSet.dstSet = gfxPipeline.descSet_;
-    writeDescriptorSet.dstBinding = 0;
-    writeDescriptorSet.dstArrayElement = 0;
-    writeDescriptorSet.descriptorCount = TUTORIAL_TEXTURE_COUNT;
-    writeDescriptorSet.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-    writeDescriptorSet.pImageInfo = descriptorImageInfo;
-    writeDescriptorSet.pBufferInfo = nullptr;
-    writeDescriptorSet.pTexelBufferView = nullptr;
-    vkUpdateDescriptorSets( device.device_, 1, &writeDescriptorSet, 0, nullptr );
+        resources[idx].image_.sampler = textures[idx].sampler_;
+        resources[idx].image_.imageView = textures[idx].imageView_;
+        resources[idx].image_.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    }
+
+    // materials binding the same textures would get this set back instead of a new one
+    gfxPipeline.descSet_ = descriptorSets.Get( gfxPipeline.dscLayout_, resources.data(), static_cast<uint32_t>( resources.size() ) );
+    if( gfxPipeline.descSet_ == VK_NULL_HANDLE )
+        return VK_ERROR_OUT_OF_POOL_MEMORY_KHR;
+    descriptorSets.Flush();
+
+#ifdef VKTUTS_BENCHMARK
+    BenchmarkDescriptorUpdates( device.device_, gfxPipeline.dscLayout_, descriptorSets.LayoutBindings( gfxPipeline.dscLayout_ ), resources,
+                                descriptorAllocator.SetSizes(), descriptorSets.UsesTemplates() );
+#endif
     return VK_SUCCESS;
 }
 
+// Draws of the scene, shared by the inline and the secondary recording paths
+// Only draws [firstDraw, firstDraw + drawCount) are recorded so the parallel path can split the scene
+void RecordSceneDraws( VkCommandBuffer cmdBuffer, uint32_t firstDraw, uint32_t drawCount )
+{
+    vkCmdBindPipeline( cmdBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, gfxPipeline.boundPipeline_ );
+
+    // secondary command buffers do not inherit dynamic state, every recording sets it
+    VkViewport viewport;
+    viewport.x = 0;
+    viewport.y = 0;
+    viewport.width = ( float ) swapchain.displaySize_.width;
+    viewport.height = ( float ) swapchain.displaySize_.height;
+    viewport.minDepth = 0.0f;
+    viewport.maxDepth = 1.0f;
+    vkCmdSetViewport( cmdBuffer, 0, 1, &viewport );
+
+    VkRect2D scissor;
+    scissor.extent = swapchain.displaySize_;
+    scissor.offset = { .x = 0, .y = 0, };
+    vkCmdSetScissor( cmdBuffer, 0, 1, &scissor );
+
+    // bindless mode too binds its one set once, whatever the number of materials
+    vkCmdBindDescriptorSets( cmdBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, gfxPipeline.layout_, 0, 1, &gfxPipeline.descSet_, 0, nullptr );
+
+    BindGeometryBuffer( cmdBuffer, buffers.scene_ );
+
+    for( uint32_t i = firstDraw; i < firstDraw + drawCount; i++ )
+    {
+        // same set every draw, the dynamic offset picks the draw's uniforms out of the ring
+        vkCmdBindDescriptorSets( cmdBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, gfxPipeline.layout_, kObjectSet, 1, &gfxPipeline.objectSet_, 1,
+                                 &render.objectOffsets_[i] );
+        if( device.bindlessTextures_ )
+        {
+            // the table was filled in order, so materials are slots 0 .. materialCount_ - 1
+            uint32_t slot = i % gfxPipeline.materialCount_;
+            vkCmdPushConstants( cmdBuffer, gfxPipeline.layout_, VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof( slot ), &slot );
+        }
+        DrawGeometryBuffer( cmdBuffer, buffers.scene_, 1 );
+    }
+}
+
+// Record the unchanging scene draws once into a secondary command buffer.
+// SIMULTANEOUS_USE: every in-flight frame executes the same buffer
+// framebuffer is left VK_NULL_HANDLE so one buffer works with all swapchain images
+void RecordStaticCommandBuffer( void )
+{
+    VkCommandBufferAllocateInfo cmdBufferCreateInfo;
+    cmdBufferCreateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+    cmdBufferCreateInfo.pNext = nullptr;
+    cmdBufferCreateInfo.commandPool = render.cmdPool_;
+    cmdBufferCreateInfo.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+    cmdBufferCreateInfo.commandBufferCount = 1;
+    CALL_VK( vkAllocateCommandBuffers( device.device_, &cmdBufferCreateInfo, &render.staticCmdBuffer_ ) );
+
+    VkCommandBufferInheritanceInfo inheritanceInfo;
+    inheritanceInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+    inheritanceInfo.pNext = nullptr;
+    inheritanceInfo.renderPass = render.renderPass_;
+    inheritanceInfo.subpass = 0;
+    inheritanceInfo.framebuffer = VK_NULL_HANDLE;
+    inheritanceInfo.occlusionQueryEnable = VK_FALSE;
+    inheritanceInfo.queryFlags = 0;
+    inheritanceInfo.pipelineStatistics = 0;
+
+    VkCommandBufferBeginInfo cmdBufferBeginInfo;
+    cmdBufferBeginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    cmdBufferBeginInfo.pNext = nullptr;
+    cmdBufferBeginInfo.flags = VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT | VK_COMMAND_BUFFER_USAGE_SIMULTANEOUS_USE_BIT;
+    cmdBufferBeginInfo.pInheritanceInfo = &inheritanceInfo;
+
+    CALL_VK( vkBeginCommandBuffer( render.staticCmdBuffer_, &cmdBufferBeginInfo ) );
+    RecordSceneDraws( render.staticCmdBuffer_, 0, render.drawCount_ );
+    CALL_VK( vkEndCommandBuffer( render.staticCmdBuffer_ ) );
+}
+
+// Split this frame's draws into render.recordThreads_ chunks and record each chunk
+// into a secondary command buffer on the job system.
+// Each job takes its command buffer from the pool of the thread it runs on.
+void RecordParallelCommandBuffers( VulkanFrameInfo& frame, uint32_t imageIndex )
+{
+    for( auto& threadCmd : frame.threadCmds_ )
+    {
+        CALL_VK( vkResetCommandPool( device.device_, threadCmd.cmdPool_, 0 ) );
+        threadCmd.used_ = 0;
+    }
+
+    VkCommandBufferInheritanceInfo inheritanceInfo;
+    inheritanceInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+    inheritanceInfo.pNext = nullptr;
+    inheritanceInfo.renderPass = render.renderPass_;
+    inheritanceInfo.subpass = 0;
+    inheritanceInfo.framebuffer = swapchain.framebuffers_[imageIndex];
+    inheritanceInfo.occlusionQueryEnable = VK_FALSE;
+    inheritanceInfo.queryFlags = 0;
+    inheritanceInfo.pipelineStatistics = 0;
+
+    VkCommandBufferBeginInfo cmdBufferBeginInfo;
+    cmdBufferBeginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    cmdBufferBeginInfo.pNext = nullptr;
+    cmdBufferBeginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT | VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+    cmdBufferBeginInfo.pInheritanceInfo = &inheritanceInfo;
+
+    uint32_t chunkCount = render.recordThreads_;
+    frame.secondaryCmdBuffers_.resize( chunkCount );
+
+    JobCounter counter;
+    for( uint32_t chunk = 0; chunk < chunkCount; chunk++ )
+    {
+        uint32_t firstDraw = render.drawCount_ * chunk / chunkCount;
+        uint32_t lastDraw = render.drawCount_ * ( chunk + 1 ) / chunkCount;
+        jobSystem->Submit( [&frame, &cmdBufferBeginInfo, chunk, firstDraw, lastDraw]() {
+            VulkanThreadCommandInfo& threadCmd = frame.threadCmds_[JobSystem::ThreadIndex()];
+            if( threadCmd.used_ == threadCmd.cmdBuffers_.size() )
+            {
+                VkCommandBufferAllocateInfo cmdBufferCreateInfo;
+                cmdBufferCreateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+                cmdBufferCreateInfo.pNext = nullptr;
+                cmdBufferCreateInfo.commandPool = threadCmd.cmdPool_;
+                cmdBufferCreateInfo.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+                cmdBufferCreateInfo.commandBufferCount = 1;
+                VkCommandBuffer cmdBuffer;
+                CALL_VK( vkAllocateCommandBuffers( device.device_, &cmdBufferCreateInfo, &cmdBuffer ) );
+                threadCmd.cmdBuffers_.push_back( cmdBuffer );
+            }
+            VkCommandBuffer cmdBuffer = threadCmd.cmdBuffers_[threadCmd.used_++];
+
+            CALL_VK( vkBeginCommandBuffer( cmdBuffer, &cmdBufferBeginInfo ) );
+            RecordSceneDraws( cmdBuffer, firstDraw, lastDraw - firstDraw );
+            CALL_VK( vkEndCommandBuffer( cmdBuffer ) );
+
+            frame.secondaryCmdBuffers_[chunk] = cmdBuffer;
+        }, &counter );
+    }
+    jobSystem->Wait( counter );
+}
+
+// Draws circle around the center, each one a little ahead of the one before
+static const float kObjectRadius = 0.1f;
+static const float kObjectSpeed = 0.02f;     // radians per frame
+static const float kObjectPhaseStep = 0.01f; // radians from one draw to the next
+
+// Writes the uniforms of every draw into uniformRing and keeps their offsets for RecordSceneDraws.
+// persistent: the static secondary's, which every frame reads; otherwise the current frame's region
+void WriteObjectUniforms( bool persistent )
+{
+    render.objectOffsets_.resize( render.drawCount_ );
+    for( uint32_t i = 0; i < render.drawCount_; i++ )
+    {
+        float phase = render.frameNumber_ * kObjectSpeed + i * kObjectPhaseStep;
+        ObjectUniforms uniforms = { { kObjectRadius * cosf( phase ), kObjectRadius * sinf( phase ), 1.0f, 1.0f } };
+
+        UniformAllocation allocation;
+        bool allocated = persistent ? uniformRing.AllocatePersistent( sizeof( uniforms ), &allocation )
+                                    : uniformRing.Allocate( sizeof( uniforms ), &allocation );
+        assert( allocated );
+        // one write into the mapped memory, it may be uncached
+        memcpy( allocation.data_, &uniforms, sizeof( uniforms ) );
+        render.objectOffsets_[i] = allocation.offset_;
+    }
+}
+
 void CreateCommand()
 {
     // https://vulkan.lunarg.com/doc/view/1.0.37.0/linux/vkspec.chunked/ch07.html
@@ -991,100 +1823,312 @@ void CreateCommand()
 
     // -----------------------------------------------
     // Create a pool of command buffers to allocate command buffer from
+    // transient pool   : 짧게 쓰고 버릴 command buffer용 힌트 (VK_COMMAND_POOL_CREATE_TRANSIENT_BIT)
+    // vkResetCommandPool : pool에서 할당한 모든 command buffer를 한번에 reset한다.
+    //                    : buffer 단위 reset(VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT)보다 드라이버 비용이 싸다.
 
     VkCommandPoolCreateInfo cmdPoolCreateInfo;
     cmdPoolCreateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
     cmdPoolCreateInfo.pNext = nullptr;
-    cmdPoolCreateInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+    cmdPoolCreateInfo.flags = 0;
     cmdPoolCreateInfo.queueFamilyIndex = device.queueFamilyIndex_;
 
     CALL_VK( vkCreateCommandPool( device.device_, &cmdPoolCreateInfo, nullptr, &render.cmdPool_ ) );
 
-    // Record a command buffer that just clear the screen
-    // 1 command buffer draw in 1 framebuffer
-    // In our case we need 2 command as we have 2 framebuffer
-    render.cmdBufferLen_ = swapchain.swapchainLength_;
-    render.cmdBuffer_ = new VkCommandBuffer[swapchain.swapchainLength_];
+    // frames in flight : 프레임마다 command pool, command buffer, fence, semaphore를 따로 가진다.
+    //                  : CPU는 N 프레임 전에 제출한 작업의 fence만 기다리면 되므로, GPU가 이전 프레임을 그리는 동안 다음 프레임을 레코딩할 수 있다.
+    //                  : command buffer는 swapchain image 개수가 아니라 in-flight 프레임 개수만큼 필요하다. (매 프레임 다시 레코딩)
+    render.frames_.resize( kFramesInFlight );
+    render.currentFrame_ = 0;
+    render.frameNumber_ = 0;
+    render.recordMode_ = kRecordMode;
+    render.drawCount_ = kDrawCount;
+    render.recordThreads_ = jobSystem->ThreadCount();
+
+    VkCommandPoolCreateInfo framePoolCreateInfo = cmdPoolCreateInfo;
+    framePoolCreateInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+
     VkCommandBufferAllocateInfo cmdBufferCreateInfo;
     cmdBufferCreateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
     cmdBufferCreateInfo.pNext = nullptr;
-    cmdBufferCreateInfo.commandPool = render.cmdPool_;
     cmdBufferCreateInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
-    cmdBufferCreateInfo.commandBufferCount = render.cmdBufferLen_;
+    cmdBufferCreateInfo.commandBufferCount = 1;
 
-    CALL_VK( vkAllocateCommandBuffers( device.device_, &cmdBufferCreateInfo, render.cmdBuffer_ ) );
+    // The fence starts signaled so the first wait on each frame returns immediately
+    VkFenceCreateInfo fenceCreateInfo;
+    fenceCreateInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+    fenceCreateInfo.pNext = nullptr;
+    fenceCreateInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
 
-    for( int bufferIndex = 0; bufferIndex < swapchain.swapchainLength_; bufferIndex++ )
+    VkSemaphoreCreateInfo semaphoreCreateInfo;
+    semaphoreCreateInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+    semaphoreCreateInfo.pNext = nullptr;
+    semaphoreCreateInfo.flags = 0;
+
+    for( uint32_t i = 0; i < kFramesInFlight; i++ )
     {
-        // We start by creating and declare the "beginning" our command buffer
-        VkCommandBufferBeginInfo cmdBufferBeginInfo;
-        cmdBufferBeginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
-        cmdBufferBeginInfo.pNext = nullptr;
-        cmdBufferBeginInfo.flags = 0;
-        cmdBufferBeginInfo.pInheritanceInfo = nullptr;
+        VulkanFrameInfo& frame = render.frames_[i];
+        CALL_VK( vkCreateCommandPool( device.device_, &framePoolCreateInfo, nullptr, &frame.cmdPool_ ) );
+        cmdBufferCreateInfo.commandPool = frame.cmdPool_;
+        CALL_VK( vkAllocateCommandBuffers( device.device_, &cmdBufferCreateInfo, &frame.cmdBuffer_ ) );
+        CALL_VK( vkCreateFence( device.device_, &fenceCreateInfo, nullptr, &frame.fence_ ) );
+        CALL_VK( vkCreateSemaphore( device.device_, &semaphoreCreateInfo, nullptr, &frame.imageAvailable_ ) );
+        CALL_VK( vkCreateSemaphore( device.device_, &semaphoreCreateInfo, nullptr, &frame.renderFinished_ ) );
+
+        if( render.recordMode_ == RECORD_PARALLEL_SECONDARY )
+        {
+            frame.threadCmds_.resize( jobSystem->ThreadCount() );
+            for( auto& threadCmd : frame.threadCmds_ )
+            {
+                CALL_VK( vkCreateCommandPool( device.device_, &framePoolCreateInfo, nullptr, &threadCmd.cmdPool_ ) );
+                threadCmd.used_ = 0;
+            }
+        }
+    }
 
-        CALL_VK( vkBeginCommandBuffer( render.cmdBuffer_[bufferIndex], &cmdBufferBeginInfo ) );
+    render.staticCmdBuffer_ = VK_NULL_HANDLE;
+    if( render.recordMode_ == RECORD_STATIC_SECONDARY )
+    {
+        // every frame executes the same draws, their uniforms are written once
+        WriteObjectUniforms( true );
+        RecordStaticCommandBuffer();
+    }
+}
 
-        // transition the buffer into color attachment
-        setImageLayout( render.cmdBuffer_[bufferIndex], swapchain.displayImages_[bufferIndex], VK_IMAGE_LAYOUT_PRESENT_SRC_KHR, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT );
+// Record the draw commands of one frame into its own command buffer.
+// The caller guarantees the GPU is done with the frame's pool (frame fence waited).
+void resetAndRecordCommandBuffer( VulkanFrameInfo& frame, uint32_t imageIndex )
+{
+    VkCommandBuffer cmdBuffer = frame.cmdBuffer_;
+    CALL_VK( vkResetCommandPool( device.device_, frame.cmdPool_, 0 ) );
+
+    // We start by creating and declare the "beginning" our command buffer
+    VkCommandBufferBeginInfo cmdBufferBeginInfo;
+    cmdBufferBeginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    cmdBufferBeginInfo.pNext = nullptr;
+    cmdBufferBeginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    cmdBufferBeginInfo.pInheritanceInfo = nullptr;
+
+    CALL_VK( vkBeginCommandBuffer( cmdBuffer, &cmdBufferBeginInfo ) );
+
+    if( render.recordMode_ != RECORD_STATIC_SECONDARY )
+        WriteObjectUniforms( false );
+
+    // transition the buffer into color attachment
+    setImageLayout( cmdBuffer, swapchain.displayImages_[imageIndex], VK_IMAGE_LAYOUT_PRESENT_SRC_KHR, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT );
+
+    // Now we start a renderpass. Any draw command has to be recorded in a
+    // renderpass
+    VkClearValue clearVals;
+    clearVals.color.float32[0] = 0.0f;
+    clearVals.color.float32[1] = 0.34f;
+    clearVals.color.float32[2] = 0.90f;
+    clearVals.color.float32[3] = 1.0f;
+
+    VkRenderPassBeginInfo renderPassBeginInfo;
+    renderPassBeginInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+    renderPassBeginInfo.pNext = nullptr;
+    renderPassBeginInfo.renderPass = render.renderPass_;
+    renderPassBeginInfo.framebuffer = swapchain.framebuffers_[imageIndex];
+    renderPassBeginInfo.renderArea.offset = { .x = 0, .y = 0 };
+    renderPassBeginInfo.renderArea.extent = swapchain.displaySize_;
+    renderPassBeginInfo.clearValueCount = 1;
+    renderPassBeginInfo.pClearValues = &clearVals;
+
+    if( render.recordMode_ == RECORD_STATIC_SECONDARY )
+    {
+        vkCmdBeginRenderPass( cmdBuffer, &renderPassBeginInfo, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS );
+        vkCmdExecuteCommands( cmdBuffer, 1, &render.staticCmdBuffer_ );
+    }
+    else if( render.recordMode_ == RECORD_PARALLEL_SECONDARY )
+    {
+        RecordParallelCommandBuffers( frame, imageIndex );
+        vkCmdBeginRenderPass( cmdBuffer, &renderPassBeginInfo, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS );
+        vkCmdExecuteCommands( cmdBuffer, frame.secondaryCmdBuffers_.size(), frame.secondaryCmdBuffers_.data() );
+    }
+    else
+    {
+        vkCmdBeginRenderPass( cmdBuffer, &renderPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE );
+        RecordSceneDraws( cmdBuffer, 0, render.drawCount_ );
+    }
 
-        // Now we start a renderpass. Any draw command has to be recorded in a
-        // renderpass
-        VkClearValue clearVals;
-        clearVals.color.float32[0] = 0.0f;
-        clearVals.color.float32[1] = 0.34f;
-        clearVals.color.float32[2] = 0.90f;
-        clearVals.color.float32[3] = 1.0f;
+    vkCmdEndRenderPass( cmdBuffer );
 
+    setImageLayout( cmdBuffer, swapchain.displayImages_[imageIndex], VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, VK_IMAGE_LAYOUT_PRESENT_SRC_KHR, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT );
 
-        VkRenderPassBeginInfo renderPassBeginInfo;
-        renderPassBeginInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
-        renderPassBeginInfo.pNext = nullptr;
-        renderPassBeginInfo.renderPass = render.renderPass_;
-        renderPassBeginInfo.framebuffer = swapchain.framebuffers_[bufferIndex];
-        renderPassBeginInfo.renderArea.offset = { .x = 0, .y = 0 };
-        renderPassBeginInfo.renderArea.extent = swapchain.displaySize_;
-        renderPassBeginInfo.clearValueCount = 1;
-        renderPassBeginInfo.pClearValues = &clearVals;
-        vkCmdBeginRenderPass( render.cmdBuffer_[bufferIndex], &renderPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE );
+    CALL_VK( vkEndCommandBuffer( cmdBuffer ) );
+}
 
-        VkDeviceSize offset = 0;
+#ifdef VKTUTS_BENCHMARK
+void LogPipelineStats( void )
+{
+    for( uint32_t i = 0; i < pipelineManager.PipelineCount(); i++ )
+    {
+        const PipelineStats& stats = pipelineManager.Stats( i );
+        // cold: empty cache, warm: loaded from disk
+        const char* cacheState = gfxPipeline.cacheFromDisk_ ? "warm" : "cold";
+        LOGI( "pipeline %s (%s cache): %.3f ms queued, %.3f ms building, ready %.3f ms after the request", stats.name_, cacheState,
+              stats.queueMs_, stats.compileMs_, stats.readyMs_ );
+    }
+    PipelineLookupStats lookupStats = pipelineManager.LookupStats();
+    LOGI( "pipelines: %u built in %.3f ms, %u of %u requests served by an existing one (%.1f%%)", lookupStats.pipelines_,
+          lookupStats.buildMs_, lookupStats.hits_, lookupStats.lookups_, 100.0 * lookupStats.hits_ / lookupStats.lookups_ );
+    LOGI( "shader modules: %u for %u pipelines", shaderModules.ModuleCount(), pipelineManager.PipelineCount() );
+    LOGI( "layouts: %u set layouts, %u pipeline layouts, %u of %u requests served by an existing one", layoutCache.SetLayoutCount(),
+          layoutCache.PipelineLayoutCount(), layoutCache.Hits(), layoutCache.Lookups() );
+}
+#endif
 
-        vkCmdBindPipeline(render.cmdBuffer_[bufferIndex], VK_PIPELINE_BIND_POINT_GRAPHICS,
-                          gfxPipeline.pipeline_);
+// Draws bind the scene pipeline from the first frame recorded after its build finished, its fallback until then
+void SelectScenePipeline( void )
+{
+    VkPipeline pipeline = pipelineManager.Get( gfxPipeline.scenePipeline_ );
+    if( pipeline == gfxPipeline.boundPipeline_ )
+        return;
+    gfxPipeline.boundPipeline_ = pipeline;
 
-        vkCmdBindDescriptorSets(render.cmdBuffer_[bufferIndex], VK_PIPELINE_BIND_POINT_GRAPHICS,
-                                gfxPipeline.layout_, 0, 1, &gfxPipeline.descSet_, 0, nullptr);
+    // the static secondary binds the old pipeline, frames in flight may still execute it
+    if( render.staticCmdBuffer_ != VK_NULL_HANDLE )
+    {
+        render.retiredCmdBuffers_.push_back( { render.staticCmdBuffer_, render.frameNumber_ + kFramesInFlight - 1 } );
+        RecordStaticCommandBuffer();
+    }
+}
 
-        vkCmdBindVertexBuffers(render.cmdBuffer_[bufferIndex], 0, 1, &buffers.vertexBuf_, &offset);
+// Free replaced command buffers and pipelines, and removed texture slots, no frame in flight uses anymore; call after waiting for the frame's fence
+void FreeRetiredObjects( void )
+{
+    std::vector<VulkanRetiredCmdBuffer>& retired = render.retiredCmdBuffers_;
+    for( size_t i = 0; i < retired.size(); )
+    {
+        if( render.frameNumber_ >= retired[i].freeFrame_ )
+        {
+            vkFreeCommandBuffers( device.device_, render.cmdPool_, 1, &retired[i].cmdBuffer_ );
+            retired[i] = retired.back();
+            retired.pop_back();
+        }
+        else
+            i++;
+    }
 
-        vkCmdDraw(render.cmdBuffer_[bufferIndex], 3, 1, 0, 0);
+    std::vector<VulkanRetiredPipeline>& retiredPipelines = render.retiredPipelines_;
+    for( size_t i = 0; i < retiredPipelines.size(); )
+    {
+        if( render.frameNumber_ >= retiredPipelines[i].freeFrame_ )
+        {
+            vkDestroyPipeline( device.device_, retiredPipelines[i].pipeline_, nullptr );
+            retiredPipelines[i] = retiredPipelines.back();
+            retiredPipelines.pop_back();
+        }
+        else
+            i++;
+    }
 
-        vkCmdEndRenderPass( render.cmdBuffer_[bufferIndex] );
+    bindlessTextures.FreeRetired( render.frameNumber_ );
+}
 
-        setImageLayout( render.cmdBuffer_[bufferIndex], swapchain.displayImages_[bufferIndex], VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, VK_IMAGE_LAYOUT_PRESENT_SRC_KHR, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT );
+#ifdef VKTUTS_SHADER_HOT_RELOAD
+// Edited shaders are pushed next to the APK's copies, e.g.
+//   adb push tri.frag /sdcard/Android/data/<package>/files/shaders/
+// and replace them from then on, in this run and the next ones.
+void StartShaderHotReload( void )
+{
+    const char* dir = androidAppCtx->activity->externalDataPath;
+    if( !dir )
+    {
+        LOGW( "shader hot reload: no external storage" );
+        return;
+    }
+    setShaderOverrideDirectory( dir );
+    if( !hotReload.watcher_.Start( ( std::string( dir ) + "/shaders" ).c_str() ) )
+        LOGW( "shader hot reload: cannot watch %s/shaders", dir );
+    hotReload.pending_ = false;
+    hotReload.presenting_ = false;
+}
 
-        CALL_VK( vkEndCommandBuffer( render.cmdBuffer_[bufferIndex] ) );
+// Rebuilds the pipelines of changed shaders on the job system and swaps them in once they are done.
+// Frames keep drawing with the old pipelines meanwhile; those are destroyed when no frame in flight uses them.
+void ReloadChangedShaders( void )
+{
+    for( const ShaderChange& change : hotReload.watcher_.Poll() )
+    {
+        std::string path = "shaders/" + change.name_;
+        shaderModules.Invalidate( path.c_str() );
+        uint32_t pipelineCount = pipelineManager.Rebuild( path.c_str() );
+        LOGI( "shader hot reload: %s changed, %u pipelines use it", change.name_.c_str(), pipelineCount );
+        if( pipelineCount != 0 )
+        {
+            hotReload.change_ = change;
+            hotReload.pending_ = true;
+        }
     }
 
-    // We need to create a fence to be able, in the main loop, to wait for our
-    // draw command(s) to finish before swapping the framebuffers
-    VkFenceCreateInfo fenceCreateInfo;
-    fenceCreateInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
-    fenceCreateInfo.pNext = nullptr;
-    fenceCreateInfo.flags = 0;
-    CALL_VK( vkCreateFence( device.device_, &fenceCreateInfo, nullptr, &render.fence_ ) );
+    std::vector<VkPipeline> replaced;
+    pipelineManager.Update( &replaced );
+    for( VkPipeline pipeline : replaced )
+        render.retiredPipelines_.push_back( { pipeline, render.frameNumber_ + kFramesInFlight - 1 } );
+    // modules of the old shader source may be in use until no build runs
+    if( !pipelineManager.Building() )
+        shaderModules.FreeRetired();
 
-    // We need to create a semaphore to be able to wait, in the main loop, for our
-    // framebuffer to be available for us before drawing.
-    VkSemaphoreCreateInfo semaphoreCreateInfo;
-    semaphoreCreateInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
-    semaphoreCreateInfo.pNext = nullptr;
-    semaphoreCreateInfo.flags = 0;
-    CALL_VK( vkCreateSemaphore( device.device_, &semaphoreCreateInfo, nullptr, &render.semaphore_ ) );
+    if( hotReload.pending_ && !pipelineManager.Rebuilding() )
+    {
+        hotReload.pending_ = false;
+        hotReload.presenting_ = true;
+        hotReload.ready_ = std::chrono::system_clock::now();
+    }
 }
 
-void resetAndRecordCommandBuffer() {}
+// The file's mtime is the edit; adb push keeps the host's, so with both clocks in sync the push is included
+void LogHotReloadLatency( void )
+{
+    auto presented = std::chrono::system_clock::now();
+    auto ms = []( std::chrono::system_clock::time_point from, std::chrono::system_clock::time_point to ) {
+        return std::chrono::duration<double, std::milli>( to - from ).count();
+    };
+    const ShaderChange& change = hotReload.change_;
+    LOGI( "shader hot reload: %s on screen %.1f ms after the edit (%.1f ms to notice, %.1f ms to rebuild, %.1f ms to present)",
+          change.name_.c_str(), ms( change.modified_, presented ), ms( change.modified_, change.detected_ ),
+          ms( change.detected_, hotReload.ready_ ), ms( hotReload.ready_, presented ) );
+}
+#endif
+
+// Rebuild the swapchain and framebuffers for the current surface.
+// The device, textures, buffers, descriptors and pipelines stay alive; viewport and scissor
+// are dynamic state, so a new display size only changes what is recorded.
+void RecreateSwapChain( void )
+{
+    vkDeviceWaitIdle( device.device_ );
+
+    // builds started rather than LookupStats().pipelines_: a background build finishing meanwhile is no resize build
+    uint32_t builds = pipelineManager.BuildCount();
+    VkExtent2D oldSize = swapchain.displaySize_;
+    VkSwapchainKHR oldSwapchain = swapchain.swapchain_;
+
+    DeleteFrameBuffers();
+    CreateSwapChain( oldSwapchain );
+    if( oldSwapchain != VK_NULL_HANDLE )
+    {
+        vkDestroySwapchainKHR( device.device_, oldSwapchain, nullptr );
+    }
+    CreateFrameBuffers();
+
+    if( oldSize.width != swapchain.displaySize_.width || oldSize.height != swapchain.displaySize_.height )
+    {
+        // the static secondary set the old viewport and scissor
+        if( render.staticCmdBuffer_ != VK_NULL_HANDLE )
+        {
+            vkFreeCommandBuffers( device.device_, render.cmdPool_, 1, &render.staticCmdBuffer_ );
+            RecordStaticCommandBuffer();
+        }
+    }
+
+    if( pipelineManager.BuildCount() != builds )
+    {
+        LOGE( "swapchain recreation built %u pipelines, a pipeline depends on the swapchain size",
+              pipelineManager.BuildCount() - builds );
+    }
+}
 
 bool VulkanDrawFrame( void )
 {
@@ -1098,26 +2142,53 @@ bool VulkanDrawFrame( void )
     //              : fence, semaphore => 시작할때 unsignaled로 하고, 끝나면 signaled로 변경
     // vkQueueSubmit        : draw call을 수행
     // vkQueuePresentKHR    : 전달된 index의 swapchain image를 present
-
+    //                      : present는 renderFinished semaphore를 기다린다. (CPU가 fence로 기다리지 않음)
+    // fence는 submit 직후가 아니라, 같은 frame slot을 다시 쓰기 직전에 기다린다.
+
+    VulkanFrameInfo& frame = render.frames_[render.currentFrame_];
+    CALL_VK( vkWaitForFences( device.device_, 1, &frame.fence_, VK_TRUE, UINT64_MAX ) );
+    FreeRetiredObjects();
+    // the sets this frame slot allocated last time are no longer used by the GPU
+    descriptorAllocator.ResetFrame( render.currentFrame_ );
+    // and so are the uniforms it wrote into its region of the ring
+    uniformRing.BeginFrame( render.currentFrame_ );
+#ifdef VKTUTS_SHADER_HOT_RELOAD
+    ReloadChangedShaders();
+#endif
+    SelectScenePipeline();
+
+    // VK_ERROR_OUT_OF_DATE_KHR : surface가 바뀌어서(회전, 크기 변경) 더이상 이 swapchain으로 present할 수 없음
+    // VK_SUBOPTIMAL_KHR        : present는 가능하지만 surface와 정확히 맞지 않음 -> 이번 프레임은 그리고 다시 만든다.
     uint32_t nextIndex;
-    CALL_VK( vkAcquireNextImageKHR( device.device_, swapchain.swapchain_, UINT64_MAX, render.semaphore_, VK_NULL_HANDLE, &nextIndex ) );
+    VkResult acquireResult = vkAcquireNextImageKHR( device.device_, swapchain.swapchain_, UINT64_MAX, frame.imageAvailable_, VK_NULL_HANDLE, &nextIndex );
+    if( acquireResult == VK_ERROR_OUT_OF_DATE_KHR )
+    {
+        RecreateSwapChain();
+        return false;
+    }
+    assert( acquireResult == VK_SUCCESS || acquireResult == VK_SUBOPTIMAL_KHR );
 
-    resetAndRecordCommandBuffer();
+#ifdef VKTUTS_BENCHMARK
+    auto recordStart = std::chrono::steady_clock::now();
+    resetAndRecordCommandBuffer( frame, nextIndex );
+    benchmark.recordSeconds_ += std::chrono::duration<double>( std::chrono::steady_clock::now() - recordStart ).count();
+#else
+    resetAndRecordCommandBuffer( frame, nextIndex );
+#endif
 
     VkPipelineStageFlags waitStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
     VkSubmitInfo submit_info;
     submit_info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
     submit_info.pNext = nullptr;
     submit_info.waitSemaphoreCount = 1;
-    submit_info.pWaitSemaphores = &render.semaphore_;
+    submit_info.pWaitSemaphores = &frame.imageAvailable_;
     submit_info.pWaitDstStageMask = &waitStageMask;
     submit_info.commandBufferCount = 1;
-    submit_info.pCommandBuffers = &render.cmdBuffer_[nextIndex];
-    submit_info.signalSemaphoreCount = 0;
-    submit_info.pSignalSemaphores = nullptr;
-    CALL_VK( vkResetFences( device.device_, 1, &render.fence_ ) );
-    CALL_VK( vkQueueSubmit( device.queue_, 1, &submit_info, render.fence_ ) )
-    CALL_VK( vkWaitForFences( device.device_, 1, &render.fence_, VK_TRUE, 100000000 ) );
+    submit_info.pCommandBuffers = &frame.cmdBuffer_;
+    submit_info.signalSemaphoreCount = 1;
+    submit_info.pSignalSemaphores = &frame.renderFinished_;
+    CALL_VK( vkResetFences( device.device_, 1, &frame.fence_ ) );
+    CALL_VK( vkQueueSubmit( device.queue_, 1, &submit_info, frame.fence_ ) )
 
     VkResult result;
     VkPresentInfoKHR presentInfo;
@@ -1126,25 +2197,412 @@ bool VulkanDrawFrame( void )
     presentInfo.swapchainCount = 1;
     presentInfo.pSwapchains = &swapchain.swapchain_;
     presentInfo.pImageIndices = &nextIndex;
-    presentInfo.waitSemaphoreCount = 0;
-    presentInfo.pWaitSemaphores = nullptr;
+    presentInfo.waitSemaphoreCount = 1;
+    presentInfo.pWaitSemaphores = &frame.renderFinished_;
     presentInfo.pResults = &result;
-    vkQueuePresentKHR( device.queue_, &presentInfo );
+    VkResult presentResult = vkQueuePresentKHR( device.queue_, &presentInfo );
+
+    render.currentFrame_ = ( render.currentFrame_ + 1 ) % kFramesInFlight;
+    render.frameNumber_++;
+
+#ifdef VKTUTS_SHADER_HOT_RELOAD
+    if( hotReload.presenting_ )
+    {
+        LogHotReloadLatency();
+        hotReload.presenting_ = false;
+    }
+#endif
+
+    if( resume.pending_ )
+    {
+        double ms = std::chrono::duration<double, std::milli>( std::chrono::steady_clock::now() - resume.start_ ).count();
+        LOGI( "%s: window init to first frame %.1f ms (%s shaders)", resume.coldStart_ ? "cold start" : "resume", ms, kShaderSource );
+        resume.pending_ = false;
+    }
+
+    if( acquireResult == VK_SUBOPTIMAL_KHR || presentResult == VK_SUBOPTIMAL_KHR || presentResult == VK_ERROR_OUT_OF_DATE_KHR )
+    {
+        RecreateSwapChain();
+    }
+
+    // Android usually kills the process without DeleteVulkan(), save as soon as the cache holds every pipeline
+    if( !gfxPipeline.cacheSaved_ && pipelineManager.AllReady() )
+    {
+        SaveVulkanPipelineCache();
+        gfxPipeline.cacheSaved_ = true;
+    }
+
+#ifdef VKTUTS_BENCHMARK
+    if( !benchmark.pipelinesLogged_ && pipelineManager.AllReady() )
+    {
+        LogPipelineStats();
+        benchmark.pipelinesLogged_ = true;
+    }
+    if( ++benchmark.frames_ == kBenchmarkFrames )
+    {
+        auto now = std::chrono::steady_clock::now();
+        double seconds = std::chrono::duration<double>( now - benchmark.start_ ).count();
+        LOGI( "frames in flight %u: %.1f fps", kFramesInFlight, benchmark.frames_ / seconds );
+        if( render.recordMode_ == RECORD_PARALLEL_SECONDARY )
+        {
+            LOGI( "parallel recording, %u draws on %u threads: %.2f us/frame", render.drawCount_, render.recordThreads_,
+                  benchmark.recordSeconds_ * 1e6 / benchmark.frames_ );
+            // walk 1..N threads so one run shows how recording scales
+            render.recordThreads_ = render.recordThreads_ % jobSystem->ThreadCount() + 1;
+        }
+        else
+        {
+            LOGI( "%s recording, %u draws: %.2f us/frame", render.recordMode_ == RECORD_STATIC_SECONDARY ? "static secondary" : "dynamic",
+                  render.drawCount_, benchmark.recordSeconds_ * 1e6 / benchmark.frames_ );
+        }
+        benchmark.start_ = now;
+        benchmark.frames_ = 0;
+        benchmark.recordSeconds_ = 0.0;
+    }
+#endif
 
     return true;
 }
 
+#ifdef VKTUTS_BENCHMARK
+// Objects whose uniforms the uniform update benchmark writes
+static const uint32_t kBenchmarkUniformObjects = 10000;
+
+// CPU cost of per-object uniform updates: written into a uniform ring, and recorded as one vkCmdUpdateBuffer
+// per object into a buffer of all objects. The recorded updates are never submitted; submitted, they would
+// also need a barrier before the draws read them.
+void BenchmarkUniformUpdates( void )
+{
+    VkDeviceSize stride = ObjectUniformsStride( uniformRing.Alignment() );
+    ObjectUniforms uniforms = { { 0.0f, 0.0f, 1.0f, 1.0f } };
+
+    UniformRing ring;
+    CALL_VK( ring.Init( device.device_, &memoryAllocator, uniformRing.Alignment(), stride * kBenchmarkUniformObjects, 1, 0 ) );
+    auto start = std::chrono::steady_clock::now();
+    ring.BeginFrame( 0 );
+    for( uint32_t i = 0; i < kBenchmarkUniformObjects; i++ )
+    {
+        UniformAllocation allocation;
+        ring.Allocate( sizeof( uniforms ), &allocation );
+        uniforms.transform_[0] = static_cast<float>( i );
+        memcpy( allocation.data_, &uniforms, sizeof( uniforms ) );
+    }
+    double ringNs = std::chrono::duration<double, std::nano>( std::chrono::steady_clock::now() - start ).count();
+    ring.Shutdown();
+
+    VkBufferCreateInfo createBufferInfo;
+    createBufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    createBufferInfo.pNext = nullptr;
+    createBufferInfo.size = stride * kBenchmarkUniformObjects;
+    createBufferInfo.usage = VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+    createBufferInfo.flags = 0;
+    createBufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    createBufferInfo.queueFamilyIndexCount = 0;
+    createBufferInfo.pQueueFamilyIndices = nullptr;
+    VkBuffer buffer;
+    MemoryAllocation memory;
+    CALL_VK( vkCreateBuffer( device.device_, &createBufferInfo, nullptr, &buffer ) );
+    CALL_VK( memoryAllocator.AllocateForBuffer( buffer, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, &memory ) );
+
+    VkCommandBufferAllocateInfo cmdBufferCreateInfo;
+    cmdBufferCreateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+    cmdBufferCreateInfo.pNext = nullptr;
+    cmdBufferCreateInfo.commandPool = render.cmdPool_;
+    cmdBufferCreateInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    cmdBufferCreateInfo.commandBufferCount = 1;
+    VkCommandBuffer cmdBuffer;
+    CALL_VK( vkAllocateCommandBuffers( device.device_, &cmdBufferCreateInfo, &cmdBuffer ) );
+
+    VkCommandBufferBeginInfo cmdBufferBeginInfo;
+    cmdBufferBeginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    cmdBufferBeginInfo.pNext = nullptr;
+    cmdBufferBeginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    cmdBufferBeginInfo.pInheritanceInfo = nullptr;
+    CALL_VK( vkBeginCommandBuffer( cmdBuffer, &cmdBufferBeginInfo ) );
+    start = std::chrono::steady_clock::now();
+    for( uint32_t i = 0; i < kBenchmarkUniformObjects; i++ )
+    {
+        uniforms.transform_[0] = static_cast<float>( i );
+        vkCmdUpdateBuffer( cmdBuffer, buffer, i * stride, sizeof( uniforms ), &uniforms );
+    }
+    double updateNs = std::chrono::duration<double, std::nano>( std::chrono::steady_clock::now() - start ).count();
+    CALL_VK( vkEndCommandBuffer( cmdBuffer ) );
+
+    vkFreeCommandBuffers( device.device_, render.cmdPool_, 1, &cmdBuffer );
+    vkDestroyBuffer( device.device_, buffer, nullptr );
+    memoryAllocator.Free( memory );
+
+    LOGI( "uniform updates, %u objects: %.1f ns each through the uniform ring, %.1f ns each through vkCmdUpdateBuffer",
+          kBenchmarkUniformObjects, ringNs / kBenchmarkUniformObjects, updateNs / kBenchmarkUniformObjects );
+}
+
+// Mesh of the geometry memory benchmark: a grid of kBenchmarkGridSize x kBenchmarkGridSize vertices,
+// drawn kBenchmarkGridDraws times per submission into a kBenchmarkTargetSize square offscreen image
+static const uint32_t kBenchmarkGridSize = 256;
+static const uint32_t kBenchmarkGridDraws = 16;
+static const uint32_t kBenchmarkGeometrySubmits = 10;
+static const uint32_t kBenchmarkTargetSize = 16;
+
+// Vertex throughput of device local against host visible geometry, drawn headless with the fallback pipeline.
+// The target is tiny so the triangles barely rasterize and vertex fetch dominates.
+void BenchmarkGeometryMemory( void )
+{
+    std::vector<float> vertices;
+    std::vector<uint32_t> indices;
+    for( uint32_t y = 0; y < kBenchmarkGridSize; y++ )
+    {
+        for( uint32_t x = 0; x < kBenchmarkGridSize; x++ )
+        {
+            float u = static_cast<float>( x ) / ( kBenchmarkGridSize - 1 );
+            float v = static_cast<float>( y ) / ( kBenchmarkGridSize - 1 );
+            vertices.insert( vertices.end(), { u * 2.0f - 1.0f, v * 2.0f - 1.0f, 0.0f, u, v } );
+            if( x + 1 < kBenchmarkGridSize && y + 1 < kBenchmarkGridSize )
+            {
+                uint32_t i = y * kBenchmarkGridSize + x;
+                indices.insert( indices.end(), { i, i + 1, i + kBenchmarkGridSize, i + 1, i + kBenchmarkGridSize + 1, i + kBenchmarkGridSize } );
+            }
+        }
+    }
+    GeometryData geometryData;
+    geometryData.vertices_ = vertices.data();
+    geometryData.vertexStride_ = 5 * sizeof( float );
+    geometryData.vertexCount_ = kBenchmarkGridSize * kBenchmarkGridSize;
+    geometryData.indices_ = indices.data();
+    geometryData.indexType_ = VK_INDEX_TYPE_UINT32;
+    geometryData.indexCount_ = static_cast<uint32_t>( indices.size() );
+
+    // offscreen target, compatible with the swapchain render pass the pipeline was built for
+    VkImageCreateInfo imageCreateInfo;
+    imageCreateInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+    imageCreateInfo.pNext = nullptr;
+    imageCreateInfo.flags = 0;
+    imageCreateInfo.imageType = VK_IMAGE_TYPE_2D;
+    imageCreateInfo.format = swapchain.displayFormat_;
+    imageCreateInfo.extent = { kBenchmarkTargetSize, kBenchmarkTargetSize, 1 };
+    imageCreateInfo.mipLevels = 1;
+    imageCreateInfo.arrayLayers = 1;
+    imageCreateInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+    imageCreateInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+    imageCreateInfo.usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+    imageCreateInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    imageCreateInfo.queueFamilyIndexCount = 0;
+    imageCreateInfo.pQueueFamilyIndices = nullptr;
+    imageCreateInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    VkImage image;
+    MemoryAllocation imageMemory;
+    CALL_VK( vkCreateImage( device.device_, &imageCreateInfo, nullptr, &image ) );
+    CALL_VK( memoryAllocator.AllocateForImage( image, VK_IMAGE_TILING_OPTIMAL, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, &imageMemory ) );
+
+    VkImageViewCreateInfo viewCreateInfo;
+    viewCreateInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+    viewCreateInfo.pNext = nullptr;
+    viewCreateInfo.flags = 0;
+    viewCreateInfo.image = image;
+    viewCreateInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+    viewCreateInfo.format = swapchain.displayFormat_;
+    viewCreateInfo.components = { VK_COMPONENT_SWIZZLE_R, VK_COMPONENT_SWIZZLE_G, VK_COMPONENT_SWIZZLE_B, VK_COMPONENT_SWIZZLE_A };
+    viewCreateInfo.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 };
+    VkImageView view;
+    CALL_VK( vkCreateImageView( device.device_, &viewCreateInfo, nullptr, &view ) );
+
+    // same attachment as render.renderPass_, but the image is never presented
+    VkAttachmentDescription attachment;
+    attachment.flags = 0;
+    attachment.format = swapchain.displayFormat_;
+    attachment.samples = VK_SAMPLE_COUNT_1_BIT;
+    attachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+    attachment.storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+    attachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+    attachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+    attachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    attachment.finalLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+    VkAttachmentReference colorReference = { 0, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL };
+    VkSubpassDescription subpass;
+    memset( &subpass, 0, sizeof( subpass ) );
+    subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+    subpass.colorAttachmentCount = 1;
+    subpass.pColorAttachments = &colorReference;
+    VkRenderPassCreateInfo renderPassCreateInfo;
+    memset( &renderPassCreateInfo, 0, sizeof( renderPassCreateInfo ) );
+    renderPassCreateInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+    renderPassCreateInfo.attachmentCount = 1;
+    renderPassCreateInfo.pAttachments = &attachment;
+    renderPassCreateInfo.subpassCount = 1;
+    renderPassCreateInfo.pSubpasses = &subpass;
+    VkRenderPass renderPass;
+    CALL_VK( vkCreateRenderPass( device.device_, &renderPassCreateInfo, nullptr, &renderPass ) );
+
+    VkFramebufferCreateInfo framebufferCreateInfo;
+    framebufferCreateInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+    framebufferCreateInfo.pNext = nullptr;
+    framebufferCreateInfo.flags = 0;
+    framebufferCreateInfo.renderPass = renderPass;
+    framebufferCreateInfo.attachmentCount = 1;
+    framebufferCreateInfo.pAttachments = &view;
+    framebufferCreateInfo.width = kBenchmarkTargetSize;
+    framebufferCreateInfo.height = kBenchmarkTargetSize;
+    framebufferCreateInfo.layers = 1;
+    VkFramebuffer framebuffer;
+    CALL_VK( vkCreateFramebuffer( device.device_, &framebufferCreateInfo, nullptr, &framebuffer ) );
+
+    // the grid fills the target unmoved
+    UniformAllocation objectUniforms;
+    ObjectUniforms uniforms = { { 0.0f, 0.0f, 1.0f, 1.0f } };
+    bool allocated = uniformRing.Allocate( sizeof( uniforms ), &objectUniforms );
+    assert( allocated );
+    memcpy( objectUniforms.data_, &uniforms, sizeof( uniforms ) );
+
+    // render.cmdPool_ cannot reset single command buffers, each memory gets a new one
+    VkCommandBufferAllocateInfo cmdBufferCreateInfo;
+    cmdBufferCreateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+    cmdBufferCreateInfo.pNext = nullptr;
+    cmdBufferCreateInfo.commandPool = render.cmdPool_;
+    cmdBufferCreateInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    cmdBufferCreateInfo.commandBufferCount = 1;
+
+    VkFenceCreateInfo fenceCreateInfo;
+    fenceCreateInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+    fenceCreateInfo.pNext = nullptr;
+    fenceCreateInfo.flags = 0;
+    VkFence fence;
+    CALL_VK( vkCreateFence( device.device_, &fenceCreateInfo, nullptr, &fence ) );
+
+    const struct
+    {
+        GeometryMemory memory_;
+        const char* name_;
+    } kMemories[] = {
+        { GEOMETRY_MEMORY_HOST_VISIBLE, "host visible" },
+        { GEOMETRY_MEMORY_DEVICE_LOCAL, "device local" },
+    };
+    for( const auto& memory : kMemories )
+    {
+        GeometryBuffer geometry;
+        CALL_VK( CreateGeometryBuffer( device.device_, &memoryAllocator, &uploadQueue, geometryData, memory.memory_, &geometry ) );
+        uploadQueue.WaitIdle();
+
+        VkCommandBuffer cmdBuffer;
+        CALL_VK( vkAllocateCommandBuffers( device.device_, &cmdBufferCreateInfo, &cmdBuffer ) );
+        VkCommandBufferBeginInfo cmdBufferBeginInfo;
+        cmdBufferBeginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+        cmdBufferBeginInfo.pNext = nullptr;
+        cmdBufferBeginInfo.flags = 0;
+        cmdBufferBeginInfo.pInheritanceInfo = nullptr;
+        CALL_VK( vkBeginCommandBuffer( cmdBuffer, &cmdBufferBeginInfo ) );
+
+        VkClearValue clearVals;
+        memset( &clearVals, 0, sizeof( clearVals ) );
+        VkRenderPassBeginInfo renderPassBeginInfo;
+        renderPassBeginInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+        renderPassBeginInfo.pNext = nullptr;
+        renderPassBeginInfo.renderPass = renderPass;
+        renderPassBeginInfo.framebuffer = framebuffer;
+        renderPassBeginInfo.renderArea.offset = { .x = 0, .y = 0 };
+        renderPassBeginInfo.renderArea.extent = { kBenchmarkTargetSize, kBenchmarkTargetSize };
+        renderPassBeginInfo.clearValueCount = 1;
+        renderPassBeginInfo.pClearValues = &clearVals;
+        vkCmdBeginRenderPass( cmdBuffer, &renderPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE );
+
+        vkCmdBindPipeline( cmdBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineManager.Get( gfxPipeline.fallbackPipeline_ ) );
+        VkViewport viewport = { 0.0f, 0.0f, static_cast<float>( kBenchmarkTargetSize ), static_cast<float>( kBenchmarkTargetSize ), 0.0f, 1.0f };
+        vkCmdSetViewport( cmdBuffer, 0, 1, &viewport );
+        VkRect2D scissor = renderPassBeginInfo.renderArea;
+        vkCmdSetScissor( cmdBuffer, 0, 1, &scissor );
+        // the fallback fragment shader samples no texture, set 0 can stay unbound
+        vkCmdBindDescriptorSets( cmdBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, gfxPipeline.layout_, kObjectSet, 1, &gfxPipeline.objectSet_, 1,
+                                 &objectUniforms.offset_ );
+        BindGeometryBuffer( cmdBuffer, geometry );
+        DrawGeometryBuffer( cmdBuffer, geometry, kBenchmarkGridDraws );
+
+        vkCmdEndRenderPass( cmdBuffer );
+        CALL_VK( vkEndCommandBuffer( cmdBuffer ) );
+
+        VkSubmitInfo submitInfo;
+        memset( &submitInfo, 0, sizeof( submitInfo ) );
+        submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+        submitInfo.commandBufferCount = 1;
+        submitInfo.pCommandBuffers = &cmdBuffer;
+        // one submission to warm up caches and clocks, then the timed ones
+        double ms = 0.0;
+        for( uint32_t i = 0; i <= kBenchmarkGeometrySubmits; i++ )
+        {
+            auto start = std::chrono::steady_clock::now();
+            CALL_VK( vkQueueSubmit( device.queue_, 1, &submitInfo, fence ) );
+            CALL_VK( vkWaitForFences( device.device_, 1, &fence, VK_TRUE, UINT64_MAX ) );
+            CALL_VK( vkResetFences( device.device_, 1, &fence ) );
+            if( i != 0 )
+                ms += std::chrono::duration<double, std::milli>( std::chrono::steady_clock::now() - start ).count();
+        }
+        ms /= kBenchmarkGeometrySubmits;
+        double vertices = static_cast<double>( geometry.indexCount_ ) * kBenchmarkGridDraws;
+        LOGI( "geometry in %s memory: %.3f ms per %.0f indexed vertices, %.1f M vertices/s", memory.name_, ms, vertices, vertices / ms / 1e3 );
+
+        vkFreeCommandBuffers( device.device_, render.cmdPool_, 1, &cmdBuffer );
+        DestroyGeometryBuffer( device.device_, &memoryAllocator, &geometry );
+    }
+
+    vkDestroyFence( device.device_, fence, nullptr );
+    vkDestroyFramebuffer( device.device_, framebuffer, nullptr );
+    vkDestroyRenderPass( device.device_, renderPass, nullptr );
+    vkDestroyImageView( device.device_, view, nullptr );
+    vkDestroyImage( device.device_, image, nullptr );
+    memoryAllocator.Free( imageMemory );
+}
+
+// Swapchain recreations of the resize check
+static const uint32_t kBenchmarkResizes = 20;
+
+// Runs the resize path kBenchmarkResizes times, RecreateSwapChain() reports pipelines it builds.
+// The surface keeps its size, so each round pretends the previous size was a different one.
+void BenchmarkResizes( void )
+{
+    uint32_t builds = pipelineManager.BuildCount();
+    auto start = std::chrono::steady_clock::now();
+    for( uint32_t i = 0; i < kBenchmarkResizes; i++ )
+    {
+        swapchain.displaySize_ = { .width = 1 + i % 2, .height = 1 };
+        RecreateSwapChain();
+    }
+    double ms = std::chrono::duration<double, std::milli>( std::chrono::steady_clock::now() - start ).count();
+
+    uint32_t resizeBuilds = pipelineManager.BuildCount() - builds;
+    LOGI( "resize: %u swapchain recreations, %.3f ms each, %u pipelines built", kBenchmarkResizes, ms / kBenchmarkResizes, resizeBuilds );
+}
+#endif
+
 bool InitVulkan( android_app* app )
 {
     androidAppCtx = app;
 
+    resume.start_ = std::chrono::steady_clock::now();
+    resume.pending_ = true;
+    resume.coldStart_ = !device.initialized_;
+
+    // New window for a device we already have (resume, rotation without config change handling ...):
+    // only the surface, the swapchain and the framebuffers depend on the window.
+    if( device.initialized_ )
+    {
+        DeleteVulkanWindow();
+        CreateSurface( androidAppCtx->window );
+        RecreateSwapChain();
+        return true;
+    }
+
     if( !InitVulkan() )
     {
         LOGW( "Vulkan is unavailable, install vulkan and re-start" );
         return false;
     }
 
-    CreateVulkanDevice( androidAppCtx->window );
+    CreateVulkanDevice();
+
+    memoryAllocator.Init( device.physicalDevice_, device.device_ );
+
+    uploadQueue.Init( device.device_, device.queue_, device.queueFamilyIndex_, &memoryAllocator, kStagingRingSize );
+
+    jobSystem.reset( new JobSystem() );
+
+    CreateSurface( androidAppCtx->window );
 
     CreateSwapChain();
 
@@ -1156,12 +2614,49 @@ bool InitVulkan( android_app* app )
 
     CreateBuffers();
 
+#ifdef VKTUTS_SHADER_HOT_RELOAD
+    StartShaderHotReload();
+#endif
+
     CreateGraphicsPipeline();
 
-    CreateDescriptorSet();
+    CALL_VK( CreateDescriptorSet() );
 
     CreateCommand();
 
+#ifdef VKTUTS_BENCHMARK
+    benchmark.start_ = std::chrono::steady_clock::now();
+    benchmark.frames_ = 0;
+    benchmark.recordSeconds_ = 0.0;
+    benchmark.pipelinesLogged_ = false;
+
+    MemoryAllocatorStats memoryStats = memoryAllocator.Stats();
+    LOGI( "device memory: %u vkAllocateMemory for %u resources, %llu / %llu bytes used, fragmentation %.2f",
+          memoryStats.deviceMemoryCount_, memoryStats.allocationCount_, static_cast<unsigned long long>( memoryStats.usedBytes_ ),
+          static_cast<unsigned long long>( memoryStats.reservedBytes_ ), memoryStats.fragmentation_ );
+    BenchmarkBlockAllocatorChurn();
+    if( device.bindlessTextures_ )
+    {
+        LOGI( "bindless textures: %u materials in %u of %u slots, texture set bound once per command buffer", gfxPipeline.materialCount_,
+              bindlessTextures.Count(), bindlessTextures.Capacity() );
+    }
+    else
+        BenchmarkDescriptorAllocation( device.device_, gfxPipeline.dscLayout_, descriptorAllocator.SetSizes() );
+    DescriptorAllocatorStats descriptorStats = descriptorAllocator.Stats();
+    LOGI( "descriptor sets: %llu allocated from %u pools, %llu pools added on demand", static_cast<unsigned long long>( descriptorStats.allocations_ ),
+          descriptorStats.poolCount_, static_cast<unsigned long long>( descriptorStats.poolGrowths_ ) );
+    DescriptorSetCacheStats setCacheStats = descriptorSets.Stats();
+    LOGI( "descriptor set cache: %u sets for %u requests, written in %u update calls (%s)", setCacheStats.sets_, setCacheStats.lookups_,
+          setCacheStats.updateCalls_, descriptorSets.UsesTemplates() ? "update templates" : "batched writes" );
+#ifdef VKTUTS_RUNTIME_SHADERC
+    reportShaderOptimization( androidAppCtx );
+    benchmarkShaderCompiles( jobSystem.get(), kBenchmarkShaderCount );
+#endif
+    BenchmarkUniformUpdates();
+    BenchmarkGeometryMemory();
+    BenchmarkResizes();
+#endif
+
     device.initialized_ = true;
 
     return true;
@@ -1169,46 +2664,125 @@ bool InitVulkan( android_app* app )
 
 bool IsVulkanReady( void )
 {
-    return device.initialized_;
+    return device.initialized_ && swapchain.swapchain_ != VK_NULL_HANDLE;
 }
 
-void DeleteSwapChain( void )
+void DeleteFrameBuffers( void )
 {
-    for( int i = 0; i < swapchain.swapchainLength_; i++ )
+    for( size_t i = 0; i < swapchain.framebuffers_.size(); i++ )
     {
         vkDestroyFramebuffer( device.device_, swapchain.framebuffers_[i], nullptr );
         vkDestroyImageView( device.device_, swapchain.displayViews_[i], nullptr );
     }
+    swapchain.framebuffers_.clear();
+    swapchain.displayViews_.clear();
+    swapchain.displayImages_.clear();
+}
+
+void DeleteSwapChain( void )
+{
+    DeleteFrameBuffers();
 
     vkDestroySwapchainKHR( device.device_, swapchain.swapchain_, nullptr );
+    swapchain.swapchain_ = VK_NULL_HANDLE;
+}
+
+void DeleteVulkanWindow( void )
+{
+    if( device.surface_ == VK_NULL_HANDLE )
+        return;
+
+    vkDeviceWaitIdle( device.device_ );
+    DeleteSwapChain();
+    vkDestroySurfaceKHR( device.instance_, device.surface_, nullptr );
+    device.surface_ = VK_NULL_HANDLE;
+}
+
+void SaveVulkanPipelineCache( void )
+{
+    if( !device.initialized_ )
+        return;
+    SavePipelineCacheToFile( device.device_, gfxPipeline.cache_, PipelineCachePath().c_str() );
 }
 
 void DeleteBuffers( void )
 {
-    vkDestroyBuffer( device.device_, buffers.vertexBuf_, nullptr );
+    DestroyGeometryBuffer( device.device_, &memoryAllocator, &buffers.scene_ );
+    uniformRing.Shutdown();
+}
+
+void DeleteTexture( void )
+{
+    for( uint32_t i = 0; i < TUTORIAL_TEXTURE_COUNT; i++ )
+    {
+        vkDestroyImageView( device.device_, textures[i].imageView_, nullptr );
+        vkDestroySampler( device.device_, textures[i].sampler_, nullptr );
+        vkDestroyImage( device.device_, textures[i].image_, nullptr );
+        memoryAllocator.Free( textures[i].memory_ );
+    }
 }
 
 void DeleteGraphicsPipeline( void )
 {
-    if( gfxPipeline.pipeline_ == VK_NULL_HANDLE )
+    if( gfxPipeline.layout_ == VK_NULL_HANDLE )
         return;
-    vkDestroyPipeline( device.device_, gfxPipeline.pipeline_, nullptr );
+    for( auto& retired : render.retiredPipelines_ )
+        vkDestroyPipeline( device.device_, retired.pipeline_, nullptr );
+    render.retiredPipelines_.clear();
+    pipelineManager.Shutdown();
+    shaderModules.Shutdown();
+    SavePipelineCacheToFile( device.device_, gfxPipeline.cache_, PipelineCachePath().c_str() );
     vkDestroyPipelineCache( device.device_, gfxPipeline.cache_, nullptr );
-    vkFreeDescriptorSets( device.device_, gfxPipeline.descPool_, 1, &gfxPipeline.descSet_ );
-    vkDestroyDescriptorPool( device.device_, gfxPipeline.descPool_, nullptr );
-    vkDestroyPipelineLayout( device.device_, gfxPipeline.layout_, nullptr );
+    bindlessTextures.Shutdown();
+    descriptorSets.Shutdown();
+    descriptorAllocator.Shutdown();
+    layoutCache.Shutdown();
 }
 
 void DeleteVulkan()
 {
-    vkFreeCommandBuffers( device.device_, render.cmdPool_, render.cmdBufferLen_, render.cmdBuffer_ );
-    delete[] render.cmdBuffer_;
+    if( !device.initialized_ )
+        return;
+
+    // frames still in flight may reference everything below
+    vkDeviceWaitIdle( device.device_ );
+    // and pipeline builds still running use the render pass and the job system
+    pipelineManager.Wait();
+#ifdef VKTUTS_SHADER_HOT_RELOAD
+    hotReload.watcher_.Stop();
+#endif
+
+    for( auto& frame : render.frames_ )
+    {
+        // destroying the pool frees the command buffer allocated from it
+        vkDestroyCommandPool( device.device_, frame.cmdPool_, nullptr );
+        for( auto& threadCmd : frame.threadCmds_ )
+        {
+            vkDestroyCommandPool( device.device_, threadCmd.cmdPool_, nullptr );
+        }
+        vkDestroyFence( device.device_, frame.fence_, nullptr );
+        vkDestroySemaphore( device.device_, frame.imageAvailable_, nullptr );
+        vkDestroySemaphore( device.device_, frame.renderFinished_, nullptr );
+    }
+    render.frames_.clear();
+    jobSystem.reset();
+
+    if( render.staticCmdBuffer_ != VK_NULL_HANDLE )
+    {
+        vkFreeCommandBuffers( device.device_, render.cmdPool_, 1, &render.staticCmdBuffer_ );
+        render.staticCmdBuffer_ = VK_NULL_HANDLE;
+    }
+    // destroying the pool below frees the retired command buffers too
+    render.retiredCmdBuffers_.clear();
 
     vkDestroyCommandPool( device.device_, render.cmdPool_, nullptr );
     vkDestroyRenderPass( device.device_, render.renderPass_, nullptr );
-    DeleteSwapChain();
+    DeleteVulkanWindow();
     DeleteGraphicsPipeline();
     DeleteBuffers();
+    DeleteTexture();
+    uploadQueue.Shutdown();
+    memoryAllocator.Shutdown();
 
     vkDestroyDevice( device.device_, nullptr );
     vkDestroyInstance( device.instance_, nullptr );
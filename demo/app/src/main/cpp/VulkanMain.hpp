@@ -16,12 +16,21 @@
 
 // Initialize vulkan device context
 // after return, vulkan is ready to draw
+// if the device already exists, only the window resources are recreated
 #include <android_native_app_glue.h>
 bool InitVulkan(android_app* app);
 
 // delete vulkan device context when application goes away
 void DeleteVulkan(void);
 
+// release the surface and swapchain when the window goes away,
+// the device and all window-independent resources are kept for the next InitVulkan()
+void DeleteVulkanWindow(void);
+
+// write the pipeline cache to the app's storage, the process may be killed
+// any time after the app is stopped
+void SaveVulkanPipelineCache(void);
+
 // Check if vulkan is ready to draw
 bool IsVulkanReady(void);
 
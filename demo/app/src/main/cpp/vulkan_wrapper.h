@@ -24,6 +24,16 @@
  */
 int InitVulkan(void);
 
+/* Initialize the instance level extension function pointers declared in this header.
+ * Call after vkCreateInstance with the extensions it was created with; functions of other extensions stay null.
+ */
+void InitVulkanInstance(VkInstance instance, const char* const* enabledExtensionNames, uint32_t enabledExtensionCount);
+
+/* Initialize the device level extension function pointers declared in this header.
+ * Call after vkCreateDevice; functions of extensions the device was not created with stay null.
+ */
+void InitVulkanDevice(VkDevice device);
+
 // VK_core
 extern PFN_vkCreateInstance vkCreateInstance;
 extern PFN_vkDestroyInstance vkDestroyInstance;
@@ -224,6 +234,15 @@ extern PFN_vkCreateWin32SurfaceKHR vkCreateWin32SurfaceKHR;
 extern PFN_vkGetPhysicalDeviceWin32PresentationSupportKHR vkGetPhysicalDeviceWin32PresentationSupportKHR;
 #endif
 
+// VK_KHR_get_physical_device_properties2
+extern PFN_vkGetPhysicalDeviceFeatures2KHR vkGetPhysicalDeviceFeatures2KHR;
+extern PFN_vkGetPhysicalDeviceProperties2KHR vkGetPhysicalDeviceProperties2KHR;
+
+// VK_KHR_descriptor_update_template
+extern PFN_vkCreateDescriptorUpdateTemplateKHR vkCreateDescriptorUpdateTemplateKHR;
+extern PFN_vkDestroyDescriptorUpdateTemplateKHR vkDestroyDescriptorUpdateTemplateKHR;
+extern PFN_vkUpdateDescriptorSetWithTemplateKHR vkUpdateDescriptorSetWithTemplateKHR;
+
 #ifdef USE_DEBUG_EXTENTIONS
 #include <vulkan/vk_sdk_platform.h>
 // VK_EXT_debug_report
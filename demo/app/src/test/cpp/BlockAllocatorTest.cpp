@@ -0,0 +1,185 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include "BlockAllocator.h"
+#include "HostTest.h"
+#include <vector>
+
+HOST_TEST( BlockAllocator, SizeRoundedToMinAlignment )
+{
+    BlockAllocator blocks( 1000 );
+    CHECK( blocks.Size() == 992 );
+    CHECK( blocks.LargestFreeBlock() == 992 );
+
+    uint64_t offset;
+    uint32_t block = blocks.Allocate( 1, 1, &offset );
+    CHECK( block != BlockAllocator::kInvalidBlock );
+    CHECK( offset == 0 );
+    CHECK( blocks.UsedSize() == BlockAllocator::kMinAlignment );
+}
+
+HOST_TEST( BlockAllocator, AllocateSplitsTheTail )
+{
+    BlockAllocator blocks( 1024 );
+    uint64_t offsetA, offsetB;
+    blocks.Allocate( 64, 16, &offsetA );
+    blocks.Allocate( 64, 16, &offsetB );
+    CHECK( offsetA == 0 );
+    CHECK( offsetB == 64 );
+    CHECK( blocks.UsedSize() == 128 );
+    CHECK( blocks.AllocationCount() == 2 );
+    // what is left stays one block behind the allocations
+    CHECK( blocks.FreeBlockCount() == 1 );
+    CHECK( blocks.LargestFreeBlock() == 896 );
+}
+
+HOST_TEST( BlockAllocator, FreeMergesNeighbours )
+{
+    BlockAllocator blocks( 1024 );
+    uint64_t offset;
+    uint32_t a = blocks.Allocate( 64, 16, &offset );
+    uint32_t b = blocks.Allocate( 64, 16, &offset );
+    uint32_t c = blocks.Allocate( 64, 16, &offset );
+
+    // a has no free neighbour, c merges with the tail
+    blocks.Free( a );
+    blocks.Free( c );
+    CHECK( blocks.FreeBlockCount() == 2 );
+    CHECK( blocks.LargestFreeBlock() == 1024 - 128 );
+
+    // b merges with both
+    blocks.Free( b );
+    CHECK( blocks.Empty() );
+    CHECK( blocks.UsedSize() == 0 );
+    CHECK( blocks.FreeBlockCount() == 1 );
+    CHECK( blocks.LargestFreeBlock() == 1024 );
+
+    uint32_t all = blocks.Allocate( 1024, 16, &offset );
+    CHECK( all != BlockAllocator::kInvalidBlock );
+    CHECK( offset == 0 );
+}
+
+HOST_TEST( BlockAllocator, AlignmentPaddingIsReused )
+{
+    BlockAllocator blocks( 1024 );
+    uint64_t offset;
+    blocks.Allocate( 16, 16, &offset );
+
+    uint32_t aligned = blocks.Allocate( 32, 256, &offset );
+    CHECK( aligned != BlockAllocator::kInvalidBlock );
+    CHECK( offset == 256 );
+    // [16, 256) went back as a free block of its own
+    CHECK( blocks.FreeBlockCount() == 2 );
+    CHECK( blocks.UsedSize() == 48 );
+
+    uint32_t padding = blocks.Allocate( 200, 16, &offset );
+    CHECK( padding != BlockAllocator::kInvalidBlock );
+    CHECK( offset == 16 );
+
+    blocks.Free( aligned );
+    blocks.Free( padding );
+    CHECK( blocks.FreeBlockCount() == 1 );
+    CHECK( blocks.LargestFreeBlock() == 1024 - 16 );
+}
+
+HOST_TEST( BlockAllocator, OutOfSpace )
+{
+    BlockAllocator blocks( 256 );
+    uint64_t offset = 1234;
+    CHECK( blocks.Allocate( 512, 16, &offset ) == BlockAllocator::kInvalidBlock );
+    CHECK( offset == 1234 );
+
+    uint32_t all = blocks.Allocate( 256, 16, &offset );
+    CHECK( all != BlockAllocator::kInvalidBlock );
+    CHECK( blocks.Allocate( 16, 16, &offset ) == BlockAllocator::kInvalidBlock );
+    CHECK( blocks.LargestFreeBlock() == 0 );
+    CHECK( blocks.AllocationCount() == 1 );
+
+    // an alignment that cannot be met within the free space fails too
+    blocks.Free( all );
+    blocks.Allocate( 16, 16, &offset );
+    CHECK( blocks.Allocate( 16, 256, &offset ) == BlockAllocator::kInvalidBlock );
+}
+
+HOST_TEST( BlockAllocator, Fragmentation )
+{
+    BlockAllocator blocks( 1024 );
+    std::vector<uint32_t> allocated;
+    uint64_t offset;
+    for( uint32_t i = 0; i < 16; i++ )
+        allocated.push_back( blocks.Allocate( 64, 16, &offset ) );
+    CHECK( blocks.UsedSize() == 1024 );
+
+    // every other block free: half the space, none of it in one piece bigger than 64
+    for( uint32_t i = 0; i < 16; i += 2 )
+        blocks.Free( allocated[i] );
+    CHECK( blocks.FreeBlockCount() == 8 );
+    CHECK( blocks.LargestFreeBlock() == 64 );
+    CHECK( blocks.Allocate( 128, 16, &offset ) == BlockAllocator::kInvalidBlock );
+
+    for( uint32_t i = 1; i < 16; i += 2 )
+        blocks.Free( allocated[i] );
+    CHECK( blocks.FreeBlockCount() == 1 );
+    CHECK( blocks.LargestFreeBlock() == 1024 );
+}
+
+HOST_TEST( BlockAllocator, RandomChurnKeepsBlocksApart )
+{
+    struct Allocation
+    {
+        uint32_t block_;
+        uint64_t offset_;
+        uint64_t size_;
+    };
+    const uint64_t kSize = 1 << 20;
+    BlockAllocator blocks( kSize );
+    std::vector<Allocation> live;
+    uint32_t random = 12345;
+    for( uint32_t i = 0; i < 20000; i++ )
+    {
+        random = random * 1664525u + 1013904223u;
+        if( live.empty() || ( random >> 16 ) % 3 != 0 )
+        {
+            uint64_t size = 1 + ( random >> 8 ) % 4096;
+            uint64_t alignment = 16ull << ( ( random >> 4 ) % 5 );
+            Allocation allocation;
+            allocation.size_ = size;
+            allocation.block_ = blocks.Allocate( size, alignment, &allocation.offset_ );
+            if( allocation.block_ == BlockAllocator::kInvalidBlock )
+                continue;
+            CHECK( allocation.offset_ % alignment == 0 );
+            CHECK( allocation.offset_ + size <= kSize );
+            for( const auto& other : live )
+                CHECK( allocation.offset_ + size <= other.offset_ || other.offset_ + other.size_ <= allocation.offset_ );
+            live.push_back( allocation );
+        }
+        else
+        {
+            uint32_t index = ( random >> 8 ) % live.size();
+            blocks.Free( live[index].block_ );
+            live[index] = live.back();
+            live.pop_back();
+        }
+    }
+    CHECK( blocks.AllocationCount() == live.size() );
+
+    for( const auto& allocation : live )
+        blocks.Free( allocation.block_ );
+    CHECK( blocks.Empty() );
+    CHECK( blocks.FreeBlockCount() == 1 );
+    CHECK( blocks.LargestFreeBlock() == kSize );
+}
@@ -0,0 +1,224 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include "BlockDecoder.h"
+#include "HostTest.h"
+
+// Expected texels are worked out by hand from the ETC2 / S3TC block layouts, not by the decoder
+
+struct Texel
+{
+    uint8_t r, g, b, a;
+};
+
+// Decodes one 4x4 block and checks the texel at x, y
+class DecodedBlock
+{
+public:
+    DecodedBlock( VkFormat format, const uint8_t* block )
+    {
+        DecodeBlocks( format, block, 4, 4, rgba_ );
+    }
+
+    bool Is( uint32_t x, uint32_t y, Texel texel ) const
+    {
+        const uint8_t* p = rgba_ + ( y * 4 + x ) * 4;
+        return p[0] == texel.r && p[1] == texel.g && p[2] == texel.b && p[3] == texel.a;
+    }
+
+    uint8_t Alpha( uint32_t x, uint32_t y ) const { return rgba_[( y * 4 + x ) * 4 + 3]; }
+
+private:
+    uint8_t rgba_[4 * 4 * 4];
+};
+
+HOST_TEST( BlockDecoder, DecodedFormats )
+{
+    CHECK( DecodedBlockFormat( VK_FORMAT_ETC2_R8G8B8_UNORM_BLOCK ) == VK_FORMAT_R8G8B8A8_UNORM );
+    CHECK( DecodedBlockFormat( VK_FORMAT_ETC2_R8G8B8A8_SRGB_BLOCK ) == VK_FORMAT_R8G8B8A8_SRGB );
+    CHECK( DecodedBlockFormat( VK_FORMAT_BC1_RGBA_UNORM_BLOCK ) == VK_FORMAT_R8G8B8A8_UNORM );
+    CHECK( DecodedBlockFormat( VK_FORMAT_BC3_SRGB_BLOCK ) == VK_FORMAT_R8G8B8A8_SRGB );
+    CHECK( DecodedBlockFormat( VK_FORMAT_ASTC_4x4_UNORM_BLOCK ) == VK_FORMAT_UNDEFINED );
+    CHECK( DecodedBlockFormat( VK_FORMAT_BC7_UNORM_BLOCK ) == VK_FORMAT_UNDEFINED );
+}
+
+HOST_TEST( BlockDecoder, Etc2Individual )
+{
+    // R1 8 R2 4, G1 2 G2 f, B1 0 B2 a; tables 0 ( 2, 8 ) and 7 ( 47, 183 ), left / right halves
+    // indices: x0 y0..3 are 0..3, x2 y0 is 1, x3 y0 is 3, the rest 0
+    uint8_t block[8] = { 0x84, 0x2f, 0x0a, 0x1c, 0x10, 0x0c, 0x11, 0x0a };
+    DecodedBlock decoded( VK_FORMAT_ETC2_R8G8B8_UNORM_BLOCK, block );
+    CHECK( decoded.Is( 0, 0, { 138, 36, 2, 255 } ) );
+    CHECK( decoded.Is( 0, 1, { 144, 42, 8, 255 } ) );
+    CHECK( decoded.Is( 0, 2, { 134, 32, 0, 255 } ) );
+    CHECK( decoded.Is( 0, 3, { 128, 26, 0, 255 } ) );
+    CHECK( decoded.Is( 1, 3, { 138, 36, 2, 255 } ) );
+    CHECK( decoded.Is( 2, 0, { 251, 255, 255, 255 } ) );
+    CHECK( decoded.Is( 3, 0, { 0, 72, 0, 255 } ) );
+    CHECK( decoded.Is( 2, 1, { 115, 255, 217, 255 } ) );
+    CHECK( decoded.Is( 3, 3, { 115, 255, 217, 255 } ) );
+
+    // flipped, the halves are top / bottom
+    block[3] |= 0x01;
+    DecodedBlock flipped( VK_FORMAT_ETC2_R8G8B8_UNORM_BLOCK, block );
+    CHECK( flipped.Is( 2, 0, { 144, 42, 8, 255 } ) );
+    CHECK( flipped.Is( 3, 0, { 128, 26, 0, 255 } ) );
+    CHECK( flipped.Is( 0, 2, { 21, 208, 123, 255 } ) );
+    CHECK( flipped.Is( 1, 3, { 115, 255, 217, 255 } ) );
+}
+
+HOST_TEST( BlockDecoder, Etc2Differential )
+{
+    // R 20 - 2, G 10 + 3, B 31 + 0; tables 1 ( 5, 17 ) and 2 ( 9, 29 ), flipped
+    // indices: x0 y3 is 3, x1 y0 is 1, the rest 0
+    const uint8_t block[8] = { 0xa6, 0x53, 0xf8, 0x2b, 0x00, 0x08, 0x00, 0x18 };
+    DecodedBlock decoded( VK_FORMAT_ETC2_R8G8B8_SRGB_BLOCK, block );
+    CHECK( decoded.Is( 0, 0, { 170, 87, 255, 255 } ) );
+    CHECK( decoded.Is( 3, 1, { 170, 87, 255, 255 } ) );
+    CHECK( decoded.Is( 1, 0, { 182, 99, 255, 255 } ) );
+    CHECK( decoded.Is( 2, 2, { 157, 116, 255, 255 } ) );
+    CHECK( decoded.Is( 0, 3, { 119, 78, 226, 255 } ) );
+}
+
+HOST_TEST( BlockDecoder, Etc2T )
+{
+    // R 2 - 4 overflows: colors 8 4 c and 2 6 a, distance 5 ( 32 )
+    // indices: x0 y0..3 are 0..3, the rest 0
+    const uint8_t block[8] = { 0x14, 0x4c, 0x26, 0xab, 0x00, 0x0c, 0x00, 0x0a };
+    DecodedBlock decoded( VK_FORMAT_ETC2_R8G8B8_UNORM_BLOCK, block );
+    CHECK( decoded.Is( 0, 0, { 136, 68, 204, 255 } ) );
+    CHECK( decoded.Is( 0, 1, { 66, 134, 202, 255 } ) );
+    CHECK( decoded.Is( 0, 2, { 34, 102, 170, 255 } ) );
+    CHECK( decoded.Is( 0, 3, { 2, 70, 138, 255 } ) );
+    CHECK( decoded.Is( 3, 3, { 136, 68, 204, 255 } ) );
+}
+
+HOST_TEST( BlockDecoder, Etc2H )
+{
+    // G 1 - 4 overflows: colors 3 6 9 and c 5 3, distance 4 ( 23 ) as 369 < c53
+    // indices: x0 y0..3 are 0..3, the rest 0
+    const uint8_t block[8] = { 0x1b, 0x0c, 0xe2, 0x9e, 0x00, 0x0c, 0x00, 0x0a };
+    DecodedBlock decoded( VK_FORMAT_ETC2_R8G8B8_UNORM_BLOCK, block );
+    CHECK( decoded.Is( 0, 0, { 74, 125, 176, 255 } ) );
+    CHECK( decoded.Is( 0, 1, { 28, 79, 130, 255 } ) );
+    CHECK( decoded.Is( 0, 2, { 227, 108, 74, 255 } ) );
+    CHECK( decoded.Is( 0, 3, { 181, 62, 28, 255 } ) );
+    CHECK( decoded.Is( 2, 1, { 74, 125, 176, 255 } ) );
+}
+
+HOST_TEST( BlockDecoder, Etc2Planar )
+{
+    // B 0 - 4 overflows: O ( 32, 64, 0 ), H ( 48, 64, 0 ), V ( 32, 96, 0 ),
+    // red grows along x and green along y
+    const uint8_t block[8] = { 0x41, 0x00, 0x04, 0x62, 0x80, 0x04, 0x18, 0x00 };
+    DecodedBlock decoded( VK_FORMAT_ETC2_R8G8B8_UNORM_BLOCK, block );
+    CHECK( decoded.Is( 0, 0, { 130, 129, 0, 255 } ) );
+    CHECK( decoded.Is( 1, 0, { 146, 129, 0, 255 } ) );
+    CHECK( decoded.Is( 2, 1, { 163, 145, 0, 255 } ) );
+    CHECK( decoded.Is( 3, 2, { 179, 161, 0, 255 } ) );
+    CHECK( decoded.Is( 0, 3, { 130, 177, 0, 255 } ) );
+}
+
+HOST_TEST( BlockDecoder, EacAlpha )
+{
+    // alpha: base 128, multiplier 15, table 0; indices x0 y0..3 are 0, 3, 7, 4, the rest 0
+    // color: individual, all zero with table 0 index 0
+    const uint8_t block[16] = { 0x80, 0xf0, 0x0f, 0xc0, 0x00, 0x00, 0x00, 0x00,
+                                0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 };
+    DecodedBlock decoded( VK_FORMAT_ETC2_R8G8B8A8_UNORM_BLOCK, block );
+    CHECK( decoded.Is( 0, 0, { 2, 2, 2, 83 } ) );
+    CHECK( decoded.Alpha( 0, 1 ) == 0 );
+    CHECK( decoded.Alpha( 0, 2 ) == 255 );
+    CHECK( decoded.Alpha( 0, 3 ) == 158 );
+    CHECK( decoded.Alpha( 3, 3 ) == 83 );
+}
+
+HOST_TEST( BlockDecoder, Bc1FourColor )
+{
+    // c0 red > c1 blue; indices x0..3 y0 are 0..3, the rest 0
+    const uint8_t block[8] = { 0x00, 0xf8, 0x1f, 0x00, 0xe4, 0x00, 0x00, 0x00 };
+    DecodedBlock decoded( VK_FORMAT_BC1_RGB_UNORM_BLOCK, block );
+    CHECK( decoded.Is( 0, 0, { 255, 0, 0, 255 } ) );
+    CHECK( decoded.Is( 1, 0, { 0, 0, 255, 255 } ) );
+    CHECK( decoded.Is( 2, 0, { 170, 0, 85, 255 } ) );
+    CHECK( decoded.Is( 3, 0, { 85, 0, 170, 255 } ) );
+    CHECK( decoded.Is( 3, 3, { 255, 0, 0, 255 } ) );
+
+    // four colors never have a transparent texel
+    DecodedBlock rgba( VK_FORMAT_BC1_RGBA_UNORM_BLOCK, block );
+    CHECK( rgba.Is( 3, 0, { 85, 0, 170, 255 } ) );
+}
+
+HOST_TEST( BlockDecoder, Bc1ThreeColor )
+{
+    // c0 black <= c1 green 32; indices x0..3 y0 are 0..3, the rest 0
+    const uint8_t block[8] = { 0x00, 0x00, 0x00, 0x04, 0xe4, 0x00, 0x00, 0x00 };
+    DecodedBlock decoded( VK_FORMAT_BC1_RGB_SRGB_BLOCK, block );
+    CHECK( decoded.Is( 0, 0, { 0, 0, 0, 255 } ) );
+    CHECK( decoded.Is( 1, 0, { 0, 130, 0, 255 } ) );
+    CHECK( decoded.Is( 2, 0, { 0, 65, 0, 255 } ) );
+    CHECK( decoded.Is( 3, 0, { 0, 0, 0, 255 } ) );
+
+    // index 3 is punched through
+    DecodedBlock rgba( VK_FORMAT_BC1_RGBA_SRGB_BLOCK, block );
+    CHECK( rgba.Is( 2, 0, { 0, 65, 0, 255 } ) );
+    CHECK( rgba.Is( 3, 0, { 0, 0, 0, 0 } ) );
+}
+
+HOST_TEST( BlockDecoder, Bc3Alpha )
+{
+    // a0 70 > a1 0, eight alphas; indices x0..3 y0..1 are 0..7, the rest 0
+    // color: c0 black <= c1 green 63, still four colors in BC3
+    uint8_t block[16] = { 70, 0, 0x88, 0xc6, 0xfa, 0x00, 0x00, 0x00,
+                          0x00, 0x00, 0xe0, 0x07, 0xe4, 0x00, 0x00, 0x00 };
+    DecodedBlock eight( VK_FORMAT_BC3_UNORM_BLOCK, block );
+    CHECK( eight.Is( 0, 0, { 0, 0, 0, 70 } ) );
+    CHECK( eight.Is( 1, 0, { 0, 255, 0, 0 } ) );
+    CHECK( eight.Is( 2, 0, { 0, 85, 0, 60 } ) );
+    CHECK( eight.Is( 3, 0, { 0, 170, 0, 50 } ) );
+    CHECK( eight.Alpha( 0, 1 ) == 40 );
+    CHECK( eight.Alpha( 1, 1 ) == 30 );
+    CHECK( eight.Alpha( 2, 1 ) == 20 );
+    CHECK( eight.Alpha( 3, 1 ) == 10 );
+    CHECK( eight.Alpha( 3, 3 ) == 70 );
+
+    // a0 0 <= a1 100, six alphas then 0 and 255
+    block[0] = 0;
+    block[1] = 100;
+    DecodedBlock six( VK_FORMAT_BC3_SRGB_BLOCK, block );
+    CHECK( six.Is( 0, 0, { 0, 0, 0, 0 } ) );
+    CHECK( six.Alpha( 1, 0 ) == 100 );
+    CHECK( six.Alpha( 2, 0 ) == 20 );
+    CHECK( six.Alpha( 3, 0 ) == 40 );
+    CHECK( six.Alpha( 0, 1 ) == 60 );
+    CHECK( six.Alpha( 1, 1 ) == 80 );
+    CHECK( six.Alpha( 2, 1 ) == 0 );
+    CHECK( six.Alpha( 3, 1 ) == 255 );
+}
+
+HOST_TEST( BlockDecoder, PartialBlocks )
+{
+    // a 2x2 level keeps the top left of its block
+    const uint8_t block[8] = { 0x00, 0xf8, 0x1f, 0x00, 0xe4, 0x00, 0x00, 0x00 };
+    uint8_t rgba[2 * 2 * 4 + 1] = {};
+    rgba[2 * 2 * 4] = 0x5a;
+    DecodeBlocks( VK_FORMAT_BC1_RGB_UNORM_BLOCK, block, 2, 2, rgba );
+    CHECK( rgba[0] == 255 && rgba[2] == 0 );
+    CHECK( rgba[4] == 0 && rgba[6] == 255 );
+    CHECK( rgba[8] == 255 && rgba[12] == 255 );
+    CHECK( rgba[2 * 2 * 4] == 0x5a );
+}
@@ -0,0 +1,132 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include "DescriptorAllocator.h"
+#include "FakeVulkan.h"
+#include "HostTest.h"
+
+static const VkDevice kDevice = FakeHandle<VkDevice>( 1 );
+static const VkDescriptorSetLayout kLayout = FakeHandle<VkDescriptorSetLayout>( 2 );
+
+static std::vector<VkDescriptorPoolSize> UniformAndTexture( void )
+{
+    return { { VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1 }, { VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 2 } };
+}
+
+HOST_TEST( DescriptorAllocator, ChainGrowsWhenFull )
+{
+    ResetFakeVulkan();
+    DescriptorAllocator allocator;
+    allocator.Init( kDevice, UniformAndTexture(), 4, 2 );
+    CHECK( allocator.Stats().poolCount_ == 0 );
+
+    VkDescriptorSet set = VK_NULL_HANDLE;
+    for( uint32_t i = 0; i < 10; i++ )
+        CHECK( allocator.Allocate( kLayout, &set ) == VK_SUCCESS );
+    CHECK( set != VK_NULL_HANDLE );
+
+    // 4 + 4 + 2
+    DescriptorAllocatorStats stats = allocator.Stats();
+    CHECK( stats.poolCount_ == 3 );
+    CHECK( stats.poolGrowths_ == 3 );
+    CHECK( stats.allocations_ == 10 );
+    CHECK( fakeVulkan.descriptorPoolsCreated_ == 3 );
+    CHECK( fakeVulkan.descriptorSetsAllocated_ == 10 );
+
+    allocator.Shutdown();
+    CHECK( fakeVulkan.descriptorPoolsDestroyed_ == 3 );
+}
+
+HOST_TEST( DescriptorAllocator, FramePoolsAreReset )
+{
+    ResetFakeVulkan();
+    DescriptorAllocator allocator;
+    allocator.Init( kDevice, UniformAndTexture(), 4, 2 );
+
+    VkDescriptorSet set;
+    for( uint32_t i = 0; i < 10; i++ )
+        CHECK( allocator.AllocateFrame( 0, kLayout, &set ) == VK_SUCCESS );
+    CHECK( allocator.AllocateFrame( 1, kLayout, &set ) == VK_SUCCESS );
+    CHECK( allocator.Stats().poolCount_ == 4 );
+
+    // the frame comes around again: same pools, no new ones
+    allocator.ResetFrame( 0 );
+    CHECK( fakeVulkan.descriptorPoolResets_ == 3 );
+    for( uint32_t i = 0; i < 10; i++ )
+        CHECK( allocator.AllocateFrame( 0, kLayout, &set ) == VK_SUCCESS );
+    CHECK( allocator.Stats().poolGrowths_ == 4 );
+    CHECK( fakeVulkan.descriptorPoolsCreated_ == 4 );
+
+    // pools a frame did not get to are not reset
+    allocator.ResetFrame( 0 );
+    allocator.AllocateFrame( 0, kLayout, &set );
+    allocator.ResetFrame( 0 );
+    CHECK( allocator.Stats().frameResets_ == 3 + 3 + 1 );
+
+    // frame 1 never saw frame 0's resets
+    allocator.ResetFrame( 1 );
+    CHECK( allocator.Stats().frameResets_ == 3 + 3 + 1 + 1 );
+
+    allocator.Shutdown();
+    CHECK( fakeVulkan.descriptorPoolsDestroyed_ == 4 );
+}
+
+HOST_TEST( DescriptorAllocator, DriverOutOfPoolMemory )
+{
+    ResetFakeVulkan();
+    // the pools run out of descriptors after 3 of their 4 sets
+    fakeVulkan.descriptorPoolSetLimit_ = 3;
+    DescriptorAllocator allocator;
+    allocator.Init( kDevice, UniformAndTexture(), 4, 1 );
+
+    VkDescriptorSet set;
+    for( uint32_t i = 0; i < 7; i++ )
+        CHECK( allocator.Allocate( kLayout, &set ) == VK_SUCCESS );
+    CHECK( allocator.Stats().poolCount_ == 3 );
+    CHECK( allocator.Stats().allocations_ == 7 );
+
+    // a set no fresh pool can hold fails instead of growing the chain forever
+    fakeVulkan.descriptorPoolSetLimit_ = 0;
+    CHECK( allocator.Allocate( kLayout, &set ) == VK_ERROR_OUT_OF_POOL_MEMORY_KHR );
+    CHECK( allocator.Stats().poolCount_ == 4 );
+    allocator.Shutdown();
+}
+
+HOST_TEST( DescriptorAllocator, SetSizes )
+{
+    ResetFakeVulkan();
+    DescriptorAllocator allocator;
+    allocator.Init( kDevice, UniformAndTexture(), 8, 1 );
+    CHECK( allocator.SetSizes().size() == 2 );
+    CHECK( allocator.SetSizes()[1].descriptorCount == 2 );
+    allocator.Shutdown();
+
+    std::vector<VkDescriptorSetLayoutBinding> bindings = {
+        { 0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1, VK_SHADER_STAGE_VERTEX_BIT, nullptr },
+        { 1, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 4, VK_SHADER_STAGE_FRAGMENT_BIT, nullptr },
+        { 2, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 2, VK_SHADER_STAGE_FRAGMENT_BIT, nullptr },
+        // runtime sized, counted by its own table
+        { 3, VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, 0, VK_SHADER_STAGE_FRAGMENT_BIT, nullptr },
+    };
+    std::vector<VkDescriptorPoolSize> sizes = DescriptorSetSizes( bindings );
+    CHECK( sizes.size() == 2 );
+    if( sizes.size() == 2 )
+    {
+        CHECK( sizes[0].type == VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER && sizes[0].descriptorCount == 3 );
+        CHECK( sizes[1].type == VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER && sizes[1].descriptorCount == 4 );
+    }
+}
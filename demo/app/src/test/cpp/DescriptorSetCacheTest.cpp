@@ -0,0 +1,197 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include "DescriptorSetCache.h"
+#include "FakeVulkan.h"
+#include "HostTest.h"
+#include <cstring>
+
+static const VkDevice kDevice = FakeHandle<VkDevice>( 1 );
+static const VkDescriptorSetLayout kTexturedLayout = FakeHandle<VkDescriptorSetLayout>( 2 );
+static const VkDescriptorSetLayout kOtherLayout = FakeHandle<VkDescriptorSetLayout>( 3 );
+static const VkDescriptorSetLayout kTexelLayout = FakeHandle<VkDescriptorSetLayout>( 4 );
+
+// binding 0: uniform buffer, binding 1: two combined image samplers
+static std::vector<VkDescriptorSetLayoutBinding> TexturedBindings( void )
+{
+    return {
+        { 0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1, VK_SHADER_STAGE_VERTEX_BIT, nullptr },
+        { 1, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 2, VK_SHADER_STAGE_FRAGMENT_BIT, nullptr },
+    };
+}
+
+// the unused bytes of every resource are filled with fill
+static std::vector<DescriptorResource> TexturedResources( uint64_t imageView, uint8_t fill )
+{
+    std::vector<DescriptorResource> resources( 3 );
+    memset( resources.data(), fill, resources.size() * sizeof( DescriptorResource ) );
+    resources[0].buffer_ = { FakeHandle<VkBuffer>( 10 ), 256, 64 };
+    resources[1].image_.sampler = FakeHandle<VkSampler>( 11 );
+    resources[1].image_.imageView = FakeHandle<VkImageView>( imageView );
+    resources[1].image_.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    resources[2].image_.sampler = FakeHandle<VkSampler>( 11 );
+    resources[2].image_.imageView = FakeHandle<VkImageView>( 13 );
+    resources[2].image_.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    return resources;
+}
+
+struct CacheFixture
+{
+    explicit CacheFixture( bool useTemplates )
+    {
+        ResetFakeVulkan();
+        allocator_.Init( kDevice, DescriptorSetSizes( TexturedBindings() ), 16, 1 );
+        cache_.Init( kDevice, &allocator_, useTemplates );
+        CHECK( cache_.AddLayout( kTexturedLayout, TexturedBindings() ) == VK_SUCCESS );
+        CHECK( cache_.AddLayout( kOtherLayout, TexturedBindings() ) == VK_SUCCESS );
+    }
+
+    ~CacheFixture()
+    {
+        cache_.Shutdown();
+        allocator_.Shutdown();
+    }
+
+    VkDescriptorSet Get( VkDescriptorSetLayout layout, const std::vector<DescriptorResource>& resources )
+    {
+        return cache_.Get( layout, resources.data(), static_cast<uint32_t>( resources.size() ) );
+    }
+
+    DescriptorAllocator allocator_;
+    DescriptorSetCache cache_;
+};
+
+HOST_TEST( DescriptorSetCache, SameResourcesSameSet )
+{
+    CacheFixture fixture( false );
+    VkDescriptorSet set = fixture.Get( kTexturedLayout, TexturedResources( 12, 0x00 ) );
+    CHECK( set != VK_NULL_HANDLE );
+
+    // padding and the unused bytes of the union are not part of the key
+    CHECK( fixture.Get( kTexturedLayout, TexturedResources( 12, 0xff ) ) == set );
+
+    DescriptorSetCacheStats stats = fixture.cache_.Stats();
+    CHECK( stats.lookups_ == 2 );
+    CHECK( stats.hits_ == 1 );
+    CHECK( stats.sets_ == 1 );
+    CHECK( fixture.allocator_.Stats().allocations_ == 1 );
+}
+
+HOST_TEST( DescriptorSetCache, EveryHandleIsKey )
+{
+    CacheFixture fixture( false );
+    VkDescriptorSet set = fixture.Get( kTexturedLayout, TexturedResources( 12, 0 ) );
+
+    std::vector<DescriptorResource> resources = TexturedResources( 14, 0 );
+    CHECK( fixture.Get( kTexturedLayout, resources ) != set );
+    resources = TexturedResources( 12, 0 );
+    resources[0].buffer_.offset = 512;
+    CHECK( fixture.Get( kTexturedLayout, resources ) != set );
+    resources = TexturedResources( 12, 0 );
+    resources[0].buffer_.range = 128;
+    CHECK( fixture.Get( kTexturedLayout, resources ) != set );
+    resources = TexturedResources( 12, 0 );
+    resources[2].image_.sampler = FakeHandle<VkSampler>( 15 );
+    CHECK( fixture.Get( kTexturedLayout, resources ) != set );
+    resources = TexturedResources( 12, 0 );
+    resources[1].image_.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+    CHECK( fixture.Get( kTexturedLayout, resources ) != set );
+    // same resources, other layout
+    CHECK( fixture.Get( kOtherLayout, TexturedResources( 12, 0 ) ) != set );
+
+    CHECK( fixture.cache_.Stats().hits_ == 0 );
+    CHECK( fixture.cache_.Stats().sets_ == 7 );
+}
+
+HOST_TEST( DescriptorSetCache, FlushBatchesWrites )
+{
+    CacheFixture fixture( false );
+    VkDescriptorSet first = fixture.Get( kTexturedLayout, TexturedResources( 12, 0 ) );
+    VkDescriptorSet second = fixture.Get( kTexturedLayout, TexturedResources( 14, 0 ) );
+    CHECK( fakeVulkan.updateDescriptorSetsCalls_ == 0 );
+
+    // one call, one write per binding of each new set
+    fixture.cache_.Flush();
+    CHECK( fakeVulkan.updateDescriptorSetsCalls_ == 1 );
+    CHECK( fakeVulkan.descriptorWrites_.size() == 4 );
+    if( fakeVulkan.descriptorWrites_.size() == 4 )
+    {
+        const VkWriteDescriptorSet& buffer = fakeVulkan.descriptorWrites_[0];
+        CHECK( buffer.dstSet == first && buffer.dstBinding == 0 && buffer.descriptorCount == 1 );
+        CHECK( buffer.pBufferInfo && buffer.pBufferInfo->offset == 256 && !buffer.pImageInfo );
+        const VkWriteDescriptorSet& images = fakeVulkan.descriptorWrites_[3];
+        CHECK( images.dstSet == second && images.dstBinding == 1 && images.descriptorCount == 2 );
+        CHECK( images.pImageInfo && images.pImageInfo[0].imageView == FakeHandle<VkImageView>( 14 ) && !images.pBufferInfo );
+    }
+
+    // hits write nothing
+    fixture.Get( kTexturedLayout, TexturedResources( 12, 0 ) );
+    fixture.cache_.Flush();
+    CHECK( fakeVulkan.updateDescriptorSetsCalls_ == 1 );
+}
+
+HOST_TEST( DescriptorSetCache, TemplateUpdates )
+{
+    CacheFixture fixture( true );
+    CHECK( fakeVulkan.updateTemplatesCreated_ == 2 );
+    // bindings laid out one after the other in the resource array
+    CHECK( fakeVulkan.updateTemplateEntries_.size() == 2 );
+    if( fakeVulkan.updateTemplateEntries_.size() == 2 )
+    {
+        CHECK( fakeVulkan.updateTemplateEntries_[0].offset == 0 );
+        CHECK( fakeVulkan.updateTemplateEntries_[1].dstBinding == 1 );
+        CHECK( fakeVulkan.updateTemplateEntries_[1].descriptorCount == 2 );
+        CHECK( fakeVulkan.updateTemplateEntries_[1].offset == sizeof( DescriptorResource ) );
+        CHECK( fakeVulkan.updateTemplateEntries_[1].stride == sizeof( DescriptorResource ) );
+    }
+
+    VkDescriptorSet first = fixture.Get( kTexturedLayout, TexturedResources( 12, 0 ) );
+    VkDescriptorSet second = fixture.Get( kOtherLayout, TexturedResources( 12, 0 ) );
+    fixture.cache_.Flush();
+    CHECK( fakeVulkan.updateDescriptorSetsCalls_ == 0 );
+    CHECK( fakeVulkan.templateUpdates_.size() == 2 );
+    if( fakeVulkan.templateUpdates_.size() == 2 )
+        CHECK( fakeVulkan.templateUpdates_[0] == first && fakeVulkan.templateUpdates_[1] == second );
+    CHECK( fixture.cache_.Stats().updateCalls_ == 2 );
+
+    // a layout without descriptors gets no template
+    CHECK( fixture.cache_.AddLayout( kTexelLayout, {} ) == VK_SUCCESS );
+    CHECK( fakeVulkan.updateTemplatesCreated_ == 2 );
+
+    fixture.cache_.Shutdown();
+    CHECK( fakeVulkan.updateTemplatesDestroyed_ == 2 );
+}
+
+HOST_TEST( DescriptorSetCache, TexelBufferWrites )
+{
+    std::vector<VkDescriptorSetLayoutBinding> bindings = {
+        { 0, VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER, 2, VK_SHADER_STAGE_VERTEX_BIT, nullptr },
+    };
+    DescriptorResource resources[2];
+    resources[0].texelBufferView_ = FakeHandle<VkBufferView>( 20 );
+    resources[1].texelBufferView_ = FakeHandle<VkBufferView>( 21 );
+
+    // buffer views are not contiguous in the resource array, a write each
+    std::vector<VkWriteDescriptorSet> writes;
+    AppendDescriptorWrites( FakeHandle<VkDescriptorSet>( 5 ), bindings, resources, &writes );
+    CHECK( writes.size() == 2 );
+    if( writes.size() == 2 )
+    {
+        CHECK( writes[1].dstArrayElement == 1 && writes[1].descriptorCount == 1 );
+        CHECK( writes[1].pTexelBufferView && *writes[1].pTexelBufferView == FakeHandle<VkBufferView>( 21 ) );
+    }
+}
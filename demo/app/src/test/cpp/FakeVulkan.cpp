@@ -0,0 +1,371 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include "FakeVulkan.h"
+#include <cstring>
+#include <map>
+#include <memory>
+
+FakeVulkan fakeVulkan;
+
+namespace
+{
+const VkDeviceSize kHeapSize = 64ull * 1024 * 1024;
+
+struct FakeMemory
+{
+    uint32_t memoryType_;
+    std::unique_ptr<uint8_t[]> data_;
+    bool mapped_;
+};
+
+struct FakeBuffer
+{
+    VkBufferCreateInfo info_;
+    VkDeviceMemory memory_;
+    VkDeviceSize offset_;
+};
+
+struct FakeBufferCopy
+{
+    VkBuffer src_;
+    VkBuffer dst_;
+    VkBufferCopy region_;
+};
+
+struct FakeDescriptorPool
+{
+    uint32_t maxSets_;
+    uint32_t sets_;
+};
+
+// handles far from the small values tests use with FakeHandle()
+uint64_t nextHandle = 0x100000;
+std::map<VkDeviceMemory, FakeMemory> memories;
+std::map<VkBuffer, FakeBuffer> buffers;
+std::map<VkCommandBuffer, std::vector<FakeBufferCopy>> recordedCopies;
+std::map<VkDescriptorPool, FakeDescriptorPool> descriptorPools;
+}
+
+template <typename T>
+static T NewHandle( void )
+{
+    return reinterpret_cast<T>( nextHandle++ );
+}
+
+void ResetFakeVulkan( void )
+{
+    fakeVulkan = FakeVulkan();
+    fakeVulkan.bufferImageGranularity_ = 1;
+    fakeVulkan.minUniformBufferOffsetAlignment_ = 256;
+    fakeVulkan.bufferAlignment_ = 16;
+    fakeVulkan.descriptorPoolSetLimit_ = ~0u;
+    memories.clear();
+    buffers.clear();
+    recordedCopies.clear();
+    descriptorPools.clear();
+}
+
+const VkBufferCreateInfo& FakeBufferInfo( VkBuffer buffer )
+{
+    return buffers.at( buffer ).info_;
+}
+
+uint8_t* FakeBufferMemory( VkBuffer buffer )
+{
+    const FakeBuffer& fake = buffers.at( buffer );
+    return memories.at( fake.memory_ ).data_.get() + fake.offset_;
+}
+
+void vkGetPhysicalDeviceProperties( VkPhysicalDevice, VkPhysicalDeviceProperties* pProperties )
+{
+    pProperties->apiVersion = 0;
+    pProperties->limits.bufferImageGranularity = fakeVulkan.bufferImageGranularity_;
+    pProperties->limits.minUniformBufferOffsetAlignment = fakeVulkan.minUniformBufferOffsetAlignment_;
+}
+
+void vkGetPhysicalDeviceMemoryProperties( VkPhysicalDevice, VkPhysicalDeviceMemoryProperties* pMemoryProperties )
+{
+    *pMemoryProperties = VkPhysicalDeviceMemoryProperties();
+    pMemoryProperties->memoryTypeCount = 2;
+    pMemoryProperties->memoryTypes[0] = { VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, 0 };
+    pMemoryProperties->memoryTypes[1] = { VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, 1 };
+    pMemoryProperties->memoryHeapCount = 2;
+    pMemoryProperties->memoryHeaps[0] = { kHeapSize, 0 };
+    pMemoryProperties->memoryHeaps[1] = { kHeapSize, 0 };
+}
+
+VkResult vkAllocateMemory( VkDevice, const VkMemoryAllocateInfo* pAllocateInfo, const VkAllocationCallbacks*, VkDeviceMemory* pMemory )
+{
+    if( pAllocateInfo->memoryTypeIndex > 1 || pAllocateInfo->allocationSize > kHeapSize )
+        return VK_ERROR_OUT_OF_DEVICE_MEMORY;
+    *pMemory = NewHandle<VkDeviceMemory>();
+    FakeMemory& memory = memories[*pMemory];
+    memory.memoryType_ = pAllocateInfo->memoryTypeIndex;
+    memory.data_.reset( new uint8_t[pAllocateInfo->allocationSize]() );
+    memory.mapped_ = false;
+    fakeVulkan.memoryAllocations_++;
+    return VK_SUCCESS;
+}
+
+void vkFreeMemory( VkDevice, VkDeviceMemory memory, const VkAllocationCallbacks* )
+{
+    memories.erase( memory );
+    fakeVulkan.memoryAllocations_--;
+}
+
+VkResult vkMapMemory( VkDevice, VkDeviceMemory memory, VkDeviceSize offset, VkDeviceSize, VkMemoryMapFlags, void** ppData )
+{
+    FakeMemory& fake = memories.at( memory );
+    if( fake.memoryType_ != 1 || fake.mapped_ )
+        return VK_ERROR_MEMORY_MAP_FAILED;
+    fake.mapped_ = true;
+    *ppData = fake.data_.get() + offset;
+    return VK_SUCCESS;
+}
+
+void vkUnmapMemory( VkDevice, VkDeviceMemory memory )
+{
+    memories.at( memory ).mapped_ = false;
+}
+
+VkResult vkBindBufferMemory( VkDevice, VkBuffer buffer, VkDeviceMemory memory, VkDeviceSize memoryOffset )
+{
+    FakeBuffer& fake = buffers.at( buffer );
+    fake.memory_ = memory;
+    fake.offset_ = memoryOffset;
+    return VK_SUCCESS;
+}
+
+VkResult vkBindImageMemory( VkDevice, VkImage, VkDeviceMemory, VkDeviceSize )
+{
+    return VK_SUCCESS;
+}
+
+void vkGetBufferMemoryRequirements( VkDevice, VkBuffer buffer, VkMemoryRequirements* pMemoryRequirements )
+{
+    VkDeviceSize alignment = fakeVulkan.bufferAlignment_;
+    pMemoryRequirements->size = ( buffers.at( buffer ).info_.size + alignment - 1 ) / alignment * alignment;
+    pMemoryRequirements->alignment = alignment;
+    pMemoryRequirements->memoryTypeBits = 0x3;
+}
+
+void vkGetImageMemoryRequirements( VkDevice, VkImage, VkMemoryRequirements* pMemoryRequirements )
+{
+    pMemoryRequirements->size = 64 * 1024;
+    pMemoryRequirements->alignment = 4096;
+    pMemoryRequirements->memoryTypeBits = 0x1;
+}
+
+VkResult vkCreateBuffer( VkDevice, const VkBufferCreateInfo* pCreateInfo, const VkAllocationCallbacks*, VkBuffer* pBuffer )
+{
+    *pBuffer = NewHandle<VkBuffer>();
+    buffers[*pBuffer] = { *pCreateInfo, VK_NULL_HANDLE, 0 };
+    fakeVulkan.buffers_++;
+    return VK_SUCCESS;
+}
+
+void vkDestroyBuffer( VkDevice, VkBuffer buffer, const VkAllocationCallbacks* )
+{
+    buffers.erase( buffer );
+    fakeVulkan.buffers_--;
+}
+
+VkResult vkCreateCommandPool( VkDevice, const VkCommandPoolCreateInfo*, const VkAllocationCallbacks*, VkCommandPool* pCommandPool )
+{
+    *pCommandPool = NewHandle<VkCommandPool>();
+    return VK_SUCCESS;
+}
+
+void vkDestroyCommandPool( VkDevice, VkCommandPool, const VkAllocationCallbacks* )
+{
+}
+
+VkResult vkResetCommandPool( VkDevice, VkCommandPool, VkCommandPoolResetFlags )
+{
+    return VK_SUCCESS;
+}
+
+VkResult vkAllocateCommandBuffers( VkDevice, const VkCommandBufferAllocateInfo* pAllocateInfo, VkCommandBuffer* pCommandBuffers )
+{
+    for( uint32_t i = 0; i < pAllocateInfo->commandBufferCount; i++ )
+        pCommandBuffers[i] = NewHandle<VkCommandBuffer>();
+    return VK_SUCCESS;
+}
+
+VkResult vkBeginCommandBuffer( VkCommandBuffer commandBuffer, const VkCommandBufferBeginInfo* )
+{
+    recordedCopies[commandBuffer].clear();
+    return VK_SUCCESS;
+}
+
+VkResult vkEndCommandBuffer( VkCommandBuffer )
+{
+    return VK_SUCCESS;
+}
+
+VkResult vkCreateFence( VkDevice, const VkFenceCreateInfo*, const VkAllocationCallbacks*, VkFence* pFence )
+{
+    *pFence = NewHandle<VkFence>();
+    return VK_SUCCESS;
+}
+
+void vkDestroyFence( VkDevice, VkFence, const VkAllocationCallbacks* )
+{
+}
+
+VkResult vkResetFences( VkDevice, uint32_t, const VkFence* )
+{
+    return VK_SUCCESS;
+}
+
+VkResult vkGetFenceStatus( VkDevice, VkFence )
+{
+    return VK_SUCCESS;
+}
+
+VkResult vkWaitForFences( VkDevice, uint32_t, const VkFence*, VkBool32, uint64_t )
+{
+    return VK_SUCCESS;
+}
+
+VkResult vkQueueSubmit( VkQueue, uint32_t submitCount, const VkSubmitInfo* pSubmits, VkFence )
+{
+    for( uint32_t i = 0; i < submitCount; i++ )
+    {
+        for( uint32_t j = 0; j < pSubmits[i].commandBufferCount; j++ )
+        {
+            for( const FakeBufferCopy& copy : recordedCopies[pSubmits[i].pCommandBuffers[j]] )
+            {
+                memcpy( FakeBufferMemory( copy.dst_ ) + copy.region_.dstOffset, FakeBufferMemory( copy.src_ ) + copy.region_.srcOffset,
+                        copy.region_.size );
+                fakeVulkan.bufferCopyRegions_++;
+            }
+        }
+    }
+    fakeVulkan.queueSubmits_++;
+    return VK_SUCCESS;
+}
+
+void vkCmdPipelineBarrier( VkCommandBuffer, VkPipelineStageFlags, VkPipelineStageFlags, VkDependencyFlags, uint32_t, const VkMemoryBarrier*, uint32_t,
+                           const VkBufferMemoryBarrier*, uint32_t, const VkImageMemoryBarrier* )
+{
+}
+
+void vkCmdCopyBuffer( VkCommandBuffer commandBuffer, VkBuffer srcBuffer, VkBuffer dstBuffer, uint32_t regionCount, const VkBufferCopy* pRegions )
+{
+    for( uint32_t i = 0; i < regionCount; i++ )
+        recordedCopies[commandBuffer].push_back( { srcBuffer, dstBuffer, pRegions[i] } );
+}
+
+void vkCmdCopyBufferToImage( VkCommandBuffer, VkBuffer, VkImage, VkImageLayout, uint32_t, const VkBufferImageCopy* )
+{
+}
+
+void vkCmdBlitImage( VkCommandBuffer, VkImage, VkImageLayout, VkImage, VkImageLayout, uint32_t, const VkImageBlit*, VkFilter )
+{
+}
+
+void vkCmdBindVertexBuffers( VkCommandBuffer, uint32_t firstBinding, uint32_t bindingCount, const VkBuffer* pBuffers, const VkDeviceSize* pOffsets )
+{
+    if( firstBinding == 0 && bindingCount )
+    {
+        fakeVulkan.vertexBuffer_ = pBuffers[0];
+        fakeVulkan.vertexBufferOffset_ = pOffsets[0];
+    }
+}
+
+void vkCmdBindIndexBuffer( VkCommandBuffer, VkBuffer buffer, VkDeviceSize offset, VkIndexType indexType )
+{
+    fakeVulkan.indexBuffer_ = buffer;
+    fakeVulkan.indexBufferOffset_ = offset;
+    fakeVulkan.indexType_ = indexType;
+}
+
+void vkCmdDraw( VkCommandBuffer, uint32_t vertexCount, uint32_t instanceCount, uint32_t, uint32_t )
+{
+    fakeVulkan.draws_++;
+    fakeVulkan.drawCount_ = vertexCount;
+    fakeVulkan.drawInstances_ = instanceCount;
+}
+
+void vkCmdDrawIndexed( VkCommandBuffer, uint32_t indexCount, uint32_t instanceCount, uint32_t, int32_t, uint32_t )
+{
+    fakeVulkan.indexedDraws_++;
+    fakeVulkan.drawCount_ = indexCount;
+    fakeVulkan.drawInstances_ = instanceCount;
+}
+
+VkResult vkCreateDescriptorPool( VkDevice, const VkDescriptorPoolCreateInfo* pCreateInfo, const VkAllocationCallbacks*, VkDescriptorPool* pDescriptorPool )
+{
+    *pDescriptorPool = NewHandle<VkDescriptorPool>();
+    descriptorPools[*pDescriptorPool] = { pCreateInfo->maxSets, 0 };
+    fakeVulkan.descriptorPoolsCreated_++;
+    return VK_SUCCESS;
+}
+
+void vkDestroyDescriptorPool( VkDevice, VkDescriptorPool descriptorPool, const VkAllocationCallbacks* )
+{
+    descriptorPools.erase( descriptorPool );
+    fakeVulkan.descriptorPoolsDestroyed_++;
+}
+
+VkResult vkResetDescriptorPool( VkDevice, VkDescriptorPool descriptorPool, VkDescriptorPoolResetFlags )
+{
+    descriptorPools.at( descriptorPool ).sets_ = 0;
+    fakeVulkan.descriptorPoolResets_++;
+    return VK_SUCCESS;
+}
+
+VkResult vkAllocateDescriptorSets( VkDevice, const VkDescriptorSetAllocateInfo* pAllocateInfo, VkDescriptorSet* pDescriptorSets )
+{
+    FakeDescriptorPool& pool = descriptorPools.at( pAllocateInfo->descriptorPool );
+    if( pool.sets_ + pAllocateInfo->descriptorSetCount > pool.maxSets_ ||
+        pool.sets_ + pAllocateInfo->descriptorSetCount > fakeVulkan.descriptorPoolSetLimit_ )
+        return VK_ERROR_OUT_OF_POOL_MEMORY_KHR;
+    for( uint32_t i = 0; i < pAllocateInfo->descriptorSetCount; i++ )
+        pDescriptorSets[i] = NewHandle<VkDescriptorSet>();
+    pool.sets_ += pAllocateInfo->descriptorSetCount;
+    fakeVulkan.descriptorSetsAllocated_ += pAllocateInfo->descriptorSetCount;
+    return VK_SUCCESS;
+}
+
+void vkUpdateDescriptorSets( VkDevice, uint32_t descriptorWriteCount, const VkWriteDescriptorSet* pDescriptorWrites, uint32_t, const VkCopyDescriptorSet* )
+{
+    fakeVulkan.descriptorWrites_.insert( fakeVulkan.descriptorWrites_.end(), pDescriptorWrites, pDescriptorWrites + descriptorWriteCount );
+    fakeVulkan.updateDescriptorSetsCalls_++;
+}
+
+VkResult vkCreateDescriptorUpdateTemplateKHR( VkDevice, const VkDescriptorUpdateTemplateCreateInfoKHR* pCreateInfo, const VkAllocationCallbacks*,
+                                              VkDescriptorUpdateTemplateKHR* pDescriptorUpdateTemplate )
+{
+    *pDescriptorUpdateTemplate = NewHandle<VkDescriptorUpdateTemplateKHR>();
+    fakeVulkan.updateTemplateEntries_.assign( pCreateInfo->pDescriptorUpdateEntries,
+                                              pCreateInfo->pDescriptorUpdateEntries + pCreateInfo->descriptorUpdateEntryCount );
+    fakeVulkan.updateTemplatesCreated_++;
+    return VK_SUCCESS;
+}
+
+void vkDestroyDescriptorUpdateTemplateKHR( VkDevice, VkDescriptorUpdateTemplateKHR, const VkAllocationCallbacks* )
+{
+    fakeVulkan.updateTemplatesDestroyed_++;
+}
+
+void vkUpdateDescriptorSetWithTemplateKHR( VkDevice, VkDescriptorSet descriptorSet, VkDescriptorUpdateTemplateKHR, const void* )
+{
+    fakeVulkan.templateUpdates_.push_back( descriptorSet );
+}
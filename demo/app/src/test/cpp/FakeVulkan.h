@@ -0,0 +1,86 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#ifndef TUTORIAL06_TEXTURE_FAKEVULKAN_H
+#define TUTORIAL06_TEXTURE_FAKEVULKAN_H
+
+#include <vulkan_wrapper.h>
+#include <vector>
+
+/*
+ * FakeVulkan
+ *   What the host implementations of the Vulkan functions did, for the
+ *   tests to check. Handles are unique and never VK_NULL_HANDLE.
+ *   ResetFakeVulkan() starts over; objects created before are forgotten.
+ *
+ *   The fake GPU has two 64 MB heaps: memory type 0 is device local, type 1
+ *   host visible and coherent. Every allocation is backed by host memory,
+ *   so tests can read what ended up in a buffer of either type.
+ *   Buffer copies recorded into a command buffer happen when it is
+ *   submitted; fences are always signaled.
+ */
+struct FakeVulkan
+{
+    VkDeviceSize bufferImageGranularity_;
+    VkDeviceSize minUniformBufferOffsetAlignment_;
+    VkDeviceSize bufferAlignment_;  // VkMemoryRequirements::alignment of every buffer
+    uint32_t memoryAllocations_;    // live vkAllocateMemory allocations
+    uint32_t buffers_;              // live buffers
+
+    uint32_t queueSubmits_;
+    uint32_t bufferCopyRegions_;    // copied by submitted command buffers
+    VkBuffer vertexBuffer_;         // bound to binding 0 by the last vkCmdBindVertexBuffers
+    VkDeviceSize vertexBufferOffset_;
+    VkBuffer indexBuffer_;          // of the last vkCmdBindIndexBuffer
+    VkDeviceSize indexBufferOffset_;
+    VkIndexType indexType_;
+    uint32_t draws_;                // vkCmdDraw calls
+    uint32_t indexedDraws_;         // vkCmdDrawIndexed calls
+    uint32_t drawCount_;            // vertices or indices of the last draw
+    uint32_t drawInstances_;
+
+    uint32_t descriptorPoolsCreated_;
+    uint32_t descriptorPoolsDestroyed_;
+    uint32_t descriptorPoolResets_;
+    uint32_t descriptorSetsAllocated_;
+    // sets a pool holds before VK_ERROR_OUT_OF_POOL_MEMORY_KHR when lower than its maxSets, as if its descriptors ran out
+    uint32_t descriptorPoolSetLimit_;
+
+    uint32_t updateDescriptorSetsCalls_;
+    std::vector<VkWriteDescriptorSet> descriptorWrites_; // of every vkUpdateDescriptorSets call
+    uint32_t updateTemplatesCreated_;
+    uint32_t updateTemplatesDestroyed_;
+    std::vector<VkDescriptorUpdateTemplateEntryKHR> updateTemplateEntries_; // of the last template created
+    std::vector<VkDescriptorSet> templateUpdates_;                          // sets written through a template
+};
+
+extern FakeVulkan fakeVulkan;
+
+void ResetFakeVulkan( void );
+
+const VkBufferCreateInfo& FakeBufferInfo( VkBuffer buffer );
+// Host copy of the memory buffer is bound to, from the buffer's first byte
+uint8_t* FakeBufferMemory( VkBuffer buffer );
+
+// Handle of some object the code under test only passes on
+template <typename T>
+T FakeHandle( uint64_t value )
+{
+    return reinterpret_cast<T>( value );
+}
+
+#endif // TUTORIAL06_TEXTURE_FAKEVULKAN_H
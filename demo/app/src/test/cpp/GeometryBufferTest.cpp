@@ -0,0 +1,162 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include "GeometryBuffer.h"
+#include "FakeVulkan.h"
+#include "HostTest.h"
+#include <cstring>
+
+static const VkPhysicalDevice kGpu = FakeHandle<VkPhysicalDevice>( 1 );
+static const VkDevice kDevice = FakeHandle<VkDevice>( 2 );
+static const VkQueue kQueue = FakeHandle<VkQueue>( 3 );
+static const VkCommandBuffer kCmdBuffer = FakeHandle<VkCommandBuffer>( 4 );
+
+// three vertices of three uint16_t, 6 bytes each
+static const uint16_t kVertices[] = { 1, 2, 3, 4, 5, 6, 7, 8, 9 };
+static const uint16_t kIndices16[] = { 0, 1, 2, 2, 1, 0 };
+static const uint32_t kIndices32[] = { 2, 1, 0 };
+
+struct GeometryFixture
+{
+    GeometryFixture( void )
+    {
+        ResetFakeVulkan();
+        allocator_.Init( kGpu, kDevice );
+        uploads_.Init( kDevice, kQueue, 0, &allocator_, 64 * 1024 );
+    }
+
+    ~GeometryFixture()
+    {
+        uploads_.Shutdown();
+        allocator_.Shutdown();
+        CHECK( fakeVulkan.buffers_ == 0 );
+        CHECK( fakeVulkan.memoryAllocations_ == 0 );
+    }
+
+    bool Create( uint32_t vertexCount, const void* indices, VkIndexType indexType, uint32_t indexCount, GeometryMemory memory,
+                 GeometryBuffer* geometry )
+    {
+        GeometryData data = { kVertices, 6, vertexCount, indices, indexType, indexCount };
+        return CreateGeometryBuffer( kDevice, &allocator_, &uploads_, data, memory, geometry ) == VK_SUCCESS;
+    }
+
+    MemoryAllocator allocator_;
+    UploadQueue uploads_;
+};
+
+HOST_TEST( GeometryBuffer, IndexOffsetAlignment )
+{
+    GeometryFixture fixture;
+    GeometryBuffer geometry;
+
+    // 6 bytes of vertices, 16 bit indices start at 8
+    CHECK( fixture.Create( 1, kIndices16, VK_INDEX_TYPE_UINT16, 6, GEOMETRY_MEMORY_HOST_VISIBLE, &geometry ) );
+    CHECK( geometry.indexOffset_ == 8 );
+    CHECK( FakeBufferInfo( geometry.buffer_ ).size == 8 + 6 * 2 );
+    DestroyGeometryBuffer( kDevice, &fixture.allocator_, &geometry );
+
+    // 18 bytes of vertices, 32 bit indices start at 20
+    CHECK( fixture.Create( 3, kIndices32, VK_INDEX_TYPE_UINT32, 3, GEOMETRY_MEMORY_HOST_VISIBLE, &geometry ) );
+    CHECK( geometry.indexOffset_ == 20 );
+    CHECK( geometry.indexOffset_ % 4 == 0 );
+    CHECK( FakeBufferInfo( geometry.buffer_ ).size == 20 + 3 * 4 );
+    DestroyGeometryBuffer( kDevice, &fixture.allocator_, &geometry );
+
+    // 12 bytes of vertices need no padding
+    CHECK( fixture.Create( 2, kIndices16, VK_INDEX_TYPE_UINT16, 6, GEOMETRY_MEMORY_HOST_VISIBLE, &geometry ) );
+    CHECK( geometry.indexOffset_ == 12 );
+    DestroyGeometryBuffer( kDevice, &fixture.allocator_, &geometry );
+}
+
+HOST_TEST( GeometryBuffer, HostVisibleContents )
+{
+    GeometryFixture fixture;
+    GeometryBuffer geometry;
+    CHECK( fixture.Create( 3, kIndices32, VK_INDEX_TYPE_UINT32, 3, GEOMETRY_MEMORY_HOST_VISIBLE, &geometry ) );
+
+    const VkBufferCreateInfo& info = FakeBufferInfo( geometry.buffer_ );
+    CHECK( info.usage == ( VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT ) );
+    // written in place, nothing was staged
+    const uint8_t* memory = FakeBufferMemory( geometry.buffer_ );
+    CHECK( memcmp( memory, kVertices, sizeof( kVertices ) ) == 0 );
+    CHECK( memcmp( memory + geometry.indexOffset_, kIndices32, sizeof( kIndices32 ) ) == 0 );
+    fixture.uploads_.Flush();
+    CHECK( fakeVulkan.queueSubmits_ == 0 );
+
+    DestroyGeometryBuffer( kDevice, &fixture.allocator_, &geometry );
+    CHECK( geometry.buffer_ == VK_NULL_HANDLE );
+}
+
+HOST_TEST( GeometryBuffer, DeviceLocalContents )
+{
+    GeometryFixture fixture;
+    GeometryBuffer geometry;
+    CHECK( fixture.Create( 1, kIndices16, VK_INDEX_TYPE_UINT16, 6, GEOMETRY_MEMORY_DEVICE_LOCAL, &geometry ) );
+
+    const VkBufferCreateInfo& info = FakeBufferInfo( geometry.buffer_ );
+    CHECK( info.usage == ( VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT ) );
+
+    // the copies land with the next flush, at the aligned index offset
+    const uint8_t* memory = FakeBufferMemory( geometry.buffer_ );
+    const uint8_t zeros[8 + sizeof( kIndices16 )] = {};
+    CHECK( memcmp( memory, zeros, sizeof( zeros ) ) == 0 );
+    fixture.uploads_.Flush();
+    CHECK( fakeVulkan.bufferCopyRegions_ == 2 );
+    CHECK( memcmp( memory, kVertices, 6 ) == 0 );
+    CHECK( memcmp( memory + 8, kIndices16, sizeof( kIndices16 ) ) == 0 );
+
+    DestroyGeometryBuffer( kDevice, &fixture.allocator_, &geometry );
+}
+
+HOST_TEST( GeometryBuffer, WithoutIndices )
+{
+    GeometryFixture fixture;
+    GeometryBuffer geometry;
+    CHECK( fixture.Create( 3, nullptr, VK_INDEX_TYPE_UINT16, 6, GEOMETRY_MEMORY_HOST_VISIBLE, &geometry ) );
+    CHECK( geometry.indexCount_ == 0 );
+    CHECK( FakeBufferInfo( geometry.buffer_ ).size == 20 );
+    CHECK( FakeBufferInfo( geometry.buffer_ ).usage == VK_BUFFER_USAGE_VERTEX_BUFFER_BIT );
+
+    BindGeometryBuffer( kCmdBuffer, geometry );
+    DrawGeometryBuffer( kCmdBuffer, geometry, 2 );
+    CHECK( fakeVulkan.vertexBuffer_ == geometry.buffer_ );
+    CHECK( fakeVulkan.indexBuffer_ == VK_NULL_HANDLE );
+    CHECK( fakeVulkan.draws_ == 1 && fakeVulkan.indexedDraws_ == 0 );
+    CHECK( fakeVulkan.drawCount_ == 3 && fakeVulkan.drawInstances_ == 2 );
+
+    DestroyGeometryBuffer( kDevice, &fixture.allocator_, &geometry );
+}
+
+HOST_TEST( GeometryBuffer, BindAndDraw )
+{
+    GeometryFixture fixture;
+    GeometryBuffer geometry;
+    CHECK( fixture.Create( 1, kIndices16, VK_INDEX_TYPE_UINT16, 6, GEOMETRY_MEMORY_DEVICE_LOCAL, &geometry ) );
+
+    BindGeometryBuffer( kCmdBuffer, geometry );
+    DrawGeometryBuffer( kCmdBuffer, geometry, 1 );
+    CHECK( fakeVulkan.vertexBuffer_ == geometry.buffer_ && fakeVulkan.vertexBufferOffset_ == 0 );
+    CHECK( fakeVulkan.indexBuffer_ == geometry.buffer_ );
+    CHECK( fakeVulkan.indexBufferOffset_ == 8 );
+    CHECK( fakeVulkan.indexType_ == VK_INDEX_TYPE_UINT16 );
+    CHECK( fakeVulkan.indexedDraws_ == 1 && fakeVulkan.draws_ == 0 );
+    CHECK( fakeVulkan.drawCount_ == 6 );
+
+    // the copies must have run before the buffer goes
+    fixture.uploads_.Flush();
+    DestroyGeometryBuffer( kDevice, &fixture.allocator_, &geometry );
+}
@@ -0,0 +1,60 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include "HostTest.h"
+#include <cstdio>
+#include <cstring>
+
+// constant initialized, so tests of every file can register before main() in any order
+static HostTest* tests = nullptr;
+static HostTest** lastTest = &tests;
+static int failures = 0;
+
+HostTest::HostTest( const char* group, const char* name, void ( *run )( void ) ) : group_( group ), name_( name ), run_( run ), next_( nullptr )
+{
+    *lastTest = this;
+    lastTest = &next_;
+}
+
+void HostTestCheck( bool passed, const char* condition, const char* file, int line )
+{
+    if( passed )
+        return;
+    printf( "%s:%d: CHECK( %s ) failed\n", file, line, condition );
+    failures++;
+}
+
+int main( int argc, char** argv )
+{
+    const char* group = argc > 1 ? argv[1] : nullptr;
+    int run = 0;
+    for( HostTest* test = tests; test; test = test->next_ )
+    {
+        if( group && strcmp( group, test->group_ ) != 0 )
+            continue;
+        int failuresBefore = failures;
+        test->run_();
+        printf( "%s %s.%s\n", failures == failuresBefore ? "passed" : "FAILED", test->group_, test->name_ );
+        run++;
+    }
+    if( run == 0 )
+    {
+        printf( "no tests in group %s\n", group ? group : "" );
+        return 1;
+    }
+    return failures ? 1 : 0;
+}
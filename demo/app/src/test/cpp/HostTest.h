@@ -0,0 +1,47 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#ifndef TUTORIAL06_TEXTURE_HOSTTEST_H
+#define TUTORIAL06_TEXTURE_HOSTTEST_H
+
+/*
+ * HostTest
+ *   Just enough of a test framework for the host tests: HOST_TEST( group, name )
+ *   defines a test, CHECK() records a failure and lets the test go on.
+ *   vktuts_host_tests <group> runs the tests of one group, all of them
+ *   without an argument; it exits with 1 if any check failed.
+ */
+struct HostTest
+{
+    HostTest( const char* group, const char* name, void ( *run )( void ) );
+
+    const char* group_;
+    const char* name_;
+    void ( *run_ )( void );
+    HostTest* next_;
+};
+
+void HostTestCheck( bool passed, const char* condition, const char* file, int line );
+
+#define CHECK( condition ) HostTestCheck( ( condition ), #condition, __FILE__, __LINE__ )
+
+#define HOST_TEST( group, name )                                          \
+    static void group##_##name( void );                                   \
+    static HostTest group##_##name##_test( #group, #name, group##_##name ); \
+    static void group##_##name( void )
+
+#endif // TUTORIAL06_TEXTURE_HOSTTEST_H
@@ -0,0 +1,147 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include "JobSystem.h"
+#include "HostTest.h"
+#include <atomic>
+#include <chrono>
+#include <memory>
+
+HOST_TEST( JobSystem, EveryJobRunsOnce )
+{
+    const uint32_t kJobs = 1000;
+    JobSystem jobs( 3 );
+    std::unique_ptr<std::atomic<uint32_t>[]> runs( new std::atomic<uint32_t>[kJobs] );
+    std::atomic<uint32_t> badThreadIndex( 0 );
+    for( uint32_t i = 0; i < kJobs; i++ )
+        runs[i] = 0;
+
+    JobCounter counter;
+    for( uint32_t i = 0; i < kJobs; i++ )
+    {
+        jobs.Submit( [&, i] {
+            runs[i]++;
+            if( JobSystem::ThreadIndex() >= jobs.ThreadCount() )
+                badThreadIndex++;
+        }, &counter );
+    }
+    jobs.Wait( counter );
+
+    CHECK( counter.pending_ == 0 );
+    CHECK( badThreadIndex == 0 );
+    uint32_t runOnce = 0;
+    for( uint32_t i = 0; i < kJobs; i++ )
+        runOnce += runs[i] == 1;
+    CHECK( runOnce == kJobs );
+}
+
+HOST_TEST( JobSystem, JobsSpawnJobs )
+{
+    // shader stages built as jobs of one batch that the pipeline build waits for
+    JobSystem jobs( 2 );
+    std::atomic<uint32_t> leaves( 0 );
+    JobCounter counter;
+    for( uint32_t i = 0; i < 16; i++ )
+    {
+        jobs.Submit( [&] {
+            for( uint32_t j = 0; j < 16; j++ )
+                jobs.Submit( [&] { leaves++; }, &counter );
+        }, &counter );
+    }
+    jobs.Wait( counter );
+    CHECK( leaves == 16 * 16 );
+}
+
+HOST_TEST( JobSystem, WaitOnlyForItsCounter )
+{
+    JobSystem jobs( 1 );
+    std::atomic<bool> started( false );
+    std::atomic<bool> release( false );
+    JobCounter blocked;
+    jobs.Submit( [&] {
+        started = true;
+        while( !release )
+            std::this_thread::yield();
+    }, &blocked );
+    // on the worker, not stolen by the Wait() below
+    while( !started )
+        std::this_thread::yield();
+
+    // the calling thread runs these itself while the only worker is stuck
+    std::atomic<uint32_t> done( 0 );
+    JobCounter counter;
+    for( uint32_t i = 0; i < 8; i++ )
+        jobs.Submit( [&] { done++; }, &counter );
+    jobs.Wait( counter );
+    CHECK( done == 8 );
+
+    release = true;
+    jobs.Wait( blocked );
+    CHECK( blocked.pending_ == 0 );
+}
+
+HOST_TEST( JobSystem, WaitLeavesOtherJobsQueued )
+{
+    // a frame waiting for its jobs must not pick up a background pipeline build
+    JobSystem jobs( 1 );
+    std::atomic<bool> started( false );
+    std::atomic<bool> release( false );
+    JobCounter blocked;
+    jobs.Submit( [&] {
+        started = true;
+        while( !release )
+            std::this_thread::yield();
+    }, &blocked );
+    while( !started )
+        std::this_thread::yield();
+
+    std::atomic<bool> backgroundRan( false );
+    JobCounter background;
+    jobs.Submit( [&] { backgroundRan = true; }, &background );
+    std::atomic<uint32_t> done( 0 );
+    JobCounter counter;
+    for( uint32_t i = 0; i < 4; i++ )
+        jobs.Submit( [&] { done++; }, &counter );
+    jobs.Wait( counter );
+    CHECK( done == 4 );
+    CHECK( !backgroundRan );
+    CHECK( background.pending_ == 1 );
+
+    // the worker gets to it; this Wait() sleeps until then
+    release = true;
+    jobs.Wait( background );
+    CHECK( backgroundRan );
+    jobs.Wait( blocked );
+}
+
+HOST_TEST( JobSystem, WaitSleepsUntilRunningJobsFinish )
+{
+    JobSystem jobs( 2 );
+    for( uint32_t round = 0; round < 200; round++ )
+    {
+        // the job is picked up by a worker, Wait() finds nothing queued and blocks on the counter
+        std::atomic<uint32_t> done( 0 );
+        JobCounter counter;
+        jobs.Submit( [&] {
+            std::this_thread::sleep_for( std::chrono::microseconds( 50 ) );
+            jobs.Submit( [&] { done++; }, &counter );
+            done++;
+        }, &counter );
+        jobs.Wait( counter );
+        CHECK( done == 2 );
+    }
+}
@@ -0,0 +1,217 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include "KtxTexture.h"
+#include "HostTest.h"
+#include <cstring>
+#include <vector>
+
+static const uint32_t kHeaderSize = 80;
+static const uint32_t kLevelEntrySize = 24;
+
+static void PutUint32( std::vector<uint8_t>* file, size_t offset, uint32_t value )
+{
+    memcpy( file->data() + offset, &value, sizeof( value ) );
+}
+
+static void PutUint64( std::vector<uint8_t>* file, size_t offset, uint64_t value )
+{
+    memcpy( file->data() + offset, &value, sizeof( value ) );
+}
+
+// KTX2 file holding levelCount levels of blockSize byte blocks, the smallest level
+// stored first as the spec lays them out; level i's bytes are all i + 1
+static std::vector<uint8_t> MakeKtx2( VkFormat format, uint32_t width, uint32_t height, uint32_t levelCount,
+                                      uint32_t blockWidth, uint32_t blockHeight, uint32_t blockSize )
+{
+    static const uint8_t identifier[12] = { 0xab, 0x4b, 0x54, 0x58, 0x20, 0x32, 0x30, 0xbb, 0x0d, 0x0a, 0x1a, 0x0a };
+
+    std::vector<uint8_t> file( kHeaderSize + levelCount * kLevelEntrySize );
+    memcpy( file.data(), identifier, sizeof( identifier ) );
+    PutUint32( &file, 12, format );
+    PutUint32( &file, 16, 1 );
+    PutUint32( &file, 20, width );
+    PutUint32( &file, 24, height );
+    PutUint32( &file, 36, 1 );
+    PutUint32( &file, 40, levelCount );
+
+    for( uint32_t i = levelCount; i-- > 0; )
+    {
+        uint32_t levelWidth = width >> i ? width >> i : 1;
+        uint32_t levelHeight = height >> i ? height >> i : 1;
+        uint64_t length = static_cast<uint64_t>( ( levelWidth + blockWidth - 1 ) / blockWidth ) *
+                          ( ( levelHeight + blockHeight - 1 ) / blockHeight ) * blockSize;
+        size_t entry = kHeaderSize + i * kLevelEntrySize;
+        PutUint64( &file, entry, file.size() );
+        PutUint64( &file, entry + 8, length );
+        PutUint64( &file, entry + 16, length );
+        file.insert( file.end(), length, static_cast<uint8_t>( i + 1 ) );
+    }
+    return file;
+}
+
+static std::vector<uint8_t> MakeEtc2( void )
+{
+    // 8x8 -> 4x4 -> 2x2 -> 1x1
+    return MakeKtx2( VK_FORMAT_ETC2_R8G8B8_UNORM_BLOCK, 8, 8, 4, 4, 4, 8 );
+}
+
+static bool Parses( const std::vector<uint8_t>& file )
+{
+    KtxTexture texture;
+    return texture.Parse( file.data(), file.size() );
+}
+
+HOST_TEST( KtxTexture, ParsesLevels )
+{
+    std::vector<uint8_t> file = MakeEtc2();
+    KtxTexture texture;
+    CHECK( texture.Parse( file.data(), file.size() ) );
+    CHECK( texture.Format() == VK_FORMAT_ETC2_R8G8B8_UNORM_BLOCK );
+    CHECK( texture.Width() == 8 && texture.Height() == 8 );
+    CHECK( texture.BlockWidth() == 4 && texture.BlockHeight() == 4 && texture.BlockSize() == 8 );
+    CHECK( texture.LevelCount() == 4 );
+
+    const KtxTexture::Level& base = texture.GetLevel( 0 );
+    CHECK( base.width_ == 8 && base.height_ == 8 && base.size_ == 32 );
+    CHECK( base.data_ == file.data() + file.size() - 32 );
+    CHECK( base.data_[0] == 1 && base.data_[31] == 1 );
+
+    // levels under the block size still take a whole block
+    for( uint32_t i = 1; i < 4; i++ )
+    {
+        const KtxTexture::Level& level = texture.GetLevel( i );
+        CHECK( level.width_ == 8u >> i && level.height_ == 8u >> i );
+        CHECK( level.size_ == 8 );
+        CHECK( level.data_[0] == i + 1 && level.data_[7] == i + 1 );
+    }
+}
+
+HOST_TEST( KtxTexture, ParsesUncompressedAndAstc )
+{
+    std::vector<uint8_t> rgba = MakeKtx2( VK_FORMAT_R8G8B8A8_SRGB, 3, 5, 1, 1, 1, 4 );
+    KtxTexture texture;
+    CHECK( texture.Parse( rgba.data(), rgba.size() ) );
+    CHECK( texture.GetLevel( 0 ).size_ == 3 * 5 * 4 );
+
+    // 10x10 in 6x6 blocks is 2x2 of them
+    std::vector<uint8_t> astc = MakeKtx2( VK_FORMAT_ASTC_6x6_UNORM_BLOCK, 10, 10, 1, 6, 6, 16 );
+    CHECK( texture.Parse( astc.data(), astc.size() ) );
+    CHECK( texture.BlockWidth() == 6 && texture.GetLevel( 0 ).size_ == 4 * 16 );
+}
+
+HOST_TEST( KtxTexture, LevelCountZeroIsBaseLevel )
+{
+    std::vector<uint8_t> file = MakeKtx2( VK_FORMAT_BC1_RGB_UNORM_BLOCK, 4, 4, 1, 4, 4, 8 );
+    PutUint32( &file, 40, 0 );
+    KtxTexture texture;
+    CHECK( texture.Parse( file.data(), file.size() ) );
+    CHECK( texture.LevelCount() == 1 && texture.GetLevel( 0 ).size_ == 8 );
+}
+
+HOST_TEST( KtxTexture, RejectsTruncatedHeader )
+{
+    std::vector<uint8_t> file = MakeEtc2();
+    KtxTexture texture;
+    CHECK( !texture.Parse( file.data(), 0 ) );
+    CHECK( !texture.Parse( file.data(), 12 ) );
+    CHECK( !texture.Parse( file.data(), kHeaderSize - 1 ) );
+
+    // the header is whole but the level index is cut short
+    CHECK( !texture.Parse( file.data(), kHeaderSize ) );
+    CHECK( !texture.Parse( file.data(), kHeaderSize + 4 * kLevelEntrySize - 1 ) );
+}
+
+HOST_TEST( KtxTexture, RejectsBadIdentifier )
+{
+    std::vector<uint8_t> file = MakeEtc2();
+    file[5] = '1'; // KTX 11
+    CHECK( !Parses( file ) );
+}
+
+HOST_TEST( KtxTexture, RejectsSupercompression )
+{
+    std::vector<uint8_t> basis = MakeEtc2();
+    PutUint32( &basis, 44, 1 );
+    CHECK( !Parses( basis ) );
+
+    std::vector<uint8_t> zstd = MakeEtc2();
+    PutUint32( &zstd, 44, 2 );
+    CHECK( !Parses( zstd ) );
+
+    // Basis Universal files leave vkFormat undefined
+    std::vector<uint8_t> undefined = MakeEtc2();
+    PutUint32( &undefined, 12, VK_FORMAT_UNDEFINED );
+    CHECK( !Parses( undefined ) );
+}
+
+HOST_TEST( KtxTexture, RejectsUnsupportedShapes )
+{
+    std::vector<uint8_t> format = MakeEtc2();
+    PutUint32( &format, 12, VK_FORMAT_R32_SFLOAT );
+    CHECK( !Parses( format ) );
+
+    std::vector<uint8_t> cube = MakeEtc2();
+    PutUint32( &cube, 36, 6 );
+    CHECK( !Parses( cube ) );
+
+    std::vector<uint8_t> array = MakeEtc2();
+    PutUint32( &array, 32, 2 );
+    CHECK( !Parses( array ) );
+
+    std::vector<uint8_t> volume = MakeEtc2();
+    PutUint32( &volume, 28, 2 );
+    CHECK( !Parses( volume ) );
+
+    std::vector<uint8_t> empty = MakeEtc2();
+    PutUint32( &empty, 20, 0 );
+    CHECK( !Parses( empty ) );
+
+    std::vector<uint8_t> levels = MakeEtc2();
+    PutUint32( &levels, 40, 33 );
+    CHECK( !Parses( levels ) );
+}
+
+HOST_TEST( KtxTexture, RejectsLevelsOutOfRange )
+{
+    size_t entry = kHeaderSize + 2 * kLevelEntrySize;
+
+    // offset past the end of the file
+    std::vector<uint8_t> offset = MakeEtc2();
+    PutUint64( &offset, entry, offset.size() + 1 );
+    CHECK( !Parses( offset ) );
+
+    // offset + length overflows to a small value
+    std::vector<uint8_t> wrap = MakeEtc2();
+    PutUint64( &wrap, entry, 16 );
+    PutUint64( &wrap, entry + 8, ~0ull - 8 );
+    CHECK( !Parses( wrap ) );
+
+    // data runs past the end of the file
+    std::vector<uint8_t> length = MakeEtc2();
+    PutUint64( &length, entry, length.size() - 4 );
+    CHECK( !Parses( length ) );
+
+    // fewer bytes than the level's blocks need
+    std::vector<uint8_t> shortLevel = MakeEtc2();
+    PutUint64( &shortLevel, kHeaderSize + 8, 31 );
+    CHECK( !Parses( shortLevel ) );
+
+    // the file is cut inside its last level
+    std::vector<uint8_t> cut = MakeEtc2();
+    CHECK( !Parses( std::vector<uint8_t>( cut.begin(), cut.end() - 1 ) ) );
+}
@@ -0,0 +1,148 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include "PipelineDesc.h"
+#include "HostTest.h"
+#include <cstring>
+#include <unordered_map>
+
+static PipelineDesc SceneDesc( void )
+{
+    PipelineDesc desc = DefaultPipelineDesc();
+    desc.vertexShader_ = "shaders/tri.vert";
+    desc.fragmentShader_ = "shaders/tri.frag";
+    desc.vertexStride_ = 12;
+    desc.vertexAttributeCount_ = 1;
+    desc.vertexAttributes_[0] = { 0, VK_FORMAT_R32G32B32_SFLOAT, 0 };
+    desc.layout_ = reinterpret_cast<VkPipelineLayout>( 0x1000 );
+    desc.renderPass_ = reinterpret_cast<VkRenderPass>( 0x2000 );
+    return desc;
+}
+
+static bool SameDesc( const PipelineDesc& a, const PipelineDesc& b )
+{
+    return a == b && HashPipelineDesc( a ) == HashPipelineDesc( b );
+}
+
+static bool OtherDesc( const PipelineDesc& a, const PipelineDesc& b )
+{
+    return a != b && HashPipelineDesc( a ) != HashPipelineDesc( b );
+}
+
+HOST_TEST( PipelineDesc, EqualDescsHashEqual )
+{
+    CHECK( SameDesc( DefaultPipelineDesc(), DefaultPipelineDesc() ) );
+    CHECK( SameDesc( SceneDesc(), SceneDesc() ) );
+
+    // shaders by their text, not their address
+    char vertexShader[] = "shaders/tri.vert";
+    PipelineDesc copied = SceneDesc();
+    copied.vertexShader_ = vertexShader;
+    CHECK( SameDesc( SceneDesc(), copied ) );
+
+    // vertex attributes past vertexAttributeCount_ are not part of the desc
+    PipelineDesc unused = SceneDesc();
+    unused.vertexAttributes_[2] = { 5, VK_FORMAT_R32_UINT, 64 };
+    CHECK( SameDesc( SceneDesc(), unused ) );
+}
+
+HOST_TEST( PipelineDesc, EveryFieldCounts )
+{
+    const PipelineDesc scene = SceneDesc();
+    PipelineDesc desc;
+    // one field changed at a time: must be a different desc with a different hash
+#define CHECK_FIELD( change )    \
+    desc = scene;                \
+    change;                      \
+    CHECK( OtherDesc( scene, desc ) )
+
+    CHECK_FIELD( desc.vertexShader_ = "shaders/other.vert" );
+    CHECK_FIELD( desc.fragmentShader_ = nullptr );
+    CHECK_FIELD( desc.vertexStride_ = 16 );
+    CHECK_FIELD( desc.vertexAttributeCount_ = 2 );
+    CHECK_FIELD( desc.vertexAttributes_[0].location_ = 1 );
+    CHECK_FIELD( desc.vertexAttributes_[0].format_ = VK_FORMAT_R32G32B32A32_SFLOAT );
+    CHECK_FIELD( desc.vertexAttributes_[0].offset_ = 4 );
+    CHECK_FIELD( desc.topology_ = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_STRIP );
+    CHECK_FIELD( SetSpecialization( &desc, 0, 1 ) );
+    CHECK_FIELD( desc.polygonMode_ = VK_POLYGON_MODE_LINE );
+    CHECK_FIELD( desc.cullMode_ = VK_CULL_MODE_BACK_BIT );
+    CHECK_FIELD( desc.frontFace_ = VK_FRONT_FACE_COUNTER_CLOCKWISE );
+    CHECK_FIELD( desc.depthTestEnable_ = VK_TRUE );
+    CHECK_FIELD( desc.depthWriteEnable_ = VK_TRUE );
+    CHECK_FIELD( desc.depthCompareOp_ = VK_COMPARE_OP_LESS );
+    CHECK_FIELD( desc.blendEnable_ = VK_TRUE );
+    CHECK_FIELD( desc.srcBlendFactor_ = VK_BLEND_FACTOR_SRC_ALPHA );
+    CHECK_FIELD( desc.dstBlendFactor_ = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA );
+    CHECK_FIELD( desc.blendOp_ = VK_BLEND_OP_SUBTRACT );
+    CHECK_FIELD( desc.colorWriteMask_ = VK_COLOR_COMPONENT_R_BIT );
+    CHECK_FIELD( desc.layout_ = reinterpret_cast<VkPipelineLayout>( 0x3000 ) );
+    CHECK_FIELD( desc.renderPass_ = reinterpret_cast<VkRenderPass>( 0x3000 ) );
+    CHECK_FIELD( desc.subpass_ = 1 );
+#undef CHECK_FIELD
+}
+
+HOST_TEST( PipelineDesc, SpecializationValues )
+{
+    PipelineDesc a = SceneDesc();
+    SetSpecialization( &a, 0, 1 );
+    PipelineDesc b = SceneDesc();
+    SetSpecialization( &b, 0, 2 );
+    CHECK( OtherDesc( a, b ) );
+
+    // setting a constant again replaces its value
+    SetSpecialization( &b, 0, 1 );
+    CHECK( b.specializationCount_ == 1 );
+    CHECK( SameDesc( a, b ) );
+}
+
+HOST_TEST( PipelineDesc, SpecializationOrder )
+{
+    PipelineDesc a = SceneDesc();
+    SetSpecialization( &a, 0, 1 );
+    SetSpecialization( &a, 2, 3 );
+    SetSpecialization( &a, 1, 2 );
+    PipelineDesc b = SceneDesc();
+    SetSpecialization( &b, 2, 3 );
+    SetSpecialization( &b, 1, 2 );
+    SetSpecialization( &b, 0, 1 );
+    CHECK( SameDesc( a, b ) );
+    for( uint32_t i = 0; i < 3; i++ )
+        CHECK( a.specializations_[i].constantId_ == i && a.specializations_[i].value_ == i + 1 );
+
+    // replacing a value keeps the order
+    SetSpecialization( &b, 1, 5 );
+    CHECK( OtherDesc( a, b ) );
+    SetSpecialization( &b, 1, 2 );
+    CHECK( SameDesc( a, b ) );
+}
+
+HOST_TEST( PipelineDesc, HashMapKey )
+{
+    std::unordered_map<PipelineDesc, uint32_t, PipelineDescHash> pipelines;
+    PipelineDesc opaque = SceneDesc();
+    PipelineDesc blended = SceneDesc();
+    blended.blendEnable_ = VK_TRUE;
+    pipelines[opaque] = 1;
+    pipelines[blended] = 2;
+
+    PipelineDesc lookup = SceneDesc();
+    CHECK( pipelines.size() == 2 );
+    CHECK( pipelines.count( lookup ) == 1 && pipelines[lookup] == 1 );
+    lookup.blendEnable_ = VK_TRUE;
+    CHECK( pipelines.count( lookup ) == 1 && pipelines[lookup] == 2 );
+}
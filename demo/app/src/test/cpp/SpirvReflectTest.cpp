@@ -0,0 +1,342 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include "SpirvReflect.h"
+#include "HostTest.h"
+#include <cstring>
+#include <initializer_list>
+#include <vector>
+
+// SPIR-V numbers the modules below use, from spirv.h
+enum
+{
+    OP_ENTRY_POINT = 15,
+    OP_TYPE_INT = 21,
+    OP_TYPE_FLOAT = 22,
+    OP_TYPE_VECTOR = 23,
+    OP_TYPE_MATRIX = 24,
+    OP_TYPE_IMAGE = 25,
+    OP_TYPE_SAMPLED_IMAGE = 27,
+    OP_TYPE_ARRAY = 28,
+    OP_TYPE_RUNTIME_ARRAY = 29,
+    OP_TYPE_STRUCT = 30,
+    OP_TYPE_POINTER = 32,
+    OP_CONSTANT = 43,
+    OP_VARIABLE = 59,
+    OP_DECORATE = 71,
+    OP_MEMBER_DECORATE = 72,
+
+    DECORATION_BLOCK = 2,
+    DECORATION_BUFFER_BLOCK = 3,
+    DECORATION_ARRAY_STRIDE = 6,
+    DECORATION_MATRIX_STRIDE = 7,
+    DECORATION_BUILT_IN = 11,
+    DECORATION_LOCATION = 30,
+    DECORATION_BINDING = 33,
+    DECORATION_DESCRIPTOR_SET = 34,
+    DECORATION_OFFSET = 35,
+
+    STORAGE_UNIFORM_CONSTANT = 0,
+    STORAGE_INPUT = 1,
+    STORAGE_UNIFORM = 2,
+    STORAGE_PUSH_CONSTANT = 9,
+
+    MODEL_VERTEX = 0,
+    MODEL_FRAGMENT = 4,
+};
+
+// Hand assembled module: header, then one instruction per Op()
+class SpirvWords
+{
+public:
+    explicit SpirvWords( uint32_t executionModel )
+    {
+        words_ = { 0x07230203, 0x00010000, 0, 100, 0 };
+        // OpEntryPoint model %1 "main"
+        Op( OP_ENTRY_POINT, { executionModel, 1, 0x6e69616d, 0 } );
+    }
+
+    void Op( uint32_t op, std::initializer_list<uint32_t> operands )
+    {
+        words_.push_back( static_cast<uint32_t>( operands.size() + 1 ) << 16 | op );
+        words_.insert( words_.end(), operands );
+    }
+
+    bool Reflect( ShaderReflection* reflection ) const { return ReflectSpirv( words_.data(), words_.size(), reflection ); }
+
+    std::vector<uint32_t> words_;
+};
+
+// ids shared by both stages
+enum
+{
+    ID_FLOAT = 10,
+    ID_VEC2,
+    ID_VEC4,
+    ID_INT,
+    ID_UINT,
+    ID_MAT4,
+    ID_UINT_4,
+    ID_IMAGE,
+    ID_SAMPLED_IMAGE,
+    ID_SAMPLED_IMAGE_ARRAY,
+    ID_FLOAT_ARRAY,
+    ID_FLOAT_RUNTIME_ARRAY,
+    ID_INNER,
+    ID_UBO,
+    ID_SSBO,
+    ID_PUSH,
+    ID_PTR_UBO,
+    ID_PTR_SSBO,
+    ID_PTR_PUSH,
+    ID_PTR_TEXTURES,
+    ID_PTR_IN_VEC2,
+    ID_PTR_IN_VEC4,
+    ID_PTR_IN_INT,
+    ID_UBO_VAR,
+    ID_SSBO_VAR,
+    ID_PUSH_VAR,
+    ID_TEXTURES_VAR,
+    ID_POSITION_VAR,
+    ID_COLOR_VAR,
+    ID_INDEX_VAR,
+    ID_VERTEX_INDEX_VAR,
+};
+
+static void AddTypes( SpirvWords& spirv )
+{
+    spirv.Op( OP_TYPE_FLOAT, { ID_FLOAT, 32 } );
+    spirv.Op( OP_TYPE_VECTOR, { ID_VEC2, ID_FLOAT, 2 } );
+    spirv.Op( OP_TYPE_VECTOR, { ID_VEC4, ID_FLOAT, 4 } );
+    spirv.Op( OP_TYPE_INT, { ID_INT, 32, 1 } );
+    spirv.Op( OP_TYPE_INT, { ID_UINT, 32, 0 } );
+    spirv.Op( OP_TYPE_MATRIX, { ID_MAT4, ID_VEC4, 4 } );
+    spirv.Op( OP_CONSTANT, { ID_UINT, ID_UINT_4, 4 } );
+    // sampler2D textures[4]
+    spirv.Op( OP_TYPE_IMAGE, { ID_IMAGE, ID_FLOAT, 1, 0, 0, 0, 1, 0 } );
+    spirv.Op( OP_TYPE_SAMPLED_IMAGE, { ID_SAMPLED_IMAGE, ID_IMAGE } );
+    spirv.Op( OP_TYPE_ARRAY, { ID_SAMPLED_IMAGE_ARRAY, ID_SAMPLED_IMAGE, ID_UINT_4 } );
+    spirv.Op( OP_TYPE_ARRAY, { ID_FLOAT_ARRAY, ID_FLOAT, ID_UINT_4 } );
+    spirv.Op( OP_TYPE_RUNTIME_ARRAY, { ID_FLOAT_RUNTIME_ARRAY, ID_FLOAT } );
+    // a struct inside a block, its member carries no Offset decoration
+    spirv.Op( OP_TYPE_STRUCT, { ID_INNER, ID_FLOAT } );
+}
+
+static void AddUniformBlock( SpirvWords& spirv )
+{
+    // layout( set = 0, binding = 0 ) uniform UBO { mat4 mvp; vec4 color; }
+    spirv.Op( OP_DECORATE, { ID_UBO, DECORATION_BLOCK } );
+    spirv.Op( OP_MEMBER_DECORATE, { ID_UBO, 0, DECORATION_OFFSET, 0 } );
+    spirv.Op( OP_MEMBER_DECORATE, { ID_UBO, 0, DECORATION_MATRIX_STRIDE, 16 } );
+    spirv.Op( OP_MEMBER_DECORATE, { ID_UBO, 1, DECORATION_OFFSET, 64 } );
+    spirv.Op( OP_DECORATE, { ID_UBO_VAR, DECORATION_DESCRIPTOR_SET, 0 } );
+    spirv.Op( OP_DECORATE, { ID_UBO_VAR, DECORATION_BINDING, 0 } );
+    spirv.Op( OP_TYPE_STRUCT, { ID_UBO, ID_MAT4, ID_VEC4 } );
+    spirv.Op( OP_TYPE_POINTER, { ID_PTR_UBO, STORAGE_UNIFORM, ID_UBO } );
+    spirv.Op( OP_VARIABLE, { ID_PTR_UBO, ID_UBO_VAR, STORAGE_UNIFORM } );
+}
+
+static void AddTextures( SpirvWords& spirv )
+{
+    // layout( set = 1, binding = 2 ) uniform sampler2D textures[4]
+    spirv.Op( OP_DECORATE, { ID_TEXTURES_VAR, DECORATION_DESCRIPTOR_SET, 1 } );
+    spirv.Op( OP_DECORATE, { ID_TEXTURES_VAR, DECORATION_BINDING, 2 } );
+    spirv.Op( OP_TYPE_POINTER, { ID_PTR_TEXTURES, STORAGE_UNIFORM_CONSTANT, ID_SAMPLED_IMAGE_ARRAY } );
+    spirv.Op( OP_VARIABLE, { ID_PTR_TEXTURES, ID_TEXTURES_VAR, STORAGE_UNIFORM_CONSTANT } );
+}
+
+// Vertex stage: uniform block, buffer block, push constants, three inputs and a built-in
+static SpirvWords VertexModule( void )
+{
+    SpirvWords spirv( MODEL_VERTEX );
+    AddTypes( spirv );
+    AddUniformBlock( spirv );
+
+    // layout( set = 0, binding = 1 ) buffer SSBO { float values[]; }, declared the GLSL 4.5 way
+    spirv.Op( OP_DECORATE, { ID_SSBO, DECORATION_BUFFER_BLOCK } );
+    spirv.Op( OP_MEMBER_DECORATE, { ID_SSBO, 0, DECORATION_OFFSET, 0 } );
+    spirv.Op( OP_DECORATE, { ID_SSBO_VAR, DECORATION_DESCRIPTOR_SET, 0 } );
+    spirv.Op( OP_DECORATE, { ID_SSBO_VAR, DECORATION_BINDING, 1 } );
+    spirv.Op( OP_TYPE_STRUCT, { ID_SSBO, ID_FLOAT_RUNTIME_ARRAY } );
+    spirv.Op( OP_TYPE_POINTER, { ID_PTR_SSBO, STORAGE_UNIFORM, ID_SSBO } );
+    spirv.Op( OP_VARIABLE, { ID_PTR_SSBO, ID_SSBO_VAR, STORAGE_UNIFORM } );
+
+    // push_constant { vec4 offset; mat4 transform; float weights[4]; Inner inner; }: 16 + 64 + 4 * 16 + 4
+    spirv.Op( OP_DECORATE, { ID_PUSH, DECORATION_BLOCK } );
+    spirv.Op( OP_DECORATE, { ID_FLOAT_ARRAY, DECORATION_ARRAY_STRIDE, 16 } );
+    spirv.Op( OP_MEMBER_DECORATE, { ID_PUSH, 0, DECORATION_OFFSET, 0 } );
+    spirv.Op( OP_MEMBER_DECORATE, { ID_PUSH, 1, DECORATION_OFFSET, 16 } );
+    spirv.Op( OP_MEMBER_DECORATE, { ID_PUSH, 1, DECORATION_MATRIX_STRIDE, 16 } );
+    spirv.Op( OP_MEMBER_DECORATE, { ID_PUSH, 2, DECORATION_OFFSET, 80 } );
+    spirv.Op( OP_MEMBER_DECORATE, { ID_PUSH, 3, DECORATION_OFFSET, 144 } );
+    spirv.Op( OP_TYPE_STRUCT, { ID_PUSH, ID_VEC4, ID_MAT4, ID_FLOAT_ARRAY, ID_INNER } );
+    spirv.Op( OP_TYPE_POINTER, { ID_PTR_PUSH, STORAGE_PUSH_CONSTANT, ID_PUSH } );
+    spirv.Op( OP_VARIABLE, { ID_PTR_PUSH, ID_PUSH_VAR, STORAGE_PUSH_CONSTANT } );
+
+    // inputs declared out of location order
+    spirv.Op( OP_DECORATE, { ID_COLOR_VAR, DECORATION_LOCATION, 1 } );
+    spirv.Op( OP_DECORATE, { ID_POSITION_VAR, DECORATION_LOCATION, 0 } );
+    spirv.Op( OP_DECORATE, { ID_INDEX_VAR, DECORATION_LOCATION, 2 } );
+    spirv.Op( OP_DECORATE, { ID_VERTEX_INDEX_VAR, DECORATION_BUILT_IN, 42 } );
+    spirv.Op( OP_TYPE_POINTER, { ID_PTR_IN_VEC2, STORAGE_INPUT, ID_VEC2 } );
+    spirv.Op( OP_TYPE_POINTER, { ID_PTR_IN_VEC4, STORAGE_INPUT, ID_VEC4 } );
+    spirv.Op( OP_TYPE_POINTER, { ID_PTR_IN_INT, STORAGE_INPUT, ID_INT } );
+    spirv.Op( OP_VARIABLE, { ID_PTR_IN_VEC4, ID_COLOR_VAR, STORAGE_INPUT } );
+    spirv.Op( OP_VARIABLE, { ID_PTR_IN_VEC2, ID_POSITION_VAR, STORAGE_INPUT } );
+    spirv.Op( OP_VARIABLE, { ID_PTR_IN_INT, ID_INDEX_VAR, STORAGE_INPUT } );
+    spirv.Op( OP_VARIABLE, { ID_PTR_IN_INT, ID_VERTEX_INDEX_VAR, STORAGE_INPUT } );
+    return spirv;
+}
+
+// Fragment stage: the same uniform block, a texture array and a smaller push constant block
+static SpirvWords FragmentModule( void )
+{
+    SpirvWords spirv( MODEL_FRAGMENT );
+    AddTypes( spirv );
+    AddUniformBlock( spirv );
+    AddTextures( spirv );
+
+    // push_constant { vec4 offset; }
+    spirv.Op( OP_DECORATE, { ID_PUSH, DECORATION_BLOCK } );
+    spirv.Op( OP_MEMBER_DECORATE, { ID_PUSH, 0, DECORATION_OFFSET, 0 } );
+    spirv.Op( OP_TYPE_STRUCT, { ID_PUSH, ID_VEC4 } );
+    spirv.Op( OP_TYPE_POINTER, { ID_PTR_PUSH, STORAGE_PUSH_CONSTANT, ID_PUSH } );
+    spirv.Op( OP_VARIABLE, { ID_PTR_PUSH, ID_PUSH_VAR, STORAGE_PUSH_CONSTANT } );
+    return spirv;
+}
+
+HOST_TEST( SpirvReflect, VertexStage )
+{
+    ShaderReflection reflection = {};
+    CHECK( VertexModule().Reflect( &reflection ) );
+    CHECK( reflection.stages_ == VK_SHADER_STAGE_VERTEX_BIT );
+
+    CHECK( reflection.bindings_.size() == 2 );
+    if( reflection.bindings_.size() == 2 )
+    {
+        const ReflectedBinding& ubo = reflection.bindings_[0];
+        CHECK( ubo.set_ == 0 && ubo.binding_ == 0 );
+        CHECK( ubo.type_ == VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER );
+        CHECK( ubo.count_ == 1 );
+        CHECK( ubo.stages_ == VK_SHADER_STAGE_VERTEX_BIT );
+        const ReflectedBinding& ssbo = reflection.bindings_[1];
+        CHECK( ssbo.set_ == 0 && ssbo.binding_ == 1 );
+        CHECK( ssbo.type_ == VK_DESCRIPTOR_TYPE_STORAGE_BUFFER );
+    }
+
+    CHECK( reflection.pushConstantSize_ == 148 );
+    CHECK( reflection.pushConstantStages_ == VK_SHADER_STAGE_VERTEX_BIT );
+
+    // by location, the built-in left out
+    CHECK( reflection.vertexInputs_.size() == 3 );
+    if( reflection.vertexInputs_.size() == 3 )
+    {
+        CHECK( reflection.vertexInputs_[0].location_ == 0 );
+        CHECK( reflection.vertexInputs_[0].format_ == VK_FORMAT_R32G32_SFLOAT );
+        CHECK( reflection.vertexInputs_[0].size_ == 8 );
+        CHECK( reflection.vertexInputs_[1].location_ == 1 );
+        CHECK( reflection.vertexInputs_[1].format_ == VK_FORMAT_R32G32B32A32_SFLOAT );
+        CHECK( reflection.vertexInputs_[1].size_ == 16 );
+        CHECK( reflection.vertexInputs_[2].location_ == 2 );
+        CHECK( reflection.vertexInputs_[2].format_ == VK_FORMAT_R32_SINT );
+        CHECK( reflection.vertexInputs_[2].size_ == 4 );
+    }
+}
+
+HOST_TEST( SpirvReflect, StagesMerge )
+{
+    ShaderReflection reflection = {};
+    CHECK( VertexModule().Reflect( &reflection ) );
+    CHECK( FragmentModule().Reflect( &reflection ) );
+    CHECK( reflection.stages_ == ( VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT ) );
+
+    // the uniform block is one binding of both stages; by set, then binding
+    CHECK( reflection.bindings_.size() == 3 );
+    if( reflection.bindings_.size() == 3 )
+    {
+        CHECK( reflection.bindings_[0].binding_ == 0 );
+        CHECK( reflection.bindings_[0].stages_ == ( VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT ) );
+        CHECK( reflection.bindings_[1].binding_ == 1 );
+        CHECK( reflection.bindings_[1].stages_ == VK_SHADER_STAGE_VERTEX_BIT );
+        const ReflectedBinding& textures = reflection.bindings_[2];
+        CHECK( textures.set_ == 1 && textures.binding_ == 2 );
+        CHECK( textures.type_ == VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER );
+        CHECK( textures.count_ == 4 );
+        CHECK( textures.stages_ == VK_SHADER_STAGE_FRAGMENT_BIT );
+    }
+
+    // one range covering the bigger block, for both stages
+    CHECK( reflection.pushConstantSize_ == 148 );
+    CHECK( reflection.pushConstantStages_ == ( VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT ) );
+    CHECK( reflection.vertexInputs_.size() == 3 );
+
+    CHECK( ReflectedSetCount( reflection ) == 2 );
+    std::vector<VkDescriptorSetLayoutBinding> set0 = ReflectedSetBindings( reflection, 0 );
+    std::vector<VkDescriptorSetLayoutBinding> set1 = ReflectedSetBindings( reflection, 1 );
+    CHECK( set0.size() == 2 );
+    CHECK( set1.size() == 1 );
+    if( set1.size() == 1 )
+    {
+        CHECK( set1[0].binding == 2 );
+        CHECK( set1[0].descriptorType == VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER );
+        CHECK( set1[0].descriptorCount == 4 );
+        CHECK( set1[0].stageFlags == VK_SHADER_STAGE_FRAGMENT_BIT );
+        CHECK( set1[0].pImmutableSamplers == nullptr );
+    }
+}
+
+HOST_TEST( SpirvReflect, ConflictingBindingFails )
+{
+    // the fragment stage declares set 0 binding 1 as a texture array, the vertex stage as a buffer
+    SpirvWords fragment( MODEL_FRAGMENT );
+    AddTypes( fragment );
+    fragment.Op( OP_DECORATE, { ID_TEXTURES_VAR, DECORATION_DESCRIPTOR_SET, 0 } );
+    fragment.Op( OP_DECORATE, { ID_TEXTURES_VAR, DECORATION_BINDING, 1 } );
+    fragment.Op( OP_TYPE_POINTER, { ID_PTR_TEXTURES, STORAGE_UNIFORM_CONSTANT, ID_SAMPLED_IMAGE_ARRAY } );
+    fragment.Op( OP_VARIABLE, { ID_PTR_TEXTURES, ID_TEXTURES_VAR, STORAGE_UNIFORM_CONSTANT } );
+
+    ShaderReflection reflection = {};
+    CHECK( VertexModule().Reflect( &reflection ) );
+    CHECK( !fragment.Reflect( &reflection ) );
+}
+
+HOST_TEST( SpirvReflect, MalformedModulesFail )
+{
+    ShaderReflection reflection = {};
+    SpirvWords spirv = VertexModule();
+
+    std::vector<uint32_t> words = spirv.words_;
+    words[0] = 0x03022307;
+    CHECK( !ReflectSpirv( words.data(), words.size(), &reflection ) );
+
+    // last instruction cut short
+    CHECK( !ReflectSpirv( spirv.words_.data(), spirv.words_.size() - 1, &reflection ) );
+    CHECK( !ReflectSpirv( spirv.words_.data(), 3, &reflection ) );
+
+    // no entry point
+    SpirvWords noEntry( MODEL_VERTEX );
+    noEntry.words_.resize( 5 );
+    AddTypes( noEntry );
+    CHECK( !noEntry.Reflect( &reflection ) );
+
+    // a vertex input without a location cannot come from a vertex buffer
+    SpirvWords noLocation( MODEL_VERTEX );
+    AddTypes( noLocation );
+    noLocation.Op( OP_TYPE_POINTER, { ID_PTR_IN_VEC4, STORAGE_INPUT, ID_VEC4 } );
+    noLocation.Op( OP_VARIABLE, { ID_PTR_IN_VEC4, ID_COLOR_VAR, STORAGE_INPUT } );
+    CHECK( !noLocation.Reflect( &reflection ) );
+}
@@ -0,0 +1,162 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include "UniformRing.h"
+#include "FakeVulkan.h"
+#include "HostTest.h"
+#include <algorithm>
+#include <thread>
+
+static const VkPhysicalDevice kGpu = FakeHandle<VkPhysicalDevice>( 1 );
+static const VkDevice kDevice = FakeHandle<VkDevice>( 2 );
+
+struct RingFixture
+{
+    // 3 frames of 1000 bytes and 300 persistent ones, both rounded up to the alignment
+    RingFixture( void )
+    {
+        ResetFakeVulkan();
+        allocator_.Init( kGpu, kDevice );
+        CHECK( ring_.Init( kDevice, &allocator_, 256, 1000, 3, 300 ) == VK_SUCCESS );
+    }
+
+    ~RingFixture()
+    {
+        ring_.Shutdown();
+        allocator_.Shutdown();
+        CHECK( fakeVulkan.buffers_ == 0 );
+        CHECK( fakeVulkan.memoryAllocations_ == 0 );
+    }
+
+    MemoryAllocator allocator_;
+    UniformRing ring_;
+};
+
+HOST_TEST( UniformRing, Layout )
+{
+    RingFixture fixture;
+    const VkBufferCreateInfo& info = FakeBufferInfo( fixture.ring_.Buffer() );
+    // persistent 512, then 3 frames of 1024
+    CHECK( info.size == 512 + 3 * 1024 );
+    CHECK( info.usage == VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT );
+    CHECK( fixture.ring_.Alignment() == 256 );
+}
+
+HOST_TEST( UniformRing, AlignedOffsetsPerFrame )
+{
+    RingFixture fixture;
+    UniformRing& ring = fixture.ring_;
+    uint8_t* memory = FakeBufferMemory( ring.Buffer() );
+
+    ring.BeginFrame( 0 );
+    UniformAllocation a, b;
+    CHECK( ring.Allocate( 64, &a ) );
+    CHECK( ring.Allocate( 100, &b ) );
+    CHECK( a.offset_ == 512 );
+    CHECK( b.offset_ == 768 );
+    CHECK( ring.FrameBytes() == 512 );
+    // the host pointer is the buffer's memory at the dynamic offset
+    CHECK( a.data_ == memory + a.offset_ );
+    CHECK( b.data_ == memory + b.offset_ );
+
+    ring.BeginFrame( 2 );
+    CHECK( ring.FrameBytes() == 0 );
+    CHECK( ring.Allocate( 16, &a ) );
+    CHECK( a.offset_ == 512 + 2 * 1024 );
+
+    // the frame comes around again, its region is rewound
+    ring.BeginFrame( 0 );
+    CHECK( ring.Allocate( 16, &a ) );
+    CHECK( a.offset_ == 512 );
+}
+
+HOST_TEST( UniformRing, FrameOverflow )
+{
+    RingFixture fixture;
+    UniformRing& ring = fixture.ring_;
+    UniformAllocation allocation;
+
+    ring.BeginFrame( 1 );
+    for( uint32_t i = 0; i < 4; i++ )
+        CHECK( ring.Allocate( 200, &allocation ) );
+    CHECK( allocation.offset_ == 512 + 1024 + 3 * 256 );
+    // never into frame 2's region
+    CHECK( !ring.Allocate( 1, &allocation ) );
+
+    // a whole region fits, a byte more does not
+    ring.BeginFrame( 1 );
+    CHECK( ring.Allocate( 1024, &allocation ) );
+    ring.BeginFrame( 1 );
+    CHECK( !ring.Allocate( 1025, &allocation ) );
+}
+
+HOST_TEST( UniformRing, PersistentRegion )
+{
+    RingFixture fixture;
+    UniformRing& ring = fixture.ring_;
+    UniformAllocation a, b, c;
+    CHECK( ring.AllocatePersistent( 100, &a ) );
+    CHECK( ring.AllocatePersistent( 100, &b ) );
+    CHECK( a.offset_ == 0 );
+    CHECK( b.offset_ == 256 );
+    CHECK( !ring.AllocatePersistent( 100, &c ) );
+
+    // rewinding frames leaves it alone
+    ring.BeginFrame( 0 );
+    CHECK( ring.Allocate( 16, &c ) );
+    CHECK( c.offset_ == 512 );
+}
+
+HOST_TEST( UniformRing, ConcurrentAllocate )
+{
+    ResetFakeVulkan();
+    MemoryAllocator allocator;
+    allocator.Init( kGpu, kDevice );
+    UniformRing ring;
+    const uint32_t kThreads = 4;
+    const uint32_t kPerThread = 64;
+    CHECK( ring.Init( kDevice, &allocator, 256, kThreads * kPerThread * 256, 2, 0 ) == VK_SUCCESS );
+    ring.BeginFrame( 1 );
+
+    std::vector<uint32_t> offsets[kThreads];
+    std::vector<std::thread> threads;
+    for( uint32_t t = 0; t < kThreads; t++ )
+    {
+        threads.emplace_back( [&, t] {
+            UniformAllocation allocation;
+            for( uint32_t i = 0; i < kPerThread; i++ )
+            {
+                if( ring.Allocate( 200, &allocation ) )
+                    offsets[t].push_back( allocation.offset_ );
+            }
+        } );
+    }
+    for( auto& thread : threads )
+        thread.join();
+
+    // every allocation got a slot of its own in frame 1's region, nothing was refused
+    std::vector<uint32_t> all;
+    for( const auto& threadOffsets : offsets )
+        all.insert( all.end(), threadOffsets.begin(), threadOffsets.end() );
+    std::sort( all.begin(), all.end() );
+    CHECK( all.size() == kThreads * kPerThread );
+    for( size_t i = 0; i < all.size(); i++ )
+        CHECK( all[i] == kThreads * kPerThread * 256 + i * 256 );
+
+    ring.Shutdown();
+    allocator.Shutdown();
+}
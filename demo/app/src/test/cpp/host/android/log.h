@@ -0,0 +1,43 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+// Host stand-in for the NDK's android/log.h, logs go to stdout
+#ifndef TUTORIAL06_TEXTURE_HOST_ANDROID_LOG_H
+#define TUTORIAL06_TEXTURE_HOST_ANDROID_LOG_H
+
+#include <cstdarg>
+#include <cstdio>
+
+enum
+{
+    ANDROID_LOG_INFO = 4,
+    ANDROID_LOG_WARN = 5,
+    ANDROID_LOG_ERROR = 6,
+};
+
+inline int __android_log_print( int prio, const char* tag, const char* fmt, ... )
+{
+    va_list args;
+    va_start( args, fmt );
+    printf( "%s: ", tag );
+    int written = vprintf( fmt, args );
+    printf( "\n" );
+    va_end( args );
+    return written;
+}
+
+#endif // TUTORIAL06_TEXTURE_HOST_ANDROID_LOG_H